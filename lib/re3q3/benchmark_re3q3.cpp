@@ -0,0 +1,114 @@
+#include <Eigen/Dense>
+#include <re3q3.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+// Compares the Sturm sequence and the companion matrix root finding in re3q3
+// in terms of runtime and accuracy on random problems.
+
+typedef std::vector<Eigen::Matrix<double, 3, 10>, Eigen::aligned_allocator<Eigen::Matrix<double, 3, 10>>> Problems;
+typedef std::vector<Eigen::Matrix<double, 3, 8>, Eigen::aligned_allocator<Eigen::Matrix<double, 3, 8>>> Solutions;
+
+double max_residual(const Eigen::Matrix<double, 3, 10> &coeffs,
+					const Eigen::Matrix<double, 3, 8> &solutions,
+					int n_sols) {
+	Eigen::Matrix<double, 10, 1> mons;
+	double max_res = 0.0;
+	for (int i = 0; i < n_sols; i++) {
+		double x = solutions(0, i);
+		double y = solutions(1, i);
+		double z = solutions(2, i);
+		mons << x * x, x * y, x * z, y * y, y * z, z * z, x, y, z, 1.0;
+		max_res = std::max(max_res, (coeffs * mons).cwiseAbs().maxCoeff());
+	}
+	return max_res;
+}
+
+template <bool UseSturm>
+double time_solver(const Problems &problems,
+				   Solutions *solutions,
+				   std::vector<int> *n_sols) {
+	const auto start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < problems.size(); i++) {
+		(*n_sols)[i] = re3q3_internal::re3q3<UseSturm>(problems[i], &(*solutions)[i], true);
+	}
+	const auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / problems.size();
+}
+
+void report(const char *name, double ns_per_call,
+			const Problems &problems,
+			const Solutions &solutions,
+			const std::vector<int> &n_sols) {
+	std::vector<double> residuals;
+	int total_sols = 0;
+	int num_inaccurate = 0;
+	for (size_t i = 0; i < problems.size(); i++) {
+		const double res = max_residual(problems[i], solutions[i], n_sols[i]);
+		total_sols += n_sols[i];
+		if (res > 1e-8) {
+			num_inaccurate++;
+		}
+		if (n_sols[i] > 0) {
+			residuals.push_back(res);
+		}
+	}
+	std::sort(residuals.begin(), residuals.end());
+	std::cout << name << ": " << ns_per_call << " ns/call, "
+			  << static_cast<double>(total_sols) / problems.size() << " solutions/call, "
+			  << "median residual " << residuals[residuals.size() / 2] << ", "
+			  << "99% residual " << residuals[residuals.size() * 99 / 100] << ", "
+			  << num_inaccurate << " problems with residual > 1e-8\n";
+}
+
+int main(int argc, char **argv) {
+	const int num_problems = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+	srand(0);
+	Problems problems(num_problems);
+	for (auto &coeffs : problems) {
+		coeffs.setRandom();
+	}
+
+	Solutions solutions_companion(num_problems);
+	Solutions solutions_sturm(num_problems);
+	std::vector<int> n_sols_companion(num_problems);
+	std::vector<int> n_sols_sturm(num_problems);
+
+	// Warm up the caches before timing.
+	time_solver<false>(problems, &solutions_companion, &n_sols_companion);
+	time_solver<true>(problems, &solutions_sturm, &n_sols_sturm);
+
+	const double ns_companion = time_solver<false>(problems, &solutions_companion, &n_sols_companion);
+	const double ns_sturm = time_solver<true>(problems, &solutions_sturm, &n_sols_sturm);
+
+	std::cout << "Running " << num_problems << " random problems\n\n";
+	report("companion matrix", ns_companion, problems, solutions_companion, n_sols_companion);
+	report("sturm sequences ", ns_sturm, problems, solutions_sturm, n_sols_sturm);
+
+	// Compare the solutions of both paths, which are matched by their
+	// x-coordinate, since the roots are found in a different order.
+	int num_count_mismatches = 0;
+	double max_deviation = 0.0;
+	for (int i = 0; i < num_problems; i++) {
+		if (n_sols_companion[i] != n_sols_sturm[i]) {
+			num_count_mismatches++;
+			continue;
+		}
+		for (int j = 0; j < n_sols_sturm[i]; j++) {
+			double min_deviation = std::numeric_limits<double>::max();
+			for (int k = 0; k < n_sols_companion[i]; k++) {
+				min_deviation = std::min(min_deviation,
+					(solutions_sturm[i].col(j) - solutions_companion[i].col(k)).norm());
+			}
+			max_deviation = std::max(max_deviation, min_deviation);
+		}
+	}
+
+	std::cout << "\nspeedup: " << ns_companion / ns_sturm << "x\n";
+	std::cout << "problems with a different number of solutions: " << num_count_mismatches << "\n";
+	std::cout << "max deviation of matching solutions: " << max_deviation << "\n";
+}
@@ -8,12 +8,58 @@
 #pragma once
 #include <complex>
 #include <Eigen/Dense>
+#include "sturm.h"
 
 /*
- * Order of coefficients is:  x^2, xy, xz, y^2, yz, z^2, x, y, z, 1.0;
- *
+ * The real roots of the univariate degree-8 polynomial are found with Sturm
+ * sequences by default. Define RE3Q3_USE_COMPANION_MATRIX to instead compute
+ * all roots as the eigenvalues of the companion matrix and discard the complex
+ * ones.
+ */
+namespace re3q3_internal {
+
+/*
+ * Real roots of c(0)*x^8 + c(1)*x^7 + ... + c(8) from the companion matrix.
+ */
+inline int real_roots_companion_matrix(const Eigen::Matrix<double, 9, 1> &c, double *real_roots) {
+    Eigen::Matrix<double, 8, 8> comp_matrix;
+    comp_matrix << -c(1) / c(0), -c(2) / c(0), -c(3) / c(0), -c(4) / c(0), -c(5) / c(0), -c(6) / c(0), -c(7) / c(0), -c(8) / c(0),
+            1, 0, 0, 0, 0, 0, 0, 0,
+            0, 1, 0, 0, 0, 0, 0, 0,
+            0, 0, 1, 0, 0, 0, 0, 0,
+            0, 0, 0, 1, 0, 0, 0, 0,
+            0, 0, 0, 0, 1, 0, 0, 0,
+            0, 0, 0, 0, 0, 1, 0, 0,
+            0, 0, 0, 0, 0, 0, 1, 0;
+    
+    Eigen::EigenSolver<Eigen::Matrix<double, 8, 8>> es(comp_matrix, false);
+    Eigen::Matrix<std::complex<double>, 8, 1> roots = es.eigenvalues();
+
+    int num_real_roots = 0;
+    for (int i = 0; i < 8; i++) {
+        if (std::fabs(roots(i).imag()) > 1e-8) {
+            continue;
+        }
+        real_roots[num_real_roots++] = roots(i).real();
+    }
+    return num_real_roots;
+}
+
+/*
+ * Real roots of c(0)*x^8 + c(1)*x^7 + ... + c(8) from its Sturm sequence.
  */
-int re3q3(Eigen::Matrix<double, 3, 10> coeffs, Eigen::Matrix<double, 3, 8> *solutions, bool try_random_var_change = true) {
+inline int real_roots_sturm(const Eigen::Matrix<double, 9, 1> &c, double *real_roots) {
+    // Normalize to a monic polynomial with increasing powers, as done by the
+    // companion matrix.
+    double p[9];
+    for (int i = 0; i < 9; i++) {
+        p[i] = c(8 - i) / c(0);
+    }
+    return sturm::real_roots<8>(p, 8, real_roots);
+}
+
+template <bool UseSturm>
+int re3q3(Eigen::Matrix<double, 3, 10> coeffs, Eigen::Matrix<double, 3, 8> *solutions, bool try_random_var_change) {
     int elim_var = 1;
     
     Eigen::Matrix<double, 3, 3> Ax, Ay, Az;
@@ -54,7 +100,7 @@ int re3q3(Eigen::Matrix<double, 3, 10> coeffs, Eigen::Matrix<double, 3, 8> *solu
                 0, 0, 0, 0, 0, 0, 0, 0, 0, 1;
         coeffs = coeffs*B;
         
-        int n_sols = re3q3(coeffs, solutions, false);
+        int n_sols = re3q3<UseSturm>(coeffs, solutions, false);
         
         // Revert change of variables
         for(int k = 0; k < n_sols; k++) {
@@ -149,32 +195,15 @@ int re3q3(Eigen::Matrix<double, 3, 10> coeffs, Eigen::Matrix<double, 3, 8> *solu
     c(7) = a16*a29*a34-a19*a26*a34-a13*a29*a38+a19*a23*a38-a25*a34*a110-a26*a33*a110+a22*a38*a110+a23*a37*a110+a15*a34*a210+a16*a33*a210-a12*a38*a210-a13*a37*a210+a12*a26*a313+a13*a25*a313+a13*a26*a312-a15*a23*a313-a16*a22*a313-a16*a23*a312;
     c(8) = -a26*a34*a110+a23*a38*a110+a16*a34*a210-a13*a38*a210+a13*a26*a313-a16*a23*a313;
     
-    Eigen::Matrix<double, 8, 8> comp_matrix;
-    comp_matrix << -c(1) / c(0), -c(2) / c(0), -c(3) / c(0), -c(4) / c(0), -c(5) / c(0), -c(6) / c(0), -c(7) / c(0), -c(8) / c(0),
-            1, 0, 0, 0, 0, 0, 0, 0,
-            0, 1, 0, 0, 0, 0, 0, 0,
-            0, 0, 1, 0, 0, 0, 0, 0,
-            0, 0, 0, 1, 0, 0, 0, 0,
-            0, 0, 0, 0, 1, 0, 0, 0,
-            0, 0, 0, 0, 0, 1, 0, 0,
-            0, 0, 0, 0, 0, 0, 1, 0;
-    
-    
-    
-    Eigen::EigenSolver<Eigen::Matrix<double, 8, 8>> es(comp_matrix, false);
-    Eigen::Matrix<std::complex<double>, 8, 1> roots = es.eigenvalues();
+    double roots[8];
+    const int num_roots = UseSturm ? real_roots_sturm(c, roots) : real_roots_companion_matrix(c, roots);
     
     Eigen::Matrix<double, 3, 3> A;
     
     int root_cnt = 0;
-    for (int i = 0; i < 8; i++)
+    for (int i = 0; i < num_roots; i++)
     {
-        
-        if (std::fabs(roots(i).imag()) > 1e-8) {
-            continue;
-        }
-        
-        double xs1 = roots[i].real();
+        double xs1 = roots[i];
         double xs2 = xs1 * xs1;
         double xs3 = xs1 * xs2;
         double xs4 = xs1 * xs3;
@@ -198,3 +227,17 @@ int re3q3(Eigen::Matrix<double, 3, 10> coeffs, Eigen::Matrix<double, 3, 8> *solu
     
     return root_cnt;
 }
+
+}  // namespace re3q3_internal
+
+/*
+ * Order of coefficients is:  x^2, xy, xz, y^2, yz, z^2, x, y, z, 1.0;
+ *
+ */
+inline int re3q3(const Eigen::Matrix<double, 3, 10> &coeffs, Eigen::Matrix<double, 3, 8> *solutions, bool try_random_var_change = true) {
+#ifdef RE3Q3_USE_COMPANION_MATRIX
+    return re3q3_internal::re3q3<false>(coeffs, solutions, try_random_var_change);
+#else
+    return re3q3_internal::re3q3<true>(coeffs, solutions, try_random_var_change);
+#endif
+}
@@ -0,0 +1,243 @@
+/*
+ * sturm.h
+ * Real root isolation of univariate polynomials using Sturm sequences.
+ * The roots are bracketed by bisection on the number of sign changes of the
+ * Sturm sequence and then polished with safeguarded Newton iterations.
+ * In contrast to the eigenvalues of the companion matrix, only the real roots
+ * are computed, which is considerably faster for small degrees.
+ */
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+namespace sturm {
+
+/*
+ * Evaluates the polynomial with coefficients p[0] + p[1]*x + ... + p[deg]*x^deg.
+ */
+inline double polyval(const double *p, int deg, double x) {
+    double v = p[deg];
+    for (int i = deg - 1; i >= 0; --i) {
+        v = v * x + p[i];
+    }
+    return v;
+}
+
+/*
+ * Evaluates the polynomial and its derivative.
+ */
+inline void polyval_deriv(const double *p, int deg, double x, double *v, double *dv) {
+    *v = p[deg];
+    *dv = 0.0;
+    for (int i = deg - 1; i >= 0; --i) {
+        *dv = *dv * x + *v;
+        *v = *v * x + p[i];
+    }
+}
+
+/*
+ * Sturm sequence of a polynomial up to degree MaxDeg, where the polynomials
+ * are stored with increasing powers.
+ */
+template <int MaxDeg>
+struct Sequence {
+    double p[MaxDeg + 1][MaxDeg + 1];
+    int deg[MaxDeg + 1];
+    int size;
+
+    // Builds the sequence p_0 = p, p_1 = p', p_{k+1} = -rem(p_{k-1}, p_k).
+    // Returns false if the polynomial is of degree < 1.
+    bool build(const double *coeffs, int degree) {
+        while (degree > 0 && coeffs[degree] == 0.0) {
+            --degree;
+        }
+        if (degree < 1) {
+            size = 0;
+            return false;
+        }
+
+        for (int i = 0; i <= degree; ++i) {
+            p[0][i] = coeffs[i];
+        }
+        deg[0] = degree;
+        for (int i = 1; i <= degree; ++i) {
+            p[1][i - 1] = i * coeffs[i];
+        }
+        deg[1] = degree - 1;
+        size = 2;
+
+        double scale = 0.0;
+        for (int i = 0; i <= degree; ++i) {
+            scale = std::max(scale, std::fabs(coeffs[i]));
+        }
+
+        while (deg[size - 1] > 0) {
+            const double *a = p[size - 2];
+            const double *b = p[size - 1];
+            const int deg_a = deg[size - 2];
+            const int deg_b = deg[size - 1];
+
+            // Polynomial long division of a by b, keeping only the remainder.
+            double r[MaxDeg + 1];
+            for (int i = 0; i <= deg_a; ++i) {
+                r[i] = a[i];
+            }
+            for (int i = deg_a; i >= deg_b; --i) {
+                const double q = r[i] / b[deg_b];
+                for (int j = 0; j <= deg_b; ++j) {
+                    r[i - deg_b + j] -= q * b[j];
+                }
+            }
+
+            // The remainder vanishes for polynomials with multiple roots, in
+            // which case the sequence ends with their greatest common divisor.
+            int deg_r = deg_b - 1;
+            double max_r = 0.0;
+            for (int i = 0; i <= deg_r; ++i) {
+                max_r = std::max(max_r, std::fabs(r[i]));
+            }
+            if (max_r <= 1e-14 * scale) {
+                break;
+            }
+            while (deg_r > 0 && std::fabs(r[deg_r]) <= 1e-14 * max_r) {
+                --deg_r;
+            }
+
+            // Normalize to unit maximum coefficient to avoid overflow.
+            for (int i = 0; i <= deg_r; ++i) {
+                p[size][i] = -r[i] / max_r;
+            }
+            deg[size] = deg_r;
+            ++size;
+        }
+        return true;
+    }
+
+    // Number of sign changes of the sequence evaluated at x.
+    int sign_changes(double x) const {
+        int changes = 0;
+        double prev = 0.0;
+        for (int k = 0; k < size; ++k) {
+            const double v = polyval(p[k], deg[k], x);
+            if (v == 0.0) {
+                continue;
+            }
+            if ((prev < 0.0 && v > 0.0) || (prev > 0.0 && v < 0.0)) {
+                ++changes;
+            }
+            prev = v;
+        }
+        return changes;
+    }
+};
+
+/*
+ * Upper bound on the absolute value of the real roots (Fujiwara's bound).
+ */
+inline double root_bound(const double *p, int deg) {
+    double bound = 0.0;
+    for (int i = 0; i < deg; ++i) {
+        const double ratio = std::fabs(p[i] / p[deg]);
+        if (i == 0) {
+            bound = std::max(bound, std::pow(0.5 * ratio, 1.0 / deg));
+        } else {
+            bound = std::max(bound, std::pow(ratio, 1.0 / (deg - i)));
+        }
+    }
+    return 2.0 * bound;
+}
+
+/*
+ * Refines the single root in [lower, upper] to machine precision with Newton
+ * iterations, falling back to bisection whenever the step leaves the bracket.
+ */
+inline double polish_root(const double *p, int deg, double lower, double upper) {
+    double f_lower = polyval(p, deg, lower);
+    double x = 0.5 * (lower + upper);
+    for (int iter = 0; iter < 100; ++iter) {
+        double f, df;
+        polyval_deriv(p, deg, x, &f, &df);
+        if (f == 0.0) {
+            return x;
+        }
+        if ((f < 0.0) == (f_lower < 0.0)) {
+            lower = x;
+            f_lower = f;
+        } else {
+            upper = x;
+        }
+
+        double x_next = x - f / df;
+        if (!(x_next > lower && x_next < upper)) {
+            x_next = 0.5 * (lower + upper);
+        }
+        if (std::fabs(x_next - x) <= 1e-15 * std::max(1.0, std::fabs(x))) {
+            return x_next;
+        }
+        x = x_next;
+    }
+    return x;
+}
+
+/*
+ * Computes the distinct real roots of the polynomial
+ * p[0] + p[1]*x + ... + p[deg]*x^deg in increasing order, where deg <= MaxDeg.
+ * Returns the number of roots.
+ */
+template <int MaxDeg>
+int real_roots(const double *p, int deg, double *roots) {
+    Sequence<MaxDeg> seq;
+    if (!seq.build(p, deg)) {
+        return 0;
+    }
+    deg = seq.deg[0];
+
+    const double bound = root_bound(p, deg);
+
+    struct Interval {
+        double lower, upper;
+        int changes_lower, changes_upper;
+    };
+
+    // Intervals are processed depth-first, left before right, so that the
+    // roots are found in increasing order.
+    Interval stack[128];
+    int stack_size = 0;
+    stack[stack_size++] = {-bound, bound, seq.sign_changes(-bound), seq.sign_changes(bound)};
+
+    int num_roots = 0;
+    while (stack_size > 0) {
+        const Interval interval = stack[--stack_size];
+        const int num_interval_roots = interval.changes_lower - interval.changes_upper;
+        if (num_interval_roots <= 0) {
+            continue;
+        }
+
+        const double width = interval.upper - interval.lower;
+        const bool converged = width <= 1e-14 * std::max(1.0, std::fabs(interval.lower));
+
+        if (num_interval_roots == 1 || converged || stack_size + 2 > 128) {
+            const double f_lower = polyval(p, deg, interval.lower);
+            const double f_upper = polyval(p, deg, interval.upper);
+            if (num_interval_roots == 1 && ((f_lower < 0.0) != (f_upper < 0.0))) {
+                roots[num_roots++] = polish_root(p, deg, interval.lower, interval.upper);
+                continue;
+            } else if (converged || stack_size + 2 > 128) {
+                // Clustered or multiple roots that cannot be separated.
+                roots[num_roots++] = 0.5 * (interval.lower + interval.upper);
+                continue;
+            }
+            // A root of even multiplicity without a sign change is further
+            // isolated by bisection.
+        }
+
+        const double mid = 0.5 * (interval.lower + interval.upper);
+        const int changes_mid = seq.sign_changes(mid);
+        stack[stack_size++] = {mid, interval.upper, changes_mid, interval.changes_upper};
+        stack[stack_size++] = {interval.lower, mid, interval.changes_lower, changes_mid};
+    }
+
+    return num_roots;
+}
+
+}  // namespace sturm
@@ -31,10 +31,12 @@
 
 #include "base/camera.h"
 
+#include <algorithm>
 #include <iomanip>
 
 #include "base/camera_models.h"
 #include "util/logging.h"
+#include "util/memory.h"
 #include "util/misc.h"
 
 namespace colmap {
@@ -214,6 +216,27 @@ Eigen::Vector2d Camera::ImageToWorld(const Eigen::Vector2d& image_point) const {
   return world_point;
 }
 
+std::vector<Eigen::Vector2d> Camera::ImageToWorld(
+    const std::vector<Eigen::Vector2d>& image_points,
+    const ImageToWorldGrid* grid) const {
+  std::vector<Eigen::Vector2d> world_points(image_points.size());
+  if (grid == nullptr) {
+    const Eigen::Matrix3d K = CalibrationMatrix();
+    for (size_t i = 0; i < image_points.size(); ++i) {
+      world_points[i](0) = (image_points[i](0) - K(0, 2)) / K(0, 0);
+      world_points[i](1) = (image_points[i](1) - K(1, 2)) / K(1, 1);
+    }
+  } else {
+    for (size_t i = 0; i < image_points.size(); ++i) {
+      world_points[i] = grid->Interpolate(image_points[i]);
+    }
+  }
+
+  CameraModelImageToWorld(model_id_, params_, image_points, &world_points);
+
+  return world_points;
+}
+
 double Camera::ImageToWorldThreshold(const double threshold) const {
   return CameraModelImageToWorldThreshold(model_id_, params_, threshold);
 }
@@ -266,4 +289,46 @@ void Camera::Rescale(const size_t width, const size_t height) {
   }
 }
 
+size_t Camera::NumBytes() const {
+  return sizeof(Camera) + VectorNumBytes(params_);
+}
+
+ImageToWorldGrid::ImageToWorldGrid(const Camera& camera, const int num_cells)
+    : num_cells_(num_cells),
+      cell_width_(camera.Width() / static_cast<double>(num_cells)),
+      cell_height_(camera.Height() / static_cast<double>(num_cells)) {
+  CHECK_GT(num_cells, 0);
+  CHECK_GT(camera.Width(), 0);
+  CHECK_GT(camera.Height(), 0);
+
+  std::vector<Eigen::Vector2d> image_points;
+  image_points.reserve((num_cells_ + 1) * (num_cells_ + 1));
+  for (int row = 0; row <= num_cells_; ++row) {
+    for (int col = 0; col <= num_cells_; ++col) {
+      image_points.emplace_back(col * cell_width_, row * cell_height_);
+    }
+  }
+
+  world_points_ = camera.ImageToWorld(image_points);
+}
+
+Eigen::Vector2d ImageToWorldGrid::Interpolate(
+    const Eigen::Vector2d& image_point) const {
+  const double col = image_point(0) / cell_width_;
+  const double row = image_point(1) / cell_height_;
+  const int col0 = std::min(std::max(static_cast<int>(std::floor(col)), 0),
+                            num_cells_ - 1);
+  const int row0 = std::min(std::max(static_cast<int>(std::floor(row)), 0),
+                            num_cells_ - 1);
+  const double dcol = col - col0;
+  const double drow = row - row0;
+
+  const size_t idx00 = row0 * (num_cells_ + 1) + col0;
+  const size_t idx10 = idx00 + num_cells_ + 1;
+  return (1 - drow) * ((1 - dcol) * world_points_[idx00] +
+                       dcol * world_points_[idx00 + 1]) +
+         drow * ((1 - dcol) * world_points_[idx10] +
+                 dcol * world_points_[idx10 + 1]);
+}
+
 }  // namespace colmap
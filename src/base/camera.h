@@ -38,6 +38,8 @@
 
 namespace colmap {
 
+class ImageToWorldGrid;
+
 // Camera class that holds the intrinsic parameters. Cameras may be shared
 // between multiple images, e.g., if the same "physical" camera took multiple
 // pictures with the exact same lens and intrinsics (focal length, etc.).
@@ -130,6 +132,15 @@ class Camera {
   // Project point in image plane to world / infinity.
   Eigen::Vector2d ImageToWorld(const Eigen::Vector2d& image_point) const;
 
+  // Project many points in image plane to world / infinity. This is much
+  // faster than projecting the points individually for cameras with
+  // distortion. Without a grid, the iterative inversion of the distortion
+  // starts from the points lifted without distortion. A grid built for this
+  // camera provides better starting points for strongly distorted cameras.
+  std::vector<Eigen::Vector2d> ImageToWorld(
+      const std::vector<Eigen::Vector2d>& image_points,
+      const ImageToWorldGrid* grid = nullptr) const;
+
   // Convert pixel threshold in image plane to world space.
   double ImageToWorldThreshold(const double threshold) const;
 
@@ -141,6 +152,9 @@ class Camera {
   void Rescale(const double scale);
   void Rescale(const size_t width, const size_t height);
 
+  // Estimated size of the camera in memory in bytes.
+  size_t NumBytes() const;
+
  private:
   // The unique identifier of the camera. If the identifier is not specified
   // it is set to `kInvalidCameraId`.
@@ -163,6 +177,27 @@ class Camera {
   bool prior_focal_length_;
 };
 
+// World coordinates of a regular grid of image points of a camera, which are
+// bilinearly interpolated to seed `Camera::ImageToWorld` for many points. Only
+// worth building for cameras with distortion, and only valid as long as the
+// parameters of the camera do not change.
+class ImageToWorldGrid {
+ public:
+  explicit ImageToWorldGrid(const Camera& camera, const int num_cells = 32);
+
+  // Interpolate the world coordinates of an image point. Points outside of
+  // the image are linearly extrapolated from the closest grid cell.
+  Eigen::Vector2d Interpolate(const Eigen::Vector2d& image_point) const;
+
+ private:
+  int num_cells_;
+  double cell_width_;
+  double cell_height_;
+  // World coordinates of the (num_cells + 1) x (num_cells + 1) grid points in
+  // row-major order.
+  std::vector<Eigen::Vector2d> world_points_;
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 // Implementation
 ////////////////////////////////////////////////////////////////////////////////
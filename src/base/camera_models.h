@@ -173,6 +173,15 @@ struct BaseCameraModel {
 
   template <typename T>
   static inline void IterativeUndistortion(const T* params, T* u, T* v);
+
+  // Refine estimates of the world coordinates of many image points with
+  // Newton's method on `WorldToImage`. In contrast to `IterativeUndistortion`,
+  // the Jacobian is computed exactly by automatic differentiation, which takes
+  // a single evaluation of the model per iteration instead of five.
+  static inline void IterativeImageToWorld(const double* params,
+                                           const size_t num_points,
+                                           const Eigen::Vector2d* image_points,
+                                           Eigen::Vector2d* world_points);
 };
 
 // Simple Pinhole camera model.
@@ -449,6 +458,23 @@ inline void CameraModelImageToWorld(const int model_id,
                                     const double x, const double y, double* u,
                                     double* v);
 
+// Transform many image points to world coordinates in camera coordinate system.
+//
+// The world coordinates must be initialized with estimates, which are then
+// refined to be consistent with `CameraModelWorldToImage`. Better initial
+// estimates require fewer iterations. Camera models with a closed-form
+// `ImageToWorld` ignore the estimates.
+//
+// @param model_id      Unique identifier of camera model.
+// @param params        Array of camera parameters.
+// @param image_points  Image coordinates in pixels.
+// @param world_points  Initial and output coordinates in camera system as
+//                      (u, v, 1).
+inline void CameraModelImageToWorld(
+    const int model_id, const std::vector<double>& params,
+    const std::vector<Eigen::Vector2d>& image_points,
+    std::vector<Eigen::Vector2d>* world_points);
+
 // Convert pixel threshold in image plane to world space by dividing
 // the threshold through the mean focal length.
 //
@@ -587,6 +613,82 @@ void BaseCameraModel<CameraModel>::IterativeUndistortion(const T* params, T* u,
   *v = x(1);
 }
 
+// Whether `ImageToWorld` of a camera model is computed in closed form, in which
+// case there is nothing to gain from refining initial estimates.
+template <typename CameraModel>
+struct HasClosedFormImageToWorld {
+  static const bool value = false;
+};
+
+template <>
+struct HasClosedFormImageToWorld<SimplePinholeCameraModel> {
+  static const bool value = true;
+};
+
+template <>
+struct HasClosedFormImageToWorld<PinholeCameraModel> {
+  static const bool value = true;
+};
+
+template <>
+struct HasClosedFormImageToWorld<FOVCameraModel> {
+  static const bool value = true;
+};
+
+template <typename CameraModel>
+void BaseCameraModel<CameraModel>::IterativeImageToWorld(
+    const double* params, const size_t num_points,
+    const Eigen::Vector2d* image_points, Eigen::Vector2d* world_points) {
+  // Same stopping criteria as in `IterativeUndistortion`.
+  const size_t kNumIterations = 100;
+  const double kMaxStepNorm = 1e-10;
+
+  if (HasClosedFormImageToWorld<CameraModel>::value) {
+    for (size_t point_idx = 0; point_idx < num_points; ++point_idx) {
+      CameraModel::ImageToWorld(params, image_points[point_idx](0),
+                                image_points[point_idx](1),
+                                &world_points[point_idx](0),
+                                &world_points[point_idx](1));
+    }
+    return;
+  }
+
+  typedef ceres::Jet<double, 2> JetType;
+
+  JetType params_jet[CameraModel::kNumParams];
+  for (size_t i = 0; i < CameraModel::kNumParams; ++i) {
+    params_jet[i] = JetType(params[i]);
+  }
+
+  Eigen::Matrix2d J;
+  Eigen::Vector2d residual;
+  for (size_t point_idx = 0; point_idx < num_points; ++point_idx) {
+    const Eigen::Vector2d& image_point = image_points[point_idx];
+    Eigen::Vector2d& world_point = world_points[point_idx];
+    for (size_t i = 0; i < kNumIterations; ++i) {
+      const JetType u(world_point(0), 0);
+      const JetType v(world_point(1), 1);
+      JetType x;
+      JetType y;
+      CameraModel::WorldToImage(params_jet, u, v, &x, &y);
+      J(0, 0) = x.v(0);
+      J(0, 1) = x.v(1);
+      J(1, 0) = y.v(0);
+      J(1, 1) = y.v(1);
+      residual(0) = x.a - image_point(0);
+      residual(1) = y.a - image_point(1);
+      const Eigen::Vector2d step_x = J.inverse() * residual;
+      if (!step_x.allFinite()) {
+        break;
+      }
+      world_point -= step_x;
+      if (step_x.squaredNorm() < kMaxStepNorm) {
+        break;
+      }
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // SimplePinholeCameraModel
 
@@ -1512,6 +1614,25 @@ void CameraModelImageToWorld(const int model_id,
   }
 }
 
+void CameraModelImageToWorld(const int model_id,
+                             const std::vector<double>& params,
+                             const std::vector<Eigen::Vector2d>& image_points,
+                             std::vector<Eigen::Vector2d>* world_points) {
+  world_points->resize(image_points.size());
+  switch (model_id) {
+#define CAMERA_MODEL_CASE(CameraModel)                                     \
+  case CameraModel::kModelId:                                              \
+    CameraModel::IterativeImageToWorld(params.data(), image_points.size(), \
+                                       image_points.data(),                \
+                                       world_points->data());              \
+    break;
+
+    CAMERA_MODEL_SWITCH_CASES
+
+#undef CAMERA_MODEL_CASE
+  }
+}
+
 double CameraModelImageToWorldThreshold(const int model_id,
                                         const std::vector<double>& params,
                                         const double threshold) {
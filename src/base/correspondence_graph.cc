@@ -36,6 +36,7 @@
 #include <unordered_set>
 
 #include "base/pose.h"
+#include "util/memory.h"
 #include "util/string.h"
 
 namespace colmap {
@@ -262,4 +263,16 @@ bool CorrespondenceGraph::IsTwoViewObservation(
   return other_corrs.size() == 1;
 }
 
+size_t CorrespondenceGraph::NumBytes() const {
+  size_t num_bytes = sizeof(CorrespondenceGraph) + HashMapNumBytes(images_) +
+                     HashMapNumBytes(image_pairs_);
+  for (const auto& image : images_) {
+    num_bytes += VectorNumBytes(image.second.corrs);
+    for (const auto& corrs : image.second.corrs) {
+      num_bytes += VectorNumBytes(corrs);
+    }
+  }
+  return num_bytes;
+}
+
 }  // namespace colmap
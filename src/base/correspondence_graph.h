@@ -133,7 +133,13 @@ class CorrespondenceGraph {
   bool IsTwoViewObservation(const image_t image_id,
                             const point2D_t line_idx) const;
 
+  // Estimated size of the graph in memory in bytes.
+  size_t NumBytes() const;
+
  private:
+  // Snapshots of the database cache directly read and write the graph.
+  friend class DatabaseCache;
+
   struct Image {
     // Number of 2D points with at least one correspondence to another image.
     point2D_t num_observations = 0;
@@ -33,6 +33,7 @@
 
 #include "base/database.h"
 
+#include <algorithm>
 #include <fstream>
 
 #include "util/sqlite3_utils.h"
@@ -41,36 +42,89 @@
 namespace colmap {
 namespace {
 
+// Legacy line storage with the three line parameters and the alignment flag
+// as four floats per line.
 typedef Eigen::Matrix<float, Eigen::Dynamic, 4, Eigen::RowMajor>
-        FeatureLinesBlob;
+    FeatureLinesBlob;
 typedef Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
     FeatureDescriptorsBlob;
 typedef Eigen::Matrix<point2D_t, Eigen::Dynamic, 2, Eigen::RowMajor>
     FeatureMatchesBlob;
 
-void SwapFeatureMatchesBlob(FeatureMatchesBlob* matches) {
-  matches->col(0).swap(matches->col(1));
-}
 
-FeatureLinesBlob FeatureLinesToBlob(const FeatureLines& lines) {
-  FeatureLinesBlob blob(lines.size(), 4);
-  for (size_t i = 0; i < lines.size(); ++i) {
-    blob.row(i).leftCols<3>() = lines.at(i).Line().transpose().cast<float>();
-    blob.row(i)(3) = lines.at(i).IsAligned() ? 1 : 0;
+// The `cols` column of the `matches` table identifies the format of the blob.
+// Raw matches are stored as two `point2D_t` per match, while compressed
+// matches are sorted by `line_idx1` and stored as a varint of the delta to the
+// previous `line_idx1` followed by a varint of `line_idx2`. With at most a few
+// thousand lines per image, this takes 2-3 bytes per match instead of 8.
+const int kRawMatchesFormat = 2;
+const int kCompressedMatchesFormat = -1;
+
+// The `cols` column of the `line_features` table identifies the format of the
+// blob. Since the lines are normalized such that a^2 + b^2 = 1, a line is
+// fully described by the angle theta with (a, b) = (cos(theta), sin(theta))
+// and the offset c. Compact lines are stored as the two floats (theta, c) of
+// all lines, followed by one byte per line for the alignment flag.
+const int kCompactLinesFormat = -1;
+const size_t kNumBytesPerCompactLine = 2 * sizeof(float) + 1;
+
+void AppendVarint(uint32_t value, std::vector<uint8_t>* data) {
+  while (value >= 0x80) {
+    data->push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
   }
-  return blob;
+  data->push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t ReadVarint(const uint8_t** data, const uint8_t* data_end) {
+  uint32_t value = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    CHECK_LT(*data, data_end) << "Truncated match data";
+    const uint8_t byte = **data;
+    *data += 1;
+    value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  LOG(FATAL) << "Invalid varint in match data";
+  return value;
+}
+
+std::vector<uint8_t> CompressFeatureMatches(FeatureMatches matches) {
+  std::sort(matches.begin(), matches.end(),
+            [](const FeatureMatch& match1, const FeatureMatch& match2) {
+              if (match1.line_idx1 == match2.line_idx1) {
+                return match1.line_idx2 < match2.line_idx2;
+              }
+              return match1.line_idx1 < match2.line_idx1;
+            });
+
+  std::vector<uint8_t> data;
+  data.reserve(3 * matches.size());
+  point2D_t prev_line_idx1 = 0;
+  for (const auto& match : matches) {
+    AppendVarint(match.line_idx1 - prev_line_idx1, &data);
+    AppendVarint(match.line_idx2, &data);
+    prev_line_idx1 = match.line_idx1;
+  }
+
+  return data;
 }
 
-FeatureLines FeatureLinesFromBlob(const FeatureLinesBlob& blob) {
-  FeatureLines lines(static_cast<size_t>(blob.rows()));
-  for (int i = 0; i < blob.rows(); ++i) {
-    const Eigen::Vector3d line = blob.row(i).leftCols<3>().transpose().cast<double>();
-    // Normalize line to simplify distance computations
-    const double norm_factor = line.head<2>().norm();
-    lines.at(i).SetLine(line / norm_factor);
-    lines.at(i).SetAligned(blob.row(i)(3) > 0);
+FeatureMatches DecompressFeatureMatches(const uint8_t* data,
+                                        const size_t num_bytes,
+                                        const size_t num_matches) {
+  FeatureMatches matches(num_matches);
+  const uint8_t* data_end = data + num_bytes;
+  point2D_t line_idx1 = 0;
+  for (auto& match : matches) {
+    line_idx1 += ReadVarint(&data, data_end);
+    match.line_idx1 = line_idx1;
+    match.line_idx2 = ReadVarint(&data, data_end);
   }
-  return lines;
+  CHECK_EQ(data, data_end) << "Trailing match data";
+  return matches;
 }
 
 FeatureMatchesBlob FeatureMatchesToBlob(const FeatureMatches& matches) {
@@ -155,6 +209,99 @@ MatrixType ReadDynamicMatrixBlob(sqlite3_stmt* sql_stmt, const int rc,
   return matrix;
 }
 
+FeatureLines FeatureLinesFromBlob(const FeatureLinesBlob& blob) {
+  FeatureLines lines(static_cast<size_t>(blob.rows()));
+  for (int i = 0; i < blob.rows(); ++i) {
+    const Eigen::Vector3d line = blob.row(i).leftCols<3>().transpose().cast<double>();
+    // Normalize line to simplify distance computations
+    const double norm_factor = line.head<2>().norm();
+    lines.at(i).SetLine(line / norm_factor);
+    lines.at(i).SetAligned(blob.row(i)(3) > 0);
+  }
+  return lines;
+}
+
+std::vector<uint8_t> CompressFeatureLines(const FeatureLines& lines) {
+  const size_t num_lines = lines.size();
+  std::vector<uint8_t> data(num_lines * kNumBytesPerCompactLine);
+  uint8_t* flags = data.data() + num_lines * 2 * sizeof(float);
+  for (size_t i = 0; i < num_lines; ++i) {
+    const Eigen::Vector3d& line = lines[i].Line();
+    const double norm_factor = line.head<2>().norm();
+    double theta = std::atan2(line(1), line(0));
+    if (theta < 0) {
+      theta += 2 * M_PI;
+    }
+    const float params[2] = {static_cast<float>(theta),
+                             static_cast<float>(line(2) / norm_factor)};
+    memcpy(data.data() + i * sizeof(params), params, sizeof(params));
+    flags[i] = lines[i].IsAligned() ? 1 : 0;
+  }
+  return data;
+}
+
+FeatureLines DecompressFeatureLines(const uint8_t* data,
+                                    const size_t num_bytes,
+                                    const size_t num_lines) {
+  CHECK_EQ(num_bytes, num_lines * kNumBytesPerCompactLine)
+      << "Invalid line data";
+  FeatureLines lines(num_lines);
+  const uint8_t* flags = data + num_lines * 2 * sizeof(float);
+  for (size_t i = 0; i < num_lines; ++i) {
+    float params[2];
+    memcpy(params, data + i * sizeof(params), sizeof(params));
+    const double theta = static_cast<double>(params[0]);
+    lines[i].SetLine(Eigen::Vector3d(std::cos(theta), std::sin(theta),
+                                     static_cast<double>(params[1])));
+    lines[i].SetAligned(flags[i] != 0);
+  }
+  return lines;
+}
+
+// Read the lines of a `line_features` row, where the format is determined
+// by the `cols` column of the row.
+FeatureLines ReadFeatureLinesRow(sqlite3_stmt* sql_stmt, const int rc,
+                                 const int col) {
+  if (rc == SQLITE_ROW &&
+      sqlite3_column_int64(sql_stmt, col + 1) == kCompactLinesFormat) {
+    const size_t num_lines =
+        static_cast<size_t>(sqlite3_column_int64(sql_stmt, col + 0));
+    const size_t num_bytes =
+        static_cast<size_t>(sqlite3_column_bytes(sql_stmt, col + 2));
+    return DecompressFeatureLines(
+        reinterpret_cast<const uint8_t*>(
+            sqlite3_column_blob(sql_stmt, col + 2)),
+        num_bytes, num_lines);
+  }
+  return FeatureLinesFromBlob(
+      ReadDynamicMatrixBlob<FeatureLinesBlob>(sql_stmt, rc, col));
+}
+
+// Read the matches of a `rows, cols, data` triplet of the `matches` table in
+// the order of the stored pair identifier, in either storage format.
+FeatureMatches ReadFeatureMatchesRow(sqlite3_stmt* sql_stmt, const int rc,
+                                     const int col) {
+  if (rc == SQLITE_ROW &&
+      sqlite3_column_int64(sql_stmt, col + 1) == kCompressedMatchesFormat) {
+    const size_t num_matches =
+        static_cast<size_t>(sqlite3_column_int64(sql_stmt, col + 0));
+    const size_t num_bytes =
+        static_cast<size_t>(sqlite3_column_bytes(sql_stmt, col + 2));
+    return DecompressFeatureMatches(
+        reinterpret_cast<const uint8_t*>(
+            sqlite3_column_blob(sql_stmt, col + 2)),
+        num_bytes, num_matches);
+  }
+  return FeatureMatchesFromBlob(
+      ReadDynamicMatrixBlob<FeatureMatchesBlob>(sql_stmt, rc, col));
+}
+
+void SwapFeatureMatches(FeatureMatches* matches) {
+  for (auto& match : *matches) {
+    std::swap(match.line_idx1, match.line_idx2);
+  }
+}
+
 template <typename MatrixType>
 void WriteStaticMatrixBlob(sqlite3_stmt* sql_stmt, const MatrixType& matrix,
                            const int col) {
@@ -233,11 +380,25 @@ std::mutex Database::update_schema_mutex_;
 
 Database::Database() : database_(nullptr) {}
 
-Database::Database(const std::string& path, const bool create_line_table) : Database() { Open(path, create_line_table); }
+bool DatabaseOptions::Check() const {
+  CHECK_OPTION_GE(mmap_size, 0);
+  CHECK_OPTION_GE(cache_size, 0);
+  CHECK_OPTION_GE(busy_timeout, 0);
+  return true;
+}
+
+Database::Database(const std::string& path, const bool create_line_table,
+                   const DatabaseOptions& options)
+    : Database() {
+  Open(path, create_line_table, options);
+}
 
 Database::~Database() { Close(); }
 
-void Database::Open(const std::string& path, const bool create_line_table) {
+void Database::Open(const std::string& path, const bool create_line_table,
+                    const DatabaseOptions& options) {
+  CHECK(options.Check());
+
   Close();
 
   // SQLITE_OPEN_NOMUTEX specifies that the connection should not have a
@@ -249,11 +410,29 @@ void Database::Open(const std::string& path, const bool create_line_table) {
       SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX,
       nullptr));
 
+  // Wait for locks held by other connections instead of failing immediately
+  SQLITE3_CALL(sqlite3_busy_timeout(database_, options.busy_timeout));
+
   // Don't wait for the operating system to write the changes to disk
   SQLITE3_EXEC(database_, "PRAGMA synchronous=OFF", nullptr);
 
   // Use faster journaling mode
-  SQLITE3_EXEC(database_, "PRAGMA journal_mode=WAL", nullptr);
+  if (options.use_wal) {
+    SQLITE3_EXEC(database_, "PRAGMA journal_mode=WAL", nullptr);
+  } else {
+    SQLITE3_EXEC(database_, "PRAGMA journal_mode=DELETE", nullptr);
+  }
+
+  // Read through memory-mapped I/O instead of copying pages into user space
+  const std::string mmap_size_sql =
+      StringPrintf("PRAGMA mmap_size=%lld",
+                   static_cast<long long>(options.mmap_size) * 1024 * 1024);
+  SQLITE3_EXEC(database_, mmap_size_sql.c_str(), nullptr);
+
+  // Negative values specify the cache size in KiB instead of pages
+  const std::string cache_size_sql =
+      StringPrintf("PRAGMA cache_size=-%d", options.cache_size);
+  SQLITE3_EXEC(database_, cache_size_sql.c_str(), nullptr);
 
   // Store temporary tables and indices in memory
   SQLITE3_EXEC(database_, "PRAGMA temp_store=MEMORY", nullptr);
@@ -278,6 +457,45 @@ void Database::Close() {
   }
 }
 
+bool Database::IsReadable(const std::string& path) {
+  sqlite3* database = nullptr;
+  if (sqlite3_open_v2(path.c_str(), &database, SQLITE_OPEN_READONLY,
+                      nullptr) != SQLITE_OK) {
+    sqlite3_close_v2(database);
+    return false;
+  }
+
+  // Runs the statement and checks that its first result is the given text.
+  const auto QueryEquals = [database](const std::string& sql,
+                                      const std::string& expected) {
+    sqlite3_stmt* sql_stmt = nullptr;
+    bool equals = false;
+    if (sqlite3_prepare_v2(database, sql.c_str(), -1, &sql_stmt, nullptr) ==
+            SQLITE_OK &&
+        sqlite3_step(sql_stmt) == SQLITE_ROW) {
+      const char* text =
+          reinterpret_cast<const char*>(sqlite3_column_text(sql_stmt, 0));
+      equals = text != nullptr && expected == text;
+    }
+    sqlite3_finalize(sql_stmt);
+    return equals;
+  };
+
+  // The quick check detects truncated and otherwise corrupted files.
+  bool readable = QueryEquals("PRAGMA quick_check;", "ok");
+  for (const std::string table_name :
+       {"cameras", "images", "line_features", "descriptors"}) {
+    readable = readable && QueryEquals("SELECT name FROM sqlite_master WHERE "
+                                       "type='table' AND name='" +
+                                           table_name + "';",
+                                       table_name);
+  }
+
+  sqlite3_close_v2(database);
+
+  return readable;
+}
+
 void Database::CloneTo(Database* target) {
   sqlite3_backup* backup_obj =
       sqlite3_backup_init(target->database_, "main", database_, "main");
@@ -328,6 +546,18 @@ bool Database::ExistsImageGravity(const image_t image_id) const {
   return ExistsRowId(sql_stmt_exists_gravity_, image_id);
 }
 
+std::unordered_set<image_t> Database::ExistingDescriptorImageIds() const {
+  return ReadImageIds(sql_stmt_exists_descriptors_all_);
+}
+
+std::unordered_set<image_t> Database::ExistingLineFeatureImageIds() const {
+  return ReadImageIds(sql_stmt_exists_lines_all_);
+}
+
+std::unordered_set<image_t> Database::ExistingGravityImageIds() const {
+  return ReadImageIds(sql_stmt_exists_gravity_all_);
+}
+
 size_t Database::NumCameras() const { return CountRows("cameras"); }
 
 size_t Database::NumImages() const { return CountRows("images"); }
@@ -425,12 +655,50 @@ FeatureLines Database::ReadFeatureLines(const image_t image_id) const {
   SQLITE3_CALL(sqlite3_bind_int64(sql_stmt_read_lines_, 1, image_id));
 
   const int rc = SQLITE3_CALL(sqlite3_step(sql_stmt_read_lines_));
-  const FeatureLinesBlob blob = ReadDynamicMatrixBlob<FeatureLinesBlob>(
-          sql_stmt_read_lines_, rc, 0);
+  FeatureLines lines = ReadFeatureLinesRow(sql_stmt_read_lines_, rc, 0);
 
   SQLITE3_CALL(sqlite3_reset(sql_stmt_read_lines_));
 
-  return FeatureLinesFromBlob(blob);
+  return lines;
+}
+
+std::unordered_map<image_t, FeatureLines> Database::ReadAllFeatureLines()
+    const {
+  std::unordered_map<image_t, FeatureLines> all_lines;
+
+  int rc;
+  while ((rc = SQLITE3_CALL(sqlite3_step(sql_stmt_read_lines_all_))) ==
+         SQLITE_ROW) {
+    const image_t image_id = static_cast<image_t>(
+        sqlite3_column_int64(sql_stmt_read_lines_all_, 0));
+    all_lines.emplace(image_id,
+                      ReadFeatureLinesRow(sql_stmt_read_lines_all_, rc, 1));
+  }
+
+  SQLITE3_CALL(sqlite3_reset(sql_stmt_read_lines_all_));
+
+  return all_lines;
+}
+
+std::unordered_map<image_t, FeatureLines> Database::ReadFeatureLines(
+    const std::unordered_set<image_t>& image_ids) const {
+  std::unordered_map<image_t, FeatureLines> lines;
+  lines.reserve(image_ids.size());
+
+  int rc;
+  while ((rc = SQLITE3_CALL(sqlite3_step(sql_stmt_read_lines_all_))) ==
+         SQLITE_ROW) {
+    const image_t image_id = static_cast<image_t>(
+        sqlite3_column_int64(sql_stmt_read_lines_all_, 0));
+    if (image_ids.count(image_id) > 0) {
+      lines.emplace(image_id,
+                    ReadFeatureLinesRow(sql_stmt_read_lines_all_, rc, 1));
+    }
+  }
+
+  SQLITE3_CALL(sqlite3_reset(sql_stmt_read_lines_all_));
+
+  return lines;
 }
 
 Eigen::Vector3d Database::ReadImageGravity(const image_t image_id) const {
@@ -454,6 +722,25 @@ Eigen::Vector3d Database::ReadImageGravity(const image_t image_id) const {
   return gravity;
 }
 
+std::unordered_map<image_t, Eigen::Vector3d> Database::ReadAllGravity() const {
+  std::unordered_map<image_t, Eigen::Vector3d> all_gravity;
+
+  while (SQLITE3_CALL(sqlite3_step(sql_stmt_read_gravity_all_)) ==
+         SQLITE_ROW) {
+    const image_t image_id = static_cast<image_t>(
+        sqlite3_column_int64(sql_stmt_read_gravity_all_, 0));
+    Eigen::Vector3d gravity;
+    for (int i = 0; i < 3; ++i) {
+      gravity(i) = sqlite3_column_double(sql_stmt_read_gravity_all_, i + 1);
+    }
+    all_gravity.emplace(image_id, gravity);
+  }
+
+  SQLITE3_CALL(sqlite3_reset(sql_stmt_read_gravity_all_));
+
+  return all_gravity;
+}
+
 FeatureDescriptors Database::ReadDescriptors(const image_t image_id) const {
   SQLITE3_CALL(sqlite3_bind_int64(sql_stmt_read_descriptors_, 1, image_id));
 
@@ -473,16 +760,16 @@ FeatureMatches Database::ReadMatches(image_t image_id1,
   SQLITE3_CALL(sqlite3_bind_int64(sql_stmt_read_matches_, 1, pair_id));
 
   const int rc = SQLITE3_CALL(sqlite3_step(sql_stmt_read_matches_));
-  FeatureMatchesBlob blob =
-      ReadDynamicMatrixBlob<FeatureMatchesBlob>(sql_stmt_read_matches_, rc, 0);
+  FeatureMatches matches =
+      ReadFeatureMatchesRow(sql_stmt_read_matches_, rc, 0);
 
   SQLITE3_CALL(sqlite3_reset(sql_stmt_read_matches_));
 
   if (SwapImagePair(image_id1, image_id2)) {
-    SwapFeatureMatchesBlob(&blob);
+    SwapFeatureMatches(&matches);
   }
 
-  return FeatureMatchesFromBlob(blob);
+  return matches;
 }
 
 std::vector<std::pair<image_pair_t, FeatureMatches>> Database::ReadAllMatches()
@@ -494,9 +781,8 @@ std::vector<std::pair<image_pair_t, FeatureMatches>> Database::ReadAllMatches()
          SQLITE_ROW) {
     const image_pair_t pair_id = static_cast<image_pair_t>(
         sqlite3_column_int64(sql_stmt_read_matches_all_, 0));
-    const FeatureMatchesBlob blob = ReadDynamicMatrixBlob<FeatureMatchesBlob>(
-        sql_stmt_read_matches_all_, rc, 1);
-    all_matches.emplace_back(pair_id, FeatureMatchesFromBlob(blob));
+    all_matches.emplace_back(
+        pair_id, ReadFeatureMatchesRow(sql_stmt_read_matches_all_, rc, 1));
   }
 
   SQLITE3_CALL(sqlite3_reset(sql_stmt_read_matches_all_));
@@ -504,6 +790,61 @@ std::vector<std::pair<image_pair_t, FeatureMatches>> Database::ReadAllMatches()
   return all_matches;
 }
 
+std::vector<std::pair<image_pair_t, FeatureMatches>>
+Database::ReadMatchesAfterImage(const image_t image_id) const {
+  std::vector<std::pair<image_pair_t, FeatureMatches>> matches;
+
+  SQLITE3_CALL(sqlite3_bind_int64(sql_stmt_read_matches_after_image_, 1,
+                                  static_cast<sqlite3_int64>(image_id)));
+
+  int rc;
+  while ((rc = SQLITE3_CALL(
+              sqlite3_step(sql_stmt_read_matches_after_image_))) ==
+         SQLITE_ROW) {
+    const image_pair_t pair_id = static_cast<image_pair_t>(
+        sqlite3_column_int64(sql_stmt_read_matches_after_image_, 0));
+    matches.emplace_back(
+        pair_id,
+        ReadFeatureMatchesRow(sql_stmt_read_matches_after_image_, rc, 1));
+  }
+
+  SQLITE3_CALL(sqlite3_reset(sql_stmt_read_matches_after_image_));
+
+  return matches;
+}
+
+std::array<uint64_t, 3> Database::ReadMatchesFingerprint(
+    const image_t max_image_id) const {
+  // The pairs of the images up to the given identifier have pair identifiers
+  // below `kMaxNumImages * max_image_id`, which limits the scanned range.
+  const std::string sql =
+      "SELECT COUNT(*), MAX(pair_id), SUM(rows) FROM matches "
+      "WHERE pair_id < ? AND pair_id % " +
+      std::to_string(kMaxNumImages) + " <= ? AND rows > 0;";
+
+  sqlite3_stmt* sql_stmt;
+  SQLITE3_CALL(sqlite3_prepare_v2(database_, sql.c_str(), -1, &sql_stmt, 0));
+
+  SQLITE3_CALL(sqlite3_bind_int64(
+      sql_stmt, 1,
+      static_cast<sqlite3_int64>(static_cast<image_pair_t>(kMaxNumImages) *
+                                 max_image_id)));
+  SQLITE3_CALL(
+      sqlite3_bind_int64(sql_stmt, 2, static_cast<sqlite3_int64>(max_image_id)));
+
+  std::array<uint64_t, 3> fingerprint = {{0, 0, 0}};
+  if (SQLITE3_CALL(sqlite3_step(sql_stmt)) == SQLITE_ROW) {
+    for (int i = 0; i < 3; ++i) {
+      fingerprint[i] =
+          static_cast<uint64_t>(sqlite3_column_int64(sql_stmt, i));
+    }
+  }
+
+  SQLITE3_CALL(sqlite3_finalize(sql_stmt));
+
+  return fingerprint;
+}
+
 void Database::ReadNumMatches(
     std::vector<std::pair<image_t, image_t> >* image_pairs,
     std::vector<int>* num_inliers) const {
@@ -591,10 +932,17 @@ image_t Database::WriteImage(const Image& image,
 
 void Database::WriteFeatureLines(const image_t image_id,
                               const FeatureLines& lines) const {
-  const FeatureLinesBlob blob = FeatureLinesToBlob(lines);
+  // Important: the compressed data must live until the query is executed.
+  const std::vector<uint8_t> data = CompressFeatureLines(lines);
 
   SQLITE3_CALL(sqlite3_bind_int64(sql_stmt_write_lines_, 1, image_id));
-  WriteDynamicMatrixBlob(sql_stmt_write_lines_, blob, 2);
+  SQLITE3_CALL(sqlite3_bind_int64(sql_stmt_write_lines_, 2,
+                                  static_cast<sqlite3_int64>(lines.size())));
+  SQLITE3_CALL(
+      sqlite3_bind_int64(sql_stmt_write_lines_, 3, kCompactLinesFormat));
+  SQLITE3_CALL(sqlite3_bind_blob(sql_stmt_write_lines_, 4, data.data(),
+                                 static_cast<int>(data.size()),
+                                 SQLITE_STATIC));
 
   SQLITE3_CALL(sqlite3_step(sql_stmt_write_lines_));
   SQLITE3_CALL(sqlite3_reset(sql_stmt_write_lines_));
@@ -614,15 +962,24 @@ void Database::WriteMatches(const image_t image_id1, const image_t image_id2,
   const image_pair_t pair_id = ImagePairToPairId(image_id1, image_id2);
   SQLITE3_CALL(sqlite3_bind_int64(sql_stmt_write_matches_, 1, pair_id));
 
-  // Important: the swapped data must live until the query is executed.
-  FeatureMatchesBlob blob = FeatureMatchesToBlob(matches);
+  // Important: the compressed data must live until the query is executed.
+  std::vector<uint8_t> data;
   if (SwapImagePair(image_id1, image_id2)) {
-    SwapFeatureMatchesBlob(&blob);
-    WriteDynamicMatrixBlob(sql_stmt_write_matches_, blob, 2);
+    FeatureMatches swapped_matches = matches;
+    SwapFeatureMatches(&swapped_matches);
+    data = CompressFeatureMatches(swapped_matches);
   } else {
-    WriteDynamicMatrixBlob(sql_stmt_write_matches_, blob, 2);
+    data = CompressFeatureMatches(matches);
   }
 
+  SQLITE3_CALL(sqlite3_bind_int64(sql_stmt_write_matches_, 2,
+                                  static_cast<sqlite3_int64>(matches.size())));
+  SQLITE3_CALL(
+      sqlite3_bind_int64(sql_stmt_write_matches_, 3, kCompressedMatchesFormat));
+  SQLITE3_CALL(sqlite3_bind_blob(sql_stmt_write_matches_, 4, data.data(),
+                                 static_cast<int>(data.size()),
+                                 SQLITE_STATIC));
+
   SQLITE3_CALL(sqlite3_step(sql_stmt_write_matches_));
   SQLITE3_CALL(sqlite3_reset(sql_stmt_write_matches_));
 }
@@ -701,8 +1058,81 @@ void Database::ClearMatches() const {
   SQLITE3_CALL(sqlite3_reset(sql_stmt_clear_matches_));
 }
 
-void Database::BeginTransaction() const {
-  SQLITE3_EXEC(database_, "BEGIN TRANSACTION", nullptr);
+size_t Database::CompressMatches() const {
+  // Convert the matches in batches of image pairs in the order of their
+  // identifiers, so that only one batch of decoded matches is held in memory.
+  const int kBatchSize = 1000;
+
+  const std::string select_sql = StringPrintf(
+      "SELECT pair_id, rows, cols, data FROM matches "
+      "WHERE cols = %d AND pair_id > ? ORDER BY pair_id LIMIT %d;",
+      kRawMatchesFormat, kBatchSize);
+  sqlite3_stmt* select_stmt;
+  SQLITE3_CALL(sqlite3_prepare_v2(database_, select_sql.c_str(), -1,
+                                  &select_stmt, 0));
+
+  const std::string update_sql =
+      "UPDATE matches SET cols = ?, data = ? WHERE pair_id = ?;";
+  sqlite3_stmt* update_stmt;
+  SQLITE3_CALL(sqlite3_prepare_v2(database_, update_sql.c_str(), -1,
+                                  &update_stmt, 0));
+
+  size_t num_converted_pairs = 0;
+  sqlite3_int64 last_pair_id = -1;
+  std::vector<std::pair<image_pair_t, FeatureMatches>> raw_matches;
+  raw_matches.reserve(kBatchSize);
+  while (true) {
+    // Collect the rows of the batch first, since the table must not be
+    // modified while the select statement is stepping through it.
+    raw_matches.clear();
+    SQLITE3_CALL(sqlite3_bind_int64(select_stmt, 1, last_pair_id));
+    int rc;
+    while ((rc = SQLITE3_CALL(sqlite3_step(select_stmt))) == SQLITE_ROW) {
+      const image_pair_t pair_id =
+          static_cast<image_pair_t>(sqlite3_column_int64(select_stmt, 0));
+      raw_matches.emplace_back(pair_id,
+                               ReadFeatureMatchesRow(select_stmt, rc, 1));
+    }
+    SQLITE3_CALL(sqlite3_reset(select_stmt));
+
+    if (raw_matches.empty()) {
+      break;
+    }
+
+    for (const auto& pair_matches : raw_matches) {
+      const std::vector<uint8_t> data =
+          CompressFeatureMatches(pair_matches.second);
+      SQLITE3_CALL(
+          sqlite3_bind_int64(update_stmt, 1, kCompressedMatchesFormat));
+      SQLITE3_CALL(sqlite3_bind_blob(update_stmt, 2, data.data(),
+                                     static_cast<int>(data.size()),
+                                     SQLITE_STATIC));
+      SQLITE3_CALL(sqlite3_bind_int64(
+          update_stmt, 3, static_cast<sqlite3_int64>(pair_matches.first)));
+      SQLITE3_CALL(sqlite3_step(update_stmt));
+      SQLITE3_CALL(sqlite3_reset(update_stmt));
+    }
+
+    num_converted_pairs += raw_matches.size();
+    last_pair_id = static_cast<sqlite3_int64>(raw_matches.back().first);
+  }
+
+  SQLITE3_CALL(sqlite3_finalize(select_stmt));
+  SQLITE3_CALL(sqlite3_finalize(update_stmt));
+
+  return num_converted_pairs;
+}
+
+void Database::Vacuum() const {
+  SQLITE3_EXEC(database_, "VACUUM;", nullptr);
+}
+
+void Database::BeginTransaction(const bool immediate) const {
+  if (immediate) {
+    SQLITE3_EXEC(database_, "BEGIN IMMEDIATE TRANSACTION", nullptr);
+  } else {
+    SQLITE3_EXEC(database_, "BEGIN TRANSACTION", nullptr);
+  }
 }
 
 void Database::EndTransaction() const {
@@ -751,6 +1181,11 @@ void Database::PrepareSQLStatements(const bool with_line_features) {
                                   &sql_stmt_exists_matches_, 0));
   sql_stmts_.push_back(sql_stmt_exists_matches_);
 
+  sql = "SELECT image_id FROM descriptors;";
+  SQLITE3_CALL(sqlite3_prepare_v2(database_, sql.c_str(), -1,
+                                  &sql_stmt_exists_descriptors_all_, 0));
+  sql_stmts_.push_back(sql_stmt_exists_descriptors_all_);
+
   if (with_line_features) {
       sql = "SELECT 1 FROM line_features WHERE image_id = ?;";
       SQLITE3_CALL(
@@ -763,6 +1198,18 @@ void Database::PrepareSQLStatements(const bool with_line_features) {
           sqlite3_prepare_v2(database_, sql.c_str(), -1,
               &sql_stmt_exists_gravity_, 0));
       sql_stmts_.push_back(sql_stmt_exists_gravity_);
+
+      sql = "SELECT image_id FROM line_features;";
+      SQLITE3_CALL(
+          sqlite3_prepare_v2(database_, sql.c_str(), -1,
+              &sql_stmt_exists_lines_all_, 0));
+      sql_stmts_.push_back(sql_stmt_exists_lines_all_);
+
+      sql = "SELECT image_id FROM gravity_directions;";
+      SQLITE3_CALL(
+          sqlite3_prepare_v2(database_, sql.c_str(), -1,
+              &sql_stmt_exists_gravity_all_, 0));
+      sql_stmts_.push_back(sql_stmt_exists_gravity_all_);
   }
 
   //////////////////////////////////////////////////////////////////////////////
@@ -835,11 +1282,22 @@ void Database::PrepareSQLStatements(const bool with_line_features) {
                                       &sql_stmt_read_lines_, 0));
       sql_stmts_.push_back(sql_stmt_read_lines_);
 
+      sql = "SELECT image_id, rows, cols, data FROM line_features;";
+      SQLITE3_CALL(sqlite3_prepare_v2(database_, sql.c_str(), -1,
+                                      &sql_stmt_read_lines_all_, 0));
+      sql_stmts_.push_back(sql_stmt_read_lines_all_);
+
       sql = "SELECT x, y, z FROM gravity_directions WHERE image_id = ?;";
       SQLITE3_CALL(
           sqlite3_prepare_v2(database_, sql.c_str(),  -1,
               &sql_stmt_read_gravity_, 0));
       sql_stmts_.push_back(sql_stmt_read_gravity_);
+
+      sql = "SELECT image_id, x, y, z FROM gravity_directions;";
+      SQLITE3_CALL(
+          sqlite3_prepare_v2(database_, sql.c_str(),  -1,
+              &sql_stmt_read_gravity_all_, 0));
+      sql_stmts_.push_back(sql_stmt_read_gravity_all_);
   }
 
   sql = "SELECT rows, cols, data FROM descriptors WHERE image_id = ?;";
@@ -857,10 +1315,17 @@ void Database::PrepareSQLStatements(const bool with_line_features) {
                                   &sql_stmt_read_matches_all_, 0));
   sql_stmts_.push_back(sql_stmt_read_matches_all_);
 
+  // The larger image identifier of a pair is the remainder of its identifier.
+  sql = "SELECT * FROM matches WHERE rows > 0 AND pair_id % " +
+        std::to_string(kMaxNumImages) + " > ?;";
+  SQLITE3_CALL(sqlite3_prepare_v2(database_, sql.c_str(), -1,
+                                  &sql_stmt_read_matches_after_image_, 0));
+  sql_stmts_.push_back(sql_stmt_read_matches_after_image_);
+
   sql = "SELECT pair_id, rows FROM matches WHERE rows > 0;";
   SQLITE3_CALL(sqlite3_prepare_v2(database_, sql.c_str(), -1,
-                                        &sql_stmt_read_num_matches_,
-                                        0));
+                                  &sql_stmt_read_num_matches_, 0));
+  sql_stmts_.push_back(sql_stmt_read_num_matches_);
 
   //////////////////////////////////////////////////////////////////////////////
   // write_*
@@ -1054,6 +1519,21 @@ bool Database::ExistsRowId(sqlite3_stmt* sql_stmt,
   return exists;
 }
 
+std::unordered_set<image_t> Database::ReadImageIds(
+    sqlite3_stmt* sql_stmt) const {
+  CHECK(sql_stmt) << "SQL statement is not initialized";
+
+  std::unordered_set<image_t> image_ids;
+  while (SQLITE3_CALL(sqlite3_step(sql_stmt)) == SQLITE_ROW) {
+    image_ids.insert(
+        static_cast<image_t>(sqlite3_column_int64(sql_stmt, 0)));
+  }
+
+  SQLITE3_CALL(sqlite3_reset(sql_stmt));
+
+  return image_ids;
+}
+
 bool Database::ExistsRowString(sqlite3_stmt* sql_stmt,
                                const std::string& row_entry) const {
   CHECK(sql_stmt) << "SQL statement is not initialized";
@@ -1140,10 +1620,11 @@ size_t Database::MaxColumn(const std::string& column,
   return max;
 }
 
-DatabaseTransaction::DatabaseTransaction(Database* database)
+DatabaseTransaction::DatabaseTransaction(Database* database,
+                                         const bool immediate)
     : database_(database), database_lock_(database->transaction_mutex_) {
   CHECK_NOTNULL(database_);
-  database_->BeginTransaction();
+  database_->BeginTransaction(immediate);
 }
 
 DatabaseTransaction::~DatabaseTransaction() { database_->EndTransaction(); }
@@ -34,8 +34,10 @@
 #ifndef COLMAP_SRC_BASE_DATABASE_H_
 #define COLMAP_SRC_BASE_DATABASE_H_
 
+#include <array>
 #include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <Eigen/Core>
@@ -48,6 +50,27 @@
 
 namespace colmap {
 
+// Connection settings applied when opening a database.
+struct DatabaseOptions {
+  // Whether to use write-ahead logging, which allows readers to proceed
+  // concurrently with a writer, instead of a rollback journal.
+  bool use_wal = true;
+
+  // The maximum size in MiB of the database file that is memory-mapped for
+  // reading. Set to zero to disable memory-mapped I/O.
+  int mmap_size = 256;
+
+  // The maximum size of the page cache of the connection in KiB.
+  int cache_size = 64 * 1024;
+
+  // The time in milliseconds to wait for a lock held by another connection,
+  // e.g. when features are extracted and matched concurrently, before failing
+  // with a busy error.
+  int busy_timeout = 60000;
+
+  bool Check() const;
+};
+
 // Database class to read and write images, features, cameras, matches, etc.
 // from a SQLite database. The class is not thread-safe and must not be accessed
 // concurrently. The class is optimized for single-thread speed and for optimal
@@ -64,14 +87,22 @@ class Database {
   const static size_t kMaxNumImages;
 
   Database();
-  explicit Database(const std::string& path, bool create_line_table = false);
+  explicit Database(const std::string& path, bool create_line_table = false,
+                    const DatabaseOptions& options = DatabaseOptions());
   ~Database();
 
   // Open and close database. The same database should not be opened
   // concurrently in multiple threads or processes.
-  void Open(const std::string& path, bool create_line_table = false);
+  void Open(const std::string& path, bool create_line_table = false,
+            const DatabaseOptions& options = DatabaseOptions());
   void Close();
 
+  // Check whether the file is an intact database with the tables of cameras,
+  // images, line features, and descriptors. In contrast to `Open`, errors do
+  // not terminate the program, so that files written by other processes can
+  // be verified before they are opened.
+  static bool IsReadable(const std::string& path);
+
   // Clone the current database into the given target
   void CloneTo(Database* target);
 
@@ -86,6 +117,14 @@ class Database {
   bool ExistsLineFeatures(const image_t image_id) const;
   bool ExistsImageGravity(const image_t image_id) const;
 
+  // Identifiers of all images with an entry in the `descriptors`,
+  // `line_features`, and `gravity_directions` table, respectively. Each is
+  // determined with a single table scan, which is much faster than checking
+  // the existence for many images individually.
+  std::unordered_set<image_t> ExistingDescriptorImageIds() const;
+  std::unordered_set<image_t> ExistingLineFeatureImageIds() const;
+  std::unordered_set<image_t> ExistingGravityImageIds() const;
+
   // Number of rows in `cameras` table.
   size_t NumCameras() const;
 
@@ -138,13 +177,32 @@ class Database {
   std::vector<Image> ReadAllImages() const;
 
   FeatureLines ReadFeatureLines(const image_t image_id) const;
+  std::unordered_map<image_t, FeatureLines> ReadAllFeatureLines() const;
+  // Read the lines of the given images with a single table scan, where only
+  // the lines of the given images are read from the row data and decoded.
+  std::unordered_map<image_t, FeatureLines> ReadFeatureLines(
+      const std::unordered_set<image_t>& image_ids) const;
   Eigen::Vector3d ReadImageGravity(const image_t image_id) const;
+  std::unordered_map<image_t, Eigen::Vector3d> ReadAllGravity() const;
   FeatureDescriptors ReadDescriptors(const image_t image_id) const;
 
   FeatureMatches ReadMatches(const image_t image_id1,
                              const image_t image_id2) const;
   std::vector<std::pair<image_pair_t, FeatureMatches>> ReadAllMatches() const;
 
+  // Read the matches of all image pairs in which the larger image identifier
+  // is greater than the given identifier, i.e. all pairs involving at least
+  // one image that was added after the given image.
+  std::vector<std::pair<image_pair_t, FeatureMatches>> ReadMatchesAfterImage(
+      const image_t image_id) const;
+
+  // Number of image pairs, largest pair identifier, and total number of
+  // matches of the image pairs with at least one match, in which both image
+  // identifiers are at most the given identifier. The matches themselves are
+  // not read, so this is a cheap way to detect changes of these pairs.
+  std::array<uint64_t, 3> ReadMatchesFingerprint(
+      const image_t max_image_id) const;
+
   // Read all image pairs that have an entry in the `matches` table with at
   // least one match and their number of matches
   void ReadNumMatches(
@@ -185,6 +243,16 @@ class Database {
   // Clear the entire matches table.
   void ClearMatches() const;
 
+  // Convert all matches stored in the raw format of older databases to the
+  // compressed format and return the number of converted image pairs. Reading
+  // handles both formats transparently, so this is only needed to reduce the
+  // size of existing databases. Wrap the call into a transaction for speed.
+  size_t CompressMatches() const;
+
+  // Rebuild the database file to reclaim unused space, e.g. after compressing
+  // the matches. Must not be called inside a transaction.
+  void Vacuum() const;
+
  private:
   friend class DatabaseTransaction;
 
@@ -192,8 +260,11 @@ class Database {
   // into a `BeginTransaction` and `EndTransaction`. You can create a scoped
   // transaction with `DatabaseTransaction` that ends when the transaction
   // object is destructed. Combining queries results in faster transaction time
-  // due to reduced locking of the database etc.
-  void BeginTransaction() const;
+  // due to reduced locking of the database etc. An immediate transaction
+  // acquires the write lock upfront, which is required for transactions that
+  // read before they write while other connections write concurrently, since
+  // upgrading a read to a write lock then fails without waiting.
+  void BeginTransaction(const bool immediate = false) const;
   void EndTransaction() const;
 
   // Prepare SQL statements once at construction of the database, and reuse
@@ -209,7 +280,10 @@ class Database {
   void CreateMatchesTable() const;
   // Create a table in the database to hold the line features.
   // We store the line features in normalized coordinates right now,
-  // this way we don't need to deal with distortions.
+  // this way we don't need to deal with distortions. Lines are written with
+  // `cols=-1` as the float angle theta and float offset of all lines,
+  // followed by one alignment flag byte per line. The legacy format with four
+  // float columns (a, b, c, is_aligned) can still be read.
   void CreateLineFeaturesTable() const;
   // Create table in the database to hold gravity directions for the images
   void CreateGravityTable() const;
@@ -219,6 +293,7 @@ class Database {
                     const std::string& column_name) const;
 
   bool ExistsRowId(sqlite3_stmt* sql_stmt, const sqlite3_int64 row_id) const;
+  std::unordered_set<image_t> ReadImageIds(sqlite3_stmt* sql_stmt) const;
   bool ExistsRowString(sqlite3_stmt* sql_stmt,
                        const std::string& row_entry) const;
 
@@ -254,6 +329,9 @@ class Database {
   sqlite3_stmt* sql_stmt_exists_matches_ = nullptr;
   sqlite3_stmt* sql_stmt_exists_lines_ = nullptr;
   sqlite3_stmt* sql_stmt_exists_gravity_ = nullptr;
+  sqlite3_stmt* sql_stmt_exists_descriptors_all_ = nullptr;
+  sqlite3_stmt* sql_stmt_exists_lines_all_ = nullptr;
+  sqlite3_stmt* sql_stmt_exists_gravity_all_ = nullptr;
 
   // add_*
   sqlite3_stmt* sql_stmt_add_camera_ = nullptr;
@@ -270,10 +348,13 @@ class Database {
   sqlite3_stmt* sql_stmt_read_image_name_ = nullptr;
   sqlite3_stmt* sql_stmt_read_images_ = nullptr;
   sqlite3_stmt* sql_stmt_read_lines_ = nullptr;
+  sqlite3_stmt* sql_stmt_read_lines_all_ = nullptr;
   sqlite3_stmt* sql_stmt_read_gravity_ = nullptr;
+  sqlite3_stmt* sql_stmt_read_gravity_all_ = nullptr;
   sqlite3_stmt* sql_stmt_read_descriptors_ = nullptr;
   sqlite3_stmt* sql_stmt_read_matches_ = nullptr;
   sqlite3_stmt* sql_stmt_read_matches_all_ = nullptr;
+  sqlite3_stmt* sql_stmt_read_matches_after_image_ = nullptr;
   sqlite3_stmt* sql_stmt_read_num_matches_ = nullptr;
 
   // write_*
@@ -294,7 +375,8 @@ class Database {
 // destruction, respectively.
 class DatabaseTransaction {
  public:
-  explicit DatabaseTransaction(Database* database);
+  explicit DatabaseTransaction(Database* database,
+                               const bool immediate = false);
   ~DatabaseTransaction();
 
  private:
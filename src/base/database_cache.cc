@@ -33,15 +33,180 @@
 
 #include "base/database_cache.h"
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
 #include <unordered_set>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <boost/filesystem.hpp>
+
 #include "feature/utils.h"
+#include "util/endian.h"
+#include "util/memory.h"
+#include "util/misc.h"
 #include "util/string.h"
 #include "util/timer.h"
+#include "util/trace.h"
 
 namespace colmap {
+namespace {
+
+// Identifier and format version of snapshots. The version must be incremented
+// whenever the layout of the snapshot changes.
+const char kSnapshotMagic[8] = {'P', 'P', 'S', 'F', 'M', 'D', 'B', 'C'};
+const uint32_t kSnapshotVersion = 3;
+
+// Add the image pair to the fingerprint of `Database::ReadMatchesFingerprint`,
+// if both of its images are at most the given identifier.
+void AddToMatchesFingerprint(const image_pair_t pair_id,
+                             const size_t num_matches,
+                             const image_t max_image_id,
+                             std::array<uint64_t, 3>* fingerprint) {
+  image_t image_id1;
+  image_t image_id2;
+  Database::PairIdToImagePair(pair_id, &image_id1, &image_id2);
+  if (num_matches > 0 && std::max(image_id1, image_id2) <= max_image_id) {
+    (*fingerprint)[0] += 1;
+    (*fingerprint)[1] = std::max<uint64_t>((*fingerprint)[1], pair_id);
+    (*fingerprint)[2] += num_matches;
+  }
+}
+
+// Read-only view of a whole file, memory-mapped where supported.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path);
+  ~MappedFile();
+
+  bool IsValid() const { return data_ != nullptr; }
+  const char* Data() const { return data_; }
+  size_t Size() const { return size_; }
+
+ private:
+  const char* data_;
+  size_t size_;
+#ifdef _WIN32
+  std::vector<char> buffer_;
+#endif
+};
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path) : data_(nullptr), size_(0) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    return;
+  }
+  buffer_.resize(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(buffer_.data(), buffer_.size());
+  data_ = buffer_.data();
+  size_ = buffer_.size();
+}
+
+MappedFile::~MappedFile() {}
 
-DatabaseCache::DatabaseCache() {}
+#else
+
+MappedFile::MappedFile(const std::string& path) : data_(nullptr), size_(0) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+    void* data = mmap(nullptr, static_cast<size_t>(file_stat.st_size),
+                      PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      // The snapshot is read front to back exactly once.
+      madvise(data, static_cast<size_t>(file_stat.st_size), MADV_SEQUENTIAL);
+      data_ = static_cast<const char*>(data);
+      size_ = static_cast<size_t>(file_stat.st_size);
+    }
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+#endif
+
+// Sequential reader of little-endian values from a snapshot in memory.
+class SnapshotReader {
+ public:
+  SnapshotReader(const char* data, const size_t size)
+      : data_(data), data_end_(data + size) {}
+
+  size_t NumRemainingBytes() const {
+    return static_cast<size_t>(data_end_ - data_);
+  }
+
+  // Check that the snapshot has enough data left for the given number of
+  // elements, before allocating memory for them.
+  void CheckRemaining(const uint64_t num_elements,
+                      const size_t num_bytes_per_element) const {
+    CHECK_LE(num_elements, NumRemainingBytes() / num_bytes_per_element)
+        << "Truncated database cache snapshot";
+  }
+
+  template <typename T>
+  T Read() {
+    CheckRemaining(1, sizeof(T));
+    T value;
+    memcpy(&value, data_, sizeof(T));
+    data_ += sizeof(T);
+    return LittleEndianToNative(value);
+  }
+
+  template <typename T>
+  void ReadArray(const size_t num_elements, T* values) {
+    CheckRemaining(num_elements, sizeof(T));
+    memcpy(values, data_, num_elements * sizeof(T));
+    data_ += num_elements * sizeof(T);
+    if (!IsLittleEndian()) {
+      for (size_t i = 0; i < num_elements; ++i) {
+        values[i] = LittleEndianToNative(values[i]);
+      }
+    }
+  }
+
+  std::string ReadString() {
+    const uint64_t length = Read<uint64_t>();
+    CheckRemaining(length, 1);
+    std::string value(data_, length);
+    data_ += length;
+    return value;
+  }
+
+ private:
+  const char* data_;
+  const char* data_end_;
+};
+
+void WriteString(std::ostream* stream, const std::string& value) {
+  WriteBinaryLittleEndian<uint64_t>(stream, value.size());
+  stream->write(value.data(), value.size());
+}
+
+}  // namespace
+
+DatabaseCache::DatabaseCache()
+    : min_num_matches_(0),
+      ignore_watermarks_(false),
+      max_image_id_(0),
+      num_database_images_(0),
+      matches_fingerprint_({{0, 0, 0}}) {}
 
 void DatabaseCache::AddCamera(const class Camera& camera) {
   CHECK(!ExistsCamera(camera.CameraId()));
@@ -57,6 +222,12 @@ void DatabaseCache::AddImage(const class Image& image) {
 void DatabaseCache::Load(const Database& database, const size_t min_num_matches,
                          const bool ignore_watermarks,
                          const std::unordered_set<std::string>& image_names) {
+  TRACE_SCOPE("DatabaseCache::Load");
+
+  min_num_matches_ = min_num_matches;
+  ignore_watermarks_ = ignore_watermarks;
+  image_names_ = image_names;
+
   //////////////////////////////////////////////////////////////////////////////
   // Load cameras
   //////////////////////////////////////////////////////////////////////////////
@@ -115,6 +286,23 @@ void DatabaseCache::Load(const Database& database, const size_t min_num_matches,
       }
     }
 
+    max_image_id_ = 0;
+    for (const image_t image_id : image_ids) {
+      max_image_id_ = std::max(max_image_id_, image_id);
+    }
+    num_database_images_ = 0;
+    for (const auto& image : images) {
+      if (image.ImageId() <= max_image_id_) {
+        num_database_images_ += 1;
+      }
+    }
+
+    matches_fingerprint_ = {{0, 0, 0}};
+    for (const auto& pair_matches : matches) {
+      AddToMatchesFingerprint(pair_matches.first, pair_matches.second.size(),
+                              max_image_id_, &matches_fingerprint_);
+    }
+
     // Collect all images that are connected in the correspondence graph.
     std::unordered_set<image_t> connected_image_ids;
     connected_image_ids.reserve(image_ids.size());
@@ -132,23 +320,37 @@ void DatabaseCache::Load(const Database& database, const size_t min_num_matches,
       }
     }
 
+    // Read the lines of the loaded images and the gravity of all images at
+    // once, which is much faster than querying them image by image.
+    std::unordered_map<image_t, FeatureLines> all_lines =
+        database.ReadFeatureLines(connected_image_ids);
+    const std::unordered_map<image_t, Eigen::Vector3d> all_gravity =
+        database.ReadAllGravity();
+
     // Load images with correspondences and discard images without
     // correspondences, as those images are useless for SfM.
     images_.reserve(connected_image_ids.size());
     for (const auto& image : images) {
       if (image_ids.count(image.ImageId()) > 0 &&
           connected_image_ids.count(image.ImageId()) > 0) {
-        images_.emplace(image.ImageId(), image);
-        images_.at(image.ImageId()).SetLines(database.ReadFeatureLines(image.ImageId()));
+        class Image& cached_image =
+            images_.emplace(image.ImageId(), image).first->second;
 
-        if (database.ExistsImageGravity(image.ImageId())) {
-          images_[image.ImageId()].SetGravityDirection(database.ReadImageGravity(images_[image.ImageId()].ImageId()));
+        const auto lines_it = all_lines.find(image.ImageId());
+        if (lines_it != all_lines.end()) {
+          cached_image.SetLines(lines_it->second);
+          all_lines.erase(lines_it);
+        }
+
+        const auto gravity_it = all_gravity.find(image.ImageId());
+        if (gravity_it != all_gravity.end()) {
+          cached_image.SetGravityDirection(gravity_it->second);
         } else {
           // Lines cannot be aligned if we do not have gravity for the image. Check that this is consistent in the data.
-          for (const auto& line : images_.at(image.ImageId()).Lines()) {
-            CHECK(!line.IsAligned());
+          const FeatureLineArray& lines = cached_image.Lines();
+          for (size_t line_idx = 0; line_idx < lines.Size(); ++line_idx) {
+            CHECK(!lines.IsAligned(line_idx));
           }
-
         }
       }
     }
@@ -203,6 +405,441 @@ void DatabaseCache::Load(const Database& database, const size_t min_num_matches,
             << std::endl;
 }
 
+bool DatabaseCache::LoadDelta(
+    const Database& database,
+    const std::unordered_set<std::string>& image_names) {
+  TRACE_SCOPE("DatabaseCache::LoadDelta");
+
+  if (image_names_.empty() != image_names.empty()) {
+    return false;
+  }
+  for (const auto& image_name : image_names_) {
+    if (image_names.count(image_name) == 0) {
+      return false;
+    }
+  }
+
+  Timer timer;
+  timer.Start();
+
+  // Find the images added since the cache was loaded. Previously loaded images
+  // must not be newly selected, since their image pairs with other previously
+  // loaded images were never read.
+  const std::vector<class Image> images = database.ReadAllImages();
+  image_t max_image_id = max_image_id_;
+  size_t num_old_images = 0;
+  std::unordered_set<image_t> image_ids;
+  for (const auto& image : images) {
+    const bool is_selected =
+        image_names.empty() || image_names.count(image.Name()) > 0;
+    if (image.ImageId() <= max_image_id_) {
+      num_old_images += 1;
+      if (is_selected && !image_names.empty() &&
+          image_names_.count(image.Name()) == 0) {
+        return false;
+      }
+    } else if (is_selected) {
+      max_image_id = std::max(max_image_id, image.ImageId());
+    }
+    if (is_selected) {
+      image_ids.insert(image.ImageId());
+    }
+  }
+
+  if (num_old_images != num_database_images_ ||
+      database.ReadMatchesFingerprint(max_image_id_) != matches_fingerprint_) {
+    return false;
+  }
+
+  std::cout << "Loading database delta..." << std::flush;
+
+  const std::vector<std::pair<image_pair_t, FeatureMatches>> matches =
+      database.ReadMatchesAfterImage(max_image_id_);
+
+  std::vector<size_t> used_pair_idxs;
+  std::unordered_set<image_t> added_image_ids;
+  for (size_t i = 0; i < matches.size(); ++i) {
+    if (matches[i].second.size() <= min_num_matches_) {
+      continue;
+    }
+    image_t image_id1;
+    image_t image_id2;
+    Database::PairIdToImagePair(matches[i].first, &image_id1, &image_id2);
+    if (image_ids.count(image_id1) == 0 || image_ids.count(image_id2) == 0) {
+      continue;
+    }
+    used_pair_idxs.push_back(i);
+    // Previously loaded images without matches may be connected now.
+    for (const image_t image_id : {image_id1, image_id2}) {
+      if (!ExistsImage(image_id)) {
+        added_image_ids.insert(image_id);
+      }
+    }
+  }
+
+  for (const auto& camera : database.ReadAllCameras()) {
+    if (!ExistsCamera(camera.CameraId())) {
+      cameras_.emplace(camera.CameraId(), camera);
+    }
+  }
+
+  for (const auto& image : images) {
+    if (added_image_ids.count(image.ImageId()) == 0) {
+      continue;
+    }
+
+    class Image& cached_image =
+        images_.emplace(image.ImageId(), image).first->second;
+    cached_image.SetLines(database.ReadFeatureLines(image.ImageId()));
+
+    const Eigen::Vector3d gravity = database.ReadImageGravity(image.ImageId());
+    if (!gravity.hasNaN()) {
+      cached_image.SetGravityDirection(gravity);
+    } else {
+      const FeatureLineArray& lines = cached_image.Lines();
+      for (size_t line_idx = 0; line_idx < lines.Size(); ++line_idx) {
+        CHECK(!lines.IsAligned(line_idx));
+      }
+    }
+
+    correspondence_graph_.AddImage(image.ImageId(), cached_image.NumLines());
+  }
+
+  for (const size_t pair_idx : used_pair_idxs) {
+    image_t image_id1;
+    image_t image_id2;
+    Database::PairIdToImagePair(matches[pair_idx].first, &image_id1,
+                                &image_id2);
+    correspondence_graph_.AddCorrespondences(image_id1, image_id2,
+                                             matches[pair_idx].second);
+  }
+
+  correspondence_graph_.Finalize();
+
+  for (auto& image : images_) {
+    image.second.SetNumObservations(
+        correspondence_graph_.NumObservationsForImage(image.first));
+    image.second.SetNumCorrespondences(
+        correspondence_graph_.NumCorrespondencesForImage(image.first));
+  }
+
+  image_names_ = image_names;
+  max_image_id_ = max_image_id;
+  num_database_images_ = 0;
+  for (const auto& image : images) {
+    if (image.ImageId() <= max_image_id_) {
+      num_database_images_ += 1;
+    }
+  }
+  for (const auto& pair_matches : matches) {
+    AddToMatchesFingerprint(pair_matches.first, pair_matches.second.size(),
+                            max_image_id_, &matches_fingerprint_);
+  }
+
+  std::cout << StringPrintf(" %d images, %d image pairs in %.3fs",
+                            added_image_ids.size(), used_pair_idxs.size(),
+                            timer.ElapsedSeconds())
+            << std::endl;
+
+  return true;
+}
+
+void DatabaseCache::WriteSnapshot(const std::string& path) const {
+  std::ofstream file(path, std::ios::trunc | std::ios::binary);
+  CHECK(file.is_open()) << path;
+
+  file.write(kSnapshotMagic, sizeof(kSnapshotMagic));
+  WriteBinaryLittleEndian<uint32_t>(&file, kSnapshotVersion);
+
+  // Parameters passed to `Load`, with the image names sorted such that the
+  // snapshot of the same cache is always identical.
+  WriteBinaryLittleEndian<uint64_t>(&file, min_num_matches_);
+  WriteBinaryLittleEndian<uint8_t>(&file, ignore_watermarks_);
+  std::vector<std::string> image_names(image_names_.begin(),
+                                       image_names_.end());
+  std::sort(image_names.begin(), image_names.end());
+  WriteBinaryLittleEndian<uint64_t>(&file, image_names.size());
+  for (const auto& image_name : image_names) {
+    WriteString(&file, image_name);
+  }
+  WriteBinaryLittleEndian<image_t>(&file, max_image_id_);
+  WriteBinaryLittleEndian<uint64_t>(&file, num_database_images_);
+  for (const uint64_t value : matches_fingerprint_) {
+    WriteBinaryLittleEndian<uint64_t>(&file, value);
+  }
+
+  WriteBinaryLittleEndian<uint64_t>(&file, cameras_.size());
+  for (const auto& camera : cameras_) {
+    WriteBinaryLittleEndian<camera_t>(&file, camera.first);
+    WriteBinaryLittleEndian<int32_t>(&file, camera.second.ModelId());
+    WriteBinaryLittleEndian<uint64_t>(&file, camera.second.Width());
+    WriteBinaryLittleEndian<uint64_t>(&file, camera.second.Height());
+    WriteBinaryLittleEndian<uint8_t>(&file,
+                                     camera.second.HasPriorFocalLength());
+    WriteBinaryLittleEndian<uint64_t>(&file, camera.second.NumParams());
+    WriteBinaryLittleEndian<double>(&file, camera.second.Params());
+  }
+
+  WriteBinaryLittleEndian<uint64_t>(&file, images_.size());
+  for (const auto& image : images_) {
+    WriteBinaryLittleEndian<image_t>(&file, image.first);
+    WriteBinaryLittleEndian<camera_t>(&file, image.second.CameraId());
+    WriteString(&file, image.second.Name());
+    for (int i = 0; i < 4; ++i) {
+      WriteBinaryLittleEndian<double>(&file, image.second.QvecPrior(i));
+    }
+    for (int i = 0; i < 3; ++i) {
+      WriteBinaryLittleEndian<double>(&file, image.second.TvecPrior(i));
+    }
+    for (int i = 0; i < 3; ++i) {
+      WriteBinaryLittleEndian<double>(&file,
+                                      image.second.GravityDirection()(i));
+    }
+    WriteBinaryLittleEndian<point2D_t>(&file, image.second.NumObservations());
+    WriteBinaryLittleEndian<point2D_t>(&file,
+                                       image.second.NumCorrespondences());
+
+    const FeatureLineArray& lines = image.second.Lines();
+    WriteBinaryLittleEndian<uint64_t>(&file, lines.Size());
+    for (const auto& line : lines.LineParams()) {
+      for (int i = 0; i < 3; ++i) {
+        WriteBinaryLittleEndian<double>(&file, line(i));
+      }
+    }
+    for (size_t line_idx = 0; line_idx < lines.Size(); ++line_idx) {
+      WriteBinaryLittleEndian<uint8_t>(&file, lines.IsAligned(line_idx));
+    }
+  }
+
+  // The correspondences of each image are stored in compressed sparse row
+  // format, i.e. the number of correspondences per line followed by all
+  // correspondences of the image as (image_id, line_idx) pairs.
+  WriteBinaryLittleEndian<uint64_t>(&file,
+                                    correspondence_graph_.images_.size());
+  for (const auto& image : correspondence_graph_.images_) {
+    WriteBinaryLittleEndian<image_t>(&file, image.first);
+    WriteBinaryLittleEndian<point2D_t>(&file, image.second.num_observations);
+    WriteBinaryLittleEndian<point2D_t>(&file,
+                                       image.second.num_correspondences);
+    WriteBinaryLittleEndian<uint64_t>(&file, image.second.corrs.size());
+    uint64_t num_corrs = 0;
+    for (const auto& corrs : image.second.corrs) {
+      WriteBinaryLittleEndian<point2D_t>(&file, corrs.size());
+      num_corrs += corrs.size();
+    }
+    WriteBinaryLittleEndian<uint64_t>(&file, num_corrs);
+    for (const auto& corrs : image.second.corrs) {
+      for (const auto& corr : corrs) {
+        WriteBinaryLittleEndian<image_t>(&file, corr.image_id);
+        WriteBinaryLittleEndian<point2D_t>(&file, corr.line_idx);
+      }
+    }
+  }
+
+  WriteBinaryLittleEndian<uint64_t>(&file,
+                                    correspondence_graph_.image_pairs_.size());
+  for (const auto& image_pair : correspondence_graph_.image_pairs_) {
+    WriteBinaryLittleEndian<image_pair_t>(&file, image_pair.first);
+    WriteBinaryLittleEndian<point2D_t>(&file,
+                                       image_pair.second.num_correspondences);
+  }
+
+  CHECK(file.good()) << "Failed to write database cache snapshot " << path;
+}
+
+bool DatabaseCache::LoadSnapshot(
+    const std::string& path, const size_t min_num_matches,
+    const bool ignore_watermarks,
+    const std::unordered_set<std::string>& image_names,
+    const bool allow_added_image_names) {
+  TRACE_SCOPE("DatabaseCache::LoadSnapshot");
+
+  Timer timer;
+  timer.Start();
+
+  const MappedFile mapped_file(path);
+  if (!mapped_file.IsValid() ||
+      mapped_file.Size() < sizeof(kSnapshotMagic) + sizeof(uint32_t) ||
+      memcmp(mapped_file.Data(), kSnapshotMagic, sizeof(kSnapshotMagic)) !=
+          0) {
+    return false;
+  }
+
+  SnapshotReader reader(mapped_file.Data() + sizeof(kSnapshotMagic),
+                        mapped_file.Size() - sizeof(kSnapshotMagic));
+  if (reader.Read<uint32_t>() != kSnapshotVersion) {
+    return false;
+  }
+
+  if (reader.Read<uint64_t>() != min_num_matches ||
+      (reader.Read<uint8_t>() != 0) != ignore_watermarks) {
+    return false;
+  }
+  const uint64_t num_image_names = reader.Read<uint64_t>();
+  std::unordered_set<std::string> snapshot_image_names;
+  snapshot_image_names.reserve(num_image_names);
+  for (uint64_t i = 0; i < num_image_names; ++i) {
+    std::string image_name = reader.ReadString();
+    if (image_names.count(image_name) == 0) {
+      return false;
+    }
+    snapshot_image_names.insert(std::move(image_name));
+  }
+  // An empty set of names selects all images, so it cannot be extended.
+  if (snapshot_image_names.size() != image_names.size() &&
+      (!allow_added_image_names || snapshot_image_names.empty())) {
+    return false;
+  }
+
+  const image_t max_image_id = reader.Read<image_t>();
+  const uint64_t num_database_images = reader.Read<uint64_t>();
+  std::array<uint64_t, 3> matches_fingerprint;
+  for (uint64_t& value : matches_fingerprint) {
+    value = reader.Read<uint64_t>();
+  }
+
+  std::cout << "Loading database cache snapshot..." << std::flush;
+
+  EIGEN_STL_UMAP(camera_t, class Camera) cameras;
+  const uint64_t num_cameras = reader.Read<uint64_t>();
+  cameras.reserve(num_cameras);
+  for (uint64_t i = 0; i < num_cameras; ++i) {
+    class Camera camera;
+    camera.SetCameraId(reader.Read<camera_t>());
+    camera.SetModelId(reader.Read<int32_t>());
+    camera.SetWidth(reader.Read<uint64_t>());
+    camera.SetHeight(reader.Read<uint64_t>());
+    camera.SetPriorFocalLength(reader.Read<uint8_t>() != 0);
+    const uint64_t num_params = reader.Read<uint64_t>();
+    CHECK_EQ(num_params, camera.NumParams());
+    reader.ReadArray(num_params, camera.ParamsData());
+    cameras.emplace(camera.CameraId(), camera);
+  }
+
+  EIGEN_STL_UMAP(image_t, class Image) images;
+  const uint64_t num_images = reader.Read<uint64_t>();
+  images.reserve(num_images);
+  std::vector<double> line_params;
+  std::vector<uint8_t> is_aligned;
+  for (uint64_t i = 0; i < num_images; ++i) {
+    class Image image;
+    image.SetImageId(reader.Read<image_t>());
+    image.SetCameraId(reader.Read<camera_t>());
+    image.SetName(reader.ReadString());
+    reader.ReadArray(4, image.QvecPrior().data());
+    reader.ReadArray(3, image.TvecPrior().data());
+    Eigen::Vector3d gravity;
+    reader.ReadArray(3, gravity.data());
+    if (!gravity.hasNaN()) {
+      image.SetGravityDirection(gravity);
+    }
+    image.SetNumObservations(reader.Read<point2D_t>());
+    image.SetNumCorrespondences(reader.Read<point2D_t>());
+
+    const uint64_t num_lines = reader.Read<uint64_t>();
+    reader.CheckRemaining(num_lines, 3 * sizeof(double) + sizeof(uint8_t));
+    line_params.resize(3 * num_lines);
+    is_aligned.resize(num_lines);
+    reader.ReadArray(line_params.size(), line_params.data());
+    reader.ReadArray(is_aligned.size(), is_aligned.data());
+    FeatureLineArray lines;
+    lines.Resize(num_lines);
+    for (size_t line_idx = 0; line_idx < num_lines; ++line_idx) {
+      lines.SetLine(line_idx, Eigen::Map<const Eigen::Vector3d>(
+                                  line_params.data() + 3 * line_idx));
+      lines.SetAligned(line_idx, is_aligned[line_idx] != 0);
+    }
+    image.SetLines(lines);
+
+    images.emplace(image.ImageId(), image);
+  }
+
+  class CorrespondenceGraph correspondence_graph;
+  const uint64_t num_graph_images = reader.Read<uint64_t>();
+  correspondence_graph.images_.reserve(num_graph_images);
+  std::vector<point2D_t> num_corrs_per_line;
+  std::vector<uint32_t> corrs_data;
+  for (uint64_t i = 0; i < num_graph_images; ++i) {
+    const image_t image_id = reader.Read<image_t>();
+    auto& image = correspondence_graph.images_[image_id];
+    image.num_observations = reader.Read<point2D_t>();
+    image.num_correspondences = reader.Read<point2D_t>();
+
+    const uint64_t num_lines = reader.Read<uint64_t>();
+    num_corrs_per_line.resize(num_lines);
+    reader.ReadArray(num_corrs_per_line.size(), num_corrs_per_line.data());
+
+    const uint64_t num_corrs = reader.Read<uint64_t>();
+    corrs_data.resize(2 * num_corrs);
+    reader.ReadArray(corrs_data.size(), corrs_data.data());
+
+    image.corrs.resize(num_lines);
+    size_t corr_idx = 0;
+    for (size_t line_idx = 0; line_idx < num_lines; ++line_idx) {
+      const size_t num_line_corrs = num_corrs_per_line[line_idx];
+      CHECK_LE(corr_idx + num_line_corrs, num_corrs)
+          << "Corrupt database cache snapshot";
+      auto& corrs = image.corrs[line_idx];
+      corrs.reserve(num_line_corrs);
+      for (size_t j = 0; j < num_line_corrs; ++j, ++corr_idx) {
+        corrs.emplace_back(corrs_data[2 * corr_idx],
+                           corrs_data[2 * corr_idx + 1]);
+      }
+    }
+  }
+
+  const uint64_t num_image_pairs = reader.Read<uint64_t>();
+  correspondence_graph.image_pairs_.reserve(num_image_pairs);
+  for (uint64_t i = 0; i < num_image_pairs; ++i) {
+    const image_pair_t pair_id = reader.Read<image_pair_t>();
+    correspondence_graph.image_pairs_[pair_id].num_correspondences =
+        reader.Read<point2D_t>();
+  }
+
+  CHECK_EQ(reader.NumRemainingBytes(), 0)
+      << "Corrupt database cache snapshot";
+
+  min_num_matches_ = min_num_matches;
+  ignore_watermarks_ = ignore_watermarks;
+  image_names_ = std::move(snapshot_image_names);
+  max_image_id_ = max_image_id;
+  num_database_images_ = num_database_images;
+  matches_fingerprint_ = matches_fingerprint;
+  cameras_ = std::move(cameras);
+  images_ = std::move(images);
+  correspondence_graph_ = std::move(correspondence_graph);
+
+  std::cout << StringPrintf(" %d cameras, %d images in %.3fs",
+                            cameras_.size(), images_.size(),
+                            timer.ElapsedSeconds())
+            << std::endl;
+
+  return true;
+}
+
+bool DatabaseCache::IsSnapshotUpToDate(const std::string& snapshot_path,
+                                       const std::string& database_path) {
+  if (!ExistsFile(snapshot_path) || !ExistsFile(database_path)) {
+    return false;
+  }
+
+  // Timestamps have a resolution of one second, so a snapshot written in the
+  // same second as the last modification is conservatively considered stale.
+  const std::time_t snapshot_time =
+      boost::filesystem::last_write_time(snapshot_path);
+  if (snapshot_time <= boost::filesystem::last_write_time(database_path)) {
+    return false;
+  }
+
+  const std::string wal_path = database_path + "-wal";
+  if (ExistsFile(wal_path) &&
+      snapshot_time <= boost::filesystem::last_write_time(wal_path)) {
+    return false;
+  }
+
+  return true;
+}
+
 const class Image* DatabaseCache::FindImageWithName(
     const std::string& name) const {
   for (const auto& image : images_) {
@@ -213,4 +850,33 @@ const class Image* DatabaseCache::FindImageWithName(
   return nullptr;
 }
 
+std::unordered_set<std::string> DatabaseCache::FindImageNamesWithAlignedLines()
+    const {
+  std::unordered_set<std::string> image_names;
+  for (const auto& image : images_) {
+    const FeatureLineArray& lines = image.second.Lines();
+    for (size_t line_idx = 0; line_idx < lines.Size(); ++line_idx) {
+      if (lines.IsAligned(line_idx)) {
+        CHECK(image.second.HasGravity());
+        image_names.insert(image.second.Name());
+        break;
+      }
+    }
+  }
+  return image_names;
+}
+
+size_t DatabaseCache::NumBytes() const {
+  size_t num_bytes = sizeof(DatabaseCache) +
+                     (correspondence_graph_.NumBytes() -
+                      sizeof(class CorrespondenceGraph)) +
+                     NestedHashMapNumBytes(cameras_) +
+                     NestedHashMapNumBytes(images_) +
+                     HashMapNumBytes(image_names_);
+  for (const auto& image_name : image_names_) {
+    num_bytes += image_name.capacity();
+  }
+  return num_bytes;
+}
+
 }  // namespace colmap
@@ -32,6 +32,7 @@
 #ifndef COLMAP_SRC_BASE_DATABASE_CACHE_H_
 #define COLMAP_SRC_BASE_DATABASE_CACHE_H_
 
+#include <array>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -92,10 +93,74 @@ class DatabaseCache {
             const bool ignore_watermarks,
             const std::unordered_set<std::string>& image_names);
 
+  // Append the images and image pairs that were added to the database since
+  // the cache was loaded, e.g. after extracting and matching the features of
+  // newly captured images, without reloading the existing data. `image_names`
+  // may add names of new images to the names passed to `Load`.
+  //
+  // This assumes that new images have larger identifiers than all loaded
+  // images, which holds for the auto-incremented identifiers of the database
+  // and for images selected in the order of their identifiers, and that only
+  // image pairs with at least one new image were matched since. Returns false
+  // and leaves the cache untouched if images were deleted, previously loaded
+  // images were newly selected, or image pairs between previously loaded
+  // images were added, deleted, or matched again, in which case the cache must
+  // be reloaded with `Load`.
+  bool LoadDelta(const Database& database,
+                 const std::unordered_set<std::string>& image_names);
+
+  // Write the loaded cache together with the parameters passed to `Load` to a
+  // versioned binary snapshot file.
+  void WriteSnapshot(const std::string& path) const;
+
+  // Load the cache from a snapshot written by `WriteSnapshot`. The file is
+  // memory-mapped and the cameras, images, and correspondence graph are
+  // restored from it without any of the checks done when building them from
+  // the database. Returns false and leaves the cache untouched if the snapshot
+  // has a different version or was written for different `Load` parameters.
+  //
+  // If `allow_added_image_names` is true, the snapshot is also accepted if it
+  // was written for a subset of `image_names`, so that the cache can then be
+  // brought up to date with `LoadDelta`.
+  bool LoadSnapshot(const std::string& path, const size_t min_num_matches,
+                    const bool ignore_watermarks,
+                    const std::unordered_set<std::string>& image_names,
+                    const bool allow_added_image_names = false);
+
+  // Check whether the snapshot exists and was written after the last
+  // modification of the database, including its write-ahead log.
+  static bool IsSnapshotUpToDate(const std::string& snapshot_path,
+                                 const std::string& database_path);
+
   // Find specific image by name. Note that this uses linear search.
   const class Image* FindImageWithName(const std::string& name) const;
 
+  // Find the names of all images with at least one gravity-aligned line.
+  std::unordered_set<std::string> FindImageNamesWithAlignedLines() const;
+
+  // Estimated size of the cache in memory in bytes, including the
+  // correspondence graph.
+  size_t NumBytes() const;
+
  private:
+  // The parameters passed to `Load`, used to validate snapshots.
+  size_t min_num_matches_;
+  bool ignore_watermarks_;
+  std::unordered_set<std::string> image_names_;
+
+  // The largest identifier of the loaded images and the number of images in
+  // the database up to this identifier at the time of loading, used to find
+  // the images added since in `LoadDelta`. Unselected images with larger
+  // identifiers may still be selected by `LoadDelta`.
+  image_t max_image_id_;
+  size_t num_database_images_;
+
+  // Fingerprint of the image pairs between the images up to `max_image_id_`
+  // as returned by `Database::ReadMatchesFingerprint`, computed from the
+  // loaded matches. `LoadDelta` compares it to the database to detect changes
+  // of these image pairs, which it cannot apply incrementally.
+  std::array<uint64_t, 3> matches_fingerprint_;
+
   class CorrespondenceGraph correspondence_graph_;
 
   EIGEN_STL_UMAP(camera_t, class Camera) cameras_;
@@ -0,0 +1,294 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#define TEST_NAME "base/database"
+#include "util/testing.h"
+
+#include <boost/filesystem.hpp>
+
+#include "base/database.h"
+
+using namespace colmap;
+
+namespace {
+
+image_t WriteTestImage(const Database& database, const std::string& name) {
+  Camera camera;
+  camera.InitializeWithName("SIMPLE_PINHOLE", 1.0, 1, 1);
+  const camera_t camera_id = database.WriteCamera(camera);
+  Image image;
+  image.SetName(name);
+  image.SetCameraId(camera_id);
+  return database.WriteImage(image);
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(TestFeatureLinesRoundTrip) {
+  Database database(":memory:", true);
+  const image_t image_id = WriteTestImage(database, "image");
+
+  // Cover all quadrants of the line normal, the angles close to the wrap-around
+  // at 2pi, and both alignment flags for each.
+  FeatureLines lines;
+  const int kNumAngles = 64;
+  for (int i = 0; i < kNumAngles; ++i) {
+    const double theta = 2 * M_PI * i / kNumAngles - 1e-9;
+    for (const bool is_aligned : {false, true}) {
+      const double scale = 0.5 + i;
+      lines.emplace_back(Eigen::Vector3d(scale * std::cos(theta),
+                                         scale * std::sin(theta),
+                                         scale * (i - kNumAngles / 2)),
+                         is_aligned);
+    }
+  }
+
+  database.WriteFeatureLines(image_id, lines);
+  const FeatureLines read_lines = database.ReadFeatureLines(image_id);
+
+  BOOST_CHECK_EQUAL(read_lines.size(), lines.size());
+  for (size_t i = 0; i < lines.size(); ++i) {
+    const Eigen::Vector3d& line = lines[i].Line();
+    const Eigen::Vector3d normalized_line = line / line.head<2>().norm();
+    const Eigen::Vector3d& read_line = read_lines[i].Line();
+    BOOST_CHECK_SMALL((read_line - normalized_line).norm(), 1e-5);
+    BOOST_CHECK_CLOSE(read_line.head<2>().norm(), 1.0, 1e-6);
+    BOOST_CHECK_EQUAL(read_lines[i].IsAligned(), lines[i].IsAligned());
+    BOOST_CHECK(!read_lines[i].HasPoint3D());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestEmptyFeatureLines) {
+  Database database(":memory:", true);
+  const image_t image_id = WriteTestImage(database, "image");
+  database.WriteFeatureLines(image_id, FeatureLines());
+  BOOST_CHECK(database.ExistsLineFeatures(image_id));
+  BOOST_CHECK_EQUAL(database.ReadFeatureLines(image_id).size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestReadSelectedFeatureLines) {
+  Database database(":memory:", true);
+  std::vector<image_t> image_ids;
+  for (int i = 0; i < 3; ++i) {
+    image_ids.push_back(WriteTestImage(database, std::to_string(i)));
+    database.WriteFeatureLines(
+        image_ids.back(),
+        FeatureLines(i + 1, FeatureLine(Eigen::Vector3d(1, 0, i))));
+  }
+
+  const auto lines = database.ReadFeatureLines(
+      std::unordered_set<image_t>{image_ids[0], image_ids[2]});
+  BOOST_CHECK_EQUAL(lines.size(), 2);
+  BOOST_CHECK_EQUAL(lines.at(image_ids[0]).size(), 1);
+  BOOST_CHECK_EQUAL(lines.at(image_ids[2]).size(), 3);
+  BOOST_CHECK_EQUAL(lines.at(image_ids[2])[0].Line()(2), 2);
+  BOOST_CHECK_EQUAL(lines.count(image_ids[1]), 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestReadLegacyFeatureLines) {
+  const std::string database_path =
+      (boost::filesystem::temp_directory_path() /
+       boost::filesystem::unique_path("%%%%-%%%%-%%%%.db"))
+          .string();
+
+  image_t image_id;
+  {
+    Database database(database_path, true);
+    image_id = WriteTestImage(database, "image");
+  }
+
+  // Write the lines in the format of older databases with the unnormalized
+  // line (a, b, c) and the alignment flag as four floats per line.
+  const std::vector<float> data = {3, 4, 10, 0,  //
+                                   0, -2, 1, 1,  //
+                                   -1, 0, -5, 0};
+  sqlite3* raw_database;
+  BOOST_CHECK_EQUAL(sqlite3_open(database_path.c_str(), &raw_database),
+                    SQLITE_OK);
+  sqlite3_stmt* insert_stmt;
+  BOOST_CHECK_EQUAL(
+      sqlite3_prepare_v2(raw_database,
+                         "INSERT INTO line_features(image_id, rows, cols, "
+                         "data) VALUES(?, 3, 4, ?);",
+                         -1, &insert_stmt, nullptr),
+      SQLITE_OK);
+  sqlite3_bind_int64(insert_stmt, 1, image_id);
+  sqlite3_bind_blob(insert_stmt, 2, data.data(),
+                    static_cast<int>(data.size() * sizeof(float)),
+                    SQLITE_STATIC);
+  BOOST_CHECK_EQUAL(sqlite3_step(insert_stmt), SQLITE_DONE);
+  sqlite3_finalize(insert_stmt);
+  sqlite3_close(raw_database);
+
+  {
+    Database database(database_path, true);
+    const FeatureLines lines = database.ReadFeatureLines(image_id);
+    BOOST_CHECK_EQUAL(lines.size(), 3);
+    BOOST_CHECK_SMALL((lines[0].Line() - Eigen::Vector3d(0.6, 0.8, 2)).norm(),
+                      1e-6);
+    BOOST_CHECK_SMALL((lines[1].Line() - Eigen::Vector3d(0, -1, 0.5)).norm(),
+                      1e-6);
+    BOOST_CHECK_SMALL((lines[2].Line() - Eigen::Vector3d(-1, 0, -5)).norm(),
+                      1e-6);
+    BOOST_CHECK(!lines[0].IsAligned());
+    BOOST_CHECK(lines[1].IsAligned());
+    BOOST_CHECK(!lines[2].IsAligned());
+
+    const auto selected_lines =
+        database.ReadFeatureLines(std::unordered_set<image_t>{image_id});
+    BOOST_CHECK_EQUAL(selected_lines.at(image_id).size(), 3);
+    BOOST_CHECK(selected_lines.at(image_id)[1].IsAligned());
+  }
+
+  boost::filesystem::remove(database_path);
+}
+
+BOOST_AUTO_TEST_CASE(TestReadMatchesFingerprint) {
+  Database database(":memory:", true);
+  for (int i = 0; i < 4; ++i) {
+    WriteTestImage(database, std::to_string(i));
+  }
+
+  const std::array<uint64_t, 3> empty_fingerprint = {{0, 0, 0}};
+  BOOST_CHECK(database.ReadMatchesFingerprint(3) == empty_fingerprint);
+
+  database.WriteMatches(1, 2, FeatureMatches(5));
+  database.WriteMatches(3, 1, FeatureMatches(7));
+  database.WriteMatches(2, 4, FeatureMatches(11));
+
+  // Only the pairs between the first three images are included.
+  const std::array<uint64_t, 3> fingerprint =
+      database.ReadMatchesFingerprint(3);
+  BOOST_CHECK_EQUAL(fingerprint[0], 2);
+  BOOST_CHECK_EQUAL(fingerprint[1], Database::ImagePairToPairId(1, 3));
+  BOOST_CHECK_EQUAL(fingerprint[2], 12);
+
+  // Matching a pair again changes the fingerprint.
+  database.DeleteMatches(1, 2);
+  database.WriteMatches(1, 2, FeatureMatches(6));
+  BOOST_CHECK(database.ReadMatchesFingerprint(3) != fingerprint);
+  BOOST_CHECK_EQUAL(database.ReadMatchesFingerprint(4)[0], 3);
+}
+
+BOOST_AUTO_TEST_CASE(TestIsReadable) {
+  const std::string database_path =
+      (boost::filesystem::temp_directory_path() /
+       boost::filesystem::unique_path("%%%%-%%%%-%%%%.db"))
+          .string();
+
+  BOOST_CHECK(!Database::IsReadable(database_path));
+
+  {
+    Database database(database_path, true);
+    const image_t image_id = WriteTestImage(database, "image");
+    database.WriteFeatureLines(
+        image_id, FeatureLines(1000, FeatureLine(Eigen::Vector3d(1, 0, 0))));
+  }
+  BOOST_CHECK(Database::IsReadable(database_path));
+
+  // A partially written database.
+  const size_t file_size = boost::filesystem::file_size(database_path);
+  boost::filesystem::resize_file(database_path, file_size / 2);
+  BOOST_CHECK(!Database::IsReadable(database_path));
+
+  // Not a database at all.
+  {
+    std::ofstream file(database_path, std::ios::trunc);
+    file << "This is not a database.";
+  }
+  BOOST_CHECK(!Database::IsReadable(database_path));
+
+  boost::filesystem::remove(database_path);
+}
+
+BOOST_AUTO_TEST_CASE(TestCompressMatches) {
+  const std::string database_path =
+      (boost::filesystem::temp_directory_path() /
+       boost::filesystem::unique_path("%%%%-%%%%-%%%%.db"))
+          .string();
+
+  // Write matches in the raw format of older databases, for more image pairs
+  // than are converted in one batch.
+  const image_t kNumImages = 50;
+  {
+    Database database(database_path, true);
+  }
+  sqlite3* raw_database;
+  BOOST_CHECK_EQUAL(sqlite3_open(database_path.c_str(), &raw_database),
+                    SQLITE_OK);
+  sqlite3_stmt* insert_stmt;
+  BOOST_CHECK_EQUAL(
+      sqlite3_prepare_v2(raw_database,
+                         "INSERT INTO matches(pair_id, rows, cols, data) "
+                         "VALUES(?, ?, 2, ?);",
+                         -1, &insert_stmt, nullptr),
+      SQLITE_OK);
+  sqlite3_exec(raw_database, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+  size_t num_pairs = 0;
+  for (image_t image_id1 = 1; image_id1 <= kNumImages; ++image_id1) {
+    for (image_t image_id2 = image_id1 + 1; image_id2 <= kNumImages;
+         ++image_id2) {
+      const std::vector<point2D_t> data = {image_id2, image_id1, 0, image_id2};
+      sqlite3_bind_int64(insert_stmt, 1,
+                         Database::ImagePairToPairId(image_id1, image_id2));
+      sqlite3_bind_int64(insert_stmt, 2, 2);
+      sqlite3_bind_blob(insert_stmt, 3, data.data(),
+                        static_cast<int>(data.size() * sizeof(point2D_t)),
+                        SQLITE_STATIC);
+      BOOST_CHECK_EQUAL(sqlite3_step(insert_stmt), SQLITE_DONE);
+      sqlite3_reset(insert_stmt);
+      num_pairs += 1;
+    }
+  }
+  sqlite3_exec(raw_database, "END TRANSACTION", nullptr, nullptr, nullptr);
+  sqlite3_finalize(insert_stmt);
+  sqlite3_close(raw_database);
+
+  {
+    Database database(database_path, true);
+    BOOST_CHECK_EQUAL(database.CompressMatches(), num_pairs);
+    BOOST_CHECK_EQUAL(database.CompressMatches(), 0);
+
+    const auto all_matches = database.ReadAllMatches();
+    BOOST_CHECK_EQUAL(all_matches.size(), num_pairs);
+    for (const auto& pair_matches : all_matches) {
+      image_t image_id1;
+      image_t image_id2;
+      Database::PairIdToImagePair(pair_matches.first, &image_id1, &image_id2);
+      const FeatureMatches& matches = pair_matches.second;
+      BOOST_CHECK_EQUAL(matches.size(), 2);
+      BOOST_CHECK_EQUAL(matches[0].line_idx1, 0);
+      BOOST_CHECK_EQUAL(matches[0].line_idx2, image_id2);
+      BOOST_CHECK_EQUAL(matches[1].line_idx1, image_id2);
+      BOOST_CHECK_EQUAL(matches[1].line_idx2, image_id1);
+    }
+  }
+
+  boost::filesystem::remove(database_path);
+}
@@ -35,6 +35,7 @@
 
 #include "base/pose.h"
 #include "base/projection.h"
+#include "util/memory.h"
 
 namespace colmap {
 namespace {
@@ -59,33 +60,34 @@ Image::Image()
       gravity_(kNaN, kNaN, kNaN) {}
 
 void Image::SetLines(const FeatureLines& lines) {
-  num_correspondences_have_point3D_.resize(lines.size(), 0);
+  SetLines(FeatureLineArray(lines));
+}
+
+void Image::SetLines(const FeatureLineArray& lines) {
+  num_correspondences_have_point3D_.resize(lines.Size(), 0);
   lines_ = lines;
 }
 
 void Image::SetPoint3DForLine(const point2D_t line_idx,
                                  const point3D_t point3D_id) {
   CHECK_NE(point3D_id, kInvalidPoint3DId);
-  class FeatureLine& line = lines_.at(line_idx);
-  if (!line.HasPoint3D()) {
+  if (!lines_.HasPoint3D(line_idx)) {
     num_points3D_ += 1;
   }
-  line.SetPoint3DId(point3D_id);
+  lines_.SetPoint3DId(line_idx, point3D_id);
 }
 
 void Image::ResetPoint3DForLine(const point2D_t line_idx) {
-  class FeatureLine& line = lines_.at(line_idx);
-  if (line.HasPoint3D()) {
-    line.SetPoint3DId(-1);
+  if (lines_.HasPoint3D(line_idx)) {
+    lines_.SetPoint3DId(line_idx, kInvalidPoint3DId);
     num_points3D_ -= 1;
   }
 }
 
 bool Image::HasPoint3D(const point3D_t point3D_id) const {
-  return std::find_if(lines_.begin(), lines_.end(),
-                      [point3D_id](const class FeatureLine& line) {
-                        return line.Point3DId() == point3D_id;
-                      }) != lines_.end();
+  const std::vector<point3D_t>& point3D_ids = lines_.Point3DIds();
+  return std::find(point3D_ids.begin(), point3D_ids.end(), point3D_id) !=
+         point3D_ids.end();
 }
 
 void Image::IncrementCorrespondenceHasPoint3D(const point2D_t line_idx) {
@@ -106,6 +108,12 @@ void Image::DecrementCorrespondenceHasPoint3D(const point2D_t point2D_idx) {
   assert(num_visible_points3D_ <= num_observations_);
 }
 
+void Image::ResetCorrespondencesHavePoint3D() {
+  std::fill(num_correspondences_have_point3D_.begin(),
+            num_correspondences_have_point3D_.end(), 0);
+  num_visible_points3D_ = 0;
+}
+
 void Image::NormalizeQvec() { qvec_ = NormalizeQuaternion(qvec_); }
 
 Eigen::Matrix3x4d Image::ProjectionMatrix() const {
@@ -128,4 +136,10 @@ Eigen::Vector3d Image::ViewingDirection() const {
   return RotationMatrix().row(2);
 }
 
+size_t Image::NumBytes() const {
+  return sizeof(Image) + name_.capacity() +
+         (lines_.NumBytes() - sizeof(FeatureLineArray)) +
+         VectorNumBytes(num_correspondences_have_point3D_);
+}
+
 }  // namespace colmap
@@ -135,11 +135,14 @@ class Image {
   inline const Eigen::Vector3d& GravityDirection() const;
   inline bool HasGravity() const;
 
-  // Access the coordinates of image points.
+  // Access the feature lines. Lines are stored as a structure of arrays, hence
+  // `Line` returns a copy of the assembled line. Loops over many lines should
+  // access the individual fields by reference through `Lines`, e.g.
+  // `Lines().Line(line_idx)` or `Lines().Point3DId(line_idx)`.
   void SetLines(const FeatureLines& lines);
-  inline const FeatureLine& Line(const point2D_t line_idx) const;
-  inline FeatureLine& Line(const point2D_t line_idx);
-  inline const FeatureLines& Lines() const;
+  void SetLines(const FeatureLineArray& lines);
+  inline FeatureLine Line(const point2D_t line_idx) const;
+  inline const FeatureLineArray& Lines() const;
 
     // Set the point as triangulated, i.e. it is part of a 3D point track.
   void SetPoint3DForLine(const point2D_t line_idx,
@@ -167,6 +170,10 @@ class Image {
   // after calling `SetUp`.
   void DecrementCorrespondenceHasPoint3D(const point2D_t line_idx);
 
+  // Forget all correspondences that have a triangulated point, e.g. before
+  // the image is set up again with a grown correspondence graph.
+  void ResetCorrespondencesHavePoint3D();
+
   // Normalize the quaternion vector.
   void NormalizeQvec();
 
@@ -185,6 +192,9 @@ class Image {
   // Extract the viewing direction of the image.
   Eigen::Vector3d ViewingDirection() const;
 
+  // Estimated size of the image in memory in bytes.
+  size_t NumBytes() const;
+
  private:
   // Identifier of the image, if not specified `kInvalidImageId`.
   image_t image_id_;
@@ -225,7 +235,7 @@ class Image {
 
   // The feature lines corresponding to the points with the same index.
   // Feature lines are stored in normalized coordinates!
-  FeatureLines lines_;
+  FeatureLineArray lines_;
 
   // The gravity direction, pointing downwards. Should be normalized.
   // A NaN-vector if gravity is not available
@@ -263,7 +273,7 @@ bool Image::IsRegistered() const { return registered_; }
 void Image::SetRegistered(const bool registered) { registered_ = registered; }
 
 point2D_t Image::NumLines() const {
-  return static_cast<point2D_t>(lines_.size());
+  return static_cast<point2D_t>(lines_.Size());
 }
 
 point2D_t Image::NumPoints3D() const { return num_points3D_; }
@@ -336,15 +346,11 @@ void Image::SetGravityDirection(const Eigen::Vector3d& gravity_direction) {
 const Eigen::Vector3d& Image::GravityDirection() const { return gravity_; }
 bool Image::HasGravity() const { return !gravity_.hasNaN(); }
 
-FeatureLine& Image::Line(const point2D_t line_idx) {
-  return lines_.at(line_idx);
-}
-
-const FeatureLine& Image::Line(const point2D_t line_idx) const {
-  return lines_.at(line_idx);
+FeatureLine Image::Line(const point2D_t line_idx) const {
+  return lines_.At(line_idx);
 }
 
-const FeatureLines& Image::Lines() const { return lines_; }
+const FeatureLineArray& Image::Lines() const { return lines_; }
 
 bool Image::IsPoint3DVisible(const point2D_t line_idx) const {
   return num_correspondences_have_point3D_.at(line_idx) > 0;
@@ -35,6 +35,7 @@
 
 #include "base/camera_models.h"
 #include "util/misc.h"
+#include "util/trace.h"
 
 namespace colmap {
 
@@ -92,10 +93,155 @@ std::vector<std::string> FilterNonImageFiles(const std::vector<std::string>& fil
 
   return image_file_paths;
 }
+
+bool IsNumericField(const std::string& field) {
+  char* end = nullptr;
+  StringToDouble(field.c_str(), &end);
+  return end != field.c_str() && *end == '\0';
+}
+
 } // namespace
 
+ImageMetadata ReadImageMetadataFiles(const std::string& image_path) {
+  ImageMetadata metadata;
+  metadata.has_gravity = ReadGravityFile(image_path + ".gravity.txt",
+                                         &metadata.gravity_direction);
+  metadata.has_camera = ReadCameraModelFile(image_path + ".camera_model.txt",
+                                            &metadata.camera);
+  return metadata;
+}
+
+std::unordered_map<std::string, ImageMetadata> ReadImageManifest(
+    const std::string& path) {
+  std::ifstream file(path);
+  CHECK(file.is_open()) << path;
+
+  std::unordered_map<std::string, ImageMetadata> manifest;
+
+  std::string line;
+  while (std::getline(file, line)) {
+    StringTrim(&line);
+
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+
+    // Split the line into its whitespace separated fields. Image names may
+    // contain spaces, so they are delimited by the trailing fields instead.
+    std::vector<size_t> field_begins;
+    std::vector<std::string> fields;
+    size_t pos = 0;
+    while (pos < line.size()) {
+      const size_t begin = line.find_first_not_of(" \t", pos);
+      if (begin == std::string::npos) {
+        break;
+      }
+      const size_t end =
+          std::min(line.find_first_of(" \t", begin), line.size());
+      field_begins.push_back(begin);
+      fields.push_back(line.substr(begin, end - begin));
+      pos = end;
+    }
+
+    // The camera model is the last non-numeric field and it is preceded by
+    // the three gravity coordinates.
+    int model_idx = static_cast<int>(fields.size()) - 1;
+    while (model_idx >= 0 && IsNumericField(fields[model_idx])) {
+      model_idx -= 1;
+    }
+    CHECK_GE(model_idx, 4) << "Invalid manifest line: " << line;
+
+    Eigen::Vector3d gravity;
+    for (int i = 0; i < 3; ++i) {
+      const std::string& field = fields[model_idx - 3 + i];
+      CHECK(IsNumericField(field)) << "Invalid manifest line: " << line;
+      gravity(i) = StringToDouble(field.c_str(), nullptr);
+    }
+
+    std::string image_name = line.substr(0, field_begins[model_idx - 3]);
+    StringTrim(&image_name);
+
+    ImageMetadata& metadata = manifest[image_name];
+
+    if (gravity != Eigen::Vector3d::Zero()) {
+      metadata.has_gravity = true;
+      metadata.gravity_direction = gravity.normalized();
+    }
+
+    const std::string& model_name = fields[model_idx];
+    if (ExistsCameraModelWithName(model_name)) {
+      metadata.camera.SetModelIdFromName(model_name);
+      std::vector<double> params;
+      for (size_t i = model_idx + 1; i < fields.size(); ++i) {
+        params.push_back(StringToDouble(fields[i].c_str(), nullptr));
+      }
+      metadata.camera.Params() = params;
+      metadata.has_camera = metadata.camera.VerifyParams();
+    }
+  }
+
+  return manifest;
+}
+
+void WriteImageManifest(
+    const std::string& path,
+    const std::unordered_map<std::string, ImageMetadata>& manifest) {
+  std::ofstream file(path, std::ios::trunc);
+  CHECK(file.is_open()) << path;
+
+  // Ensure that we don't loose any precision by storing in text.
+  file.precision(17);
+
+  file << "# Image manifest with one line of data per image:" << std::endl;
+  file << "#   IMAGE_NAME, GRAVITY_X, GRAVITY_Y, GRAVITY_Z, MODEL, PARAMS[]"
+       << std::endl;
+  file << "# A zero gravity direction or the model NONE mark missing data."
+       << std::endl;
+  file << "# Number of images: " << manifest.size() << std::endl;
+
+  std::vector<std::string> image_names;
+  image_names.reserve(manifest.size());
+  for (const auto& metadata : manifest) {
+    image_names.push_back(metadata.first);
+  }
+  std::sort(image_names.begin(), image_names.end());
+
+  for (const auto& image_name : image_names) {
+    const ImageMetadata& metadata = manifest.at(image_name);
+
+    std::ostringstream line;
+    line.imbue(std::locale::classic());
+    line.precision(17);
+
+    line << image_name << " ";
+
+    if (metadata.has_gravity) {
+      line << metadata.gravity_direction(0) << " "
+           << metadata.gravity_direction(1) << " "
+           << metadata.gravity_direction(2) << " ";
+    } else {
+      line << "0 0 0 ";
+    }
+
+    if (metadata.has_camera) {
+      line << metadata.camera.ModelName() << " ";
+      for (const double param : metadata.camera.Params()) {
+        line << param << " ";
+      }
+    } else {
+      line << "NONE ";
+    }
+
+    std::string line_string = line.str();
+    line_string = line_string.substr(0, line_string.size() - 1);
+
+    file << line_string << std::endl;
+  }
+}
+
 bool ImageReaderOptions::Check() const {
   CHECK_OPTION_GT(default_focal_length_factor, 0.0);
+  CHECK_OPTION_NE(num_threads, 0);
   CHECK_OPTION(ExistsCameraModelWithName(camera_model));
   const int model_id = CameraModelNameToId(camera_model);
   if (!camera_params.empty()) {
@@ -106,7 +252,10 @@ bool ImageReaderOptions::Check() const {
 }
 
 ImageReader::ImageReader(const ImageReaderOptions& options, Database* database)
-    : options_(options), database_(database), image_index_(0) {
+    : options_(options),
+      database_(database),
+      image_index_(0),
+      prefetch_index_(0) {
   CHECK(options_.Check());
 
   // Ensure trailing slash, so that we can build the correct image name.
@@ -136,6 +285,26 @@ ImageReader::ImageReader(const ImageReaderOptions& options, Database* database)
       default_camera_ = prev_camera_;
     }
   }
+
+  if (!options_.manifest_path.empty()) {
+    manifest_ = ReadImageManifest(options_.manifest_path);
+  }
+
+  image_ids_with_lines_ = database_->ExistingLineFeatureImageIds();
+  image_ids_with_descriptors_ = database_->ExistingDescriptorImageIds();
+
+  for (const auto& image : database_->ReadAllImages()) {
+    if (image_ids_with_lines_.count(image.ImageId()) > 0 &&
+        image_ids_with_descriptors_.count(image.ImageId()) > 0) {
+      complete_image_names_.insert(image.Name());
+    }
+  }
+
+  const int num_threads = GetEffectiveNumThreads(options_.num_threads);
+  thread_pool_.reset(new ThreadPool(num_threads));
+  // Keep a few decoded images per thread in flight, so that the workers do
+  // not idle while the consumer processes the current image.
+  num_prefetched_images_ = 2 * static_cast<size_t>(num_threads);
 }
 
 ImageReader::Status ImageReader::Next(Camera* camera, Image* image,
@@ -149,17 +318,18 @@ ImageReader::Status ImageReader::Next(Camera* camera, Image* image,
 
   const std::string image_path = options_.image_list.at(image_index_ - 1);
 
+  PrefetchImageFiles();
+  CHECK(!image_file_data_.empty());
+  ImageFileData file_data = image_file_data_.front().get();
+  image_file_data_.pop_front();
+
   DatabaseTransaction database_transaction(database_);
 
   //////////////////////////////////////////////////////////////////////////////
   // Set the image name.
   //////////////////////////////////////////////////////////////////////////////
 
-  image->SetName(image_path);
-  image->SetName(StringReplace(image->Name(), "\\", "/"));
-  image->SetName(
-      image->Name().substr(options_.image_path.size(),
-                           image->Name().size() - options_.image_path.size()));
+  image->SetName(ImageNameFromPath(image_path));
 
   const std::string image_folder = GetParentDir(image->Name());
 
@@ -171,48 +341,51 @@ ImageReader::Status ImageReader::Next(Camera* camera, Image* image,
 
   if (exists_image) {
     *image = database_->ReadImageWithName(image->Name());
-    const bool exists_lines = database_->ExistsLineFeatures(image->ImageId());
+    const bool exists_lines = image_ids_with_lines_.count(image->ImageId()) > 0;
     const bool exists_descriptors =
-        database_->ExistsDescriptors(image->ImageId());
+        image_ids_with_descriptors_.count(image->ImageId()) > 0;
 
     if (exists_lines && exists_descriptors) {
       return Status::IMAGE_EXISTS;
     }
   }
 
+  if (file_data.skipped) {
+    // The database changed since the image was prefetched.
+    file_data = ReadImageFile(image_path, false);
+  }
+
   //////////////////////////////////////////////////////////////////////////////
   // Read image.
   //////////////////////////////////////////////////////////////////////////////
 
-  if (!bitmap->Read(image_path, false)) {
+  if (!file_data.bitmap_valid) {
     return Status::BITMAP_ERROR;
   }
 
+  *bitmap = std::move(file_data.bitmap);
+
   //////////////////////////////////////////////////////////////////////////////
   // Read mask.
   //////////////////////////////////////////////////////////////////////////////
 
   if (mask && !options_.mask_path.empty()) {
-    const std::string mask_path =
-        JoinPaths(options_.mask_path,
-                  GetRelativePath(options_.image_path, image_path) + ".png");
-    if (ExistsFile(mask_path) && !mask->Read(mask_path, false)) {
+    if (!file_data.mask_valid) {
       // NOTE: Maybe introduce a separate error type MASK_ERROR?
       return Status::BITMAP_ERROR;
     }
+    *mask = std::move(file_data.mask);
   }
 
   //////////////////////////////////////////////////////////////////////////////
-  // Try to read gravity direction
+  // Set gravity direction
   //////////////////////////////////////////////////////////////////////////////
 
-  {
-    const std::string gravity_file_path = image_path + ".gravity.txt";
-    Eigen::Vector3d gravity_direction;
-    if (!ReadGravityFile(gravity_file_path, &gravity_direction)) {
-      gravity_direction.setConstant(std::numeric_limits<double>::quiet_NaN());
-    }
-    image->SetGravityDirection(gravity_direction);
+  if (file_data.metadata.has_gravity) {
+    image->SetGravityDirection(file_data.metadata.gravity_direction);
+  } else {
+    image->SetGravityDirection(Eigen::Vector3d::Constant(
+        std::numeric_limits<double>::quiet_NaN()));
   }
 
   //////////////////////////////////////////////////////////////////////////////
@@ -222,28 +395,29 @@ ImageReader::Status ImageReader::Next(Camera* camera, Image* image,
   if (exists_image) {
     const Camera camera = database_->ReadCamera(image->CameraId());
 
-    if (static_cast<size_t>(bitmap->Width()) != camera.Width() ||
-        static_cast<size_t>(bitmap->Height()) != camera.Height()) {
+    if (static_cast<size_t>(file_data.width) != camera.Width() ||
+        static_cast<size_t>(file_data.height) != camera.Height()) {
       return Status::CAMERA_EXIST_DIM_ERROR;
     }
   }
 
   //////////////////////////////////////////////////////////////////////////////
-  // Read camera model and parameters
+  // Set camera model and parameters
   //////////////////////////////////////////////////////////////////////////////
 
-  {
-    const std::string camera_model_file_path = image_path + ".camera_model.txt";
-    if (!ReadCameraModelFile(camera_model_file_path, &prev_camera_)) {
-      if (options_.camera_params.empty()) {
-        std::cout << "Could not read camera model file and no default model given\n";
-        return Status::FAILURE;
-      }
-      prev_camera_ = default_camera_;
+  if (file_data.metadata.has_camera) {
+    prev_camera_ = file_data.metadata.camera;
+  } else {
+    if (options_.camera_params.empty()) {
+      std::cout << "Could not read camera model file and no default model given\n";
+      return Status::FAILURE;
     }
-    prev_camera_.SetWidth(bitmap->Width());
-    prev_camera_.SetHeight(bitmap->Height());
+    prev_camera_ = default_camera_;
   }
+  // The bitmap may be decoded at a reduced resolution, but the camera always
+  // refers to the full resolution image.
+  prev_camera_.SetWidth(file_data.width);
+  prev_camera_.SetHeight(file_data.height);
 
   prev_camera_.SetCameraId(database_->WriteCamera(prev_camera_));
   image->SetCameraId(prev_camera_.CameraId());
@@ -269,4 +443,66 @@ size_t ImageReader::NextIndex() const { return image_index_; }
 
 size_t ImageReader::NumImages() const { return options_.image_list.size(); }
 
+std::string ImageReader::ImageNameFromPath(const std::string& image_path) const {
+  const std::string image_name = StringReplace(image_path, "\\", "/");
+  return image_name.substr(options_.image_path.size(),
+                           image_name.size() - options_.image_path.size());
+}
+
+ImageReader::ImageFileData ImageReader::ReadImageFile(
+    const std::string& image_path, const bool skip_complete) const {
+  TRACE_SCOPE("ReadImageFile");
+  ImageFileData file_data;
+
+  const std::string image_name = ImageNameFromPath(image_path);
+
+  if (skip_complete && complete_image_names_.count(image_name) > 0) {
+    file_data.skipped = true;
+    return file_data;
+  }
+
+  if (options_.max_image_size > 0) {
+    file_data.bitmap_valid = file_data.bitmap.ReadScaled(
+        image_path, false, options_.max_image_size, &file_data.width,
+        &file_data.height);
+  } else {
+    file_data.bitmap_valid = file_data.bitmap.Read(image_path, false);
+    file_data.width = file_data.bitmap.Width();
+    file_data.height = file_data.bitmap.Height();
+  }
+
+  if (!file_data.bitmap_valid) {
+    return file_data;
+  }
+
+  if (!options_.mask_path.empty()) {
+    const std::string mask_path =
+        JoinPaths(options_.mask_path,
+                  GetRelativePath(options_.image_path, image_path) + ".png");
+    if (ExistsFile(mask_path) && !file_data.mask.Read(mask_path, false)) {
+      file_data.mask_valid = false;
+      return file_data;
+    }
+  }
+
+  const auto manifest_it = manifest_.find(image_name);
+  if (manifest_it == manifest_.end()) {
+    file_data.metadata = ReadImageMetadataFiles(image_path);
+  } else {
+    file_data.metadata = manifest_it->second;
+  }
+
+  return file_data;
+}
+
+void ImageReader::PrefetchImageFiles() {
+  while (prefetch_index_ < options_.image_list.size() &&
+         prefetch_index_ < image_index_ + num_prefetched_images_) {
+    const std::string& image_path = options_.image_list[prefetch_index_];
+    image_file_data_.push_back(thread_pool_->AddTask(
+        &ImageReader::ReadImageFile, this, image_path, true));
+    prefetch_index_ += 1;
+  }
+}
+
 }  // namespace colmap
@@ -34,6 +34,9 @@
 #ifndef COLMAP_SRC_BASE_IMAGE_READER_H_
 #define COLMAP_SRC_BASE_IMAGE_READER_H_
 
+#include <deque>
+#include <future>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "base/database.h"
@@ -83,12 +86,50 @@ struct ImageReaderOptions {
   // intensity value 0 in grayscale).
   std::string camera_mask_path = "";
 
+  // Optional path to a manifest with the gravity direction and camera model of
+  // the images, see `WriteImageManifest`. Images that are not listed in the
+  // manifest fall back to their `.gravity.txt` and `.camera_model.txt` files.
+  std::string manifest_path = "";
+
+  // Number of threads that read and decode the upcoming images ahead of time.
+  int num_threads = -1;
+
+  // Maximum image size required by the consumer of the images. If positive,
+  // JPEG images are decoded at 1/2, 1/4 or 1/8 of their resolution, as long
+  // as their larger dimension stays at least this large. Cameras always refer
+  // to the full resolution images. This is set by the feature extractor.
+  int max_image_size = -1;
+
   bool Check() const;
 };
 
+// Metadata of an image, which is otherwise stored next to the image in the
+// files `<image_path>.gravity.txt` and `<image_path>.camera_model.txt`.
+struct ImageMetadata {
+  bool has_gravity = false;
+  Eigen::Vector3d gravity_direction = Eigen::Vector3d::Zero();
+
+  bool has_camera = false;
+  Camera camera;
+};
+
+// Read the metadata of an image from its gravity and camera model files.
+ImageMetadata ReadImageMetadataFiles(const std::string& image_path);
+
+// Read and write the metadata of many images in a single text file, where the
+// images are identified by their name relative to the image root path. This
+// avoids opening two small files per image, e.g. on network file systems.
+std::unordered_map<std::string, ImageMetadata> ReadImageManifest(
+    const std::string& path);
+void WriteImageManifest(
+    const std::string& path,
+    const std::unordered_map<std::string, ImageMetadata>& manifest);
+
 // Recursively iterate over the images in a directory. Skips an image if it
 // already exists in the database. Extracts the camera intrinsics from EXIF and
-// writes the camera information to the database.
+// writes the camera information to the database. The image files are read and
+// decoded by a thread pool several images ahead of the current image, while
+// the database is only accessed by the thread calling `Next`.
 class ImageReader {
  public:
   enum class Status {
@@ -108,6 +149,29 @@ class ImageReader {
   size_t NumImages() const;
 
  private:
+  // Data of an image that is read from the file system without accessing the
+  // database, such that it can be prefetched in parallel.
+  struct ImageFileData {
+    // Whether the image is already complete in the database and was skipped.
+    bool skipped = false;
+    bool bitmap_valid = false;
+    bool mask_valid = true;
+    Bitmap bitmap;
+    Bitmap mask;
+    // Dimensions of the full resolution image.
+    int width = 0;
+    int height = 0;
+    ImageMetadata metadata;
+  };
+
+  std::string ImageNameFromPath(const std::string& image_path) const;
+
+  ImageFileData ReadImageFile(const std::string& image_path,
+                              const bool skip_complete) const;
+
+  // Schedule the reading of the images following the current image.
+  void PrefetchImageFiles();
+
   // Image reader options.
   ImageReaderOptions options_;
   Database* database_;
@@ -119,6 +183,23 @@ class ImageReader {
   Camera default_camera_;
   // Names of image sub-folders.
   std::unordered_set<std::string> image_folders_;
+  // Images in the database with lines and descriptors when the reader was
+  // created. Every image is read only once, so images written afterwards
+  // never need to be checked.
+  std::unordered_set<image_t> image_ids_with_lines_;
+  std::unordered_set<image_t> image_ids_with_descriptors_;
+  // Metadata of the images in the manifest, indexed by image name.
+  std::unordered_map<std::string, ImageMetadata> manifest_;
+  // Names of the images with lines and descriptors, which are not read again.
+  std::unordered_set<std::string> complete_image_names_;
+  // Number of images read ahead of the current image.
+  size_t num_prefetched_images_;
+  // Index of the next image to prefetch.
+  size_t prefetch_index_;
+  std::deque<std::future<ImageFileData>> image_file_data_;
+  // Declared last, so that its workers are joined before the data they access
+  // is destroyed.
+  std::unique_ptr<ThreadPool> thread_pool_;
 };
 
 }  // namespace colmap
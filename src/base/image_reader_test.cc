@@ -0,0 +1,90 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#define TEST_NAME "base/image_reader"
+#include "util/testing.h"
+
+#include <boost/filesystem.hpp>
+
+#include "base/image_reader.h"
+
+using namespace colmap;
+
+BOOST_AUTO_TEST_CASE(TestImageManifestRoundTrip) {
+  const std::string manifest_path =
+      (boost::filesystem::temp_directory_path() /
+       boost::filesystem::unique_path("%%%%-%%%%-%%%%.txt"))
+          .string();
+
+  std::unordered_map<std::string, ImageMetadata> manifest;
+
+  ImageMetadata& full_metadata = manifest["dir/image 1.jpg"];
+  full_metadata.has_gravity = true;
+  full_metadata.gravity_direction =
+      Eigen::Vector3d(0.1, -0.2, 0.3).normalized();
+  full_metadata.has_camera = true;
+  full_metadata.camera.InitializeWithName("SIMPLE_RADIAL", 1234.5, 640, 480);
+  full_metadata.camera.Params(3) = -0.0625;
+
+  // An image without metadata, whose name contains spaces and numbers.
+  manifest["dir/image 2 1.5 3.jpg"];
+
+  ImageMetadata& gravity_metadata = manifest["image3.jpg"];
+  gravity_metadata.has_gravity = true;
+  gravity_metadata.gravity_direction = Eigen::Vector3d(0, 0, -1);
+
+  WriteImageManifest(manifest_path, manifest);
+  const auto read_manifest = ReadImageManifest(manifest_path);
+  boost::filesystem::remove(manifest_path);
+
+  BOOST_CHECK_EQUAL(read_manifest.size(), manifest.size());
+
+  const ImageMetadata& read_full_metadata =
+      read_manifest.at("dir/image 1.jpg");
+  BOOST_CHECK(read_full_metadata.has_gravity);
+  BOOST_CHECK_SMALL((read_full_metadata.gravity_direction -
+                     full_metadata.gravity_direction)
+                        .norm(),
+                    1e-12);
+  BOOST_CHECK(read_full_metadata.has_camera);
+  BOOST_CHECK_EQUAL(read_full_metadata.camera.ModelName(), "SIMPLE_RADIAL");
+  BOOST_CHECK_EQUAL(read_full_metadata.camera.ParamsToString(),
+                    full_metadata.camera.ParamsToString());
+
+  const ImageMetadata& read_empty_metadata =
+      read_manifest.at("dir/image 2 1.5 3.jpg");
+  BOOST_CHECK(!read_empty_metadata.has_gravity);
+  BOOST_CHECK(!read_empty_metadata.has_camera);
+
+  const ImageMetadata& read_gravity_metadata = read_manifest.at("image3.jpg");
+  BOOST_CHECK(read_gravity_metadata.has_gravity);
+  BOOST_CHECK_EQUAL(read_gravity_metadata.gravity_direction,
+                    Eigen::Vector3d(0, 0, -1));
+  BOOST_CHECK(!read_gravity_metadata.has_camera);
+}
@@ -31,8 +31,14 @@
 
 #include "base/point3d.h"
 
+#include "util/memory.h"
+
 namespace colmap {
 
 Point3D::Point3D() : xyz_(0.0, 0.0, 0.0), color_(0, 0, 0), error_(-1.0) {}
 
+size_t Point3D::NumBytes() const {
+  return sizeof(Point3D) + VectorNumBytes(track_.Elements());
+}
+
 }  // namespace colmap
@@ -75,6 +75,9 @@ class Point3D {
   inline class Track& Track();
   inline void SetTrack(const class Track& track);
 
+  // Estimated size of the point in memory in bytes.
+  size_t NumBytes() const;
+
  private:
   // The 3D position of the point.
   Eigen::Vector3d xyz_;
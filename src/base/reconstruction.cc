@@ -33,17 +33,224 @@
 
 #include "base/reconstruction.h"
 
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <sstream>
 
 #include "base/database_cache.h"
 #include "base/pose.h"
 #include "base/projection.h"
+#include "base/similarity_transform.h"
 #include "base/triangulation.h"
 #include "util/bitmap.h"
+#include "util/memory.h"
 #include "util/misc.h"
 #include "util/ply.h"
+#include "util/threading.h"
 
 namespace colmap {
+namespace {
+
+// A line of a text file in memory without the line break.
+struct TextLine {
+  const char* begin;
+  const char* end;
+};
+
+bool IsTextWhiteSpace(const char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' ||
+         c == '\f';
+}
+
+// Read the entire text file into memory, so that its lines can be parsed in
+// parallel without copying them.
+std::string ReadTextFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  CHECK(file.is_open()) << path;
+  file.seekg(0, std::ios::end);
+  const std::streamoff num_bytes = file.tellg();
+  file.seekg(0, std::ios::beg);
+  std::string text(static_cast<size_t>(num_bytes), '\0');
+  file.read(&text[0], num_bytes);
+  CHECK(file.good()) << path;
+  return text;
+}
+
+// Split the text into its trimmed lines.
+std::vector<TextLine> SplitTextLines(const std::string& text) {
+  std::vector<TextLine> lines;
+  const char* begin = text.data();
+  const char* text_end = text.data() + text.size();
+  while (begin < text_end) {
+    const char* end = static_cast<const char*>(
+        std::memchr(begin, '\n', static_cast<size_t>(text_end - begin)));
+    if (end == nullptr) {
+      end = text_end;
+    }
+    TextLine line = {begin, end};
+    while (line.begin < line.end && IsTextWhiteSpace(*line.begin)) {
+      ++line.begin;
+    }
+    while (line.end > line.begin && IsTextWhiteSpace(*(line.end - 1))) {
+      --line.end;
+    }
+    lines.push_back(line);
+    begin = end + 1;
+  }
+  return lines;
+}
+
+bool IsEmptyOrCommentLine(const TextLine& line) {
+  return line.begin == line.end || *line.begin == '#';
+}
+
+// Parser of the items of a line separated by white space, which avoids the
+// string streams and copies of each item for large text files. The line
+// must be part of a null-terminated text.
+class TextLineParser {
+ public:
+  explicit TextLineParser(const TextLine& line)
+      : pos_(line.begin), end_(line.end) {}
+
+  bool AtEnd() {
+    SkipWhiteSpace();
+    return pos_ == end_;
+  }
+
+  std::string NextString() {
+    SkipWhiteSpace();
+    const char* begin = pos_;
+    while (pos_ < end_ && !IsTextWhiteSpace(*pos_)) {
+      ++pos_;
+    }
+    return std::string(begin, pos_);
+  }
+
+  double NextDouble() {
+    BeginItem();
+    char* item_end;
+    const double value = StringToDouble(pos_, &item_end);
+    EndItem(item_end);
+    return value;
+  }
+
+  float NextFloat() {
+    BeginItem();
+    char* item_end;
+    const float value = StringToFloat(pos_, &item_end);
+    EndItem(item_end);
+    return value;
+  }
+
+  long long NextInt() {
+    BeginItem();
+    char* item_end;
+    const long long value = std::strtoll(pos_, &item_end, 10);
+    EndItem(item_end);
+    return value;
+  }
+
+  unsigned long long NextUInt() {
+    BeginItem();
+    char* item_end;
+    const unsigned long long value = std::strtoull(pos_, &item_end, 10);
+    EndItem(item_end);
+    return value;
+  }
+
+ private:
+  void SkipWhiteSpace() {
+    while (pos_ < end_ && IsTextWhiteSpace(*pos_)) {
+      ++pos_;
+    }
+  }
+
+  void BeginItem() {
+    SkipWhiteSpace();
+    CHECK_LT(pos_, end_) << "Missing item in line";
+  }
+
+  void EndItem(const char* item_end) {
+    CHECK(item_end > pos_ && item_end <= end_ &&
+          (item_end == end_ || IsTextWhiteSpace(*item_end)))
+        << "Invalid item in line: " << std::string(pos_, end_);
+    pos_ = item_end;
+  }
+
+  const char* pos_;
+  const char* end_;
+};
+
+// Apply the function to all items in parallel and return the results in the
+// order of the items, where each task processes at least `grain_size` items.
+template <typename Result, typename Item, typename Func>
+std::vector<Result> ParallelTransform(const std::vector<Item>& items,
+                                      const size_t grain_size,
+                                      const Func& func) {
+  std::vector<Result> results(items.size());
+
+  // Only start threads if there is more than one chunk of work.
+  const size_t num_chunks = (items.size() + grain_size - 1) / grain_size;
+  std::unique_ptr<WorkStealingThreadPool> thread_pool;
+  if (num_chunks > 1) {
+    const size_t num_threads = std::min(
+        static_cast<size_t>(
+            GetEffectiveNumThreads(WorkStealingThreadPool::kMaxNumThreads)),
+        num_chunks);
+    thread_pool.reset(
+        new WorkStealingThreadPool(static_cast<int>(num_threads)));
+  }
+
+  ParallelFor(thread_pool.get(), 0, items.size(), grain_size,
+              [&items, &results, &func](const size_t i) {
+                results[i] = func(items[i]);
+              });
+
+  return results;
+}
+
+// Format the items in parallel chunks with one string stream per chunk, which
+// are written to the file in the order of the items. The streams use the
+// classic locale and the same precision as the file.
+template <typename Item, typename Func>
+void WriteTextRecords(const std::vector<Item>& items, const Func& func,
+                      std::ofstream* file) {
+  const size_t kNumItemsPerChunk = 1024;
+  std::vector<size_t> chunk_begins;
+  for (size_t begin = 0; begin < items.size(); begin += kNumItemsPerChunk) {
+    chunk_begins.push_back(begin);
+  }
+
+  const std::vector<std::string> chunks = ParallelTransform<std::string>(
+      chunk_begins, 1, [&](const size_t begin) -> std::string {
+        std::ostringstream stream;
+        stream.imbue(std::locale::classic());
+        stream.precision(file->precision());
+        const size_t end = std::min(begin + kNumItemsPerChunk, items.size());
+        for (size_t i = begin; i < end; ++i) {
+          func(items[i], &stream);
+        }
+        return stream.str();
+      });
+
+  for (const auto& chunk : chunks) {
+    file->write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+  }
+}
+
+PlyPoint Point3DToPly(const Point3D& point3D) {
+  PlyPoint ply_point;
+  ply_point.x = point3D.X();
+  ply_point.y = point3D.Y();
+  ply_point.z = point3D.Z();
+  ply_point.r = point3D.Color(0);
+  ply_point.g = point3D.Color(1);
+  ply_point.b = point3D.Color(2);
+  return ply_point;
+}
+
+}  // namespace
 
 Reconstruction::Reconstruction()
     : correspondence_graph_(nullptr), num_added_points3D_(0) {}
@@ -109,7 +316,7 @@ void Reconstruction::SetUp(const CorrespondenceGraph* correspondence_graph) {
     const class Image& image = Image(image_id);
     for (point2D_t line_idx = 0; line_idx < image.NumLines();
          ++line_idx) {
-      if (image.Line(line_idx).HasPoint3D()) {
+      if (image.Lines().HasPoint3D(line_idx)) {
         const bool kIsContinuedPoint3D = false;
         SetObservationAsTriangulated(image_id, line_idx,
                                      kIsContinuedPoint3D);
@@ -145,6 +352,15 @@ void Reconstruction::TearDown() {
   for (auto& point3D : points3D_) {
     point3D.second.Track().Compress();
   }
+
+  // The triangulated correspondences are counted again by `SetUp`, when the
+  // reconstruction is continued, possibly with a grown correspondence graph.
+  for (auto& image : images_) {
+    image.second.ResetCorrespondencesHavePoint3D();
+  }
+  for (auto& image_pair_stat : image_pair_stats_) {
+    image_pair_stat.second.num_tri_corrs = 0;
+  }
 }
 
 void Reconstruction::AddCamera(const class Camera& camera) {
@@ -172,7 +388,7 @@ point3D_t Reconstruction::AddPoint3D(const Eigen::Vector3d& xyz,
 
   for (const auto& track_el : track.Elements()) {
     class Image& image = Image(track_el.image_id);
-    CHECK(!image.Line(track_el.line_idx).HasPoint3D());
+    CHECK(!image.Lines().HasPoint3D(track_el.line_idx));
     image.SetPoint3DForLine(track_el.line_idx, point3D_id);
     CHECK_LE(image.NumPoints3D(), image.NumLines());
   }
@@ -190,7 +406,7 @@ point3D_t Reconstruction::AddPoint3D(const Eigen::Vector3d& xyz,
 void Reconstruction::AddObservation(const point3D_t point3D_id,
                                     const TrackElement& track_el) {
   class Image& image = Image(track_el.image_id);
-  CHECK(!image.Line(track_el.line_idx).HasPoint3D());
+  CHECK(!image.Lines().HasPoint3D(track_el.line_idx));
 
   image.SetPoint3DForLine(track_el.line_idx, point3D_id);
   CHECK_LE(image.NumPoints3D(), image.NumLines());
@@ -258,7 +474,7 @@ void Reconstruction::DeleteObservation(const image_t image_id,
   // `Reconstruction::ResetTriObservations`
 
   class Image& image = Image(image_id);
-  const point3D_t point3D_id = image.Line(line_idx).Point3DId();
+  const point3D_t point3D_id = image.Lines().Point3DId(line_idx);
   class Point3D& point3D = Point3D(point3D_id);
 
   if (point3D.Track().Length() <= 3) {
@@ -287,7 +503,7 @@ void Reconstruction::DeRegisterImage(const image_t image_id) {
 
   for (point2D_t line_idx = 0; line_idx < image.NumLines();
        ++line_idx) {
-    if (image.Line(line_idx).HasPoint3D()) {
+    if (image.Lines().HasPoint3D(line_idx)) {
       DeleteObservation(image_id, line_idx);
     }
   }
@@ -396,6 +612,109 @@ void Reconstruction::Normalize(const double extent, const double p0,
   }
 }
 
+bool Reconstruction::Merge(const Reconstruction& reconstruction,
+                           const double max_reproj_error) {
+  CHECK(correspondence_graph_ == nullptr);
+
+  const double kMinInlierRatio = 0.3;
+
+  SimilarityTransform3 tform;
+  if (!ComputeAlignmentBetweenReconstructions(reconstruction, *this,
+                                              kMinInlierRatio,
+                                              max_reproj_error, &tform)) {
+    return false;
+  }
+
+  // Find common and missing images in the two reconstructions.
+  std::unordered_set<image_t> common_image_ids;
+  std::unordered_set<image_t> missing_image_ids;
+  for (const auto& image_id : reconstruction.RegImageIds()) {
+    if (ExistsImage(image_id) && Image(image_id).IsRegistered()) {
+      common_image_ids.insert(image_id);
+    } else {
+      missing_image_ids.insert(image_id);
+    }
+  }
+
+  // Register the missing images in this reconstruction.
+  for (const auto image_id : missing_image_ids) {
+    class Image reg_image = reconstruction.Image(image_id);
+    reg_image.SetRegistered(false);
+    for (point2D_t line_idx = 0; line_idx < reg_image.NumLines();
+         ++line_idx) {
+      reg_image.ResetPoint3DForLine(line_idx);
+    }
+    if (ExistsImage(image_id)) {
+      images_.erase(image_id);
+    }
+    AddImage(reg_image);
+    RegisterImage(image_id);
+    if (!ExistsCamera(reg_image.CameraId())) {
+      AddCamera(reconstruction.Camera(reg_image.CameraId()));
+    }
+    class Image& image = Image(image_id);
+    tform.TransformPose(&image.Qvec(), &image.Tvec());
+  }
+
+  // Merge the two point clouds using the following two rules:
+  //    - copy points to this reconstruction with non-conflicting tracks,
+  //      i.e. points that do not have an already triangulated observation
+  //      in this reconstruction.
+  //    - merge tracks that are unambiguous, i.e. only merge points in the two
+  //      reconstructions if they have a one-to-one mapping.
+  // Note that in both cases no cheirality or reprojection test is performed,
+  // the merged points are filtered afterwards.
+  for (const auto& point3D : reconstruction.Points3D()) {
+    Track new_track;
+    std::unordered_set<point3D_t> old_point3D_ids;
+    for (const auto& track_el : point3D.second.Track().Elements()) {
+      if (common_image_ids.count(track_el.image_id) > 0) {
+        const class Image& image = Image(track_el.image_id);
+        if (image.Lines().HasPoint3D(track_el.line_idx)) {
+          old_point3D_ids.insert(image.Lines().Point3DId(track_el.line_idx));
+        } else {
+          new_track.AddElement(track_el);
+        }
+      } else if (missing_image_ids.count(track_el.image_id) > 0) {
+        new_track.AddElement(track_el);
+      }
+    }
+
+    // A point needs at least three feature lines to be constrained.
+    const size_t kMinTrackLength = 3;
+    const bool create_new_point = new_track.Length() >= kMinTrackLength &&
+                                  old_point3D_ids.size() != 1;
+    const bool merge_new_and_old_point =
+        new_track.Length() > 0 && old_point3D_ids.size() == 1;
+    if (create_new_point) {
+      Eigen::Vector3d xyz = point3D.second.XYZ();
+      tform.TransformPoint(&xyz);
+      AddPoint3D(xyz, new_track, point3D.second.Color());
+    } else if (merge_new_and_old_point) {
+      const point3D_t old_point3D_id = *old_point3D_ids.begin();
+      for (const auto& track_el : new_track.Elements()) {
+        AddObservation(old_point3D_id, track_el);
+      }
+    }
+  }
+
+  FilterAllPoints3D(max_reproj_error, 0.0);
+
+  return true;
+}
+
+std::vector<image_t> Reconstruction::FindCommonRegImageIds(
+    const Reconstruction& reconstruction) const {
+  std::vector<image_t> common_reg_image_ids;
+  for (const auto image_id : reg_image_ids_) {
+    if (reconstruction.ExistsImage(image_id) &&
+        reconstruction.Image(image_id).IsRegistered()) {
+      common_reg_image_ids.push_back(image_id);
+    }
+  }
+  return common_reg_image_ids;
+}
+
 size_t Reconstruction::FilterPoints3D(
     const double max_reproj_error, const double min_tri_angle,
     const std::unordered_set<point3D_t>& point3D_ids) {
@@ -446,9 +765,9 @@ size_t Reconstruction::FilterObservationsWithNegativeDepth() {
     const Eigen::Matrix3x4d proj_matrix = image.ProjectionMatrix();
     for (point2D_t line_idx = 0; line_idx < image.NumLines();
          ++line_idx) {
-      const FeatureLine& line = image.Line(line_idx);
-      if (line.HasPoint3D()) {
-        const class Point3D& point3D = Point3D(line.Point3DId());
+      if (image.Lines().HasPoint3D(line_idx)) {
+        const class Point3D& point3D =
+            Point3D(image.Lines().Point3DId(line_idx));
         if (!HasPointPositiveDepth(proj_matrix, point3D.XYZ())) {
           DeleteObservation(image_id, line_idx);
           num_filtered += 1;
@@ -557,14 +876,7 @@ std::vector<PlyPoint> Reconstruction::ConvertToPLY() const {
   ply_points.reserve(points3D_.size());
 
   for (const auto& point3D : points3D_) {
-    PlyPoint ply_point;
-    ply_point.x = point3D.second.X();
-    ply_point.y = point3D.second.Y();
-    ply_point.z = point3D.second.Z();
-    ply_point.r = point3D.second.Color(0);
-    ply_point.g = point3D.second.Color(1);
-    ply_point.b = point3D.second.Color(2);
-    ply_points.push_back(ply_point);
+    ply_points.push_back(Point3DToPly(point3D.second));
   }
 
   return ply_points;
@@ -584,11 +896,21 @@ void Reconstruction::ImportPLY(const std::string& path) {
 }
 
 void Reconstruction::ExportPLY(const std::string& path) const {
-  const auto ply_points = ConvertToPLY();
-
+  // The points are streamed to the file instead of converting them at once.
   const bool kWriteNormal = false;
   const bool kWriteRGB = true;
-  WriteBinaryPlyPoints(path, ply_points, kWriteNormal, kWriteRGB);
+  BinaryPlyPointsWriter writer(path, points3D_.size(), kWriteNormal,
+                               kWriteRGB);
+  for (const auto& point3D : points3D_) {
+    writer.Write(Point3DToPly(point3D.second));
+  }
+  writer.Close();
+}
+
+size_t Reconstruction::NumBytes() const {
+  return sizeof(Reconstruction) + NestedHashMapNumBytes(cameras_) +
+         NestedHashMapNumBytes(images_) + NestedHashMapNumBytes(points3D_) +
+         HashMapNumBytes(image_pair_stats_) + VectorNumBytes(reg_image_ids_);
 }
 
 size_t Reconstruction::FilterPoints3DWithSmallTriangulationAngle(
@@ -670,7 +992,7 @@ size_t Reconstruction::FilterPoints3DWithLargeReprojectionError(
 
     bool have_non_aligned = false;
     for (const auto& track_el : point3D.Track().Elements()) {
-        if(!Image(track_el.image_id).Line(track_el.line_idx).IsAligned())
+        if(!Image(track_el.image_id).Lines().IsAligned(track_el.line_idx))
           have_non_aligned = true;
     }
     if(!have_non_aligned) {
@@ -692,10 +1014,10 @@ size_t Reconstruction::FilterPoints3DWithLargeReprojectionError(
     for (const auto& track_el : point3D.Track().Elements()) {
       const class Image& image = Image(track_el.image_id);
       const class Camera& camera = Camera(image.CameraId());
-      const FeatureLine& line2D = image.Line(track_el.line_idx);
-      CHECK_NEAR(line2D.Line().head<2>().norm(), 1.0, 1e-6);
+      const Eigen::Vector3d& line2D = image.Lines().Line(track_el.line_idx);
+      CHECK_NEAR(line2D.head<2>().norm(), 1.0, 1e-6);
       const double squared_reproj_error = CalculateSquaredLineReprojectionError(
-          line2D.Line(), point3D.XYZ(), image.Qvec(), image.Tvec(), camera);
+          line2D, point3D.XYZ(), image.Qvec(), image.Tvec(), camera);
       if (squared_reproj_error > max_squared_reproj_error) {
         track_els_to_delete.push_back(track_el);
       } else {
@@ -770,104 +1092,81 @@ void Reconstruction::ReadCamerasText(const std::string& path) {
 void Reconstruction::ReadImagesText(const std::string& path) {
   images_.clear();
 
-  std::ifstream file(path);
-  CHECK(file.is_open()) << path;
-
-  std::string line;
-  std::string item;
+  const std::string text = ReadTextFile(path);
+  const std::vector<TextLine> lines = SplitTextLines(text);
 
-  while (std::getline(file, line)) {
-    StringTrim(&line);
-
-    if (line.empty() || line[0] == '#') {
+  // Each image has a line with its pose and a line with its 2D lines, which
+  // may be empty. The records are split sequentially and parsed in parallel.
+  std::vector<std::pair<TextLine, TextLine>> records;
+  for (size_t i = 0; i < lines.size(); ++i) {
+    if (IsEmptyOrCommentLine(lines[i])) {
       continue;
     }
+    if (i + 1 == lines.size()) {
+      break;
+    }
+    records.emplace_back(lines[i], lines[i + 1]);
+    i += 1;
+  }
 
-    std::stringstream line_stream1(line);
-
-    // ID
-    std::getline(line_stream1, item, ' ');
-    const image_t image_id = std::stoul(item);
-
-    class Image image;
-    image.SetImageId(image_id);
-
-    image.SetRegistered(true);
-    reg_image_ids_.push_back(image_id);
-
-    // QVEC (qw, qx, qy, qz)
-    std::getline(line_stream1, item, ' ');
-    image.Qvec(0) = std::stold(item);
-
-    std::getline(line_stream1, item, ' ');
-    image.Qvec(1) = std::stold(item);
-
-    std::getline(line_stream1, item, ' ');
-    image.Qvec(2) = std::stold(item);
-
-    std::getline(line_stream1, item, ' ');
-    image.Qvec(3) = std::stold(item);
-
-    image.NormalizeQvec();
+  // An image record contains all 2D lines of the image, so that only few
+  // records are parsed per task.
+  const size_t kNumImagesPerTask = 16;
+  std::vector<class Image> images = ParallelTransform<class Image>(
+      records, kNumImagesPerTask,
+      [](const std::pair<TextLine, TextLine>& record) -> class Image {
+        TextLineParser parser1(record.first);
 
-    // TVEC
-    std::getline(line_stream1, item, ' ');
-    image.Tvec(0) = std::stold(item);
+        class Image image;
 
-    std::getline(line_stream1, item, ' ');
-    image.Tvec(1) = std::stold(item);
+        // ID
+        image.SetImageId(static_cast<image_t>(parser1.NextUInt()));
 
-    std::getline(line_stream1, item, ' ');
-    image.Tvec(2) = std::stold(item);
+        image.SetRegistered(true);
 
-    // CAMERA_ID
-    std::getline(line_stream1, item, ' ');
-    image.SetCameraId(std::stoul(item));
+        // QVEC (qw, qx, qy, qz)
+        image.Qvec(0) = parser1.NextDouble();
+        image.Qvec(1) = parser1.NextDouble();
+        image.Qvec(2) = parser1.NextDouble();
+        image.Qvec(3) = parser1.NextDouble();
 
-    // NAME
-    std::getline(line_stream1, item, ' ');
-    image.SetName(item);
+        image.NormalizeQvec();
 
-    // LINES2D
-    if (!std::getline(file, line)) {
-        break;
-    }
+        // TVEC
+        image.Tvec(0) = parser1.NextDouble();
+        image.Tvec(1) = parser1.NextDouble();
+        image.Tvec(2) = parser1.NextDouble();
 
-    FeatureLines feature_lines;
+        // CAMERA_ID
+        image.SetCameraId(static_cast<camera_t>(parser1.NextUInt()));
 
-    StringTrim(&line);
-    std::stringstream line_stream2(line);
+        // NAME
+        image.SetName(parser1.NextString());
 
-    if (!line.empty()) {
-      while (!line_stream2.eof()) {
+        // LINES2D
+        TextLineParser parser2(record.second);
+        if (parser2.AtEnd()) {
+          return image;
+        }
 
+        FeatureLines feature_lines;
+        while (!parser2.AtEnd()) {
           FeatureLine feature_line;
 
           Eigen::Vector3d line_dir;
+          line_dir(0) = parser2.NextFloat();
+          line_dir(1) = parser2.NextFloat();
+          line_dir(2) = parser2.NextFloat();
 
-          std::getline(line_stream2, item, ' ');
-
-          line_dir(0) = std::stof(item);
-
-          std::getline(line_stream2, item, ' ');
-          line_dir(1) = std::stof(item);
-
-          std::getline(line_stream2, item, ' ');
-          line_dir(2) = std::stof(item);
-
-          std::getline(line_stream2, item, ' ');
-          if (item == "1") {
-              feature_line.SetAligned(true);
-          } else {
-              CHECK(item == "0");
-              feature_line.SetAligned(false);
-          }
+          const long long is_aligned = parser2.NextInt();
+          CHECK(is_aligned == 0 || is_aligned == 1);
+          feature_line.SetAligned(is_aligned == 1);
 
-          std::getline(line_stream2, item, ' ');
-          if (item == "-1") {
-              feature_line.SetPoint3DId(kInvalidPoint3DId);
+          const long long point3D_id = parser2.NextInt();
+          if (point3D_id == -1) {
+            feature_line.SetPoint3DId(kInvalidPoint3DId);
           } else {
-              feature_line.SetPoint3DId(std::stoll(item));
+            feature_line.SetPoint3DId(static_cast<point3D_t>(point3D_id));
           }
 
           // Normalize line to simplify distance computations
@@ -876,87 +1175,72 @@ void Reconstruction::ReadImagesText(const std::string& path) {
           feature_line.SetLine(line_dir / normalization_factor);
 
           feature_lines.push_back(feature_line);
-      }
+        }
 
-      image.SetLines(feature_lines);
-    }
+        image.SetLines(feature_lines);
+
+        return image;
+      });
 
-    images_.emplace(image.ImageId(), image);
+  images_.reserve(images.size());
+  for (auto& image : images) {
+    reg_image_ids_.push_back(image.ImageId());
+    images_.emplace(image.ImageId(), std::move(image));
   }
 }
 
 void Reconstruction::ReadPoints3DText(const std::string& path) {
   points3D_.clear();
 
-  std::ifstream file(path);
-  CHECK(file.is_open()) << path;
-
-  std::string line;
-  std::string item;
+  const std::string text = ReadTextFile(path);
+  std::vector<TextLine> lines = SplitTextLines(text);
+  lines.erase(std::remove_if(lines.begin(), lines.end(), IsEmptyOrCommentLine),
+              lines.end());
 
-  while (std::getline(file, line)) {
-    StringTrim(&line);
+  const size_t kNumPoints3DPerTask = 1024;
+  std::vector<std::pair<point3D_t, class Point3D>> points3D =
+      ParallelTransform<std::pair<point3D_t, class Point3D>>(
+          lines, kNumPoints3DPerTask,
+          [](const TextLine& line) -> std::pair<point3D_t, class Point3D> {
+            TextLineParser parser(line);
 
-    if (line.empty() || line[0] == '#') {
-      continue;
-    }
+            std::pair<point3D_t, class Point3D> point3D;
 
-    std::stringstream line_stream(line);
+            // ID
+            point3D.first = static_cast<point3D_t>(parser.NextInt());
 
-    // ID
-    std::getline(line_stream, item, ' ');
-    const point3D_t point3D_id = std::stoll(item);
+            // XYZ
+            point3D.second.XYZ(0) = parser.NextDouble();
+            point3D.second.XYZ(1) = parser.NextDouble();
+            point3D.second.XYZ(2) = parser.NextDouble();
 
-    // Make sure, that we can add new 3D points after reading 3D points
-    // without overwriting existing 3D points.
-    num_added_points3D_ = std::max(num_added_points3D_, point3D_id);
+            // Color
+            point3D.second.Color(0) = static_cast<uint8_t>(parser.NextInt());
+            point3D.second.Color(1) = static_cast<uint8_t>(parser.NextInt());
+            point3D.second.Color(2) = static_cast<uint8_t>(parser.NextInt());
 
-    class Point3D point3D;
+            // ERROR
+            point3D.second.SetError(parser.NextDouble());
 
-    // XYZ
-    std::getline(line_stream, item, ' ');
-    point3D.XYZ(0) = std::stold(item);
+            // TRACK
+            while (!parser.AtEnd()) {
+              TrackElement track_el;
+              track_el.image_id = static_cast<image_t>(parser.NextUInt());
+              track_el.line_idx = static_cast<point2D_t>(parser.NextUInt());
+              point3D.second.Track().AddElement(track_el);
+            }
 
-    std::getline(line_stream, item, ' ');
-    point3D.XYZ(1) = std::stold(item);
+            point3D.second.Track().Compress();
 
-    std::getline(line_stream, item, ' ');
-    point3D.XYZ(2) = std::stold(item);
+            return point3D;
+          });
 
-    // Color
-    std::getline(line_stream, item, ' ');
-    point3D.Color(0) = static_cast<uint8_t>(std::stoi(item));
-
-    std::getline(line_stream, item, ' ');
-    point3D.Color(1) = static_cast<uint8_t>(std::stoi(item));
-
-    std::getline(line_stream, item, ' ');
-    point3D.Color(2) = static_cast<uint8_t>(std::stoi(item));
-
-    // ERROR
-    std::getline(line_stream, item, ' ');
-    point3D.SetError(std::stold(item));
-
-    // TRACK
-    while (!line_stream.eof()) {
-      TrackElement track_el;
-
-      std::getline(line_stream, item, ' ');
-      StringTrim(&item);
-      if (item.empty()) {
-        break;
-      }
-      track_el.image_id = std::stoul(item);
-
-      std::getline(line_stream, item, ' ');
-      track_el.line_idx = std::stoul(item);
-
-      point3D.Track().AddElement(track_el);
-    }
-
-    point3D.Track().Compress();
-
-    points3D_.emplace(point3D_id, point3D);
+  points3D_.reserve(points3D.size());
+  for (auto& point3D : points3D) {
+    // Make sure, that we can add new 3D points after reading 3D points
+    // without overwriting existing 3D points.
+    num_added_points3D_ = std::max(num_added_points3D_, point3D.first);
+    points3D_.emplace(point3D.first, std::move(point3D.second));
   }
 }
 
@@ -1006,54 +1290,56 @@ void Reconstruction::WriteImagesText(const std::string& path) const {
        << ", mean observations per image: "
        << ComputeMeanObservationsPerRegImage() << std::endl;
 
+  std::vector<const class Image*> reg_images;
+  reg_images.reserve(reg_image_ids_.size());
   for (const auto& image : images_) {
-    if (!image.second.IsRegistered()) {
-      continue;
+    if (image.second.IsRegistered()) {
+      reg_images.push_back(&image.second);
     }
+  }
 
-    std::ostringstream line;
-    std::string line_string;
-
-    line << image.first << " ";
-
-    // QVEC (qw, qx, qy, qz)
-    const Eigen::Vector4d normalized_qvec =
-        NormalizeQuaternion(image.second.Qvec());
-    line << normalized_qvec(0) << " ";
-    line << normalized_qvec(1) << " ";
-    line << normalized_qvec(2) << " ";
-    line << normalized_qvec(3) << " ";
-
-    // TVEC
-    line << image.second.Tvec(0) << " ";
-    line << image.second.Tvec(1) << " ";
-    line << image.second.Tvec(2) << " ";
+  WriteTextRecords(
+      reg_images,
+      [](const class Image* image, std::ostringstream* line) {
+        *line << image->ImageId() << " ";
 
-    line << image.second.CameraId() << " ";
+        // QVEC (qw, qx, qy, qz)
+        const Eigen::Vector4d normalized_qvec =
+            NormalizeQuaternion(image->Qvec());
+        *line << normalized_qvec(0) << " ";
+        *line << normalized_qvec(1) << " ";
+        *line << normalized_qvec(2) << " ";
+        *line << normalized_qvec(3) << " ";
 
-    line << image.second.Name();
+        // TVEC
+        *line << image->Tvec(0) << " ";
+        *line << image->Tvec(1) << " ";
+        *line << image->Tvec(2) << " ";
 
-    file << line.str() << std::endl;
+        *line << image->CameraId() << " ";
 
-    line.str("");
-    line.clear();
+        *line << image->Name() << "\n";
 
-    for (const FeatureLine& feature_line : image.second.Lines()) {
-      const Eigen::Vector3d& line_dir = feature_line.Line();
-      line << line_dir(0) << " ";
-      line << line_dir(1) << " ";
-      line << line_dir(2) << " ";
-      line << (feature_line.IsAligned() ? "1" : "0") << " ";
-      if (feature_line.HasPoint3D()) {
-        line << feature_line.Point3DId() << " ";
-      } else {
-        line << -1 << " ";
-      }
-    }
-    line_string = line.str();
-    line_string = line_string.substr(0, line_string.size() - 1);
-    file << line_string << std::endl;
-  }
+        bool first_line = true;
+        for (const FeatureLine& feature_line : image->Lines()) {
+          if (!first_line) {
+            *line << " ";
+          }
+          first_line = false;
+          const Eigen::Vector3d& line_dir = feature_line.Line();
+          *line << line_dir(0) << " ";
+          *line << line_dir(1) << " ";
+          *line << line_dir(2) << " ";
+          *line << (feature_line.IsAligned() ? "1" : "0") << " ";
+          if (feature_line.HasPoint3D()) {
+            *line << feature_line.Point3DId();
+          } else {
+            *line << -1;
+          }
+        }
+        *line << "\n";
+      },
+      &file);
 }
 
 void Reconstruction::WritePoints3DText(const std::string& path) const {
@@ -1070,28 +1356,33 @@ void Reconstruction::WritePoints3DText(const std::string& path) const {
   file << "# Number of points: " << points3D_.size()
        << ", mean track length: " << ComputeMeanTrackLength() << std::endl;
 
+  std::vector<const std::pair<const point3D_t, class Point3D>*> points3D;
+  points3D.reserve(points3D_.size());
   for (const auto& point3D : points3D_) {
-    file << point3D.first << " ";
-    file << point3D.second.XYZ()(0) << " ";
-    file << point3D.second.XYZ()(1) << " ";
-    file << point3D.second.XYZ()(2) << " ";
-    file << static_cast<int>(point3D.second.Color(0)) << " ";
-    file << static_cast<int>(point3D.second.Color(1)) << " ";
-    file << static_cast<int>(point3D.second.Color(2)) << " ";
-    file << point3D.second.Error() << " ";
-
-    std::ostringstream line;
-
-    for (const auto& track_el : point3D.second.Track().Elements()) {
-      line << track_el.image_id << " ";
-      line << track_el.line_idx << " ";
-    }
+    points3D.push_back(&point3D);
+  }
 
-    std::string line_string = line.str();
-    line_string = line_string.substr(0, line_string.size() - 1);
+  WriteTextRecords(
+      points3D,
+      [](const std::pair<const point3D_t, class Point3D>* point3D,
+         std::ostringstream* line) {
+        *line << point3D->first << " ";
+        *line << point3D->second.XYZ()(0) << " ";
+        *line << point3D->second.XYZ()(1) << " ";
+        *line << point3D->second.XYZ()(2) << " ";
+        *line << static_cast<int>(point3D->second.Color(0)) << " ";
+        *line << static_cast<int>(point3D->second.Color(1)) << " ";
+        *line << static_cast<int>(point3D->second.Color(2)) << " ";
+        *line << point3D->second.Error();
+
+        for (const auto& track_el : point3D->second.Track().Elements()) {
+          *line << " " << track_el.image_id;
+          *line << " " << track_el.line_idx;
+        }
 
-    file << line_string << std::endl;
-  }
+        *line << "\n";
+      },
+      &file);
 }
 
 void Reconstruction::SetObservationAsTriangulated(
@@ -1102,20 +1393,19 @@ void Reconstruction::SetObservationAsTriangulated(
   }
 
   const class Image& image = Image(image_id);
-  const FeatureLine& line = image.Line(line_idx);
+  const point3D_t point3D_id = image.Lines().Point3DId(line_idx);
   const std::vector<CorrespondenceGraph::Correspondence>& corrs =
       correspondence_graph_->FindCorrespondences(image_id, line_idx);
 
   CHECK(image.IsRegistered());
-  CHECK(line.HasPoint3D());
+  CHECK_NE(point3D_id, kInvalidPoint3DId);
 
   for (const auto& corr : corrs) {
     class Image& corr_image = Image(corr.image_id);
-    const FeatureLine& corr_line = corr_image.Line(corr.line_idx);
     corr_image.IncrementCorrespondenceHasPoint3D(corr.line_idx);
     // Update number of shared 3D points between image pairs and make sure to
     // only count the correspondences once (not twice forward and backward).
-    if (line.Point3DId() == corr_line.Point3DId() &&
+    if (point3D_id == corr_image.Lines().Point3DId(corr.line_idx) &&
         (is_continued_point3D || image_id < corr.image_id)) {
       const image_pair_t pair_id =
           Database::ImagePairToPairId(image_id, corr.image_id);
@@ -1136,20 +1426,19 @@ void Reconstruction::ResetTriObservations(const image_t image_id,
   }
 
   const class Image& image = Image(image_id);
-  const FeatureLine& line = image.Line(line_idx);
+  const point3D_t point3D_id = image.Lines().Point3DId(line_idx);
   const std::vector<CorrespondenceGraph::Correspondence>& corrs =
       correspondence_graph_->FindCorrespondences(image_id, line_idx);
 
   CHECK(image.IsRegistered());
-  CHECK(line.HasPoint3D());
+  CHECK_NE(point3D_id, kInvalidPoint3DId);
 
   for (const auto& corr : corrs) {
     class Image& corr_image = Image(corr.image_id);
-    const FeatureLine& corr_line = corr_image.Line(corr.line_idx);
     corr_image.DecrementCorrespondenceHasPoint3D(corr.line_idx);
     // Update number of shared 3D points between image pairs and make sure to
     // only count the correspondences once (not twice forward and backward).
-    if (line.Point3DId() == corr_line.Point3DId() &&
+    if (point3D_id == corr_image.Lines().Point3DId(corr.line_idx) &&
         (!is_deleted_point3D || image_id < corr.image_id)) {
       const image_pair_t pair_id =
           Database::ImagePairToPairId(image_id, corr.image_id);
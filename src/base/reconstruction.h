@@ -54,6 +54,7 @@ struct PlyPoint;
 struct RANSACOptions;
 class DatabaseCache;
 class CorrespondenceGraph;
+class SimilarityTransform3;
 
 // Reconstruction class holds all information about a single reconstructed
 // model. It is used by the mapping and bundle adjustment classes and can be
@@ -162,6 +163,19 @@ class Reconstruction {
   void Normalize(const double extent = 10.0, const double p0 = 0.1,
                  const double p1 = 0.9, const bool use_images = true);
 
+  // Merge the given reconstruction into this reconstruction by registering the
+  // images of the other reconstruction and merging the two clouds and their
+  // tracks. The coordinate frames of the two reconstructions are aligned using
+  // the 3D points observed in the common images. Both reconstructions must
+  // be torn down, i.e. not be used by a mapper. Returns whether the two
+  // reconstructions could be aligned and merged.
+  bool Merge(const Reconstruction& reconstruction,
+             const double max_reproj_error);
+
+  // Find images that are registered in both reconstructions.
+  std::vector<image_t> FindCommonRegImageIds(
+      const Reconstruction& reconstruction) const;
+
   // Filter 3D points with large reprojection error, negative depth, or
   // insufficient triangulation angle.
   //
@@ -217,6 +231,10 @@ class Reconstruction {
   // Export to other data formats.
   void ExportPLY(const std::string& path) const;
 
+  // Estimated size of the reconstruction in memory in bytes. The referenced
+  // correspondence graph is not included.
+  size_t NumBytes() const;
+
  private:
   size_t FilterPoints3DWithSmallTriangulationAngle(
       const double min_tri_angle,
@@ -0,0 +1,356 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/scene_clustering.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "util/logging.h"
+#include "util/misc.h"
+
+namespace colmap {
+namespace {
+
+typedef std::vector<std::vector<std::pair<size_t, int>>> AdjacencyList;
+
+// Find a node on the periphery of the region of unassigned nodes connected to
+// the given start node, i.e. the last node reached by breadth-first search.
+size_t FindPeripheralNode(const AdjacencyList& adjacency,
+                          const std::vector<int>& labels, const size_t start) {
+  std::vector<char> visited(adjacency.size(), 0);
+  std::queue<size_t> queue;
+  queue.push(start);
+  visited[start] = 1;
+  size_t node = start;
+  while (!queue.empty()) {
+    node = queue.front();
+    queue.pop();
+    for (const auto& edge : adjacency[node]) {
+      if (labels[edge.first] == -1 && !visited[edge.first]) {
+        visited[edge.first] = 1;
+        queue.push(edge.first);
+      }
+    }
+  }
+  return node;
+}
+
+// Greedily move nodes on the boundary between parts to the part they are most
+// strongly connected to, as long as the parts stay balanced.
+void RefinePartition(const AdjacencyList& adjacency, const int num_parts,
+                     std::vector<int>* labels) {
+  const size_t kMaxNumPasses = 5;
+  const double kMaxImbalance = 0.1;
+
+  const double mean_part_size =
+      static_cast<double>(adjacency.size()) / num_parts;
+  const size_t min_part_size =
+      static_cast<size_t>(std::ceil((1 - kMaxImbalance) * mean_part_size));
+  const size_t max_part_size =
+      static_cast<size_t>((1 + kMaxImbalance) * mean_part_size);
+
+  std::vector<size_t> part_sizes(num_parts, 0);
+  for (const int label : *labels) {
+    part_sizes[label] += 1;
+  }
+
+  std::vector<int64_t> part_weights(num_parts);
+  for (size_t pass = 0; pass < kMaxNumPasses; ++pass) {
+    size_t num_moved = 0;
+    for (size_t node = 0; node < adjacency.size(); ++node) {
+      const int label = (*labels)[node];
+      std::fill(part_weights.begin(), part_weights.end(), 0);
+      for (const auto& edge : adjacency[node]) {
+        part_weights[(*labels)[edge.first]] += edge.second;
+      }
+
+      int best_label = label;
+      for (int part = 0; part < num_parts; ++part) {
+        if (part_weights[part] > part_weights[best_label] &&
+            part_sizes[part] < max_part_size) {
+          best_label = part;
+        }
+      }
+
+      if (best_label != label && part_sizes[label] > min_part_size) {
+        (*labels)[node] = best_label;
+        part_sizes[label] -= 1;
+        part_sizes[best_label] += 1;
+        num_moved += 1;
+      }
+    }
+
+    if (num_moved == 0) {
+      break;
+    }
+  }
+}
+
+// Partition the graph into parts of equal size with a small weight of cut
+// edges. Each part is grown from a peripheral node by always adding the
+// unassigned node with the strongest connection to the part, which is then
+// refined by moving boundary nodes.
+std::vector<int> PartitionGraph(const AdjacencyList& adjacency,
+                                const int num_parts) {
+  const size_t num_nodes = adjacency.size();
+  std::vector<int> labels(num_nodes, -1);
+  std::vector<int64_t> connections(num_nodes);
+
+  size_t num_assigned = 0;
+  size_t next_unassigned = 0;
+  for (int part = 0; part < num_parts - 1; ++part) {
+    const size_t part_size = (num_nodes - num_assigned) / (num_parts - part);
+    std::fill(connections.begin(), connections.end(), 0);
+    std::priority_queue<std::pair<int64_t, size_t>> queue;
+    size_t num_part_nodes = 0;
+    while (num_part_nodes < part_size) {
+      size_t node;
+      if (queue.empty()) {
+        // Start a new region for the first node of the part or when the
+        // region of the part is disconnected from all unassigned nodes.
+        while (labels[next_unassigned] != -1) {
+          next_unassigned += 1;
+        }
+        node = FindPeripheralNode(adjacency, labels, next_unassigned);
+      } else {
+        const auto entry = queue.top();
+        queue.pop();
+        node = entry.second;
+        // Skip assigned nodes and outdated entries.
+        if (labels[node] != -1 || entry.first != connections[node]) {
+          continue;
+        }
+      }
+
+      labels[node] = part;
+      num_part_nodes += 1;
+      for (const auto& edge : adjacency[node]) {
+        if (labels[edge.first] == -1) {
+          connections[edge.first] += edge.second;
+          queue.emplace(connections[edge.first], edge.first);
+        }
+      }
+    }
+    num_assigned += num_part_nodes;
+  }
+
+  for (auto& label : labels) {
+    if (label == -1) {
+      label = num_parts - 1;
+    }
+  }
+
+  RefinePartition(adjacency, num_parts, &labels);
+
+  return labels;
+}
+
+}  // namespace
+
+bool SceneClustering::Options::Check() const {
+  CHECK_OPTION_GE(branching, 2);
+  CHECK_OPTION_GE(image_overlap, 0);
+  CHECK_OPTION_GE(leaf_max_num_images, 1);
+  return true;
+}
+
+SceneClustering::SceneClustering(const Options& options) : options_(options) {
+  CHECK(options_.Check());
+}
+
+void SceneClustering::Partition(
+    const std::vector<std::pair<image_t, image_t>>& image_pairs,
+    const std::vector<int>& num_correspondences) {
+  CHECK_EQ(image_pairs.size(), num_correspondences.size());
+
+  std::unordered_set<image_t> image_ids;
+  for (const auto& image_pair : image_pairs) {
+    image_ids.insert(image_pair.first);
+    image_ids.insert(image_pair.second);
+  }
+
+  root_cluster_.reset(new Cluster());
+  root_cluster_->image_ids.assign(image_ids.begin(), image_ids.end());
+  std::sort(root_cluster_->image_ids.begin(), root_cluster_->image_ids.end());
+
+  PartitionCluster(image_pairs, num_correspondences, root_cluster_.get());
+  AddLeafClusterOverlap(image_pairs, num_correspondences);
+}
+
+const SceneClustering::Cluster* SceneClustering::GetRootCluster() const {
+  return root_cluster_.get();
+}
+
+std::vector<const SceneClustering::Cluster*> SceneClustering::GetLeafClusters()
+    const {
+  std::vector<const Cluster*> leaf_clusters;
+  if (!root_cluster_) {
+    return leaf_clusters;
+  }
+
+  std::vector<const Cluster*> non_leaf_clusters = {root_cluster_.get()};
+  while (!non_leaf_clusters.empty()) {
+    const Cluster* cluster = non_leaf_clusters.back();
+    non_leaf_clusters.pop_back();
+    if (cluster->child_clusters.empty()) {
+      leaf_clusters.push_back(cluster);
+    } else {
+      for (const auto& child_cluster : cluster->child_clusters) {
+        non_leaf_clusters.push_back(&child_cluster);
+      }
+    }
+  }
+
+  return leaf_clusters;
+}
+
+void SceneClustering::PartitionCluster(
+    const std::vector<std::pair<image_t, image_t>>& image_pairs,
+    const std::vector<int>& num_correspondences, Cluster* cluster) {
+  if (cluster->image_ids.size() <=
+      static_cast<size_t>(options_.leaf_max_num_images)) {
+    return;
+  }
+
+  std::unordered_map<image_t, size_t> image_id_to_idx;
+  image_id_to_idx.reserve(cluster->image_ids.size());
+  for (size_t i = 0; i < cluster->image_ids.size(); ++i) {
+    image_id_to_idx.emplace(cluster->image_ids[i], i);
+  }
+
+  AdjacencyList adjacency(cluster->image_ids.size());
+  for (size_t i = 0; i < image_pairs.size(); ++i) {
+    const size_t idx1 = image_id_to_idx.at(image_pairs[i].first);
+    const size_t idx2 = image_id_to_idx.at(image_pairs[i].second);
+    adjacency[idx1].emplace_back(idx2, num_correspondences[i]);
+    adjacency[idx2].emplace_back(idx1, num_correspondences[i]);
+  }
+
+  const std::vector<int> labels = PartitionGraph(adjacency, options_.branching);
+
+  cluster->child_clusters.resize(options_.branching);
+  for (size_t i = 0; i < labels.size(); ++i) {
+    cluster->child_clusters[labels[i]].image_ids.push_back(
+        cluster->image_ids[i]);
+  }
+
+  std::vector<std::vector<std::pair<image_t, image_t>>> child_image_pairs(
+      options_.branching);
+  std::vector<std::vector<int>> child_num_correspondences(options_.branching);
+  for (size_t i = 0; i < image_pairs.size(); ++i) {
+    const int label1 = labels[image_id_to_idx.at(image_pairs[i].first)];
+    const int label2 = labels[image_id_to_idx.at(image_pairs[i].second)];
+    if (label1 == label2) {
+      child_image_pairs[label1].push_back(image_pairs[i]);
+      child_num_correspondences[label1].push_back(num_correspondences[i]);
+    }
+  }
+
+  for (int i = 0; i < options_.branching; ++i) {
+    PartitionCluster(child_image_pairs[i], child_num_correspondences[i],
+                     &cluster->child_clusters[i]);
+  }
+}
+
+void SceneClustering::AddLeafClusterOverlap(
+    const std::vector<std::pair<image_t, image_t>>& image_pairs,
+    const std::vector<int>& num_correspondences) {
+  std::vector<Cluster*> leaf_clusters;
+  std::vector<Cluster*> non_leaf_clusters = {root_cluster_.get()};
+  while (!non_leaf_clusters.empty()) {
+    Cluster* cluster = non_leaf_clusters.back();
+    non_leaf_clusters.pop_back();
+    if (cluster->child_clusters.empty()) {
+      leaf_clusters.push_back(cluster);
+    } else {
+      for (auto& child_cluster : cluster->child_clusters) {
+        non_leaf_clusters.push_back(&child_cluster);
+      }
+    }
+  }
+
+  if (leaf_clusters.size() < 2 || options_.image_overlap == 0) {
+    return;
+  }
+
+  std::unordered_map<image_t, size_t> image_id_to_leaf_idx;
+  for (size_t i = 0; i < leaf_clusters.size(); ++i) {
+    for (const image_t image_id : leaf_clusters[i]->image_ids) {
+      image_id_to_leaf_idx.emplace(image_id, i);
+    }
+  }
+
+  // For each pair of neighboring leaf clusters, the edges between them given
+  // by the number of correspondences and the image in the other cluster.
+  std::vector<std::unordered_map<size_t, std::vector<std::pair<int, image_t>>>>
+      overlap_edges(leaf_clusters.size());
+  for (size_t i = 0; i < image_pairs.size(); ++i) {
+    const size_t leaf_idx1 = image_id_to_leaf_idx.at(image_pairs[i].first);
+    const size_t leaf_idx2 = image_id_to_leaf_idx.at(image_pairs[i].second);
+    if (leaf_idx1 != leaf_idx2) {
+      overlap_edges[leaf_idx1][leaf_idx2].emplace_back(num_correspondences[i],
+                                                       image_pairs[i].second);
+      overlap_edges[leaf_idx2][leaf_idx1].emplace_back(num_correspondences[i],
+                                                       image_pairs[i].first);
+    }
+  }
+
+  const size_t image_overlap = static_cast<size_t>(options_.image_overlap);
+  for (size_t i = 0; i < leaf_clusters.size(); ++i) {
+    std::unordered_set<image_t> overlap_image_ids;
+    for (auto& neighbor_edges : overlap_edges[i]) {
+      auto& edges = neighbor_edges.second;
+      std::sort(edges.begin(), edges.end(),
+                [](const std::pair<int, image_t>& edge1,
+                   const std::pair<int, image_t>& edge2) {
+                  return edge1.first > edge2.first;
+                });
+      std::unordered_set<image_t> neighbor_image_ids;
+      for (const auto& edge : edges) {
+        if (neighbor_image_ids.size() >= image_overlap) {
+          break;
+        }
+        neighbor_image_ids.insert(edge.second);
+      }
+      overlap_image_ids.insert(neighbor_image_ids.begin(),
+                               neighbor_image_ids.end());
+    }
+
+    auto& image_ids = leaf_clusters[i]->image_ids;
+    image_ids.insert(image_ids.end(), overlap_image_ids.begin(),
+                     overlap_image_ids.end());
+    std::sort(image_ids.begin(), image_ids.end());
+  }
+}
+
+}  // namespace colmap
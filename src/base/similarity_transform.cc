@@ -0,0 +1,300 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/similarity_transform.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <Eigen/Geometry>
+
+#include "base/pose.h"
+#include "base/projection.h"
+#include "base/reconstruction.h"
+#include "optim/loransac.h"
+
+namespace colmap {
+namespace {
+
+// Estimator for the alignment between two reconstructions from pairs of
+// shared 3D points. The residual of a pair is the largest squared line
+// reprojection error of the transformed points in the images of the other
+// reconstruction that observe them.
+class ReconstructionAlignmentEstimator {
+ public:
+  typedef const Point3D* X_t;
+  typedef const Point3D* Y_t;
+  typedef Eigen::Matrix3x4d M_t;
+
+  // Three non-collinear points determine a similarity transformation.
+  static const int kMinNumSamples = 3;
+
+  void SetReconstructions(const Reconstruction* src_reconstruction,
+                          const Reconstruction* ref_reconstruction) {
+    src_reconstruction_ = CHECK_NOTNULL(src_reconstruction);
+    ref_reconstruction_ = CHECK_NOTNULL(ref_reconstruction);
+  }
+
+  std::vector<M_t> Estimate(const std::vector<X_t>& src_points3D,
+                            const std::vector<Y_t>& ref_points3D) const {
+    CHECK_EQ(src_points3D.size(), ref_points3D.size());
+
+    std::vector<Eigen::Vector3d> src(src_points3D.size());
+    std::vector<Eigen::Vector3d> dst(ref_points3D.size());
+    for (size_t i = 0; i < src_points3D.size(); ++i) {
+      src[i] = src_points3D[i]->XYZ();
+      dst[i] = ref_points3D[i]->XYZ();
+    }
+
+    SimilarityTransform3 tform;
+    if (!tform.Estimate(src, dst)) {
+      return std::vector<M_t>();
+    }
+
+    return std::vector<M_t>{tform.Matrix()};
+  }
+
+  void Residuals(const std::vector<X_t>& src_points3D,
+                 const std::vector<Y_t>& ref_points3D,
+                 const M_t& src_to_ref_matrix,
+                 std::vector<double>* residuals) const {
+    CHECK_EQ(src_points3D.size(), ref_points3D.size());
+
+    const SimilarityTransform3 src_to_ref(src_to_ref_matrix);
+    const SimilarityTransform3 ref_to_src = src_to_ref.Inverse();
+
+    residuals->resize(src_points3D.size());
+    for (size_t i = 0; i < src_points3D.size(); ++i) {
+      Eigen::Vector3d src_xyz_in_ref = src_points3D[i]->XYZ();
+      src_to_ref.TransformPoint(&src_xyz_in_ref);
+      Eigen::Vector3d ref_xyz_in_src = ref_points3D[i]->XYZ();
+      ref_to_src.TransformPoint(&ref_xyz_in_src);
+
+      (*residuals)[i] = std::max(
+          MaxSquaredLineReprojectionError(*src_reconstruction_,
+                                          *ref_reconstruction_,
+                                          *src_points3D[i], src_xyz_in_ref),
+          MaxSquaredLineReprojectionError(*ref_reconstruction_,
+                                          *src_reconstruction_,
+                                          *ref_points3D[i], ref_xyz_in_src));
+    }
+  }
+
+ private:
+  // The largest squared reprojection error of the transformed point in the
+  // images of the other reconstruction, which observe the point in the
+  // original reconstruction.
+  static double MaxSquaredLineReprojectionError(
+      const Reconstruction& reconstruction,
+      const Reconstruction& other_reconstruction, const Point3D& point3D,
+      const Eigen::Vector3d& xyz_in_other) {
+    double max_squared_error = 0;
+    for (const auto& track_el : point3D.Track().Elements()) {
+      if (!other_reconstruction.ExistsImage(track_el.image_id)) {
+        continue;
+      }
+      const Image& other_image = other_reconstruction.Image(track_el.image_id);
+      if (!other_image.IsRegistered()) {
+        continue;
+      }
+      const Image& image = reconstruction.Image(track_el.image_id);
+      max_squared_error = std::max(
+          max_squared_error,
+          CalculateSquaredLineReprojectionError(
+              image.Lines().Line(track_el.line_idx), xyz_in_other,
+              other_image.Qvec(), other_image.Tvec(),
+              other_reconstruction.Camera(other_image.CameraId())));
+    }
+    return max_squared_error;
+  }
+
+  const Reconstruction* src_reconstruction_ = nullptr;
+  const Reconstruction* ref_reconstruction_ = nullptr;
+};
+
+}  // namespace
+
+SimilarityTransform3::SimilarityTransform3()
+    : scale_(1),
+      rotation_(Eigen::Matrix3d::Identity()),
+      translation_(Eigen::Vector3d::Zero()) {}
+
+SimilarityTransform3::SimilarityTransform3(const Eigen::Matrix3x4d& matrix) {
+  scale_ = matrix.leftCols<3>().col(0).norm();
+  rotation_ = matrix.leftCols<3>() / scale_;
+  translation_ = matrix.col(3);
+}
+
+SimilarityTransform3::SimilarityTransform3(const double scale,
+                                           const Eigen::Vector4d& qvec,
+                                           const Eigen::Vector3d& tvec)
+    : scale_(scale),
+      rotation_(QuaternionToRotationMatrix(qvec)),
+      translation_(tvec) {}
+
+bool SimilarityTransform3::Estimate(const std::vector<Eigen::Vector3d>& src,
+                                    const std::vector<Eigen::Vector3d>& dst) {
+  CHECK_EQ(src.size(), dst.size());
+  if (src.size() < 3) {
+    return false;
+  }
+
+  Eigen::Matrix<double, 3, Eigen::Dynamic> src_mat(3, src.size());
+  Eigen::Matrix<double, 3, Eigen::Dynamic> dst_mat(3, dst.size());
+  for (size_t i = 0; i < src.size(); ++i) {
+    src_mat.col(i) = src[i];
+    dst_mat.col(i) = dst[i];
+  }
+
+  const Eigen::Matrix4d matrix = Eigen::umeyama(src_mat, dst_mat, true);
+  if (!matrix.allFinite()) {
+    return false;
+  }
+
+  const double scale = matrix.topLeftCorner<3, 3>().col(0).norm();
+  if (scale < std::numeric_limits<double>::epsilon()) {
+    return false;
+  }
+
+  scale_ = scale;
+  rotation_ = matrix.topLeftCorner<3, 3>() / scale;
+  translation_ = matrix.topRightCorner<3, 1>();
+
+  return true;
+}
+
+SimilarityTransform3 SimilarityTransform3::Inverse() const {
+  SimilarityTransform3 inverse;
+  inverse.scale_ = 1 / scale_;
+  inverse.rotation_ = rotation_.transpose();
+  inverse.translation_ = -inverse.scale_ * (inverse.rotation_ * translation_);
+  return inverse;
+}
+
+void SimilarityTransform3::TransformPoint(Eigen::Vector3d* xyz) const {
+  *xyz = scale_ * (rotation_ * *xyz) + translation_;
+}
+
+void SimilarityTransform3::TransformPose(Eigen::Vector4d* qvec,
+                                         Eigen::Vector3d* tvec) const {
+  // With x = R^T (x' - t) / s, the camera maps x' to R_c R^T (x' - t) / s +
+  // t_c, which is the same ray as R_c R^T x' - R_c R^T t + s t_c.
+  const Eigen::Matrix3d R = QuaternionToRotationMatrix(*qvec) *
+                            rotation_.transpose();
+  *tvec = scale_ * *tvec - R * translation_;
+  *qvec = RotationMatrixToQuaternion(R);
+}
+
+Eigen::Matrix3x4d SimilarityTransform3::Matrix() const {
+  Eigen::Matrix3x4d matrix;
+  matrix.leftCols<3>() = scale_ * rotation_;
+  matrix.col(3) = translation_;
+  return matrix;
+}
+
+double SimilarityTransform3::Scale() const { return scale_; }
+
+Eigen::Vector4d SimilarityTransform3::Rotation() const {
+  return RotationMatrixToQuaternion(rotation_);
+}
+
+Eigen::Vector3d SimilarityTransform3::Translation() const {
+  return translation_;
+}
+
+bool ComputeAlignmentBetweenReconstructions(
+    const Reconstruction& src_reconstruction,
+    const Reconstruction& ref_reconstruction, const double min_inlier_ratio,
+    const double max_reproj_error, SimilarityTransform3* alignment) {
+  CHECK_GE(min_inlier_ratio, 0.0);
+  CHECK_LE(min_inlier_ratio, 1.0);
+  CHECK_NOTNULL(alignment);
+
+  // Find the shared 3D points through the observations in common images. If a
+  // source point observes several reference points, the one with most common
+  // observations is used.
+  std::vector<const Point3D*> src_points3D;
+  std::vector<const Point3D*> ref_points3D;
+  std::unordered_map<point3D_t, size_t> num_shared_observations;
+  for (const auto& point3D : src_reconstruction.Points3D()) {
+    num_shared_observations.clear();
+    for (const auto& track_el : point3D.second.Track().Elements()) {
+      if (!ref_reconstruction.ExistsImage(track_el.image_id)) {
+        continue;
+      }
+      const Image& ref_image = ref_reconstruction.Image(track_el.image_id);
+      if (ref_image.IsRegistered() &&
+          ref_image.Lines().HasPoint3D(track_el.line_idx)) {
+        num_shared_observations[ref_image.Lines().Point3DId(
+            track_el.line_idx)] += 1;
+      }
+    }
+
+    if (num_shared_observations.empty()) {
+      continue;
+    }
+
+    const auto best_ref_point3D = std::max_element(
+        num_shared_observations.begin(), num_shared_observations.end(),
+        [](const std::pair<const point3D_t, size_t>& corr1,
+           const std::pair<const point3D_t, size_t>& corr2) {
+          return corr1.second < corr2.second;
+        });
+    src_points3D.push_back(&point3D.second);
+    ref_points3D.push_back(&ref_reconstruction.Point3D(best_ref_point3D->first));
+  }
+
+  if (src_points3D.size() <
+      static_cast<size_t>(ReconstructionAlignmentEstimator::kMinNumSamples)) {
+    return false;
+  }
+
+  RANSACOptions ransac_options;
+  ransac_options.max_error = max_reproj_error;
+  ransac_options.min_inlier_ratio = std::max(min_inlier_ratio, 0.01);
+
+  LORANSAC<ReconstructionAlignmentEstimator, ReconstructionAlignmentEstimator>
+      ransac(ransac_options);
+  ransac.estimator.SetReconstructions(&src_reconstruction,
+                                      &ref_reconstruction);
+  ransac.local_estimator.SetReconstructions(&src_reconstruction,
+                                            &ref_reconstruction);
+
+  const auto report = ransac.Estimate(src_points3D, ref_points3D);
+  if (!report.success || report.support.num_inliers <
+                             min_inlier_ratio * src_points3D.size()) {
+    return false;
+  }
+
+  *alignment = SimilarityTransform3(report.model);
+
+  return true;
+}
+
+}  // namespace colmap
@@ -0,0 +1,106 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef COLMAP_SRC_BASE_SIMILARITY_TRANSFORM_H_
+#define COLMAP_SRC_BASE_SIMILARITY_TRANSFORM_H_
+
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include "util/alignment.h"
+#include "util/types.h"
+
+namespace colmap {
+
+class Reconstruction;
+
+// 3D similarity transformation with 7 degrees of freedom, which maps points
+// from a source to a target coordinate frame as `scale * R * x + t`.
+class SimilarityTransform3 {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  SimilarityTransform3();
+
+  explicit SimilarityTransform3(const Eigen::Matrix3x4d& matrix);
+
+  SimilarityTransform3(const double scale, const Eigen::Vector4d& qvec,
+                       const Eigen::Vector3d& tvec);
+
+  // Estimate the transformation from the source to the destination points
+  // in the least-squares sense. Returns false for degenerate configurations.
+  bool Estimate(const std::vector<Eigen::Vector3d>& src,
+                const std::vector<Eigen::Vector3d>& dst);
+
+  SimilarityTransform3 Inverse() const;
+
+  // Transform a point from the source to the target frame.
+  void TransformPoint(Eigen::Vector3d* xyz) const;
+
+  // Transform the world-to-camera pose of an image from the source to the
+  // target frame, such that it observes the transformed points identically.
+  void TransformPose(Eigen::Vector4d* qvec, Eigen::Vector3d* tvec) const;
+
+  Eigen::Matrix3x4d Matrix() const;
+  double Scale() const;
+  Eigen::Vector4d Rotation() const;
+  Eigen::Vector3d Translation() const;
+
+ private:
+  double scale_;
+  Eigen::Matrix3d rotation_;
+  Eigen::Vector3d translation_;
+};
+
+// Robustly compute the alignment from the source to the reference
+// reconstruction. The transformation is estimated from the 3D points shared by
+// both reconstructions, i.e. points whose tracks observe the same feature line
+// in an image registered in both. A pair of shared points is an inlier, if the
+// transformed points are consistent with all the feature lines observing them
+// in the common images, i.e. if the line reprojection errors are below
+// `max_reproj_error` pixels.
+//
+// @param src_reconstruction    The reconstruction to be aligned.
+// @param ref_reconstruction    The reconstruction defining the target frame.
+// @param min_inlier_ratio      The minimum ratio of shared points that must be
+//                              inliers for the alignment to be accepted.
+// @param max_reproj_error      The maximum line reprojection error in pixels.
+// @param alignment             The estimated transformation.
+//
+// @return                      Whether the alignment was successful.
+bool ComputeAlignmentBetweenReconstructions(
+    const Reconstruction& src_reconstruction,
+    const Reconstruction& ref_reconstruction, const double min_inlier_ratio,
+    const double max_reproj_error, SimilarityTransform3* alignment);
+
+}  // namespace colmap
+
+#endif  // COLMAP_SRC_BASE_SIMILARITY_TRANSFORM_H_
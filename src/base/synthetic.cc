@@ -0,0 +1,298 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/synthetic.h"
+
+#include <map>
+#include <unordered_set>
+
+#include <Eigen/Geometry>
+
+#include "base/camera_models.h"
+#include "base/pose.h"
+#include "util/misc.h"
+#include "util/random.h"
+
+namespace colmap {
+namespace {
+
+// Distance of the facade from the street and the extent of the facade in
+// front of the first and behind the last image.
+const double kFacadeDistance = 5.0;
+const double kFacadeDepth = 1.0;
+const double kFacadeHeight = 6.0;
+const double kFacadeMargin = 3.0;
+
+// The standard deviations of the camera position and orientation.
+const double kCameraPositionStddev = 0.1;
+const double kCameraRotationStddev = DegToRad(2.0);
+
+double RandomGaussian(PhiloxRandomGenerator* random_generator,
+                      const double stddev) {
+  // Box-Muller transform, where the first uniform number is in (0, 1].
+  const double u1 = 1.0 - random_generator->UniformReal(0.0, 1.0);
+  const double u2 = random_generator->UniformReal(0.0, 1.0);
+  return stddev * std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * M_PI * u2);
+}
+
+Eigen::Matrix3d RandomRotation(PhiloxRandomGenerator* random_generator,
+                               const double stddev) {
+  return (Eigen::AngleAxisd(RandomGaussian(random_generator, stddev),
+                            Eigen::Vector3d::UnitX()) *
+          Eigen::AngleAxisd(RandomGaussian(random_generator, stddev),
+                            Eigen::Vector3d::UnitY()) *
+          Eigen::AngleAxisd(RandomGaussian(random_generator, stddev),
+                            Eigen::Vector3d::UnitZ()))
+      .toRotationMatrix();
+}
+
+// Lift the observation to a line through it, normalized such that the first
+// two components have unit norm, as done by the feature extraction.
+FeatureLine LiftObservation(PhiloxRandomGenerator* random_generator,
+                            const Eigen::Vector2d& point,
+                            const Eigen::Vector3d& gravity,
+                            const bool is_aligned) {
+  Eigen::Vector3d line;
+  if (is_aligned) {
+    line = gravity.cross(point.homogeneous());
+  } else {
+    const Eigen::Vector3d random_dir(random_generator->UniformReal(-1.0, 1.0),
+                                     random_generator->UniformReal(-1.0, 1.0),
+                                     random_generator->UniformReal(-1.0, 1.0));
+    line = random_dir.cross(point.homogeneous());
+  }
+  return FeatureLine(line / line.head<2>().norm(), is_aligned);
+}
+
+}  // namespace
+
+bool SyntheticDatasetOptions::Check() const {
+  CHECK_OPTION_GT(num_images, 1);
+  CHECK_OPTION_GT(num_points3D, 0);
+  CHECK_OPTION(ExistsCameraModelWithName(camera_model));
+  CHECK_OPTION_GT(camera_width, 0);
+  CHECK_OPTION_GT(camera_height, 0);
+  CHECK_OPTION_GT(camera_focal_length, 0.0);
+  CHECK_OPTION_GE(aligned_line_ratio, 0.0);
+  CHECK_OPTION_LE(aligned_line_ratio, 1.0);
+  CHECK_OPTION_GE(point2D_stddev, 0.0);
+  CHECK_OPTION_GE(gravity_stddev, 0.0);
+  CHECK_OPTION_GE(outlier_match_ratio, 0.0);
+  CHECK_OPTION_LE(outlier_match_ratio, 1.0);
+  CHECK_OPTION_GE(seed, 0);
+  return true;
+}
+
+void SynthesizeDataset(const SyntheticDatasetOptions& options,
+                       Database* database, Reconstruction* reconstruction) {
+  CHECK(options.Check());
+  CHECK_NOTNULL(database);
+  CHECK_NOTNULL(reconstruction);
+  CHECK_EQ(database->NumImages(), 0);
+  CHECK_EQ(reconstruction->NumImages(), 0);
+
+  PhiloxRandomGenerator random_generator(
+      PhiloxRandomGenerator::MakeKey(options.seed, "synthetic"));
+
+  // The world gravity points along the y-axis, which is also the downward
+  // direction of the images.
+  const Eigen::Vector3d world_gravity = Eigen::Vector3d::UnitY();
+
+  DatabaseTransaction database_transaction(database);
+
+  Camera camera;
+  camera.InitializeWithName(options.camera_model, options.camera_focal_length,
+                            options.camera_width, options.camera_height);
+  camera.SetPriorFocalLength(true);
+  camera.SetCameraId(database->WriteCamera(camera));
+  reconstruction->AddCamera(camera);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Synthesize the 3D points
+  //////////////////////////////////////////////////////////////////////////////
+
+  std::vector<Eigen::Vector3d> points3D(options.num_points3D);
+  for (auto& point3D : points3D) {
+    point3D.x() = random_generator.UniformReal(
+        -kFacadeMargin, options.num_images - 1 + kFacadeMargin);
+    point3D.y() =
+        random_generator.UniformReal(-kFacadeHeight / 2, kFacadeHeight / 2);
+    point3D.z() = kFacadeDistance + random_generator.UniformReal(
+                                        -kFacadeDepth / 2, kFacadeDepth / 2);
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Synthesize the images and their lines
+  //////////////////////////////////////////////////////////////////////////////
+
+  // The observations of every 3D point, i.e. its track.
+  std::vector<std::vector<TrackElement>> tracks(points3D.size());
+  std::vector<image_t> image_ids;
+  image_ids.reserve(options.num_images);
+
+  const double gravity_stddev = DegToRad(options.gravity_stddev);
+
+  for (int image_idx = 0; image_idx < options.num_images; ++image_idx) {
+    Image image;
+    image.SetName(StringPrintf("image%06d.jpg", image_idx));
+    image.SetCameraId(camera.CameraId());
+
+    const Eigen::Vector3d proj_center(
+        image_idx, RandomGaussian(&random_generator, kCameraPositionStddev),
+        RandomGaussian(&random_generator, kCameraPositionStddev));
+    const Eigen::Matrix3d rot_mat =
+        RandomRotation(&random_generator, kCameraRotationStddev);
+    image.SetQvec(RotationMatrixToQuaternion(rot_mat));
+    image.SetTvec(-rot_mat * proj_center);
+
+    // Measure the gravity in the camera frame with a random rotation about an
+    // axis perpendicular to it.
+    const Eigen::Vector3d gravity = rot_mat * world_gravity;
+    const Eigen::Vector3d noise_axis =
+        gravity.cross(Eigen::Vector3d(random_generator.UniformReal(-1.0, 1.0),
+                                      random_generator.UniformReal(-1.0, 1.0),
+                                      random_generator.UniformReal(-1.0, 1.0)))
+            .normalized();
+    image.SetGravityDirection(
+        Eigen::AngleAxisd(RandomGaussian(&random_generator, gravity_stddev),
+                          noise_axis) *
+        gravity);
+
+    const Eigen::Matrix3x4d proj_matrix = image.ProjectionMatrix();
+
+    FeatureLines lines;
+    std::vector<size_t> point3D_idxs;
+    for (size_t point3D_idx = 0; point3D_idx < points3D.size();
+         ++point3D_idx) {
+      const Eigen::Vector3d point_in_camera =
+          proj_matrix * points3D[point3D_idx].homogeneous();
+      if (point_in_camera.z() <= 0) {
+        continue;
+      }
+
+      const Eigen::Vector2d point2D =
+          camera.WorldToImage(point_in_camera.hnormalized()) +
+          Eigen::Vector2d(
+              RandomGaussian(&random_generator, options.point2D_stddev),
+              RandomGaussian(&random_generator, options.point2D_stddev));
+      if (point2D.x() < 0 || point2D.y() < 0 ||
+          point2D.x() >= options.camera_width ||
+          point2D.y() >= options.camera_height) {
+        continue;
+      }
+
+      const bool is_aligned = random_generator.UniformReal(0.0, 1.0) <
+                              options.aligned_line_ratio;
+      lines.push_back(LiftObservation(&random_generator,
+                                      camera.ImageToWorld(point2D),
+                                      image.GravityDirection(), is_aligned));
+      point3D_idxs.push_back(point3D_idx);
+    }
+
+    image.SetLines(lines);
+    image.SetImageId(database->WriteImage(image));
+    database->WriteImageGravity(image.ImageId(), image.GravityDirection());
+    database->WriteFeatureLines(image.ImageId(), lines);
+
+    for (size_t line_idx = 0; line_idx < point3D_idxs.size(); ++line_idx) {
+      tracks[point3D_idxs[line_idx]].emplace_back(image.ImageId(), line_idx);
+    }
+
+    reconstruction->AddImage(image);
+    reconstruction->RegisterImage(image.ImageId());
+    image_ids.push_back(image.ImageId());
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Synthesize the matches
+  //////////////////////////////////////////////////////////////////////////////
+
+  // Ordered by the pair identifier, so that the outliers do not depend on the
+  // iteration order of the standard library.
+  std::map<image_pair_t, FeatureMatches> matches;
+  for (const auto& track : tracks) {
+    for (size_t i = 0; i < track.size(); ++i) {
+      for (size_t j = i + 1; j < track.size(); ++j) {
+        FeatureMatch match;
+        match.line_idx1 = track[i].line_idx;
+        match.line_idx2 = track[j].line_idx;
+        matches[Database::ImagePairToPairId(track[i].image_id,
+                                            track[j].image_id)]
+            .push_back(match);
+      }
+    }
+  }
+
+  for (auto& pair_matches : matches) {
+    image_t image_id1;
+    image_t image_id2;
+    Database::PairIdToImagePair(pair_matches.first, &image_id1, &image_id2);
+
+    // Replace the second line of the outlier matches with a random line that
+    // is not yet matched, as matches must be unique.
+    const point2D_t num_lines2 =
+        reconstruction->Image(image_id2).NumLines();
+    std::unordered_set<point2D_t> matched_line_idxs2;
+    for (const auto& match : pair_matches.second) {
+      matched_line_idxs2.insert(match.line_idx2);
+    }
+
+    for (auto& match : pair_matches.second) {
+      if (matched_line_idxs2.size() >= num_lines2 ||
+          random_generator.UniformReal(0.0, 1.0) >=
+              options.outlier_match_ratio) {
+        continue;
+      }
+      point2D_t line_idx2;
+      do {
+        line_idx2 = random_generator.UniformInteger(num_lines2 - 1);
+      } while (matched_line_idxs2.count(line_idx2) > 0);
+      matched_line_idxs2.erase(match.line_idx2);
+      matched_line_idxs2.insert(line_idx2);
+      match.line_idx2 = line_idx2;
+    }
+
+    database->WriteMatches(image_id1, image_id2, pair_matches.second);
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Add the ground truth 3D points
+  //////////////////////////////////////////////////////////////////////////////
+
+  for (size_t point3D_idx = 0; point3D_idx < points3D.size(); ++point3D_idx) {
+    if (tracks[point3D_idx].size() < 2) {
+      continue;
+    }
+    Track track;
+    track.SetElements(tracks[point3D_idx]);
+    reconstruction->AddPoint3D(points3D[point3D_idx], track);
+  }
+}
+
+}  // namespace colmap
@@ -0,0 +1,86 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef COLMAP_SRC_BASE_SYNTHETIC_H_
+#define COLMAP_SRC_BASE_SYNTHETIC_H_
+
+#include <string>
+
+#include "base/database.h"
+#include "base/reconstruction.h"
+
+namespace colmap {
+
+struct SyntheticDatasetOptions {
+  // The number of images, which are placed along a straight street facing
+  // the facade on one side of it, one unit apart.
+  int num_images = 50;
+
+  // The number of 3D points, which are uniformly distributed over the facade.
+  int num_points3D = 2000;
+
+  // The intrinsics of the camera that is shared by all images.
+  std::string camera_model = "SIMPLE_PINHOLE";
+  int camera_width = 1024;
+  int camera_height = 768;
+  double camera_focal_length = 1000.0;
+
+  // The ratio of observations that are lifted to gravity-aligned lines. The
+  // remaining observations are lifted to lines with a random direction.
+  double aligned_line_ratio = 0.5;
+
+  // The standard deviation of the image noise in pixels, which is added to
+  // the projections before lifting them to lines.
+  double point2D_stddev = 0.5;
+
+  // The standard deviation of the gravity direction noise in degrees.
+  double gravity_stddev = 0.5;
+
+  // The ratio of outlier matches between each image pair, whose second line
+  // is replaced by a random line in the second image.
+  double outlier_match_ratio = 0.1;
+
+  // The seed of the random number generator, so that the same options always
+  // produce the same dataset on all platforms.
+  int seed = 0;
+
+  bool Check() const;
+};
+
+// Synthesize a scene and write its cameras, images with gravity, lifted lines,
+// and matches to the given empty database. The ground truth is stored in the
+// given reconstruction with the same camera and image identifiers as in the
+// database, where all images are registered and every 3D point has a track
+// with its noise-free observations.
+void SynthesizeDataset(const SyntheticDatasetOptions& options,
+                       Database* database, Reconstruction* reconstruction);
+
+}  // namespace colmap
+
+#endif  // COLMAP_SRC_BASE_SYNTHETIC_H_
@@ -33,6 +33,9 @@
 
 #include "base/triangulation.h"
 
+#include <Eigen/Cholesky>
+#include <Eigen/Eigenvalues>
+
 #include "base/pose.h"
 
 namespace colmap {
@@ -56,6 +59,58 @@ Eigen::Vector3d TriangulateMultiViewPoint(
   return X.hnormalized();
 }
 
+Eigen::Vector3d TriangulateMultiViewPointNormal(
+    const std::vector<Eigen::Matrix3x4d>& proj_matrices,
+    const std::vector<Eigen::Vector3d>& lines) {
+  CHECK_EQ(proj_matrices.size(), lines.size());
+
+  MultiViewTriangulationEquations equations;
+  for (size_t i = 0; i < lines.size(); i++) {
+    equations.Add(proj_matrices[i], lines[i]);
+  }
+
+  return equations.Solve();
+}
+
+MultiViewTriangulationEquations::MultiViewTriangulationEquations() {
+  Clear();
+}
+
+void MultiViewTriangulationEquations::Add(const Eigen::Matrix3x4d& proj_matrix,
+                                          const Eigen::Vector3d& line) {
+  const Eigen::RowVector4d row = line.transpose() * proj_matrix;
+  normal_matrix_.noalias() += row.transpose() * row;
+  num_observations_ += 1;
+}
+
+void MultiViewTriangulationEquations::Clear() {
+  normal_matrix_.setZero();
+  num_observations_ = 0;
+}
+
+size_t MultiViewTriangulationEquations::NumObservations() const {
+  return num_observations_;
+}
+
+Eigen::Vector3d MultiViewTriangulationEquations::Solve() const {
+  CHECK_GE(num_observations_, 3);
+
+  // Points in front of the cameras are finite, so the homogeneous coordinate
+  // can be fixed to one, which reduces the problem to the 3x3 system
+  // `N * x = -n`, where `[N n; n^T c]` is the normal matrix.
+  const Eigen::LLT<Eigen::Matrix3d> llt(normal_matrix_.topLeftCorner<3, 3>());
+  if (llt.info() == Eigen::Success) {
+    return llt.solve(-normal_matrix_.topRightCorner<3, 1>());
+  }
+
+  // Fall back to the eigenvector of the smallest eigenvalue for degenerate
+  // configurations. The eigenvalues are sorted in increasing order.
+  const Eigen::SelfAdjointEigenSolver<Eigen::Matrix4d> eigen_solver(
+      normal_matrix_);
+  const Eigen::Vector4d X = eigen_solver.eigenvectors().col(0);
+  return X.hnormalized();
+}
+
 double CalculateTriangulationAngle(const Eigen::Vector3d& proj_center1,
                                    const Eigen::Vector3d& proj_center2,
                                    const Eigen::Vector3d& point3D) {
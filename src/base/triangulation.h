@@ -55,6 +55,46 @@ Eigen::Vector3d TriangulateMultiViewPoint(
     const std::vector<Eigen::Matrix3x4d>& proj_matrices,
     const std::vector<Eigen::Vector3d>& lines);
 
+// Triangulate point from lines in multiple views by solving the normal
+// equations of the linear system in `TriangulateMultiViewPoint` with
+// fixed-size solvers, which avoids the dynamic allocation and the SVD.
+//
+// @param proj_matrices       Projection matrices of multi-view observations.
+// @param lines               Image observations of multi-view observations.
+//
+// @return                    Estimated 3D point.
+Eigen::Vector3d TriangulateMultiViewPointNormal(
+    const std::vector<Eigen::Matrix3x4d>& proj_matrices,
+    const std::vector<Eigen::Vector3d>& lines);
+
+// Normal equations of the multi-view line triangulation problem. Each
+// observation contributes the row `line^T * proj_matrix` to the linear system
+// `A * X = 0`, so that the normal matrix `A^T * A` can be updated as
+// observations are added to a track without re-stacking the full system.
+class MultiViewTriangulationEquations {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  MultiViewTriangulationEquations();
+
+  // Add the observation of the point in a view.
+  void Add(const Eigen::Matrix3x4d& proj_matrix, const Eigen::Vector3d& line);
+
+  // Reset to the empty system without any observations.
+  void Clear();
+
+  size_t NumObservations() const;
+
+  // Estimate the 3D point from the accumulated observations with a Cholesky
+  // solve and fall back to the symmetric eigen-solver for degenerate systems.
+  // Requires at least three observations.
+  Eigen::Vector3d Solve() const;
+
+ private:
+  Eigen::Matrix4d normal_matrix_;
+  size_t num_observations_;
+};
+
 // Calculate angle in radians between the two rays of a triangulated point.
 double CalculateTriangulationAngle(const Eigen::Vector3d& proj_center1,
                                    const Eigen::Vector3d& proj_center2,
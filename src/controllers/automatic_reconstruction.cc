@@ -33,6 +33,9 @@
 
 #include "controllers/automatic_reconstruction.h"
 
+#include <chrono>
+#include <thread>
+
 #include "controllers/incremental_mapper.h"
 #include "feature/extraction.h"
 #include "feature/matching.h"
@@ -64,6 +67,13 @@ AutomaticReconstructionController::AutomaticReconstructionController(
   }
 
   CHECK(ExistsCameraModelWithName(options_.camera_model));
+  CHECK_GT(options_.streaming_seed_num_images, 0);
+
+  if (options_.streaming && options_.data_type != DataType::VIDEO) {
+    std::cout << "WARNING: Streaming requires video data, running the "
+                 "stages one after another instead."
+              << std::endl;
+  }
 
   if (options_.quality == Quality::LOW) {
     option_manager_.ModifyForLowQuality();
@@ -97,15 +107,16 @@ AutomaticReconstructionController::AutomaticReconstructionController(
   option_manager_.sift_matching->gpu_index = options_.gpu_index;
 
   feature_extractor_.reset(new SiftFeatureExtractor(
-      reader_options, *option_manager_.sift_extraction));
+      reader_options, *option_manager_.sift_extraction,
+      *option_manager_.database));
 
   exhaustive_matcher_.reset(new ExhaustiveFeatureMatcher(
       *option_manager_.exhaustive_matching, *option_manager_.sift_matching,
-      *option_manager_.database_path));
+      *option_manager_.database_path, *option_manager_.database));
 
   sequential_matcher_.reset(new SequentialFeatureMatcher(
       *option_manager_.sequential_matching, *option_manager_.sift_matching,
-      *option_manager_.database_path));
+      *option_manager_.database_path, *option_manager_.database));
 }
 
 void AutomaticReconstructionController::Stop() {
@@ -120,6 +131,12 @@ void AutomaticReconstructionController::Run() {
     return;
   }
 
+  if (options_.streaming && options_.data_type == DataType::VIDEO &&
+      options_.sparse && !ExistsSparseReconstruction()) {
+    RunStreamingReconstruction();
+    return;
+  }
+
   RunFeatureExtraction();
 
   if (IsStopped()) {
@@ -155,7 +172,8 @@ void AutomaticReconstructionController::RunFeatureMatching() {
   if (options_.data_type == DataType::VIDEO) {
     matcher = sequential_matcher_.get();
   } else if (options_.data_type == DataType::INDIVIDUAL) {
-    Database database(*option_manager_.database_path);
+    Database database(*option_manager_.database_path, false,
+                      *option_manager_.database);
     matcher = exhaustive_matcher_.get();
   }
 
@@ -188,7 +206,8 @@ void AutomaticReconstructionController::RunSparseMapper() {
 
   IncrementalMapperController mapper(
       option_manager_.mapper.get(), *option_manager_.image_path,
-      *option_manager_.database_path, reconstruction_manager_);
+      *option_manager_.database_path, reconstruction_manager_,
+      *option_manager_.database);
   active_thread_ = &mapper;
   mapper.Start();
   mapper.Wait();
@@ -198,4 +217,96 @@ void AutomaticReconstructionController::RunSparseMapper() {
   reconstruction_manager_->Write(sparse_path, &option_manager_);
 }
 
+void AutomaticReconstructionController::RunStreamingReconstruction() {
+  CHECK(feature_extractor_);
+  CHECK(sequential_matcher_);
+
+  const int kPollIntervalMs = 100;
+
+  Thread* extractor = feature_extractor_.get();
+  SequentialFeatureMatcher* matcher =
+      static_cast<SequentialFeatureMatcher*>(sequential_matcher_.get());
+  // Streaming is only enabled here, since the matcher otherwise waits for
+  // images to be added until the end of extraction is signaled.
+  matcher->EnableStreaming();
+  IncrementalMapperController mapper(
+      option_manager_.mapper.get(), *option_manager_.image_path,
+      *option_manager_.database_path, reconstruction_manager_,
+      *option_manager_.database);
+  mapper.EnableStreaming();
+
+  matcher->Start();
+  extractor->Start();
+
+  const size_t seed_num_images =
+      static_cast<size_t>(options_.streaming_seed_num_images);
+  std::vector<std::string> seed_image_names;
+  bool extraction_finished = false;
+  bool mapper_started = false;
+  while (!IsStopped()) {
+    if (!extraction_finished && extractor->IsFinished()) {
+      extraction_finished = true;
+      matcher->FinishStreaming();
+    }
+
+    // Check whether matching finished before retrieving the matched images,
+    // so that no matched images are missed.
+    const bool matching_finished = matcher->IsFinished();
+    const std::vector<std::string> matched_image_names =
+        matcher->PopMatchedImageNames();
+
+    if (mapper_started) {
+      if (!matched_image_names.empty()) {
+        mapper.AddStreamingImages(matched_image_names);
+      }
+    } else {
+      seed_image_names.insert(seed_image_names.end(),
+                              matched_image_names.begin(),
+                              matched_image_names.end());
+      if (seed_image_names.size() >= seed_num_images || matching_finished) {
+        mapper.AddStreamingImages(seed_image_names);
+        mapper.Start();
+        mapper_started = true;
+      }
+    }
+
+    if (matching_finished) {
+      break;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kPollIntervalMs));
+  }
+
+  if (IsStopped()) {
+    extractor->Stop();
+    matcher->Stop();
+    mapper.Stop();
+  }
+
+  extractor->Wait();
+  matcher->Wait();
+  feature_extractor_.reset();
+  exhaustive_matcher_.reset();
+  sequential_matcher_.reset();
+  vocab_tree_matcher_.reset();
+
+  if (mapper_started) {
+    mapper.FinishStreaming();
+    mapper.Wait();
+  }
+
+  if (IsStopped()) {
+    return;
+  }
+
+  const auto sparse_path = JoinPaths(options_.workspace_path, "sparse");
+  CreateDirIfNotExists(sparse_path);
+  reconstruction_manager_->Write(sparse_path, &option_manager_);
+}
+
+bool AutomaticReconstructionController::ExistsSparseReconstruction() const {
+  const auto sparse_path = JoinPaths(options_.workspace_path, "sparse");
+  return ExistsDir(sparse_path) && !GetDirList(sparse_path).empty();
+}
+
 }  // namespace colmap
@@ -67,6 +67,20 @@ class AutomaticReconstructionController : public Thread {
     // Whether to perform sparse mapping.
     bool sparse = true;
 
+    // Whether to overlap feature extraction, matching, and sparse mapping.
+    // Images are matched sequentially as soon as their features are extracted
+    // and the mapper starts once `streaming_seed_num_images` images are
+    // matched, after which it continues with the newly matched images. This
+    // only applies to video data, since the other data types are not matched
+    // sequentially. The stages run one after another as usual for other data
+    // types, if sparse mapping is disabled, or if the workspace already
+    // contains a sparse reconstruction.
+    bool streaming = false;
+
+    // The number of matched images, after which the mapper starts in
+    // streaming mode.
+    int streaming_seed_num_images = 30;
+
     // The number of threads to use in all stages.
     int num_threads = -1;
 
@@ -89,6 +103,8 @@ class AutomaticReconstructionController : public Thread {
   void RunFeatureExtraction();
   void RunFeatureMatching();
   void RunSparseMapper();
+  void RunStreamingReconstruction();
+  bool ExistsSparseReconstruction() const;
 
   const Options options_;
   OptionManager option_manager_;
@@ -0,0 +1,331 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "controllers/hierarchical_mapper.h"
+
+#include <algorithm>
+#include <set>
+
+#include "base/database.h"
+#include "optim/bundle_adjustment.h"
+#include "util/misc.h"
+
+namespace colmap {
+namespace {
+
+void AdjustGlobalBundle(const IncrementalMapperOptions& mapper_options,
+                        Reconstruction* reconstruction) {
+  const std::vector<image_t>& reg_image_ids = reconstruction->RegImageIds();
+  if (reg_image_ids.size() < 2) {
+    return;
+  }
+
+  PrintHeading1("Global bundle adjustment");
+
+  // Avoid degeneracies in bundle adjustment.
+  reconstruction->FilterObservationsWithNegativeDepth();
+
+  BundleAdjustmentConfig ba_config;
+  for (const image_t image_id : reg_image_ids) {
+    ba_config.AddImage(image_id);
+  }
+  ba_config.SetConstantPose(reg_image_ids[0]);
+  ba_config.SetConstantTvec(reg_image_ids[1], {0});
+
+  BundleAdjuster bundle_adjuster(mapper_options.GlobalBundleAdjustment(),
+                                 ba_config);
+  bundle_adjuster.Solve(reconstruction);
+
+  const IncrementalMapper::Options options = mapper_options.Mapper();
+  const size_t num_filtered_observations = reconstruction->FilterAllPoints3D(
+      options.filter_max_reproj_error, options.filter_min_tri_angle);
+  std::cout << "  => Filtered observations: " << num_filtered_observations
+            << std::endl;
+}
+
+}  // namespace
+
+bool HierarchicalMapperController::Options::Check() const {
+  CHECK_OPTION_GT(init_num_trials, 0);
+  CHECK_OPTION_GE(num_workers, -1);
+  CHECK_OPTION_GE(merge_min_num_common_images, 1);
+  CHECK_OPTION_GT(merge_max_reproj_error, 0);
+  return true;
+}
+
+HierarchicalMapperController::HierarchicalMapperController(
+    const Options& options, const SceneClustering::Options& clustering_options,
+    const IncrementalMapperOptions& mapper_options,
+    ReconstructionManager* reconstruction_manager)
+    : options_(options),
+      clustering_options_(clustering_options),
+      mapper_options_(mapper_options),
+      reconstruction_manager_(reconstruction_manager) {
+  CHECK(options_.Check());
+  CHECK(clustering_options_.Check());
+  CHECK(mapper_options_.Check());
+}
+
+void HierarchicalMapperController::Run() {
+  PrintHeading1("Partitioning the scene");
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Cluster scene
+  //////////////////////////////////////////////////////////////////////////////
+
+  SceneClustering scene_clustering(clustering_options_);
+
+  std::unordered_map<image_t, std::string> image_id_to_name;
+
+  // Only the image names and the number of matches per image pair are read
+  // for the partitioning, since the lines and matches of each cluster are
+  // loaded by its own mapper.
+  {
+    std::vector<std::pair<image_t, image_t>> all_image_pairs;
+    std::vector<int> all_num_matches;
+    {
+      Database database(options_.database_path, true,
+                        options_.database_options);
+      for (const auto& image : database.ReadAllImages()) {
+        if (mapper_options_.image_names.empty() ||
+            mapper_options_.image_names.count(image.Name()) > 0) {
+          image_id_to_name.emplace(image.ImageId(), image.Name());
+        }
+      }
+      database.ReadNumMatches(&all_image_pairs, &all_num_matches);
+    }
+
+    // The scene graph is weighted by the number of matches between the
+    // images, where pairs are skipped as in the database cache of the mapper.
+    std::vector<std::pair<image_t, image_t>> image_pairs;
+    std::vector<int> num_matches;
+    for (size_t i = 0; i < all_image_pairs.size(); ++i) {
+      if (all_num_matches[i] > mapper_options_.min_num_matches &&
+          image_id_to_name.count(all_image_pairs[i].first) > 0 &&
+          image_id_to_name.count(all_image_pairs[i].second) > 0) {
+        image_pairs.push_back(all_image_pairs[i]);
+        num_matches.push_back(all_num_matches[i]);
+      }
+    }
+
+    std::cout << "Partitioning the scene graph with " << image_pairs.size()
+              << " image pairs" << std::endl;
+    scene_clustering.Partition(image_pairs, num_matches);
+  }
+
+  auto leaf_clusters = scene_clustering.GetLeafClusters();
+
+  size_t total_num_images = 0;
+  for (size_t i = 0; i < leaf_clusters.size(); ++i) {
+    total_num_images += leaf_clusters[i]->image_ids.size();
+    std::cout << StringPrintf("  Cluster %d with %d images", i + 1,
+                              leaf_clusters[i]->image_ids.size())
+              << std::endl;
+  }
+
+  std::cout << StringPrintf("Clusters have %d images", total_num_images)
+            << std::endl;
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Reconstruct clusters
+  //////////////////////////////////////////////////////////////////////////////
+
+  PrintHeading1("Reconstructing clusters");
+
+  // Determine the number of workers and threads per worker.
+  const int kMaxNumThreads = -1;
+  const int num_eff_threads = GetEffectiveNumThreads(kMaxNumThreads);
+  const int kDefaultNumWorkers = 8;
+  const int num_eff_workers =
+      options_.num_workers < 1
+          ? std::min(static_cast<int>(leaf_clusters.size()),
+                     std::min(kDefaultNumWorkers, num_eff_threads))
+          : options_.num_workers;
+  const int num_threads_per_worker =
+      std::max(1, num_eff_threads / std::max(num_eff_workers, 1));
+
+  // Function to reconstruct one cluster using incremental mapping. Each
+  // mapper loads the images of its cluster from the database and finds its
+  // own initial images with aligned feature lines.
+  auto ReconstructCluster = [&, this](
+                                const SceneClustering::Cluster& cluster,
+                                ReconstructionManager* reconstruction_manager) {
+    if (cluster.image_ids.empty()) {
+      return;
+    }
+
+    IncrementalMapperOptions custom_options = mapper_options_;
+    custom_options.max_model_overlap = 3;
+    custom_options.init_num_trials = options_.init_num_trials;
+    custom_options.num_threads = num_threads_per_worker;
+    custom_options.image_names.clear();
+    for (const auto image_id : cluster.image_ids) {
+      custom_options.image_names.insert(image_id_to_name.at(image_id));
+    }
+
+    IncrementalMapperController mapper(
+        &custom_options, options_.image_path, options_.database_path,
+        reconstruction_manager, options_.database_options);
+    mapper.Start();
+    mapper.Wait();
+  };
+
+  // Start reconstructing the bigger clusters first for better resource usage.
+  std::sort(leaf_clusters.begin(), leaf_clusters.end(),
+            [](const SceneClustering::Cluster* cluster1,
+               const SceneClustering::Cluster* cluster2) {
+              return cluster1->image_ids.size() > cluster2->image_ids.size();
+            });
+
+  // Start the reconstruction workers.
+  std::vector<ReconstructionManager> reconstruction_managers(
+      leaf_clusters.size());
+  {
+    ThreadPool thread_pool(num_eff_workers);
+    for (size_t i = 0; i < leaf_clusters.size(); ++i) {
+      thread_pool.AddTask(ReconstructCluster, *leaf_clusters[i],
+                          &reconstruction_managers[i]);
+    }
+    thread_pool.Wait();
+  }
+
+  for (auto& cluster_reconstruction_manager : reconstruction_managers) {
+    for (size_t i = 0; i < cluster_reconstruction_manager.Size(); ++i) {
+      const size_t reconstruction_idx = reconstruction_manager_->Add();
+      reconstruction_manager_->Get(reconstruction_idx) =
+          std::move(cluster_reconstruction_manager.Get(i));
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Merge clusters
+  //////////////////////////////////////////////////////////////////////////////
+
+  PrintHeading1("Merging clusters");
+
+  MergeReconstructions();
+
+  std::cout << std::endl;
+  GetTimer().PrintMinutes();
+}
+
+void HierarchicalMapperController::MergeReconstructions() {
+  // Pairs of sub-models, which failed to merge in their current state.
+  std::set<std::pair<const Reconstruction*, const Reconstruction*>>
+      failed_pairs;
+  std::unordered_set<const Reconstruction*> merged_reconstructions;
+
+  while (!IsStopped()) {
+    size_t best_num_common_images = 0;
+    size_t best_idx1 = 0;
+    size_t best_idx2 = 0;
+    for (size_t idx1 = 0; idx1 < reconstruction_manager_->Size(); ++idx1) {
+      const Reconstruction& reconstruction1 =
+          reconstruction_manager_->Get(idx1);
+      for (size_t idx2 = idx1 + 1; idx2 < reconstruction_manager_->Size();
+           ++idx2) {
+        const Reconstruction& reconstruction2 =
+            reconstruction_manager_->Get(idx2);
+        if (failed_pairs.count({&reconstruction1, &reconstruction2}) > 0) {
+          continue;
+        }
+        const size_t num_common_images =
+            reconstruction1.FindCommonRegImageIds(reconstruction2).size();
+        if (num_common_images > best_num_common_images) {
+          best_num_common_images = num_common_images;
+          best_idx1 = idx1;
+          best_idx2 = idx2;
+        }
+      }
+    }
+
+    if (best_num_common_images <
+        static_cast<size_t>(options_.merge_min_num_common_images)) {
+      break;
+    }
+
+    // Merge the smaller into the bigger sub-model.
+    if (reconstruction_manager_->Get(best_idx1).NumRegImages() <
+        reconstruction_manager_->Get(best_idx2).NumRegImages()) {
+      std::swap(best_idx1, best_idx2);
+    }
+
+    Reconstruction& reconstruction = reconstruction_manager_->Get(best_idx1);
+    const Reconstruction& other_reconstruction =
+        reconstruction_manager_->Get(best_idx2);
+
+    std::cout << StringPrintf(
+                     "Merging model with %d images into model with %d images "
+                     "(%d common images)",
+                     other_reconstruction.NumRegImages(),
+                     reconstruction.NumRegImages(), best_num_common_images)
+              << std::endl;
+
+    if (reconstruction.Merge(other_reconstruction,
+                             options_.merge_max_reproj_error)) {
+      std::cout << StringPrintf("  => Merged model has %d images",
+                                reconstruction.NumRegImages())
+                << std::endl;
+      // The merged model may now be aligned with models it failed before.
+      for (auto it = failed_pairs.begin(); it != failed_pairs.end();) {
+        if (it->first == &reconstruction || it->second == &reconstruction ||
+            it->first == &other_reconstruction ||
+            it->second == &other_reconstruction) {
+          it = failed_pairs.erase(it);
+        } else {
+          ++it;
+        }
+      }
+      merged_reconstructions.erase(&other_reconstruction);
+      merged_reconstructions.insert(&reconstruction);
+      reconstruction_manager_->Delete(best_idx2);
+    } else {
+      std::cout << "  => Failed to align the models" << std::endl;
+      const Reconstruction* reconstruction1 =
+          &reconstruction_manager_->Get(std::min(best_idx1, best_idx2));
+      const Reconstruction* reconstruction2 =
+          &reconstruction_manager_->Get(std::max(best_idx1, best_idx2));
+      failed_pairs.emplace(reconstruction1, reconstruction2);
+    }
+  }
+
+  // Refine the merged models jointly, since the sub-models were only adjusted
+  // separately and their overlaps are only aligned by a similarity.
+  for (size_t i = 0; i < reconstruction_manager_->Size(); ++i) {
+    if (IsStopped()) {
+      break;
+    }
+    Reconstruction& reconstruction = reconstruction_manager_->Get(i);
+    if (merged_reconstructions.count(&reconstruction) > 0) {
+      AdjustGlobalBundle(mapper_options_, &reconstruction);
+    }
+  }
+}
+
+}  // namespace colmap
@@ -0,0 +1,97 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef COLMAP_SRC_CONTROLLERS_HIERARCHICAL_MAPPER_H_
+#define COLMAP_SRC_CONTROLLERS_HIERARCHICAL_MAPPER_H_
+
+#include "base/reconstruction_manager.h"
+#include "base/scene_clustering.h"
+#include "controllers/incremental_mapper.h"
+#include "util/threading.h"
+
+namespace colmap {
+
+// Hierarchical mapping first partitions the scene graph into overlapping
+// clusters, then reconstructs the clusters in parallel with independent
+// incremental mappers, and finally merges the sub-models of the clusters.
+// This is faster than incremental mapping of the full scene and uses all
+// cores for large image collections, at the cost of some completeness.
+class HierarchicalMapperController : public Thread {
+ public:
+  struct Options {
+    // The path to the image folder which are used as input.
+    std::string image_path;
+
+    // The path to the database file which is used as input.
+    std::string database_path;
+
+    // The connection settings of the database.
+    DatabaseOptions database_options;
+
+    // The maximum number of trials to initialize a cluster.
+    int init_num_trials = 10;
+
+    // The number of clusters reconstructed in parallel. By default, as many
+    // clusters as there are threads.
+    int num_workers = -1;
+
+    // The minimum number of common registered images of two sub-models for
+    // trying to merge them.
+    int merge_min_num_common_images = 3;
+
+    // The maximum line reprojection error in pixels of the 3D points shared
+    // by two sub-models for aligning and merging them.
+    double merge_max_reproj_error = 4.0;
+
+    bool Check() const;
+  };
+
+  HierarchicalMapperController(
+      const Options& options,
+      const SceneClustering::Options& clustering_options,
+      const IncrementalMapperOptions& mapper_options,
+      ReconstructionManager* reconstruction_manager);
+
+ private:
+  void Run() override;
+
+  // Merge the sub-models of the clusters through their common images, always
+  // merging the two sub-models with the most common images first, and adjust
+  // the merged models with global bundle adjustment.
+  void MergeReconstructions();
+
+  const Options options_;
+  const SceneClustering::Options clustering_options_;
+  const IncrementalMapperOptions mapper_options_;
+  ReconstructionManager* reconstruction_manager_;
+};
+
+}  // namespace colmap
+
+#endif  // COLMAP_SRC_CONTROLLERS_HIERARCHICAL_MAPPER_H_
@@ -33,7 +33,12 @@
 
 #include "controllers/incremental_mapper.h"
 
+#include <chrono>
+#include <thread>
+
+#include "util/memory.h"
 #include "util/misc.h"
+#include "util/trace.h"
 
 namespace colmap {
 namespace {
@@ -69,14 +74,16 @@ void AdjustGlobalBundle(const IncrementalMapperOptions& options,
   mapper->AdjustGlobalBundle(options.Mapper(), custom_ba_options);
 }
 
-void IterativeLocalRefinement(const IncrementalMapperOptions& options,
-                              const image_t image_id,
-                              IncrementalMapper* mapper) {
+void IterativeLocalRefinement(
+    const IncrementalMapperOptions& options, const image_t image_id,
+    IncrementalMapper* mapper,
+    std::unordered_set<point3D_t>* changed_point3D_ids) {
+  TRACE_SCOPE("IterativeLocalRefinement");
   auto ba_options = options.LocalBundleAdjustment();
   for (int i = 0; i < options.ba_local_max_refinements; ++i) {
     const auto report = mapper->AdjustLocalBundle(
         options.Mapper(), ba_options, options.Triangulation(), image_id,
-        mapper->GetModifiedPoints3D());
+        mapper->GetModifiedPoints3D(), changed_point3D_ids);
     std::cout << "  => Merged observations: " << report.num_merged_observations
               << std::endl;
     std::cout << "  => Completed observations: "
@@ -96,11 +103,15 @@ void IterativeLocalRefinement(const IncrementalMapperOptions& options,
     ba_options.loss_function_type =
         BundleAdjustmentOptions::LossFunctionType::TRIVIAL;
   }
+  const auto& modified_point3D_ids = mapper->GetModifiedPoints3D();
+  changed_point3D_ids->insert(modified_point3D_ids.begin(),
+                              modified_point3D_ids.end());
   mapper->ClearModifiedPoints3D();
 }
 
 void IterativeGlobalRefinement(const IncrementalMapperOptions& options,
                                IncrementalMapper* mapper) {
+  TRACE_SCOPE("IterativeGlobalRefinement");
   PrintHeading1("Retriangulation");
   CompleteAndMergeTracks(options, mapper);
 
@@ -121,6 +132,13 @@ void IterativeGlobalRefinement(const IncrementalMapperOptions& options,
   }
 
   FilterImages(options, mapper);
+
+  MemoryTracker& memory_tracker = MemoryTracker::Get();
+  if (memory_tracker.IsStarted()) {
+    memory_tracker.AddSample(
+        "IterativeGlobalRefinement",
+        {{"Reconstruction", mapper->GetReconstruction().NumBytes()}});
+  }
 }
 
 void WriteSnapshot(const Reconstruction& reconstruction,
@@ -139,8 +157,86 @@ void WriteSnapshot(const Reconstruction& reconstruction,
   reconstruction.Write(path);
 }
 
+// The minimum number of matches of image pairs in the database cache of images
+// with gravity-aligned lines, which is only used for initialization.
+const size_t kAlignedMinNumMatches = 4;
+
+std::string DatabaseCacheSnapshotPath(const std::string& database_path) {
+  return database_path + ".cache";
+}
+
+std::string AlignedDatabaseCacheSnapshotPath(const std::string& database_path) {
+  return database_path + ".aligned.cache";
+}
+
+// Load the database cache from its snapshot, if it is up to date and was
+// written for the same parameters, and from the database otherwise. An
+// outdated snapshot is brought up to date by only loading the images and image
+// pairs added to the database since, in which case true is returned, so that
+// the snapshot can be rewritten. The database is only opened if needed.
+bool LoadDatabaseCache(const std::string& database_path,
+                       const DatabaseOptions& database_options,
+                       const std::string& snapshot_path,
+                       const size_t min_num_matches,
+                       const bool ignore_watermarks,
+                       const std::unordered_set<std::string>& image_names,
+                       std::unique_ptr<Database>* database,
+                       DatabaseCache* database_cache) {
+  if (DatabaseCache::IsSnapshotUpToDate(snapshot_path, database_path) &&
+      database_cache->LoadSnapshot(snapshot_path, min_num_matches,
+                                   ignore_watermarks, image_names)) {
+    return false;
+  }
+
+  if (!*database) {
+    database->reset(new Database(database_path, true, database_options));
+  }
+
+  if (ExistsFile(snapshot_path) &&
+      database_cache->LoadSnapshot(snapshot_path, min_num_matches,
+                                   ignore_watermarks, image_names,
+                                   /*allow_added_image_names=*/true)) {
+    if (database_cache->LoadDelta(**database, image_names)) {
+      return true;
+    }
+    *database_cache = DatabaseCache();
+  }
+
+  database_cache->Load(**database, min_num_matches, ignore_watermarks,
+                       image_names);
+
+  return false;
+}
+
 }  // namespace
 
+void ExportDatabaseCacheSnapshots(const IncrementalMapperOptions& options,
+                                  const std::string& database_path,
+                                  const DatabaseOptions& database_options) {
+  DatabaseCache database_cache;
+  DatabaseCache aligned_db_cache;
+
+  {
+    Database database(database_path, true, database_options);
+    database_cache.Load(database,
+                        static_cast<size_t>(options.min_num_matches),
+                        options.ignore_watermarks, options.image_names);
+    aligned_db_cache.Load(database, kAlignedMinNumMatches, false,
+                          database_cache.FindImageNamesWithAlignedLines());
+  }
+
+  // The snapshots must be written after the database is closed, so that they
+  // are newer than any file touched by the database.
+  const std::string snapshot_path = DatabaseCacheSnapshotPath(database_path);
+  std::cout << "Writing " << snapshot_path << std::endl;
+  database_cache.WriteSnapshot(snapshot_path);
+
+  const std::string aligned_snapshot_path =
+      AlignedDatabaseCacheSnapshotPath(database_path);
+  std::cout << "Writing " << aligned_snapshot_path << std::endl;
+  aligned_db_cache.WriteSnapshot(aligned_snapshot_path);
+}
+
 size_t FilterPoints(const IncrementalMapperOptions& options,
                     IncrementalMapper* mapper) {
   const size_t num_filtered_observations =
@@ -271,18 +367,47 @@ bool IncrementalMapperOptions::Check() const {
 IncrementalMapperController::IncrementalMapperController(
     const IncrementalMapperOptions* options, const std::string& image_path,
     const std::string& database_path,
-    ReconstructionManager* reconstruction_manager)
+    ReconstructionManager* reconstruction_manager,
+    const DatabaseOptions& database_options)
     : options_(options),
       image_path_(image_path),
       database_path_(database_path),
-      reconstruction_manager_(reconstruction_manager) {
+      database_options_(database_options),
+      reconstruction_manager_(reconstruction_manager),
+      streaming_(false),
+      streaming_finished_(false) {
   CHECK(options_->Check());
   RegisterCallback(INITIAL_IMAGE_PAIR_REG_CALLBACK);
   RegisterCallback(NEXT_IMAGE_REG_CALLBACK);
   RegisterCallback(LAST_IMAGE_REG_CALLBACK);
 }
 
+const IncrementalMapperController::ReconstructionChanges&
+IncrementalMapperController::Changes() const {
+  return changes_;
+}
+
+void IncrementalMapperController::EnableStreaming() {
+  CHECK(!IsStarted());
+  streaming_ = true;
+}
+
+void IncrementalMapperController::AddStreamingImages(
+    const std::vector<std::string>& image_names) {
+  std::unique_lock<std::mutex> lock(streaming_mutex_);
+  new_streaming_image_names_.insert(new_streaming_image_names_.end(),
+                                    image_names.begin(), image_names.end());
+}
+
+void IncrementalMapperController::FinishStreaming() {
+  streaming_finished_ = true;
+}
+
 void IncrementalMapperController::Run() {
+  if (streaming_ && !WaitForStreamingImages()) {
+    return;
+  }
+
   if (!LoadDatabase()) {
     return;
   }
@@ -309,13 +434,36 @@ void IncrementalMapperController::Run() {
     Reconstruct(init_mapper_options);
   }
 
+  if (streaming_) {
+    ReconstructStreamingImages();
+  }
+
+  MemoryTracker& memory_tracker = MemoryTracker::Get();
+  if (memory_tracker.IsStarted()) {
+    size_t num_reconstruction_bytes = 0;
+    for (size_t i = 0; i < reconstruction_manager_->Size(); ++i) {
+      num_reconstruction_bytes += reconstruction_manager_->Get(i).NumBytes();
+    }
+    memory_tracker.AddSample(
+        "Reconstruct", {{"DatabaseCache", database_cache_.NumBytes()},
+                        {"Reconstructions", num_reconstruction_bytes}});
+  }
+
   std::cout << std::endl;
   GetTimer().PrintMinutes();
 }
 
 bool IncrementalMapperController::LoadDatabase() {
+  TRACE_SCOPE("LoadDatabase");
   PrintHeading1("Loading database");
 
+  // The snapshots are not used in streaming mode, since the images change
+  // continuously.
+  if (streaming_) {
+    LoadStreamingImages();
+    return true;
+  }
+
   // Make sure images of the given reconstruction are also included when
   // manually specifying images for the reconstrunstruction procedure.
   std::unordered_set<std::string> image_names = options_->image_names;
@@ -327,12 +475,14 @@ bool IncrementalMapperController::LoadDatabase() {
     }
   }
 
-  Database database(database_path_, true);
+  std::unique_ptr<Database> database;
   Timer timer;
   timer.Start();
   const size_t min_num_matches = static_cast<size_t>(options_->min_num_matches);
-  database_cache_.Load(database, min_num_matches, options_->ignore_watermarks,
-                       image_names);
+  const bool database_cache_updated = LoadDatabaseCache(
+      database_path_, database_options_,
+      DatabaseCacheSnapshotPath(database_path_), min_num_matches,
+      options_->ignore_watermarks, image_names, &database, &database_cache_);
   std::cout << std::endl;
   timer.PrintMinutes();
 
@@ -349,38 +499,39 @@ bool IncrementalMapperController::LoadDatabase() {
   // features.
   // We only need this for initialization, but right now it's the easiest to
   // create it here and keep it around as a member.
-  // Find aligned features
-  std::unordered_map<image_t, std::unordered_set<int>> aligned_lines;
-  for (const auto& image : database_cache_.Images()) {
-    const FeatureLines& image_lines = image.second.Lines();
-    const int num_lines = image_lines.size();
-    for (int i = 0; i < num_lines; ++i) {
-      if (image_lines.at(i).IsAligned()) {
-        aligned_lines[image.first].emplace(i);
-      }
-    }
-  }
-
-  // We only really need the images with aligned lines here. Create a set
-  // of the corresponding image names and pass it to the database cache when
-  // loading.
   // For random initialization, this will not really help much, but it also
   // shouldn't hurt.
-  std::unordered_set<std::string> aligned_image_names;
-  for (const auto& im_lines : aligned_lines) {
-    const Image& image = database_cache_.Image(im_lines.first);
-    const std::string& image_name = image.Name();
-    CHECK(image.HasGravity());
-    aligned_image_names.emplace(image_name);
+  const bool aligned_db_cache_updated = LoadDatabaseCache(
+      database_path_, database_options_,
+      AlignedDatabaseCacheSnapshotPath(database_path_), kAlignedMinNumMatches,
+      false, database_cache_.FindImageNamesWithAlignedLines(), &database,
+      &aligned_db_cache_);
+
+  // Persist the snapshots brought up to date, so that the next run does not
+  // load the same delta again. The snapshots must be written after the
+  // database is closed, so that they are newer than any file touched by it.
+  database.reset();
+  if (database_cache_updated) {
+    database_cache_.WriteSnapshot(DatabaseCacheSnapshotPath(database_path_));
+  }
+  if (aligned_db_cache_updated) {
+    aligned_db_cache_.WriteSnapshot(
+        AlignedDatabaseCacheSnapshotPath(database_path_));
   }
 
-  aligned_db_cache_.Load(database, 4, false, aligned_image_names);
+  MemoryTracker& memory_tracker = MemoryTracker::Get();
+  if (memory_tracker.IsStarted()) {
+    memory_tracker.AddSample(
+        "LoadDatabase", {{"DatabaseCache", database_cache_.NumBytes()},
+                         {"AlignedDatabaseCache", aligned_db_cache_.NumBytes()}});
+  }
 
   return true;
 }
 
 void IncrementalMapperController::Reconstruct(
     const IncrementalMapper::Options& init_mapper_options) {
+  TRACE_SCOPE("Reconstruct");
   const bool kDiscardReconstruction = true;
 
   //////////////////////////////////////////////////////////////////////////////
@@ -390,11 +541,14 @@ void IncrementalMapperController::Reconstruct(
   IncrementalMapper mapper(&database_cache_);
 
   // Is there a sub-model before we start the reconstruction? I.e. the user
-  // has imported an existing reconstruction.
+  // has imported an existing reconstruction. In streaming mode, the last
+  // reconstruction is continued with the newly added images.
   const bool initial_reconstruction_given = reconstruction_manager_->Size() > 0;
-  CHECK_LE(reconstruction_manager_->Size(), 1) << "Can only resume from a "
-                                                  "single reconstruction, but "
-                                                  "multiple are given.";
+  if (!streaming_) {
+    CHECK_LE(reconstruction_manager_->Size(), 1)
+        << "Can only resume from a single reconstruction, but multiple are "
+           "given.";
+  }
 
   for (int num_trials = 0; num_trials < options_->init_num_trials;
        ++num_trials) {
@@ -407,7 +561,7 @@ void IncrementalMapperController::Reconstruct(
     if (!initial_reconstruction_given || num_trials > 0) {
       reconstruction_idx = reconstruction_manager_->Add();
     } else {
-      reconstruction_idx = 0;
+      reconstruction_idx = reconstruction_manager_->Size() - 1;
     }
 
     Reconstruction& reconstruction =
@@ -450,6 +604,9 @@ void IncrementalMapperController::Reconstruct(
 
     Callback(INITIAL_IMAGE_PAIR_REG_CALLBACK);
 
+    changes_ = ReconstructionChanges();
+    changes_.reconstruction = &reconstruction;
+
     ////////////////////////////////////////////////////////////////////////////
     // Incremental mapping
     ////////////////////////////////////////////////////////////////////////////
@@ -492,7 +649,8 @@ void IncrementalMapperController::Reconstruct(
 
         if (reg_next_success) {
           TriangulateImage(*options_, next_image, &mapper);
-          IterativeLocalRefinement(*options_, next_image_id, &mapper);
+          IterativeLocalRefinement(*options_, next_image_id, &mapper,
+                                   &changes_.point3D_ids);
 
           if (reconstruction.NumRegImages() >=
                   options_->ba_global_images_ratio * ba_prev_num_reg_images ||
@@ -505,6 +663,7 @@ void IncrementalMapperController::Reconstruct(
             IterativeGlobalRefinement(*options_, &mapper);
             ba_prev_num_points = reconstruction.NumPoints3D();
             ba_prev_num_reg_images = reconstruction.NumRegImages();
+            changes_.all_changed = true;
           }
 
           if (options_->snapshot_images_freq > 0 &&
@@ -515,8 +674,24 @@ void IncrementalMapperController::Reconstruct(
             WriteSnapshot(reconstruction, options_->snapshot_path);
           }
 
+          // The poses of the images observing the changed points are mostly
+          // changed by the local refinement as well.
+          changes_.image_ids.insert(next_image_id);
+          for (const point3D_t point3D_id : changes_.point3D_ids) {
+            if (!reconstruction.ExistsPoint3D(point3D_id)) {
+              continue;
+            }
+            for (const auto& track_el :
+                 reconstruction.Point3D(point3D_id).Track().Elements()) {
+              changes_.image_ids.insert(track_el.image_id);
+            }
+          }
+
           Callback(NEXT_IMAGE_REG_CALLBACK);
 
+          changes_ = ReconstructionChanges();
+          changes_.reconstruction = &reconstruction;
+
           break;
         } else {
           std::cout << "  => Could not register, trying another image."
@@ -546,6 +721,7 @@ void IncrementalMapperController::Reconstruct(
         reg_next_success = true;
         prev_reg_next_success = false;
         IterativeGlobalRefinement(*options_, &mapper);
+        changes_.all_changed = true;
       } else {
         prev_reg_next_success = reg_next_success;
       }
@@ -590,4 +766,77 @@ void IncrementalMapperController::Reconstruct(
   }
 }
 
+bool IncrementalMapperController::WaitForStreamingImages() {
+  const int kPollIntervalMs = 100;
+
+  while (!IsStopped()) {
+    // Read the finished flag before the images, so that all images added
+    // before finishing are reconstructed.
+    const bool finished = streaming_finished_;
+
+    std::vector<std::string> new_image_names;
+    {
+      std::unique_lock<std::mutex> lock(streaming_mutex_);
+      new_image_names.swap(new_streaming_image_names_);
+    }
+
+    if (!new_image_names.empty()) {
+      streaming_image_names_.insert(new_image_names.begin(),
+                                    new_image_names.end());
+      return true;
+    }
+
+    if (finished) {
+      return false;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kPollIntervalMs));
+  }
+
+  return false;
+}
+
+void IncrementalMapperController::LoadStreamingImages() {
+  TRACE_SCOPE("LoadStreamingImages");
+
+  const size_t min_num_matches = static_cast<size_t>(options_->min_num_matches);
+
+  Timer timer;
+  timer.Start();
+
+  Database database(database_path_, true, database_options_);
+
+  // Only the images and image pairs added since the last call are loaded, if
+  // the images were added in the order of their identifiers. Otherwise, or if
+  // the caches are still empty, they are fully loaded.
+  if (database_cache_.NumImages() == 0 ||
+      !database_cache_.LoadDelta(database, streaming_image_names_)) {
+    database_cache_ = DatabaseCache();
+    database_cache_.Load(database, min_num_matches,
+                         options_->ignore_watermarks, streaming_image_names_);
+  }
+
+  const std::unordered_set<std::string> aligned_image_names =
+      database_cache_.FindImageNamesWithAlignedLines();
+  if (aligned_db_cache_.NumImages() == 0 ||
+      !aligned_db_cache_.LoadDelta(database, aligned_image_names)) {
+    aligned_db_cache_ = DatabaseCache();
+    aligned_db_cache_.Load(database, kAlignedMinNumMatches, false,
+                           aligned_image_names);
+  }
+
+  std::cout << std::endl;
+  timer.PrintMinutes();
+  std::cout << std::endl;
+}
+
+void IncrementalMapperController::ReconstructStreamingImages() {
+  while (WaitForStreamingImages()) {
+    PrintHeading1(StringPrintf("Continuing with %d streamed images",
+                               streaming_image_names_.size()));
+    LoadStreamingImages();
+    Reconstruct(options_->Mapper());
+  }
+}
+
 }  // namespace colmap
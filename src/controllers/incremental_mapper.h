@@ -34,6 +34,9 @@
 #ifndef COLMAP_SRC_CONTROLLERS_INCREMENTAL_MAPPER_H_
 #define COLMAP_SRC_CONTROLLERS_INCREMENTAL_MAPPER_H_
 
+#include <atomic>
+#include <mutex>
+
 #include "base/reconstruction_manager.h"
 #include "sfm/incremental_mapper.h"
 #include "util/threading.h"
@@ -150,22 +153,67 @@ class IncrementalMapperController : public Thread {
     LAST_IMAGE_REG_CALLBACK,
   };
 
-  IncrementalMapperController(const IncrementalMapperOptions* options,
-                              const std::string& image_path,
-                              const std::string& database_path,
-                              ReconstructionManager* reconstruction_manager);
+  // The changes of the current reconstruction since the previous callback,
+  // which can be used in the `NEXT_IMAGE_REG_CALLBACK` to incrementally update
+  // a copy of the reconstruction, e.g., for visualization.
+  struct ReconstructionChanges {
+    const Reconstruction* reconstruction = nullptr;
+
+    // Whether the entire reconstruction changed, e.g., in global refinement.
+    bool all_changed = false;
+
+    // The registered images with changed poses or observations.
+    std::unordered_set<image_t> image_ids;
+
+    // The added, modified, or deleted 3D points.
+    std::unordered_set<point3D_t> point3D_ids;
+  };
+
+  IncrementalMapperController(
+      const IncrementalMapperOptions* options, const std::string& image_path,
+      const std::string& database_path,
+      ReconstructionManager* reconstruction_manager,
+      const DatabaseOptions& database_options = DatabaseOptions());
+
+  const ReconstructionChanges& Changes() const;
+
+  // Enable streaming mode, which must be done before starting the thread. The
+  // mapper then only reconstructs the images added with `AddStreamingImages`.
+  // It starts once the first images are added and continues the last
+  // reconstruction with the images added since, until `FinishStreaming` is
+  // called. Images must be added in the order of their identifiers and only
+  // after all their matches to the previously added images are written to the
+  // database.
+  void EnableStreaming();
+  void AddStreamingImages(const std::vector<std::string>& image_names);
+  void FinishStreaming();
 
  private:
   void Run();
   bool LoadDatabase();
   void Reconstruct(const IncrementalMapper::Options& init_mapper_options);
 
+  // Wait for new images in streaming mode and add them to the images to
+  // reconstruct. Returns false if streaming finished without new images.
+  bool WaitForStreamingImages();
+  void LoadStreamingImages();
+  void ReconstructStreamingImages();
+
   const IncrementalMapperOptions* options_;
   const std::string image_path_;
   const std::string database_path_;
+  const DatabaseOptions database_options_;
   ReconstructionManager* reconstruction_manager_;
   DatabaseCache database_cache_;
   DatabaseCache aligned_db_cache_;
+
+  ReconstructionChanges changes_;
+
+  bool streaming_;
+  std::atomic<bool> streaming_finished_;
+  std::mutex streaming_mutex_;
+  std::vector<std::string> new_streaming_image_names_;
+  std::unordered_set<std::string> streaming_image_names_;
 };
 
 // Globally filter points and images in mapper.
@@ -178,6 +226,14 @@ size_t FilterImages(const IncrementalMapperOptions& options,
 size_t CompleteAndMergeTracks(const IncrementalMapperOptions& options,
                               IncrementalMapper* mapper);
 
+// Load the database caches used by the mapper and write them as snapshots
+// next to the database. The mapper loads these snapshots instead of the
+// database as long as they are newer than the database and the loading
+// options of the mapper did not change.
+void ExportDatabaseCacheSnapshots(
+    const IncrementalMapperOptions& options, const std::string& database_path,
+    const DatabaseOptions& database_options = DatabaseOptions());
+
 }  // namespace colmap
 
 #endif  // COLMAP_SRC_CONTROLLERS_INCREMENTAL_MAPPER_H_
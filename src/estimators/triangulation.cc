@@ -33,15 +33,46 @@
 
 #include "estimators/triangulation.h"
 
+#include <algorithm>
+#include <limits>
+
 #include <Eigen/Geometry>
 
 #include "base/projection.h"
 #include "base/triangulation.h"
 #include "optim/combination_sampler.h"
+#include "optim/guided_sampler.h"
 #include "optim/loransac.h"
 #include "util/logging.h"
 
 namespace colmap {
+namespace {
+
+// Check that the point is in front of all views and that at least one pair of
+// views has a sufficient triangulation angle.
+bool HasValidTriangulationGeometry(
+    const std::vector<TriangulationEstimator::PoseData>& pose_data,
+    const Eigen::Vector3d& xyz, const double min_tri_angle) {
+  for (const auto& pose : pose_data) {
+    if (!HasPointPositiveDepth(pose.proj_matrix, xyz)) {
+      return false;
+    }
+  }
+
+  for (size_t i = 0; i < pose_data.size(); ++i) {
+    for (size_t j = 0; j < i; ++j) {
+      const double tri_angle = CalculateTriangulationAngle(
+          pose_data[i].proj_center, pose_data[j].proj_center, xyz);
+      if (tri_angle >= min_tri_angle) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+}  // namespace
 
 void TriangulationEstimator::SetMinTriAngle(const double min_tri_angle) {
   CHECK_GE(min_tri_angle, 0);
@@ -61,36 +92,19 @@ std::vector<TriangulationEstimator::M_t> TriangulationEstimator::Estimate(
   CHECK(point_data.size() > 2);
 
   // Multi-view triangulation.
-  std::vector<Eigen::Matrix3x4d> proj_matrices;
-  proj_matrices.reserve(point_data.size());
-  std::vector<Eigen::Vector3d> lines;
-  lines.reserve(point_data.size());
+  MultiViewTriangulationEquations equations;
   for (size_t i = 0; i < point_data.size(); ++i) {
-    proj_matrices.push_back(pose_data[i].proj_matrix);
-    lines.push_back(point_data[i].line);
+    equations.Add(pose_data[i].proj_matrix, point_data[i].line);
   }
 
-  const M_t xyz = TriangulateMultiViewPoint(proj_matrices, lines);
-
-  // Check for cheirality constraint.
-  for (const auto& pose : pose_data) {
-    if (!HasPointPositiveDepth(pose.proj_matrix, xyz)) {
-      return std::vector<M_t>();
-    }
-  }
+  const M_t xyz = equations.Solve();
 
-  // Check for sufficient triangulation angle.
-  for (size_t i = 0; i < pose_data.size(); ++i) {
-    for (size_t j = 0; j < i; ++j) {
-      const double tri_angle = CalculateTriangulationAngle(
-          pose_data[i].proj_center, pose_data[j].proj_center, xyz);
-      if (tri_angle >= min_tri_angle_) {
-        return std::vector<M_t>{xyz};
-      }
-    }
+  // Check for cheirality constraint and sufficient triangulation angle.
+  if (!HasValidTriangulationGeometry(pose_data, xyz, min_tri_angle_)) {
+    return std::vector<M_t>();
   }
 
-  return std::vector<M_t>();
+  return std::vector<M_t>{xyz};
 }
 
 void TriangulationEstimator::Residuals(const std::vector<X_t>& point_data,
@@ -115,6 +129,210 @@ void TriangulationEstimator::Residuals(const std::vector<X_t>& point_data,
   }
 }
 
+std::vector<std::vector<size_t>> SelectTriangulationSeedSamples(
+    const std::vector<TriangulationEstimator::PointData>& point_data,
+    const std::vector<TriangulationEstimator::PoseData>& pose_data,
+    const size_t num_seed_samples) {
+  CHECK_EQ(point_data.size(), pose_data.size());
+
+  const size_t num_views = point_data.size();
+  if (num_views < TriangulationEstimator::kMinNumSamples ||
+      num_seed_samples == 0) {
+    return {};
+  }
+
+  // The triangulation angles are evaluated at the linear estimate from all
+  // observations, which is sufficiently accurate to rank the views, even if
+  // the track contains outliers.
+  MultiViewTriangulationEquations equations;
+  for (size_t i = 0; i < num_views; ++i) {
+    equations.Add(pose_data[i].proj_matrix, point_data[i].line);
+  }
+  const Eigen::Vector3d xyz = equations.Solve();
+
+  Eigen::MatrixXd tri_angles = Eigen::MatrixXd::Zero(num_views, num_views);
+  std::vector<std::pair<double, std::pair<size_t, size_t>>> pairs;
+  pairs.reserve(num_views * (num_views - 1) / 2);
+  for (size_t i = 0; i < num_views; ++i) {
+    for (size_t j = 0; j < i; ++j) {
+      const double tri_angle = CalculateTriangulationAngle(
+          pose_data[i].proj_center, pose_data[j].proj_center, xyz);
+      tri_angles(i, j) = tri_angle;
+      tri_angles(j, i) = tri_angle;
+      pairs.emplace_back(tri_angle, std::make_pair(j, i));
+    }
+  }
+
+  // Complete the widest pairs with the view that maximizes the smallest
+  // angle of the triplet.
+  const size_t num_pairs = std::min(pairs.size(), 2 * num_seed_samples);
+  std::partial_sort(pairs.begin(), pairs.begin() + num_pairs, pairs.end(),
+                    [](const std::pair<double, std::pair<size_t, size_t>>& a,
+                       const std::pair<double, std::pair<size_t, size_t>>& b) {
+                      return a.first > b.first;
+                    });
+
+  std::vector<std::pair<double, std::vector<size_t>>> triplets;
+  triplets.reserve(num_pairs);
+  for (size_t pair_idx = 0; pair_idx < num_pairs; ++pair_idx) {
+    const size_t i = pairs[pair_idx].second.first;
+    const size_t j = pairs[pair_idx].second.second;
+    double best_tri_angle = -1;
+    size_t best_k = 0;
+    for (size_t k = 0; k < num_views; ++k) {
+      if (k == i || k == j) {
+        continue;
+      }
+      const double tri_angle = std::min(tri_angles(i, k), tri_angles(j, k));
+      if (tri_angle > best_tri_angle) {
+        best_tri_angle = tri_angle;
+        best_k = k;
+      }
+    }
+
+    std::vector<size_t> triplet = {i, j, best_k};
+    std::sort(triplet.begin(), triplet.end());
+    const double score = std::min(pairs[pair_idx].first, best_tri_angle);
+    bool is_duplicate = false;
+    for (const auto& other_triplet : triplets) {
+      if (other_triplet.second == triplet) {
+        is_duplicate = true;
+        break;
+      }
+    }
+    if (!is_duplicate) {
+      triplets.emplace_back(score, std::move(triplet));
+    }
+  }
+
+  std::stable_sort(triplets.begin(), triplets.end(),
+                   [](const std::pair<double, std::vector<size_t>>& a,
+                      const std::pair<double, std::vector<size_t>>& b) {
+                     return a.first > b.first;
+                   });
+
+  std::vector<std::vector<size_t>> seed_samples;
+  seed_samples.reserve(num_seed_samples);
+  for (size_t i = 0; i < std::min(triplets.size(), num_seed_samples); ++i) {
+    seed_samples.push_back(std::move(triplets[i].second));
+  }
+
+  return seed_samples;
+}
+
+namespace {
+
+// Evaluate the sines of the angular errors of the observations and their
+// Jacobians with respect to the 3D point. Returns the summed squared cost.
+double ComputeTriangulationCost(
+    const std::vector<TriangulationEstimator::PointData>& point_data,
+    const std::vector<TriangulationEstimator::PoseData>& pose_data,
+    const Eigen::Vector3d& xyz, Eigen::Matrix3d* JtJ, Eigen::Vector3d* Jtr) {
+  if (JtJ != nullptr) {
+    JtJ->setZero();
+    Jtr->setZero();
+  }
+
+  double cost = 0;
+  for (size_t i = 0; i < point_data.size(); ++i) {
+    const Eigen::Matrix3x4d& proj_matrix = pose_data[i].proj_matrix;
+    const Eigen::Vector3d ray = proj_matrix * xyz.homogeneous();
+    const double ray_norm = ray.norm();
+    if (ray_norm == 0) {
+      return std::numeric_limits<double>::max();
+    }
+    const Eigen::Vector3d line_normal = point_data[i].line.normalized();
+    const double residual = line_normal.dot(ray) / ray_norm;
+    cost += residual * residual;
+
+    if (JtJ != nullptr) {
+      const Eigen::RowVector3d J =
+          (line_normal - residual * ray / ray_norm).transpose() *
+          proj_matrix.leftCols<3>() / ray_norm;
+      JtJ->noalias() += J.transpose() * J;
+      Jtr->noalias() += J.transpose() * residual;
+    }
+  }
+
+  return cost;
+}
+
+template <typename RANSAC_t>
+bool EstimateTriangulationRANSAC(
+    const EstimateTriangulationOptions& options,
+    const std::vector<TriangulationEstimator::PointData>& point_data,
+    const std::vector<TriangulationEstimator::PoseData>& pose_data,
+    RANSAC_t* ransac, std::vector<char>* inlier_mask, Eigen::Vector3d* xyz) {
+  ransac->estimator.SetMinTriAngle(options.min_tri_angle);
+  ransac->estimator.SetResidualType(options.residual_type);
+  ransac->local_estimator.SetMinTriAngle(options.min_tri_angle);
+  ransac->local_estimator.SetResidualType(options.residual_type);
+  const auto report = ransac->Estimate(point_data, pose_data);
+  if (!report.success) {
+    return false;
+  }
+
+  *inlier_mask = report.inlier_mask;
+  *xyz = report.model;
+
+  return true;
+}
+
+}  // namespace
+
+bool RefineTriangulation(
+    const std::vector<TriangulationEstimator::PointData>& point_data,
+    const std::vector<TriangulationEstimator::PoseData>& pose_data,
+    const int max_num_iterations, Eigen::Vector3d* xyz) {
+  CHECK_EQ(point_data.size(), pose_data.size());
+  CHECK_NOTNULL(xyz);
+
+  if (point_data.size() < TriangulationEstimator::kMinNumSamples) {
+    return false;
+  }
+
+  Eigen::Matrix3d JtJ;
+  Eigen::Vector3d Jtr;
+  const double initial_cost =
+      ComputeTriangulationCost(point_data, pose_data, *xyz, &JtJ, &Jtr);
+  double cost = initial_cost;
+
+  for (int iteration = 0; iteration < max_num_iterations; ++iteration) {
+    const Eigen::LDLT<Eigen::Matrix3d> ldlt(JtJ);
+    if (ldlt.info() != Eigen::Success) {
+      break;
+    }
+
+    const Eigen::Vector3d step = -ldlt.solve(Jtr);
+    if (!step.allFinite()) {
+      break;
+    }
+
+    // Halve the step until the cost decreases.
+    bool success = false;
+    for (double scale = 1; scale > 1e-3; scale *= 0.5) {
+      const Eigen::Vector3d new_xyz = *xyz + scale * step;
+      const double new_cost =
+          ComputeTriangulationCost(point_data, pose_data, new_xyz, nullptr,
+                                   nullptr);
+      if (new_cost < cost) {
+        *xyz = new_xyz;
+        cost = new_cost;
+        success = true;
+        break;
+      }
+    }
+
+    if (!success || step.norm() <= 1e-10 * xyz->norm()) {
+      break;
+    }
+
+    ComputeTriangulationCost(point_data, pose_data, *xyz, &JtJ, &Jtr);
+  }
+
+  return cost < initial_cost;
+}
+
 bool EstimateTriangulation(
     const EstimateTriangulationOptions& options,
     const std::vector<TriangulationEstimator::PointData>& point_data,
@@ -129,23 +347,86 @@ bool EstimateTriangulation(
   if(point_data.size() < 3)
     return false;
 
-  // Robustly estimate track using LORANSAC.
-  LORANSAC<TriangulationEstimator, TriangulationEstimator,
-           InlierSupportMeasurer, CombinationSampler>
-      ransac(options.ransac_options);
-  ransac.estimator.SetMinTriAngle(options.min_tri_angle);
-  ransac.estimator.SetResidualType(options.residual_type);
-  ransac.local_estimator.SetMinTriAngle(options.min_tri_angle);
-  ransac.local_estimator.SetResidualType(options.residual_type);
-  const auto report = ransac.Estimate(point_data, pose_data);
-  if (!report.success) {
-    return false;
+  // Robustly estimate track using LORANSAC. Long tracks are sampled starting
+  // from the most informative view triplets, since enumerating all
+  // combinations of observations is prohibitively expensive.
+  if (point_data.size() >=
+      static_cast<size_t>(options.guided_min_num_observations)) {
+    RANSACOptions ransac_options = options.ransac_options;
+    ransac_options.max_num_trials = std::min<size_t>(
+        ransac_options.max_num_trials, options.guided_max_num_trials);
+    ransac_options.min_num_trials = std::min(ransac_options.min_num_trials,
+                                             ransac_options.max_num_trials);
+    LORANSAC<TriangulationEstimator, TriangulationEstimator,
+             InlierSupportMeasurer, GuidedSampler>
+        ransac(ransac_options);
+    ransac.sampler.SetSeedSamples(SelectTriangulationSeedSamples(
+        point_data, pose_data, options.guided_num_seed_samples));
+    if (!EstimateTriangulationRANSAC(options, point_data, pose_data, &ransac,
+                                     inlier_mask, xyz)) {
+      return false;
+    }
+  } else {
+    LORANSAC<TriangulationEstimator, TriangulationEstimator,
+             InlierSupportMeasurer, CombinationSampler>
+        ransac(options.ransac_options);
+    if (!EstimateTriangulationRANSAC(options, point_data, pose_data, &ransac,
+                                     inlier_mask, xyz)) {
+      return false;
+    }
   }
 
-  *inlier_mask = report.inlier_mask;
-  *xyz = report.model;
+  // Refine the estimate using all inliers of long tracks.
+  const size_t num_inliers =
+      std::count(inlier_mask->begin(), inlier_mask->end(), true);
+  if (num_inliers <
+      static_cast<size_t>(options.refine_min_num_observations)) {
+    return true;
+  }
+
+  std::vector<TriangulationEstimator::PointData> inlier_point_data;
+  std::vector<TriangulationEstimator::PoseData> inlier_pose_data;
+  for (size_t i = 0; i < inlier_mask->size(); ++i) {
+    if ((*inlier_mask)[i]) {
+      inlier_point_data.push_back(point_data[i]);
+      inlier_pose_data.push_back(pose_data[i]);
+    }
+  }
+
+  Eigen::Vector3d refined_xyz = *xyz;
+  if (!RefineTriangulation(inlier_point_data, inlier_pose_data,
+                           options.refine_max_num_iterations, &refined_xyz)) {
+    return true;
+  }
+
+  // The refinement is unconstrained, so the refined point must satisfy the
+  // same geometric constraints as the RANSAC estimate.
+  if (!HasValidTriangulationGeometry(inlier_pose_data, refined_xyz,
+                                     options.min_tri_angle)) {
+    return true;
+  }
+
+  // Only keep the refined point if none of the inliers is lost.
+  TriangulationEstimator estimator;
+  estimator.SetResidualType(options.residual_type);
+  std::vector<double> residuals;
+  estimator.Residuals(point_data, pose_data, refined_xyz, &residuals);
+  const double max_residual =
+      options.ransac_options.max_error * options.ransac_options.max_error;
+  for (size_t i = 0; i < residuals.size(); ++i) {
+    if ((*inlier_mask)[i] && residuals[i] > max_residual) {
+      return true;
+    }
+  }
+
+  for (size_t i = 0; i < residuals.size(); ++i) {
+    (*inlier_mask)[i] =
+        residuals[i] <= max_residual &&
+        HasPointPositiveDepth(pose_data[i].proj_matrix, refined_xyz);
+  }
+  *xyz = refined_xyz;
 
-  return report.success;
+  return true;
 }
 
 }  // namespace colmap
@@ -131,15 +131,58 @@ struct EstimateTriangulationOptions {
   // RANSAC options for TriangulationEstimator.
   RANSACOptions ransac_options;
 
+  // Minimum number of observations for which RANSAC is seeded with the view
+  // triplets with the widest triangulation angles instead of enumerating all
+  // combinations of observations.
+  int guided_min_num_observations = 15;
+
+  // Number of view triplets to seed the guided RANSAC with.
+  int guided_num_seed_samples = 10;
+
+  // Maximum number of RANSAC trials for guided sampling. The estimate is
+  // then improved by the non-linear refinement rather than more sampling.
+  int guided_max_num_trials = 100;
+
+  // Minimum number of inliers for which the RANSAC estimate is refined
+  // non-linearly. For fewer inliers, the linear estimate of the local
+  // optimization in LORANSAC, which already uses all inliers, is kept.
+  int refine_min_num_observations = 15;
+
+  // Maximum number of Gauss-Newton iterations of the non-linear refinement.
+  int refine_max_num_iterations = 10;
+
   void Check() const {
     CHECK_GE(min_tri_angle, 0.0);
+    CHECK_GE(guided_min_num_observations, 3);
+    CHECK_GE(guided_num_seed_samples, 0);
+    CHECK_GT(guided_max_num_trials, 0);
+    CHECK_GE(refine_min_num_observations, 3);
+    CHECK_GE(refine_max_num_iterations, 0);
     ransac_options.Check();
   }
 };
 
+// Select the view triplets with the widest triangulation angles with respect
+// to the linear estimate from all observations. The triplets are sorted by
+// decreasing angle, such that the most informative triplet comes first.
+std::vector<std::vector<size_t>> SelectTriangulationSeedSamples(
+    const std::vector<TriangulationEstimator::PointData>& point_data,
+    const std::vector<TriangulationEstimator::PoseData>& pose_data,
+    const size_t num_seed_samples);
+
+// Refine the 3D point by minimizing the squared sines of the angular errors of
+// the given observations with Gauss-Newton. Returns whether the refinement
+// decreased the cost.
+bool RefineTriangulation(
+    const std::vector<TriangulationEstimator::PointData>& point_data,
+    const std::vector<TriangulationEstimator::PoseData>& pose_data,
+    const int max_num_iterations, Eigen::Vector3d* xyz);
+
 // Robustly estimate 3D point from observations in multiple views using RANSAC
-// and a subsequent non-linear refinement using all inliers. Returns true
-// if the estimated number of inliers has more than two views.
+// and a subsequent non-linear refinement using all inliers of long tracks.
+// Long tracks are sampled with guided RANSAC seeded from the most informative
+// view triplets.
+// Returns true if the estimated number of inliers has more than two views.
 bool EstimateTriangulation(
     const EstimateTriangulationOptions& options,
     const std::vector<TriangulationEstimator::PointData>& point_data,
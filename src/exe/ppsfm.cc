@@ -36,17 +36,23 @@
 #endif
 
 #include <algorithm>
+#include <chrono>
+#include <thread>
 
 #include "base/pose.h"
 #include "controllers/automatic_reconstruction.h"
 #include "controllers/bundle_adjustment.h"
+#include "controllers/hierarchical_mapper.h"
 #include "feature/extraction.h"
 #include "feature/matching.h"
 #include "feature/utils.h"
+#include "sfm/localizer.h"
 #include "ui/main_window.h"
+#include "util/memory.h"
 #include "util/opengl_utils.h"
 #include "util/random.h"
 #include "util/string.h"
+#include "util/trace.h"
 #include "util/version.h"
 
 #include "init/initializer.h"
@@ -105,6 +111,9 @@ int RunAutomaticReconstructor(int argc, char** argv) {
   options.AddDefaultOption("num_threads", &reconstruction_options.num_threads);
   options.AddDefaultOption("use_gpu", &reconstruction_options.use_gpu);
   options.AddDefaultOption("gpu_index", &reconstruction_options.gpu_index);
+  options.AddDefaultOption("streaming", &reconstruction_options.streaming);
+  options.AddDefaultOption("streaming_seed_num_images",
+                           &reconstruction_options.streaming_seed_num_images);
   options.Parse(argc, argv);
 
   StringToLower(&data_type);
@@ -189,7 +198,57 @@ int RunDatabaseCreator(int argc, char** argv) {
   options.AddDatabaseOptions();
   options.Parse(argc, argv);
 
-  Database database(*options.database_path);
+  Database database(*options.database_path, false, *options.database);
+
+  return EXIT_SUCCESS;
+}
+
+int RunDatabaseCacheExporter(int argc, char** argv) {
+  OptionManager options;
+  options.AddDatabaseOptions();
+  options.AddMapperOptions();
+  options.Parse(argc, argv);
+
+  PrintHeading1("Exporting database cache");
+
+  Timer timer;
+  timer.Start();
+
+  ExportDatabaseCacheSnapshots(*options.mapper, *options.database_path,
+                               *options.database);
+
+  timer.PrintMinutes();
+
+  return EXIT_SUCCESS;
+}
+
+int RunDatabaseMigrator(int argc, char** argv) {
+  OptionManager options;
+  options.AddDatabaseOptions();
+  options.Parse(argc, argv);
+
+  PrintHeading1("Compressing matches");
+
+  Timer timer;
+  timer.Start();
+
+  Database database(*options.database_path, false, *options.database);
+
+  size_t num_converted_pairs = 0;
+  {
+    DatabaseTransaction database_transaction(&database);
+    num_converted_pairs = database.CompressMatches();
+  }
+
+  std::cout << StringPrintf("Converted %d image pairs",
+                            static_cast<int>(num_converted_pairs))
+            << std::endl;
+
+  if (num_converted_pairs > 0) {
+    database.Vacuum();
+  }
+
+  timer.PrintMinutes();
 
   return EXIT_SUCCESS;
 }
@@ -235,9 +294,9 @@ int RunExhaustiveMatcher(int argc, char** argv) {
     app.reset(new QApplication(argc, argv));
   }
 
-  ExhaustiveFeatureMatcher feature_matcher(*options.exhaustive_matching,
-                                           *options.sift_matching,
-                                           *options.database_path);
+  ExhaustiveFeatureMatcher feature_matcher(
+      *options.exhaustive_matching, *options.sift_matching,
+      *options.database_path, *options.database);
 
   if (options.sift_matching->use_gpu && kUseOpenGL) {
     RunThreadWithOpenGLContext(&feature_matcher);
@@ -302,8 +361,8 @@ int RunFeatureExtractor(int argc, char** argv) {
     app.reset(new QApplication(argc, argv));
   }
 
-  SiftFeatureExtractor feature_extractor(reader_options,
-                                         *options.sift_extraction);
+  SiftFeatureExtractor feature_extractor(
+      reader_options, *options.sift_extraction, *options.database);
 
   if (options.sift_extraction->use_gpu && kUseOpenGL) {
     RunThreadWithOpenGLContext(&feature_extractor);
@@ -364,6 +423,255 @@ int RunImageFilterer(int argc, char** argv) {
   return EXIT_SUCCESS;
 }
 
+void PrintLocalizerStatistics(const std::vector<double>& latencies,
+                              const size_t num_localized,
+                              const double busy_seconds) {
+  if (latencies.empty()) {
+    return;
+  }
+
+  std::vector<double> sorted_latencies = latencies;
+  std::sort(sorted_latencies.begin(), sorted_latencies.end());
+  const auto Percentile = [&sorted_latencies](const double p) {
+    return sorted_latencies[static_cast<size_t>(
+        p * (sorted_latencies.size() - 1))];
+  };
+
+  std::cout << StringPrintf(
+                   "Queries: %d (%d localized), throughput: %.1f queries/s, "
+                   "latency [ms] mean: %.1f, median: %.1f, p99: %.1f, "
+                   "max: %.1f",
+                   latencies.size(), num_localized,
+                   latencies.size() / std::max(busy_seconds, 1e-9),
+                   1000 * Mean(sorted_latencies), 1000 * Percentile(0.5),
+                   1000 * Percentile(0.99), 1000 * sorted_latencies.back())
+            << std::endl;
+}
+
+// Serves localization queries against a fixed model. The reconstruction and
+// the descriptor index of its 3D points are kept in memory, and queries are
+// read from a spool directory, e.g.:
+//
+//    ppsfm localizer --database_path model.db --input_path model/
+//                    --spool_path queries/
+//
+// A query is a database with the cameras, lines, and descriptors of one or
+// more query images, e.g. as written by `feature_extractor`. Clients should
+// write the query under a different name and then rename it to `*.db`, so
+// that it is never read partially. The poses are written to `*.txt` next to
+// the query, with one line per image in the format
+//
+//    IMAGE_NAME QW QX QY QZ TX TY TZ NUM_MATCHES NUM_INLIERS
+//
+// or `IMAGE_NAME FAILED NUM_MATCHES NUM_INLIERS`, and the query is renamed to
+// `*.db.done` afterwards. Queries that are not intact databases are renamed to
+// `*.db.invalid` without writing results. The latency of a query image covers
+// reading its features and localizing it, but not opening the query database.
+// The server exits after `max_num_queries` query databases, if positive.
+int RunLocalizer(int argc, char** argv) {
+  std::string input_path;
+  std::string spool_path;
+  int poll_interval_ms = 10;
+  int max_num_queries = 0;
+  int report_interval = 100;
+
+  Localizer::Options localizer_options;
+
+  OptionManager options;
+  options.AddDatabaseOptions();
+  options.AddRequiredOption("input_path", &input_path);
+  options.AddRequiredOption("spool_path", &spool_path);
+  options.AddDefaultOption("poll_interval_ms", &poll_interval_ms);
+  options.AddDefaultOption("max_num_queries", &max_num_queries);
+  options.AddDefaultOption("report_interval", &report_interval);
+  options.AddDefaultOption("Localizer.max_ratio",
+                           &localizer_options.max_ratio);
+  options.AddDefaultOption("Localizer.max_distance",
+                           &localizer_options.max_distance);
+  options.AddDefaultOption("Localizer.index_all_observations",
+                           &localizer_options.index_all_observations);
+  options.AddDefaultOption("Localizer.num_index_trees",
+                           &localizer_options.num_index_trees);
+  options.AddDefaultOption("Localizer.num_index_checks",
+                           &localizer_options.num_index_checks);
+  options.AddDefaultOption("Localizer.abs_pose_max_error",
+                           &localizer_options.abs_pose_max_error);
+  options.AddDefaultOption("Localizer.abs_pose_min_num_inliers",
+                           &localizer_options.abs_pose_min_num_inliers);
+  options.AddDefaultOption("Localizer.abs_pose_min_inlier_ratio",
+                           &localizer_options.abs_pose_min_inlier_ratio);
+  options.AddDefaultOption("Localizer.abs_pose_max_num_trials",
+                           &localizer_options.abs_pose_max_num_trials);
+  options.Parse(argc, argv);
+
+  if (!ExistsDir(input_path)) {
+    std::cerr << "ERROR: `input_path` is not a directory." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (!ExistsDir(spool_path)) {
+    std::cerr << "ERROR: `spool_path` is not a directory." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  PrintHeading1("Loading model");
+
+  Timer timer;
+  timer.Start();
+
+  Reconstruction reconstruction;
+  reconstruction.Read(input_path);
+
+  std::unique_ptr<Localizer> localizer;
+  {
+    Database database(*options.database_path, false, *options.database);
+    localizer.reset(
+        new Localizer(localizer_options, &reconstruction, database));
+  }
+
+  std::cout << StringPrintf("Indexed %d descriptors of %d points in %.3fs",
+                            localizer->NumIndexedDescriptors(),
+                            reconstruction.NumPoints3D(),
+                            timer.ElapsedSeconds())
+            << std::endl;
+
+  PrintHeading1("Serving queries");
+
+  std::vector<double> latencies;
+  size_t num_localized = 0;
+  double busy_seconds = 0;
+  int num_queries = 0;
+
+  while (max_num_queries <= 0 || num_queries < max_num_queries) {
+    std::vector<std::string> query_paths;
+    for (const auto& path : GetFileList(spool_path)) {
+      if (HasFileExtension(path, ".db")) {
+        query_paths.push_back(path);
+      }
+    }
+
+    if (query_paths.empty()) {
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(poll_interval_ms));
+      continue;
+    }
+
+    std::sort(query_paths.begin(), query_paths.end());
+
+    for (const auto& query_path : query_paths) {
+      if (max_num_queries > 0 && num_queries >= max_num_queries) {
+        break;
+      }
+
+      // Move malformed queries aside instead of failing on them, since a
+      // single bad client must not take down the server.
+      if (!Database::IsReadable(query_path)) {
+        std::cerr << "WARNING: Ignoring invalid query database " << query_path
+                  << std::endl;
+        boost::filesystem::rename(query_path, query_path + ".invalid");
+        continue;
+      }
+
+      num_queries += 1;
+
+      const std::vector<Localizer::QueryResult> results =
+          localizer->LocalizeQueryDatabase(query_path, *options.database);
+
+      std::ostringstream query_results;
+      query_results.precision(17);
+      for (const auto& query_result : results) {
+        const Localizer::Result& result = query_result.result;
+        query_results << query_result.image_name;
+        if (query_result.success) {
+          num_localized += 1;
+          query_results << " " << result.qvec(0) << " " << result.qvec(1)
+                        << " " << result.qvec(2) << " " << result.qvec(3)
+                        << " " << result.tvec(0) << " " << result.tvec(1)
+                        << " " << result.tvec(2);
+        } else {
+          query_results << " FAILED";
+        }
+        query_results << " " << result.num_matches << " "
+                      << result.num_inliers << std::endl;
+
+        latencies.push_back(query_result.seconds);
+        busy_seconds += query_result.seconds;
+
+        if (report_interval > 0 &&
+            latencies.size() % static_cast<size_t>(report_interval) == 0) {
+          PrintLocalizerStatistics(latencies, num_localized, busy_seconds);
+        }
+      }
+
+      // Write the results under a temporary name first, so that clients never
+      // read partial results.
+      const std::string result_path =
+          query_path.substr(0, query_path.size() - 3) + ".txt";
+      {
+        std::ofstream file(result_path + ".tmp", std::ios::trunc);
+        CHECK(file.is_open()) << result_path;
+        file.precision(17);
+        file << query_results.str();
+      }
+      boost::filesystem::rename(result_path + ".tmp", result_path);
+      boost::filesystem::rename(query_path, query_path + ".done");
+    }
+  }
+
+  PrintLocalizerStatistics(latencies, num_localized, busy_seconds);
+
+  return EXIT_SUCCESS;
+}
+
+int RunManifestBuilder(int argc, char** argv) {
+  std::string output_path;
+
+  OptionManager options;
+  options.AddImageOptions();
+  options.AddRequiredOption("output_path", &output_path);
+  options.Parse(argc, argv);
+
+  PrintHeading1("Building image manifest");
+
+  Timer timer;
+  timer.Start();
+
+  const std::string image_path =
+      EnsureTrailingSlash(StringReplace(*options.image_path, "\\", "/"));
+
+  std::unordered_map<std::string, ImageMetadata> manifest;
+  size_t num_gravity = 0;
+  size_t num_cameras = 0;
+  for (const auto& file_path : GetRecursiveFileList(image_path)) {
+    if (!Bitmap::IsImageFileType(file_path)) {
+      continue;
+    }
+
+    const std::string image_name =
+        StringReplace(file_path, "\\", "/").substr(image_path.size());
+    const ImageMetadata metadata = ReadImageMetadataFiles(file_path);
+    if (metadata.has_gravity) {
+      num_gravity += 1;
+    }
+    if (metadata.has_camera) {
+      num_cameras += 1;
+    }
+    manifest.emplace(image_name, metadata);
+  }
+
+  WriteImageManifest(output_path, manifest);
+
+  std::cout << StringPrintf("Images: %d, with gravity: %d, with camera: %d",
+                            static_cast<int>(manifest.size()),
+                            static_cast<int>(num_gravity),
+                            static_cast<int>(num_cameras))
+            << std::endl;
+
+  timer.PrintMinutes();
+
+  return EXIT_SUCCESS;
+}
+
 int RunMapper(int argc, char** argv) {
   std::string input_path;
   std::string output_path;
@@ -398,9 +706,9 @@ int RunMapper(int argc, char** argv) {
     reconstruction_manager.Read(input_path);
   }
 
-  IncrementalMapperController mapper(options.mapper.get(), *options.image_path,
-                                     *options.database_path,
-                                     &reconstruction_manager);
+  IncrementalMapperController mapper(
+      options.mapper.get(), *options.image_path, *options.database_path,
+      &reconstruction_manager, *options.database);
 
   // In case a new reconstruction is started, write results of individual sub-
   // models to as their reconstruction finishes instead of writing all results
@@ -437,6 +745,52 @@ int RunMapper(int argc, char** argv) {
   return EXIT_SUCCESS;
 }
 
+int RunHierarchicalMapper(int argc, char** argv) {
+  HierarchicalMapperController::Options hierarchical_options;
+  SceneClustering::Options clustering_options;
+  std::string output_path;
+
+  OptionManager options;
+  options.AddDatabaseOptions();
+  options.AddImageOptions();
+  options.AddRequiredOption("output_path", &output_path);
+  options.AddDefaultOption("num_workers", &hierarchical_options.num_workers);
+  options.AddDefaultOption("init_num_trials",
+                           &hierarchical_options.init_num_trials);
+  options.AddDefaultOption("merge_min_num_common_images",
+                           &hierarchical_options.merge_min_num_common_images);
+  options.AddDefaultOption("merge_max_reproj_error",
+                           &hierarchical_options.merge_max_reproj_error);
+  options.AddDefaultOption("branching", &clustering_options.branching);
+  options.AddDefaultOption("image_overlap", &clustering_options.image_overlap);
+  options.AddDefaultOption("leaf_max_num_images",
+                           &clustering_options.leaf_max_num_images);
+  options.AddMapperOptions();
+  options.Parse(argc, argv);
+
+  if (!ExistsDir(output_path)) {
+    std::cerr << "ERROR: `output_path` is not a directory." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  hierarchical_options.database_path = *options.database_path;
+  hierarchical_options.database_options = *options.database;
+  hierarchical_options.image_path = *options.image_path;
+
+  ReconstructionManager reconstruction_manager;
+
+  HierarchicalMapperController hierarchical_mapper(
+      hierarchical_options, clustering_options, *options.mapper,
+      &reconstruction_manager);
+
+  hierarchical_mapper.Start();
+  hierarchical_mapper.Wait();
+
+  reconstruction_manager.Write(output_path, &options);
+
+  return EXIT_SUCCESS;
+}
+
 int RunSequentialMatcher(int argc, char** argv) {
   OptionManager options;
   options.AddDatabaseOptions();
@@ -448,9 +802,9 @@ int RunSequentialMatcher(int argc, char** argv) {
     app.reset(new QApplication(argc, argv));
   }
 
-  SequentialFeatureMatcher feature_matcher(*options.sequential_matching,
-                                           *options.sift_matching,
-                                           *options.database_path);
+  SequentialFeatureMatcher feature_matcher(
+      *options.sequential_matching, *options.sift_matching,
+      *options.database_path, *options.database);
 
   if (options.sift_matching->use_gpu && kUseOpenGL) {
     RunThreadWithOpenGLContext(&feature_matcher);
@@ -509,12 +863,11 @@ int ShowHelp(
 
 int LineInitializer(int argc, char** argv) {
 
-  std::string database_path;
   std::string gravity_path;
   std::string model_output_path;
   IncrementalMapper::Options incremental_mapper_options;
   OptionManager options(false);
-  options.AddRequiredOption("database_path", &database_path);
+  options.AddDatabaseOptions();
   options.AddRequiredOption("gravity_path", &gravity_path);
   options.AddRequiredOption("model_output_path", &model_output_path);
   options.AddDefaultOption("max_reprojection_error", &incremental_mapper_options.init_max_error);
@@ -522,6 +875,8 @@ int LineInitializer(int argc, char** argv) {
   options.AddDefaultOption("min_num_inliers", &incremental_mapper_options.init_min_num_inliers);
   options.Parse(argc, argv);
 
+  const std::string& database_path = *options.database_path;
+
   // Read the gravity.txt file
   EIGEN_STL_UMAP(std::string, Eigen::Vector3d) gravity;
   {
@@ -549,7 +904,7 @@ int LineInitializer(int argc, char** argv) {
   // errors.
   CHECK(ExistsFile(database_path)) << "Database " << database_path << " does not exist.";
 
-  Database database(database_path, true);
+  Database database(database_path, true, *options.database);
 
   EIGEN_STL_UMAP(image_t, Image) images;
   {
@@ -562,18 +917,25 @@ int LineInitializer(int argc, char** argv) {
 
   CHECK_GT(images.size(), 0);
 
-  for (auto& image : images) {
-    image.second.SetLines(database.ReadFeatureLines(image.first));
+  {
+    const std::unordered_map<image_t, FeatureLines> all_lines =
+        database.ReadAllFeatureLines();
+    for (auto& image : images) {
+      const auto lines_it = all_lines.find(image.first);
+      if (lines_it != all_lines.end()) {
+        image.second.SetLines(lines_it->second);
+      }
+    }
   }
 
   std::unordered_map<image_t, std::unordered_set<int>> aligned_lines;
 
   // Find aligned features
   for (const auto& image : images) {
-    const FeatureLines& image_lines = image.second.Lines();
-    const int num_lines = image_lines.size();
+    const FeatureLineArray& image_lines = image.second.Lines();
+    const int num_lines = image_lines.Size();
     for (int i = 0; i < num_lines; ++i) {
-      if (image_lines.at(i).IsAligned()) {
+      if (image_lines.IsAligned(i)) {
         aligned_lines[image.first].emplace(i);
       }
     }
@@ -716,17 +1078,17 @@ int LineInitializer(int argc, char** argv) {
 
     // Search for correspondences for all features, aligned and unaligned.
     // Wen can split the tracks later
-    const int num_features = image.Lines().size();
+    const int num_features = image.NumLines();
     for (int line_idx = 0; line_idx < num_features; ++line_idx) {
 
-      const bool aligned_feature = image.Line(line_idx).IsAligned();
+      const bool aligned_feature = image.Lines().IsAligned(line_idx);
       const auto& corrs = corr_graph.FindCorrespondences(image_id, line_idx);
 
       // Only consider correspondences with the same alignment (either
       // gravity-aligned or random) as the reference.
       std::vector<CorrespondenceGraph::Correspondence> alignment_corrs;
       for (const auto& corr : corrs) {
-        if (images.at(corr.image_id).Line(corr.line_idx).IsAligned() ==
+        if (images.at(corr.image_id).Lines().IsAligned(corr.line_idx) ==
             aligned_feature) {
           alignment_corrs.emplace_back(corr);
         }
@@ -864,7 +1226,7 @@ int LineInitializer(int argc, char** argv) {
         const int line_idx = track.at(i);
         lines.at(image_idx_map.at(image_id))
             .emplace_back(images.at(image_id).Line(line_idx));
-        CHECK(images.at(image_id).Line(line_idx).IsAligned());
+        CHECK(images.at(image_id).Lines().IsAligned(line_idx));
       }
     }
 
@@ -876,7 +1238,7 @@ int LineInitializer(int argc, char** argv) {
         const int line_idx = track.at(i);
         lines.at(image_idx_map.at(image_id))
             .emplace_back(images.at(image_id).Line(line_idx));
-        CHECK(!images.at(image_id).Line(line_idx).IsAligned());
+        CHECK(!images.at(image_id).Lines().IsAligned(line_idx));
       }
     }
 
@@ -966,10 +1328,15 @@ int main(int argc, char** argv) {
   commands.emplace_back("gui", &RunGraphicalUserInterface);
   commands.emplace_back("automatic_reconstructor", &RunAutomaticReconstructor);
   commands.emplace_back("bundle_adjuster", &RunBundleAdjuster);
+  commands.emplace_back("database_cache_export", &RunDatabaseCacheExporter);
   commands.emplace_back("database_creator", &RunDatabaseCreator);
+  commands.emplace_back("database_migrator", &RunDatabaseMigrator);
   commands.emplace_back("exhaustive_matcher", &RunExhaustiveMatcher);
   commands.emplace_back("feature_extractor", &RunFeatureExtractor);
+  commands.emplace_back("hierarchical_mapper", &RunHierarchicalMapper);
   commands.emplace_back("image_filterer", &RunImageFilterer);
+  commands.emplace_back("localizer", &RunLocalizer);
+  commands.emplace_back("manifest_builder", &RunManifestBuilder);
   commands.emplace_back("mapper", &RunMapper);
   commands.emplace_back("project_generator", &RunProjectGenerator);
   commands.emplace_back("sequential_matcher", &RunSequentialMatcher);
@@ -1001,7 +1368,10 @@ int main(int argc, char** argv) {
       int command_argc = argc - 1;
       char** command_argv = &argv[1];
       command_argv[0] = argv[0];
-      return matched_command_func(command_argc, command_argv);
+      const int return_code = matched_command_func(command_argc, command_argv);
+      MemoryTracker::Get().Stop();
+      Tracer::Get().Stop();
+      return return_code;
     }
   }
 
@@ -0,0 +1,452 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+
+#include <Eigen/Geometry>
+
+#include "base/database_cache.h"
+#include "base/pose.h"
+#include "base/synthetic.h"
+#include "controllers/incremental_mapper.h"
+#include "sfm/incremental_mapper.h"
+#include "util/math.h"
+#include "util/memory.h"
+#include "util/misc.h"
+#include "util/option_manager.h"
+#include "util/timer.h"
+
+using namespace colmap;
+
+// Synthesizes a line-SfM dataset, times the individual stages of the
+// incremental reconstruction and the full `IncrementalMapperController` on it,
+// and writes the timings together with the accuracy of the reconstructions
+// with respect to the ground truth to `output_path/benchmark.json`, e.g.:
+//
+//    ppsfm_bench --output_path bench --num_images 200 --num_points3D 20000
+//
+// The database of the synthetic dataset is written to
+// `output_path/database.db`, so that it can be inspected or used with the
+// other commands of ppsfm.
+
+namespace {
+
+// Accumulated wall-clock time of all calls of a stage.
+struct StageTiming {
+  size_t num_calls = 0;
+  double total_seconds = 0.0;
+  double max_seconds = 0.0;
+};
+
+class StageTimer {
+ public:
+  explicit StageTimer(StageTiming* timing) : timing_(timing) {
+    timer_.Start();
+  }
+
+  ~StageTimer() {
+    const double seconds = timer_.ElapsedSeconds();
+    timing_->num_calls += 1;
+    timing_->total_seconds += seconds;
+    timing_->max_seconds = std::max(timing_->max_seconds, seconds);
+  }
+
+ private:
+  Timer timer_;
+  StageTiming* timing_;
+};
+
+struct AccuracyReport {
+  size_t num_reg_images = 0;
+  size_t num_points3D = 0;
+  double mean_track_length = 0.0;
+  double mean_reproj_error = 0.0;
+  // Errors after aligning the reconstruction to the ground truth with a
+  // similarity transform estimated from the projection centers, where the
+  // positions are in units of the distance between consecutive images.
+  double median_position_error = 0.0;
+  double max_position_error = 0.0;
+  double median_rotation_error = 0.0;
+  double max_rotation_error = 0.0;
+  double median_point_error = 0.0;
+};
+
+AccuracyReport EvaluateAccuracy(const Reconstruction& ground_truth,
+                                const Reconstruction& reconstruction) {
+  AccuracyReport report;
+  report.num_reg_images = reconstruction.NumRegImages();
+  report.num_points3D = reconstruction.NumPoints3D();
+  report.mean_track_length = reconstruction.ComputeMeanTrackLength();
+  report.mean_reproj_error = reconstruction.ComputeMeanReprojectionError();
+
+  // The image identifiers are the same, since both refer to the same database.
+  const std::vector<image_t>& reg_image_ids = reconstruction.RegImageIds();
+  if (reg_image_ids.size() < 3) {
+    return report;
+  }
+
+  Eigen::Matrix3Xd src(3, reg_image_ids.size());
+  Eigen::Matrix3Xd dst(3, reg_image_ids.size());
+  for (size_t i = 0; i < reg_image_ids.size(); ++i) {
+    src.col(i) = reconstruction.Image(reg_image_ids[i]).ProjectionCenter();
+    dst.col(i) = ground_truth.Image(reg_image_ids[i]).ProjectionCenter();
+  }
+
+  const Eigen::Matrix4d transform = Eigen::umeyama(src, dst, true);
+  const double scale = transform.block<3, 1>(0, 0).norm();
+  const Eigen::Matrix3d rotation = transform.block<3, 3>(0, 0) / scale;
+
+  std::vector<double> position_errors;
+  std::vector<double> rotation_errors;
+  for (size_t i = 0; i < reg_image_ids.size(); ++i) {
+    position_errors.push_back(
+        ((transform * src.col(i).homogeneous()).head<3>() - dst.col(i))
+            .norm());
+    const Eigen::Matrix3d rotation_error =
+        reconstruction.Image(reg_image_ids[i]).RotationMatrix() *
+        rotation.transpose() *
+        ground_truth.Image(reg_image_ids[i]).RotationMatrix().transpose();
+    rotation_errors.push_back(
+        RadToDeg(Eigen::AngleAxisd(rotation_error).angle()));
+  }
+
+  // Every line in the ground truth images is part of a ground truth point, so
+  // that the first element of a track identifies the corresponding point.
+  std::vector<double> point_errors;
+  for (const auto& point3D : reconstruction.Points3D()) {
+    const TrackElement& track_el = point3D.second.Track().Element(0);
+    const point3D_t ground_truth_point3D_id =
+        ground_truth.Image(track_el.image_id).Line(track_el.line_idx)
+            .Point3DId();
+    if (ground_truth_point3D_id == kInvalidPoint3DId) {
+      continue;
+    }
+    point_errors.push_back(
+        ((transform * point3D.second.XYZ().homogeneous()).head<3>() -
+         ground_truth.Point3D(ground_truth_point3D_id).XYZ())
+            .norm());
+  }
+
+  report.median_position_error = Median(position_errors);
+  report.max_position_error =
+      *std::max_element(position_errors.begin(), position_errors.end());
+  report.median_rotation_error = Median(rotation_errors);
+  report.max_rotation_error =
+      *std::max_element(rotation_errors.begin(), rotation_errors.end());
+  if (!point_errors.empty()) {
+    report.median_point_error = Median(point_errors);
+  }
+
+  return report;
+}
+
+// Run the incremental reconstruction stage by stage as the
+// `IncrementalMapperController` does for its first trial, but without the
+// iterative refinements and the relaxation of the initialization constraints,
+// and time every stage.
+void ReconstructStepwise(const IncrementalMapperOptions& options,
+                         const std::string& database_path,
+                         std::map<std::string, StageTiming>* timings,
+                         Reconstruction* reconstruction) {
+  DatabaseCache database_cache;
+  DatabaseCache aligned_db_cache;
+  {
+    Database database(database_path, true);
+    {
+      StageTimer timer(&(*timings)["database_cache_load"]);
+      database_cache.Load(database,
+                          static_cast<size_t>(options.min_num_matches),
+                          options.ignore_watermarks, options.image_names);
+    }
+    {
+      // Same as in the `IncrementalMapperController`.
+      const size_t kAlignedMinNumMatches = 4;
+      StageTimer timer(&(*timings)["aligned_database_cache_load"]);
+      aligned_db_cache.Load(database, kAlignedMinNumMatches, false,
+                            database_cache.FindImageNamesWithAlignedLines());
+    }
+  }
+
+  IncrementalMapper mapper(&database_cache);
+  mapper.BeginReconstruction(reconstruction);
+
+  bool init_success;
+  {
+    StageTimer timer(&(*timings)["initialization"]);
+    init_success =
+        mapper.RegisterInitialLineImages(options.Mapper(), aligned_db_cache);
+  }
+
+  if (!init_success) {
+    std::cerr << "WARNING: Initialization failed." << std::endl;
+    mapper.EndReconstruction(false);
+    return;
+  }
+
+  const auto AdjustGlobalBundle = [&]() {
+    StageTimer timer(&(*timings)["global_ba"]);
+    mapper.AdjustGlobalBundle(options.Mapper(),
+                              options.GlobalBundleAdjustment());
+    mapper.FilterPoints(options.Mapper());
+    mapper.FilterImages(options.Mapper());
+  };
+
+  AdjustGlobalBundle();
+
+  size_t ba_prev_num_reg_images = reconstruction->NumRegImages();
+  size_t ba_prev_num_points = reconstruction->NumPoints3D();
+
+  bool reg_next_success = true;
+  while (reg_next_success) {
+    reg_next_success = false;
+    for (const image_t next_image_id :
+         mapper.FindNextImages(options.Mapper())) {
+      {
+        StageTimer timer(&(*timings)["registration"]);
+        reg_next_success =
+            mapper.RegisterNextImage(options.Mapper(), next_image_id);
+      }
+
+      if (!reg_next_success) {
+        continue;
+      }
+
+      {
+        StageTimer timer(&(*timings)["triangulation"]);
+        mapper.TriangulateImage(options.Triangulation(), next_image_id);
+      }
+
+      {
+        StageTimer timer(&(*timings)["local_ba"]);
+        mapper.AdjustLocalBundle(options.Mapper(),
+                                 options.LocalBundleAdjustment(),
+                                 options.Triangulation(), next_image_id,
+                                 mapper.GetModifiedPoints3D());
+        mapper.ClearModifiedPoints3D();
+      }
+
+      if (reconstruction->NumRegImages() >=
+              options.ba_global_images_ratio * ba_prev_num_reg_images ||
+          reconstruction->NumPoints3D() >=
+              options.ba_global_points_ratio * ba_prev_num_points) {
+        AdjustGlobalBundle();
+        ba_prev_num_reg_images = reconstruction->NumRegImages();
+        ba_prev_num_points = reconstruction->NumPoints3D();
+      }
+
+      break;
+    }
+  }
+
+  AdjustGlobalBundle();
+
+  mapper.EndReconstruction(false);
+}
+
+void WriteTiming(std::ofstream& file, const std::string& name,
+                 const StageTiming& timing) {
+  file << "    \"" << name << "\": {\"num_calls\": " << timing.num_calls
+       << ", \"total_seconds\": " << timing.total_seconds
+       << ", \"mean_seconds\": "
+       << (timing.num_calls > 0 ? timing.total_seconds / timing.num_calls : 0)
+       << ", \"max_seconds\": " << timing.max_seconds << "}";
+}
+
+void WriteAccuracy(std::ofstream& file, const std::string& name,
+                   const AccuracyReport& report) {
+  file << "    \"" << name << "\": {"
+       << "\"num_reg_images\": " << report.num_reg_images
+       << ", \"num_points3D\": " << report.num_points3D
+       << ", \"mean_track_length\": " << report.mean_track_length
+       << ", \"mean_reproj_error\": " << report.mean_reproj_error
+       << ", \"median_position_error\": " << report.median_position_error
+       << ", \"max_position_error\": " << report.max_position_error
+       << ", \"median_rotation_error\": " << report.median_rotation_error
+       << ", \"max_rotation_error\": " << report.max_rotation_error
+       << ", \"median_point_error\": " << report.median_point_error << "}";
+}
+
+void WriteBenchmark(const std::string& path,
+                    const SyntheticDatasetOptions& synthetic_options,
+                    const Reconstruction& ground_truth,
+                    const std::map<std::string, StageTiming>& timings,
+                    const std::map<std::string, AccuracyReport>& accuracies) {
+  std::ofstream file(path, std::ios::trunc);
+  CHECK(file.is_open()) << path;
+
+  file << std::setprecision(9);
+
+  file << "{\n  \"dataset\": {"
+       << "\"num_images\": " << synthetic_options.num_images
+       << ", \"num_points3D\": " << ground_truth.NumPoints3D()
+       << ", \"num_observations\": " << ground_truth.ComputeNumObservations()
+       << ", \"aligned_line_ratio\": " << synthetic_options.aligned_line_ratio
+       << ", \"point2D_stddev\": " << synthetic_options.point2D_stddev
+       << ", \"gravity_stddev\": " << synthetic_options.gravity_stddev
+       << ", \"outlier_match_ratio\": "
+       << synthetic_options.outlier_match_ratio
+       << ", \"seed\": " << synthetic_options.seed << "},\n";
+
+  file << "  \"timings\": {\n";
+  for (auto it = timings.begin(); it != timings.end(); ++it) {
+    WriteTiming(file, it->first, it->second);
+    file << (std::next(it) == timings.end() ? "\n" : ",\n");
+  }
+  file << "  },\n";
+
+  file << "  \"accuracy\": {\n";
+  for (auto it = accuracies.begin(); it != accuracies.end(); ++it) {
+    WriteAccuracy(file, it->first, it->second);
+    file << (std::next(it) == accuracies.end() ? "\n" : ",\n");
+  }
+  file << "  },\n";
+
+  file << "  \"peak_rss\": " << GetPeakRSS() << "\n}\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  InitializeGlog(argv);
+
+  std::string output_path;
+  SyntheticDatasetOptions synthetic_options;
+
+  OptionManager options(false);
+  options.AddRequiredOption("output_path", &output_path);
+  options.AddDefaultOption("num_images", &synthetic_options.num_images);
+  options.AddDefaultOption("num_points3D", &synthetic_options.num_points3D);
+  options.AddDefaultOption("aligned_line_ratio",
+                           &synthetic_options.aligned_line_ratio);
+  options.AddDefaultOption("point2D_stddev",
+                           &synthetic_options.point2D_stddev);
+  options.AddDefaultOption("gravity_stddev",
+                           &synthetic_options.gravity_stddev);
+  options.AddDefaultOption("outlier_match_ratio",
+                           &synthetic_options.outlier_match_ratio);
+  options.AddDefaultOption("seed", &synthetic_options.seed);
+  options.AddMapperOptions();
+  options.Parse(argc, argv);
+
+  if (!ExistsDir(output_path)) {
+    std::cerr << "ERROR: `output_path` is not a directory." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::string database_path = JoinPaths(output_path, "database.db");
+  if (ExistsFile(database_path)) {
+    boost::filesystem::remove(database_path);
+  }
+
+  std::map<std::string, StageTiming> timings;
+  std::map<std::string, AccuracyReport> accuracies;
+
+  PrintHeading1("Synthesizing dataset");
+
+  Reconstruction ground_truth;
+  {
+    StageTimer timer(&timings["synthesis"]);
+    Database database(database_path, true);
+    SynthesizeDataset(synthetic_options, &database, &ground_truth);
+  }
+
+  std::cout << StringPrintf("  => Images: %d", ground_truth.NumImages())
+            << std::endl;
+  std::cout << StringPrintf("  => Points: %d", ground_truth.NumPoints3D())
+            << std::endl;
+  std::cout << StringPrintf("  => Observations: %d",
+                            ground_truth.ComputeNumObservations())
+            << std::endl;
+
+  PrintHeading1("Stepwise reconstruction");
+
+  {
+    Reconstruction reconstruction;
+    ReconstructStepwise(*options.mapper, database_path, &timings,
+                        &reconstruction);
+    accuracies["stepwise"] = EvaluateAccuracy(ground_truth, reconstruction);
+  }
+
+  PrintHeading1("Incremental mapper controller");
+
+  {
+    ReconstructionManager reconstruction_manager;
+    {
+      StageTimer timer(&timings["incremental_mapper_controller"]);
+      IncrementalMapperController mapper(options.mapper.get(), "",
+                                         database_path,
+                                         &reconstruction_manager);
+      mapper.Start();
+      mapper.Wait();
+    }
+
+    // Evaluate the largest reconstruction.
+    size_t largest_idx = 0;
+    for (size_t i = 1; i < reconstruction_manager.Size(); ++i) {
+      if (reconstruction_manager.Get(i).NumRegImages() >
+          reconstruction_manager.Get(largest_idx).NumRegImages()) {
+        largest_idx = i;
+      }
+    }
+    if (reconstruction_manager.Size() > 0) {
+      accuracies["controller"] = EvaluateAccuracy(
+          ground_truth, reconstruction_manager.Get(largest_idx));
+    } else {
+      accuracies["controller"] = AccuracyReport();
+    }
+  }
+
+  const std::string benchmark_path = JoinPaths(output_path, "benchmark.json");
+  WriteBenchmark(benchmark_path, synthetic_options, ground_truth, timings,
+                 accuracies);
+
+  PrintHeading1("Benchmark");
+  for (const auto& timing : timings) {
+    std::cout << StringPrintf("  %-30s %8d calls %12.3fs", timing.first.c_str(),
+                              timing.second.num_calls,
+                              timing.second.total_seconds)
+              << std::endl;
+  }
+  for (const auto& accuracy : accuracies) {
+    std::cout << StringPrintf(
+                     "  %-30s %6d images, position error %.4f, rotation "
+                     "error %.4f deg",
+                     accuracy.first.c_str(), accuracy.second.num_reg_images,
+                     accuracy.second.median_position_error,
+                     accuracy.second.median_rotation_error)
+              << std::endl;
+  }
+  std::cout << std::endl << "Results written to " << benchmark_path
+            << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,195 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+#include <Eigen/Geometry>
+
+#include "base/triangulation.h"
+#include "util/misc.h"
+#include "util/option_manager.h"
+#include "util/random.h"
+#include "util/timer.h"
+
+using namespace colmap;
+
+// Compares the SVD and the normal equation paths of the multi-view line
+// triangulation in terms of run-time and accuracy on random problems, e.g.:
+//
+//    triangulation_bench --num_problems 100000 --noise_stddev 0.001
+
+namespace {
+
+struct Problem {
+  std::vector<Eigen::Matrix3x4d> proj_matrices;
+  std::vector<Eigen::Vector3d> lines;
+  Eigen::Vector3d xyz;
+  double depth;
+};
+
+// Observes a random point in front of cameras distributed along a street with
+// random lines through its noisy projections in normalized coordinates. The
+// scene is shifted by the offset, e.g. to mimic georeferenced coordinates.
+Problem CreateProblem(const int num_views, const double noise_stddev,
+                      const Eigen::Vector3d& offset) {
+  Problem problem;
+  problem.depth = RandomReal(5.0, 50.0);
+  problem.xyz =
+      offset + Eigen::Vector3d(RandomReal(-5.0, 5.0), RandomReal(-2.0, 2.0),
+                               problem.depth);
+
+  problem.proj_matrices.reserve(num_views);
+  problem.lines.reserve(num_views);
+  for (int i = 0; i < num_views; ++i) {
+    const Eigen::Matrix3d R =
+        (Eigen::AngleAxisd(RandomReal(-0.2, 0.2), Eigen::Vector3d::UnitX()) *
+         Eigen::AngleAxisd(RandomReal(-0.2, 0.2), Eigen::Vector3d::UnitY()))
+            .toRotationMatrix();
+    const Eigen::Vector3d proj_center =
+        offset +
+        Eigen::Vector3d(RandomReal(-10.0, 10.0), RandomReal(-1.0, 1.0), 0);
+
+    Eigen::Matrix3x4d proj_matrix;
+    proj_matrix.leftCols<3>() = R;
+    proj_matrix.col(3) = -R * proj_center;
+
+    const Eigen::Vector2d point2D =
+        (proj_matrix * problem.xyz.homogeneous()).hnormalized() +
+        Eigen::Vector2d(RandomGaussian(0.0, noise_stddev),
+                        RandomGaussian(0.0, noise_stddev));
+    const double angle = RandomReal(0.0, M_PI);
+    const Eigen::Vector3d direction(std::cos(angle), std::sin(angle), 0);
+    Eigen::Vector3d line = point2D.homogeneous().cross(direction);
+    line /= line.head<2>().norm();
+
+    problem.proj_matrices.push_back(proj_matrix);
+    problem.lines.push_back(line);
+  }
+
+  return problem;
+}
+
+struct Report {
+  double nanoseconds_per_call = 0.0;
+  std::vector<double> errors;
+};
+
+template <typename Func>
+Report Evaluate(const std::vector<Problem>& problems, Func triangulate) {
+  Report report;
+  report.errors.reserve(problems.size());
+
+  std::vector<Eigen::Vector3d> points3D(problems.size());
+  Timer timer;
+  timer.Start();
+  for (size_t i = 0; i < problems.size(); ++i) {
+    points3D[i] =
+        triangulate(problems[i].proj_matrices, problems[i].lines);
+  }
+  report.nanoseconds_per_call =
+      1e9 * timer.ElapsedSeconds() / std::max<size_t>(problems.size(), 1);
+
+  // Relative error with respect to the depth of the point.
+  for (size_t i = 0; i < problems.size(); ++i) {
+    report.errors.push_back((points3D[i] - problems[i].xyz).norm() /
+                            problems[i].depth);
+  }
+
+  std::sort(report.errors.begin(), report.errors.end());
+
+  return report;
+}
+
+double Quantile(const std::vector<double>& sorted_values, const double q) {
+  if (sorted_values.empty()) {
+    return 0.0;
+  }
+  return sorted_values[static_cast<size_t>(q * (sorted_values.size() - 1))];
+}
+
+void PrintReport(const std::string& name, const Report& report) {
+  std::cout << "  " << std::left << std::setw(8) << name << std::right
+            << std::setw(12) << std::fixed << std::setprecision(1)
+            << report.nanoseconds_per_call << std::scientific
+            << std::setprecision(3) << std::setw(14)
+            << Quantile(report.errors, 0.5) << std::setw(14)
+            << Quantile(report.errors, 0.99) << std::setw(14)
+            << Quantile(report.errors, 1.0) << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  InitializeGlog(argv);
+
+  int num_problems = 100000;
+  double noise_stddev = 1e-3;
+  double large_offset = 1e6;
+  int seed = 0;
+
+  OptionManager options(false);
+  options.AddDefaultOption("num_problems", &num_problems);
+  options.AddDefaultOption("noise_stddev", &noise_stddev);
+  options.AddDefaultOption("large_offset", &large_offset);
+  options.AddDefaultOption("seed", &seed);
+  options.Parse(argc, argv);
+
+  SetPRNGSeed(static_cast<unsigned>(seed));
+
+  for (const int num_views : {3, 5, 10, 50}) {
+    PrintHeading1(StringPrintf("Triangulation from %d views", num_views));
+
+    // The normal matrix squares the condition of the system, so large scene
+    // coordinates are the critical case for the accuracy of the normal path.
+    for (const double offset : {0.0, large_offset}) {
+      for (const double stddev : {0.0, noise_stddev}) {
+        std::vector<Problem> problems;
+        problems.reserve(num_problems);
+        for (int i = 0; i < num_problems; ++i) {
+          problems.push_back(CreateProblem(num_views, stddev,
+                                           Eigen::Vector3d::Constant(offset)));
+        }
+
+        std::cout << StringPrintf("Offset %.1e, noise %.1e", offset, stddev)
+                  << std::endl;
+        std::cout << "  " << std::left << std::setw(8) << "Method"
+                  << std::right << std::setw(12) << "ns/call" << std::setw(14)
+                  << "Median" << std::setw(14) << "99%" << std::setw(14)
+                  << "Max" << std::endl;
+        PrintReport("SVD", Evaluate(problems, TriangulateMultiViewPoint));
+        PrintReport("Normal",
+                    Evaluate(problems, TriangulateMultiViewPointNormal));
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
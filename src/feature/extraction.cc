@@ -33,14 +33,16 @@
 
 #include "feature/extraction.h"
 
+#include <cmath>
 #include <numeric>
-#include <set>
 
 #include "SiftGPU/SiftGPU.h"
 #include "feature/sift.h"
 #include "util/cuda.h"
+#include "util/memory.h"
 #include "util/misc.h"
 #include "util/random.h"
+#include "util/trace.h"
 #include "utils.h"
 
 namespace colmap {
@@ -84,15 +86,27 @@ void MaskKeypoints(const Bitmap& mask, FeatureKeypoints* keypoints,
   descriptors->conservativeResize(out_index, descriptors->cols());
 }
 
+// The images are only needed up to the maximum extraction size, which allows
+// the reader to decode them at a reduced resolution.
+ImageReaderOptions ExtractionImageReaderOptions(
+    const ImageReaderOptions& reader_options,
+    const SiftExtractionOptions& sift_options) {
+  ImageReaderOptions options = reader_options;
+  options.max_image_size = sift_options.max_image_size;
+  return options;
+}
+
 }  // namespace
 
 SiftFeatureExtractor::SiftFeatureExtractor(
     const ImageReaderOptions& reader_options,
-    const SiftExtractionOptions& sift_options)
+    const SiftExtractionOptions& sift_options,
+    const DatabaseOptions& database_options)
     : reader_options_(reader_options),
       sift_options_(sift_options),
-      database_(reader_options_.database_path, true),
-      image_reader_(reader_options_, &database_) {
+      database_(reader_options_.database_path, true, database_options),
+      image_reader_(ExtractionImageReaderOptions(reader_options_, sift_options_),
+                    &database_) {
   CHECK(reader_options_.Check());
   CHECK(sift_options_.Check());
 
@@ -113,10 +127,16 @@ SiftFeatureExtractor::SiftFeatureExtractor(
 
   // Make sure that we only have limited number of objects in the queue to avoid
   // excess in memory usage since images and features take lots of memory.
+  // The bitmaps are released after extraction, so the later stages can buffer
+  // more images to decouple the extractors from the database writes.
   const int kQueueSize = 1;
+  const int kNumImagesPerTransaction = 32;
   resizer_queue_.reset(new JobQueue<internal::ImageData>(kQueueSize));
   extractor_queue_.reset(new JobQueue<internal::ImageData>(kQueueSize));
-  writer_queue_.reset(new JobQueue<internal::ImageData>(kQueueSize));
+  lifter_queue_.reset(
+      new JobQueue<internal::ImageData>(kNumImagesPerTransaction));
+  writer_queue_.reset(
+      new JobQueue<internal::ImageData>(kNumImagesPerTransaction));
 
   if (sift_options_.max_image_size > 0) {
     for (int i = 0; i < num_threads; ++i) {
@@ -145,7 +165,7 @@ SiftFeatureExtractor::SiftFeatureExtractor(
       sift_gpu_options.gpu_index = std::to_string(gpu_index);
       extractors_.emplace_back(new internal::SiftFeatureExtractorThread(
           sift_gpu_options, camera_mask, extractor_queue_.get(),
-          writer_queue_.get()));
+          lifter_queue_.get()));
     }
   } else {
     auto custom_sift_options = sift_options_;
@@ -153,16 +173,26 @@ SiftFeatureExtractor::SiftFeatureExtractor(
     for (int i = 0; i < num_threads; ++i) {
       extractors_.emplace_back(new internal::SiftFeatureExtractorThread(
           custom_sift_options, camera_mask, extractor_queue_.get(),
-          writer_queue_.get()));
+          lifter_queue_.get()));
     }
   }
 
-  // TODO Make aligned line ratio a parameter
+  image_ids_with_lines_ = database_.ExistingLineFeatureImageIds();
+
+  for (int i = 0; i < num_threads; ++i) {
+    lifters_.emplace_back(new internal::LineLifterThread(
+        sift_options_.aligned_line_ratio,
+        static_cast<unsigned>(sift_options_.line_seed),
+        &image_ids_with_lines_, lifter_queue_.get(), writer_queue_.get()));
+  }
+
   writer_.reset(new internal::LineFeatureWriterThread(
-      0.5, image_reader_.NumImages(), &database_, writer_queue_.get()));
+      image_reader_.NumImages(), kNumImagesPerTransaction, &database_,
+      writer_queue_.get()));
 }
 
 void SiftFeatureExtractor::Run() {
+  TRACE_SCOPE("FeatureExtraction");
   PrintHeading1("Feature extraction");
 
   for (auto& resizer : resizers_) {
@@ -173,6 +203,10 @@ void SiftFeatureExtractor::Run() {
     extractor->Start();
   }
 
+  for (auto& lifter : lifters_) {
+    lifter->Start();
+  }
+
   writer_->Start();
 
   for (auto& extractor : extractors_) {
@@ -191,18 +225,21 @@ void SiftFeatureExtractor::Run() {
     }
 
     internal::ImageData image_data;
-    image_data.status =
-        image_reader_.Next(&image_data.camera, &image_data.image,
-                           &image_data.bitmap, &image_data.mask);
+    {
+      TRACE_SCOPE("ReadImage");
+      image_data.status =
+          image_reader_.Next(&image_data.camera, &image_data.image,
+                             &image_data.bitmap, &image_data.mask);
+    }
 
     if (image_data.status != ImageReader::Status::SUCCESS) {
       image_data.bitmap.Deallocate();
     }
 
     if (sift_options_.max_image_size > 0) {
-      CHECK(resizer_queue_->Push(image_data));
+      CHECK(resizer_queue_->Push(std::move(image_data)));
     } else {
-      CHECK(extractor_queue_->Push(image_data));
+      CHECK(extractor_queue_->Push(std::move(image_data)));
     }
   }
 
@@ -218,10 +255,18 @@ void SiftFeatureExtractor::Run() {
     extractor->Wait();
   }
 
+  lifter_queue_->Wait();
+  lifter_queue_->Stop();
+  for (auto& lifter : lifters_) {
+    lifter->Wait();
+  }
+
   writer_queue_->Wait();
   writer_queue_->Stop();
   writer_->Wait();
 
+  MemoryTracker::Get().AddSample("FeatureExtraction");
+
   GetTimer().PrintMinutes();
 }
 
@@ -240,11 +285,12 @@ void ImageResizerThread::Run() {
       break;
     }
 
-    const auto input_job = input_queue_->Pop();
+    auto input_job = input_queue_->Pop();
     if (input_job.IsValid()) {
-      auto image_data = input_job.Data();
+      auto& image_data = input_job.Data();
 
       if (image_data.status == ImageReader::Status::SUCCESS) {
+        TRACE_SCOPE("ResizeImage");
         if (static_cast<int>(image_data.bitmap.Width()) > max_image_size_ ||
             static_cast<int>(image_data.bitmap.Height()) > max_image_size_) {
           // Fit the down-sampled version exactly into the max dimensions.
@@ -260,7 +306,7 @@ void ImageResizerThread::Run() {
         }
       }
 
-      output_queue_->Push(image_data);
+      output_queue_->Push(std::move(image_data));
     } else {
       break;
     }
@@ -307,11 +353,12 @@ void SiftFeatureExtractorThread::Run() {
       break;
     }
 
-    const auto input_job = input_queue_->Pop();
+    auto input_job = input_queue_->Pop();
     if (input_job.IsValid()) {
-      auto image_data = input_job.Data();
+      auto& image_data = input_job.Data();
 
       if (image_data.status == ImageReader::Status::SUCCESS) {
+        TRACE_SCOPE("ExtractSiftFeatures");
         bool success = false;
         if (sift_options_.estimate_affine_shape ||
             sift_options_.domain_size_pooling) {
@@ -345,24 +392,28 @@ void SiftFeatureExtractorThread::Run() {
 
       image_data.bitmap.Deallocate();
 
-      output_queue_->Push(image_data);
+      output_queue_->Push(std::move(image_data));
     } else {
       break;
     }
   }
 }
 
-LineFeatureWriterThread::LineFeatureWriterThread(const double aligned_line_ratio,
-                                                 const size_t num_images,
-                                                 Database* database,
-                                                 JobQueue<ImageData>* input_queue)
-    : aligned_line_ratio_(aligned_line_ratio), num_images_(num_images), database_(database), input_queue_(input_queue) {
-  // TODO: Remove this?
-  SetPRNGSeed(std::chrono::system_clock::now().time_since_epoch().count());
+LineLifterThread::LineLifterThread(
+    const double aligned_line_ratio, const unsigned seed,
+    const std::unordered_set<image_t>* image_ids_with_lines,
+    JobQueue<ImageData>* input_queue, JobQueue<ImageData>* output_queue)
+    : aligned_line_ratio_(aligned_line_ratio),
+      seed_(seed),
+      image_ids_with_lines_(image_ids_with_lines),
+      input_queue_(input_queue),
+      output_queue_(output_queue) {
+  CHECK_GE(aligned_line_ratio_, 0.0);
+  CHECK_LE(aligned_line_ratio_, 1.0);
+  CHECK_NOTNULL(image_ids_with_lines_);
 }
 
-void LineFeatureWriterThread::Run() {
-  size_t image_index = 0;
+void LineLifterThread::Run() {
   while (true) {
     if (IsStopped()) {
       break;
@@ -372,160 +423,260 @@ void LineFeatureWriterThread::Run() {
     if (input_job.IsValid()) {
       auto& image_data = input_job.Data();
 
-      image_index += 1;
-
-      std::cout << StringPrintf("Processed file [%d/%d]", image_index,
-                                num_images_)
-                << std::endl;
-
-      std::cout << StringPrintf("  Name:            %s",
-                                image_data.image.Name().c_str())
-                << std::endl;
-
-      if (image_data.status == ImageReader::Status::IMAGE_EXISTS) {
-        std::cout << "  SKIP: Features for image already extracted."
-                  << std::endl;
-      } else if (image_data.status == ImageReader::Status::BITMAP_ERROR) {
-        std::cout << "  ERROR: Failed to read image file format." << std::endl;
-      } else if (image_data.status ==
-                 ImageReader::Status::CAMERA_SINGLE_DIM_ERROR) {
-        std::cout << "  ERROR: Single camera specified, "
-                     "but images have different dimensions."
-                  << std::endl;
-      } else if (image_data.status ==
-                 ImageReader::Status::CAMERA_EXIST_DIM_ERROR) {
-        std::cout << "  ERROR: Image previously processed, but current image "
-                     "has different dimensions."
-                  << std::endl;
-      } else if (image_data.status == ImageReader::Status::CAMERA_PARAM_ERROR) {
-        std::cout << "  ERROR: Camera has invalid parameters." << std::endl;
-      } else if (image_data.status == ImageReader::Status::FAILURE) {
-        std::cout << "  ERROR: Failed to extract features." << std::endl;
-      }
-
-      if (image_data.status != ImageReader::Status::SUCCESS) {
-        continue;
+      if (image_data.status == ImageReader::Status::SUCCESS &&
+          image_ids_with_lines_->count(image_data.image.ImageId()) == 0) {
+        LiftLines(&image_data);
       }
 
-      std::cout << StringPrintf("  Dimensions:      %d x %d",
-                                image_data.camera.Width(),
-                                image_data.camera.Height())
-                << std::endl;
-      std::cout << StringPrintf("  Camera:          #%d - %s",
-                                image_data.camera.CameraId(),
-                                image_data.camera.ModelName().c_str())
-                << std::endl;
-      std::cout << StringPrintf("  Focal Length:    %.2fpx",
-                                image_data.camera.MeanFocalLength());
-      if (image_data.camera.HasPriorFocalLength()) {
-        std::cout << " (Prior)" << std::endl;
-      } else {
-        std::cout << std::endl;
-      }
-      if (image_data.image.HasTvecPrior()) {
-        std::cout << StringPrintf(
-            "  GPS:             LAT=%.3f, LON=%.3f, ALT=%.3f",
-            image_data.image.TvecPrior(0),
-            image_data.image.TvecPrior(1),
-            image_data.image.TvecPrior(2))
-                  << std::endl;
-      }
-      std::cout << StringPrintf("  Features:        %d",
-                                image_data.keypoints.size())
-                << std::endl;
+      output_queue_->Push(std::move(image_data));
+    } else {
+      break;
+    }
+  }
+}
 
-      if (!database_->ExistsLineFeatures(image_data.image.ImageId())) {
-        // Generate line features
-        Image& image = image_data.image;
+void LineLifterThread::LiftLines(ImageData* image_data) {
+  TRACE_SCOPE("LiftLines");
+  Image& image = image_data->image;
+  const Camera& camera = image_data->camera;
+
+  const std::vector<Eigen::Vector2d> points =
+      FeatureKeypointsToPointsVector(image_data->keypoints);
+
+  const size_t num_features = points.size();
+
+  PhiloxRandomGenerator random_generator(
+      PhiloxRandomGenerator::MakeKey(seed_, image.Name()));
+
+  // Randomly select features to be aligned by partially shuffling the
+  // feature indices.
+  const size_t num_aligned_features = std::min(
+      num_features, static_cast<size_t>(
+                        std::ceil(aligned_line_ratio_ * num_features)));
+  std::vector<uint32_t> feature_idxs(num_features);
+  std::iota(feature_idxs.begin(), feature_idxs.end(), 0);
+  for (size_t i = 0; i < num_aligned_features; ++i) {
+    const uint32_t j =
+        static_cast<uint32_t>(i) +
+        random_generator.UniformInteger(
+            static_cast<uint32_t>(num_features - i - 1));
+    std::swap(feature_idxs[i], feature_idxs[j]);
+  }
+  std::vector<bool> aligned_features(num_features, false);
+  for (size_t i = 0; i < num_aligned_features; ++i) {
+    aligned_features[feature_idxs[i]] = true;
+  }
 
-        const std::vector<Eigen::Vector2d> points =
-            FeatureKeypointsToPointsVector(image_data.keypoints);
+  const Eigen::Vector3d gravity_dir =
+      image.HasGravity() ? image.GravityDirection() : Eigen::Vector3d::Zero();
 
-        const int num_features = points.size();
-        const double num_features_double = static_cast<double>(num_features);
-        const int max_feature_idx = num_features-1;
+  // Cameras without distortion are inverted exactly from any starting
+  // point, so only build the grid for cameras with distortion.
+  if (!camera.ExtraParamsIdxs().empty() &&
+      image_to_world_grids_.count(camera.CameraId()) == 0) {
+    image_to_world_grids_.emplace(camera.CameraId(), ImageToWorldGrid(camera));
+  }
+  const auto grid_it = image_to_world_grids_.find(camera.CameraId());
+  const std::vector<Eigen::Vector2d> normalized_points = camera.ImageToWorld(
+      points,
+      grid_it == image_to_world_grids_.end() ? nullptr : &grid_it->second);
 
-        // Make sure the lines are initialized
-        if (image.NumLines() == 0) {
-          image.SetLines(FeatureLines(num_features));
-        }
+  FeatureLines lines(num_features);
+  for (size_t feature_idx = 0; feature_idx < num_features; ++feature_idx) {
+    const Eigen::Vector3d point = normalized_points[feature_idx].homogeneous();
 
-        // Randomly select features to be aligned
-        std::set<int> aligned_feature_idxs;
-        while (static_cast<double>(aligned_feature_idxs.size())
-               / num_features_double < aligned_line_ratio_) {
-          aligned_feature_idxs.emplace(RandomInteger(0, max_feature_idx));
-        }
+    FeatureLine& feature_line = lines[feature_idx];
 
-        std::cout << "Aligning " << aligned_feature_idxs.size()
-                  << " out of " << num_features << " lines\n";
+    if (image.HasGravity() && aligned_features[feature_idx]) {
+      // Line should be gravity-aligned
+      feature_line =
+          FeatureLine{gravity_dir.cross(point), true, kInvalidPoint3DId};
+    } else {
+      // Assign a random orientation
+      const Eigen::Vector3d random_dir(random_generator.UniformReal(-1.0, 1.0),
+                                       random_generator.UniformReal(-1.0, 1.0),
+                                       random_generator.UniformReal(-1.0, 1.0));
+      feature_line =
+          FeatureLine{random_dir.cross(point), false, kInvalidPoint3DId};
+    }
 
-        // GO over all features and create the respective lines
-        const Camera& camera = database_->ReadCamera(image.CameraId());
+    // Normalizing the first two components to 1 makes the distance
+    // computation during SfM simpler.
+    const double head_norm = feature_line.Line().head<2>().norm();
 
-        const Eigen::Vector3d& gravity_dir =
-            image.HasGravity() ? image.GravityDirection() : Eigen::Vector3d::Zero();
+    feature_line.SetLine(feature_line.Line() / head_norm);
+  }
 
-        if (!image.HasGravity()) {
-          std::cout << "Warning - No gravity available for image "
-                    << image.ImageId() << " (" << image.Name() << "). "
-                    << "Only assigning random line features."
-                    << std::endl;
-        }
+  image.SetLines(lines);
+}
 
-        for (int feature_idx = 0; feature_idx < num_features; ++ feature_idx) {
-          const Eigen::Vector2d point2D = points.at(feature_idx);
-          const Eigen::Vector2d normalized_point2D =
-              camera.ImageToWorld(point2D);
+LineFeatureWriterThread::LineFeatureWriterThread(
+    const size_t num_images, const size_t num_images_per_transaction,
+    Database* database, JobQueue<ImageData>* input_queue)
+    : num_images_(num_images),
+      num_images_per_transaction_(num_images_per_transaction),
+      database_(database),
+      input_queue_(input_queue) {
+  CHECK_GT(num_images_per_transaction_, 0);
+}
 
-          FeatureLine& feature_line = image.Line(feature_idx);
+void LineFeatureWriterThread::Run() {
+  // Determine the existing data once up front instead of querying the
+  // database several times per image.
+  std::unordered_set<image_t> image_ids_with_lines =
+      database_->ExistingLineFeatureImageIds();
+  std::unordered_set<image_t> image_ids_with_descriptors =
+      database_->ExistingDescriptorImageIds();
+  std::unordered_set<image_t> image_ids_with_gravity =
+      database_->ExistingGravityImageIds();
+
+  std::vector<ImageData> batch;
+  batch.reserve(num_images_per_transaction_);
+
+  const auto WriteBatch = [&]() {
+    if (batch.empty()) {
+      return;
+    }
 
-          if (image.HasGravity() && aligned_feature_idxs.count(feature_idx) > 0) {
-            // Line should be gravity-aligned
-            const Eigen::Vector3d line_dir =
-                gravity_dir.cross(normalized_point2D.homogeneous());
+    TRACE_SCOPE("WriteFeatureBatch");
+    DatabaseTransaction database_transaction(database_);
 
-            feature_line = FeatureLine{line_dir, true, kInvalidPoint3DId};
-          } else {
-            // Assign a random orientation
+    for (auto& image_data : batch) {
+      if (image_data.image.ImageId() == kInvalidImageId) {
+        image_data.image.SetImageId(database_->WriteImage(image_data.image));
+      }
 
-            const Eigen::Vector3d random_dir = Eigen::Vector3d::Random();
-            const Eigen::Vector3d line_dir =
-                random_dir.cross(normalized_point2D.homogeneous());
+      if (image_ids_with_descriptors.insert(image_data.image.ImageId())
+              .second) {
+        database_->WriteDescriptors(image_data.image.ImageId(),
+                                    image_data.descriptors);
+      }
 
-            feature_line = FeatureLine{line_dir, false, kInvalidPoint3DId};
-          }
+      if (image_ids_with_lines.insert(image_data.image.ImageId()).second) {
+        database_->WriteFeatureLines(
+            image_data.image.ImageId(),
+            image_data.image.Lines().ToFeatureLines());
+      }
 
-          // Normalizing the first two components to 1 makes the distance
-          // computation during SfM simpler.
-          const double head_norm = image.Line(feature_idx).Line().head<2>().norm();
+      if (image_data.image.HasGravity() &&
+          image_ids_with_gravity.insert(image_data.image.ImageId()).second) {
+        database_->WriteImageGravity(image_data.image.ImageId(),
+                                     image_data.image.GravityDirection());
+      }
+    }
 
-          feature_line.SetLine(feature_line.Line() / head_norm);
-        }
+    MemoryTracker& memory_tracker = MemoryTracker::Get();
+    if (memory_tracker.IsStarted()) {
+      size_t num_batch_bytes = VectorNumBytes(batch);
+      for (const auto& image_data : batch) {
+        num_batch_bytes +=
+            (image_data.image.NumBytes() - sizeof(Image)) +
+            (image_data.bitmap.NumBytes() + image_data.mask.NumBytes()) +
+            VectorNumBytes(image_data.keypoints) +
+            image_data.descriptors.size() * sizeof(FeatureDescriptors::Scalar);
       }
+      memory_tracker.AddSample("WriteFeatureBatch",
+                               {{"FeatureBatch", num_batch_bytes}});
+    }
 
-      DatabaseTransaction database_transaction(database_);
+    batch.clear();
+  };
 
-      if (image_data.image.ImageId() == kInvalidImageId) {
-        image_data.image.SetImageId(database_->WriteImage(image_data.image));
-      }
+  size_t image_index = 0;
+  while (true) {
+    if (IsStopped()) {
+      break;
+    }
 
-      if (!database_->ExistsDescriptors(image_data.image.ImageId())) {
-        database_->WriteDescriptors(image_data.image.ImageId(),
-                                    image_data.descriptors);
-      }
+    auto input_job = input_queue_->Pop();
+    if (input_job.IsValid()) {
+      auto& image_data = input_job.Data();
+
+      image_index += 1;
 
-      if(!database_->ExistsLineFeatures(image_data.image.ImageId())) {
-        database_->WriteFeatureLines(image_data.image.ImageId(), image_data.image.Lines());
+      PrintImageData(image_index, image_data);
+
+      if (image_data.status == ImageReader::Status::SUCCESS) {
+        batch.push_back(std::move(image_data));
       }
 
-      if (image_data.image.HasGravity() && !database_->ExistsImageGravity(image_data.image.ImageId())) {
-        database_->WriteImageGravity(image_data.image.ImageId(), image_data.image.GravityDirection());
+      // Commit once the batch is full or no further images are pending, so
+      // that no images are held back while waiting for the next one.
+      if (batch.size() >= num_images_per_transaction_ ||
+          input_queue_->Size() == 0) {
+        WriteBatch();
       }
     } else {
       break;
     }
   }
+
+  WriteBatch();
+}
+
+void LineFeatureWriterThread::PrintImageData(
+    const size_t image_index, const ImageData& image_data) const {
+  std::cout << StringPrintf("Processed file [%d/%d]", image_index, num_images_)
+            << std::endl;
+
+  std::cout << StringPrintf("  Name:            %s",
+                            image_data.image.Name().c_str())
+            << std::endl;
+
+  if (image_data.status == ImageReader::Status::IMAGE_EXISTS) {
+    std::cout << "  SKIP: Features for image already extracted." << std::endl;
+  } else if (image_data.status == ImageReader::Status::BITMAP_ERROR) {
+    std::cout << "  ERROR: Failed to read image file format." << std::endl;
+  } else if (image_data.status ==
+             ImageReader::Status::CAMERA_SINGLE_DIM_ERROR) {
+    std::cout << "  ERROR: Single camera specified, "
+                 "but images have different dimensions."
+              << std::endl;
+  } else if (image_data.status ==
+             ImageReader::Status::CAMERA_EXIST_DIM_ERROR) {
+    std::cout << "  ERROR: Image previously processed, but current image "
+                 "has different dimensions."
+              << std::endl;
+  } else if (image_data.status == ImageReader::Status::CAMERA_PARAM_ERROR) {
+    std::cout << "  ERROR: Camera has invalid parameters." << std::endl;
+  } else if (image_data.status == ImageReader::Status::FAILURE) {
+    std::cout << "  ERROR: Failed to extract features." << std::endl;
+  }
+
+  if (image_data.status != ImageReader::Status::SUCCESS) {
+    return;
+  }
+
+  std::cout << StringPrintf("  Dimensions:      %d x %d",
+                            image_data.camera.Width(),
+                            image_data.camera.Height())
+            << std::endl;
+  std::cout << StringPrintf("  Camera:          #%d - %s",
+                            image_data.camera.CameraId(),
+                            image_data.camera.ModelName().c_str())
+            << std::endl;
+  std::cout << StringPrintf("  Focal Length:    %.2fpx",
+                            image_data.camera.MeanFocalLength());
+  if (image_data.camera.HasPriorFocalLength()) {
+    std::cout << " (Prior)" << std::endl;
+  } else {
+    std::cout << std::endl;
+  }
+  if (image_data.image.HasTvecPrior()) {
+    std::cout << StringPrintf("  GPS:             LAT=%.3f, LON=%.3f, ALT=%.3f",
+                              image_data.image.TvecPrior(0),
+                              image_data.image.TvecPrior(1),
+                              image_data.image.TvecPrior(2))
+              << std::endl;
+  }
+  std::cout << StringPrintf("  Features:        %d",
+                            image_data.keypoints.size())
+            << std::endl;
+  if (!image_data.image.HasGravity()) {
+    std::cout << "  Warning - No gravity available. "
+                 "Only assigning random line features."
+              << std::endl;
+  }
 }
 
 }  // namespace internal
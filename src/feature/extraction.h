@@ -34,6 +34,9 @@
 #ifndef COLMAP_SRC_FEATURE_EXTRACTION_H_
 #define COLMAP_SRC_FEATURE_EXTRACTION_H_
 
+#include <unordered_map>
+#include <unordered_set>
+
 #include "base/database.h"
 #include "base/image_reader.h"
 #include "feature/sift.h"
@@ -51,8 +54,10 @@ struct ImageData;
 // Feature extraction class to extract features for all images in a directory.
 class SiftFeatureExtractor : public Thread {
  public:
-  SiftFeatureExtractor(const ImageReaderOptions& reader_options,
-                       const SiftExtractionOptions& sift_options);
+  SiftFeatureExtractor(
+      const ImageReaderOptions& reader_options,
+      const SiftExtractionOptions& sift_options,
+      const DatabaseOptions& database_options = DatabaseOptions());
 
  private:
   void Run();
@@ -63,12 +68,18 @@ class SiftFeatureExtractor : public Thread {
   Database database_;
   ImageReader image_reader_;
 
+  // Images whose line features are already stored in the database and must
+  // not be lifted again. Shared read-only by all lifter threads.
+  std::unordered_set<image_t> image_ids_with_lines_;
+
   std::vector<std::unique_ptr<Thread>> resizers_;
   std::vector<std::unique_ptr<Thread>> extractors_;
+  std::vector<std::unique_ptr<Thread>> lifters_;
   std::unique_ptr<Thread> writer_;
 
   std::unique_ptr<JobQueue<internal::ImageData>> resizer_queue_;
   std::unique_ptr<JobQueue<internal::ImageData>> extractor_queue_;
+  std::unique_ptr<JobQueue<internal::ImageData>> lifter_queue_;
   std::unique_ptr<JobQueue<internal::ImageData>> writer_queue_;
 };
 
@@ -123,16 +134,51 @@ class SiftFeatureExtractorThread : public Thread {
   JobQueue<ImageData>* output_queue_;
 };
 
-class LineFeatureWriterThread : public Thread {
+// Lifts the extracted keypoints of an image to random lines through the
+// keypoints, a fraction of which are aligned with the gravity direction.
+// The random numbers of each image are drawn from a counter-based generator
+// keyed on the seed and the image name, so the lifted lines are reproducible
+// and independent of the thread and order in which the images are processed.
+class LineLifterThread : public Thread {
  public:
-  LineFeatureWriterThread(double aligned_line_ratio, size_t num_images, Database* database,
-                      JobQueue<ImageData>* input_queue);
+  LineLifterThread(const double aligned_line_ratio, const unsigned seed,
+                   const std::unordered_set<image_t>* image_ids_with_lines,
+                   JobQueue<ImageData>* input_queue,
+                   JobQueue<ImageData>* output_queue);
 
  private:
   void Run();
 
+  void LiftLines(ImageData* image_data);
+
   const double aligned_line_ratio_;
+  const unsigned seed_;
+  const std::unordered_set<image_t>* image_ids_with_lines_;
+
+  // Grids to seed the projection of keypoints to the normalized image plane,
+  // which are shared by all images of the same camera.
+  std::unordered_map<camera_t, ImageToWorldGrid> image_to_world_grids_;
+
+  JobQueue<ImageData>* input_queue_;
+  JobQueue<ImageData>* output_queue_;
+};
+
+// Writes the lifted images to the database, combining up to the given number
+// of images into a single transaction.
+class LineFeatureWriterThread : public Thread {
+ public:
+  LineFeatureWriterThread(const size_t num_images,
+                          const size_t num_images_per_transaction,
+                          Database* database, JobQueue<ImageData>* input_queue);
+
+ private:
+  void Run();
+
+  void PrintImageData(const size_t image_index,
+                      const ImageData& image_data) const;
+
   const size_t num_images_;
+  const size_t num_images_per_transaction_;
   Database* database_;
   JobQueue<ImageData>* input_queue_;
 };
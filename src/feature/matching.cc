@@ -34,18 +34,22 @@
 #include "feature/matching.h"
 
 
+#include <chrono>
 #include <fstream>
 #include <numeric>
+#include <thread>
 #include <unordered_set>
 
 #include "SiftGPU/SiftGPU.h"
 #include <FLANN/algorithms/dist.h>
-#include <FLANN/algorithms/linear_index.h>
+#include <FLANN/algorithms/kdtree_single_index.h>
 #include <FLANN/util/matrix.h>
 #include "base/gps.h"
 #include "feature/utils.h"
 #include "util/cuda.h"
+#include "util/memory.h"
 #include "util/misc.h"
+#include "util/trace.h"
 
 namespace colmap {
 namespace {
@@ -109,6 +113,20 @@ void FeatureMatcherCache::Setup() {
       }));
 }
 
+void FeatureMatcherCache::Update() {
+  for (const auto& camera : database_->ReadAllCameras()) {
+    if (cameras_cache_.count(camera.CameraId()) == 0) {
+      cameras_cache_.emplace(camera.CameraId(), camera);
+    }
+  }
+
+  for (const auto& image : database_->ReadAllImages()) {
+    if (images_cache_.count(image.ImageId()) == 0) {
+      images_cache_.emplace(image.ImageId(), image);
+    }
+  }
+}
+
 const Camera& FeatureMatcherCache::GetCamera(const camera_t camera_id) const {
   return cameras_cache_.at(camera_id);
 }
@@ -157,6 +175,21 @@ void FeatureMatcherCache::DeleteMatches(const image_t image_id1,
   database_->DeleteMatches(image_id1, image_id2);
 }
 
+size_t FeatureMatcherCache::NumBytes() {
+  size_t num_bytes = sizeof(FeatureMatcherCache) +
+                     NestedHashMapNumBytes(cameras_cache_) +
+                     NestedHashMapNumBytes(images_cache_);
+  std::unique_lock<std::mutex> lock(database_mutex_);
+  if (descriptors_cache_) {
+    descriptors_cache_->ForEach(
+        [&num_bytes](const image_t, const FeatureDescriptors& descriptors) {
+          num_bytes += sizeof(FeatureDescriptors) +
+                       descriptors.size() * sizeof(FeatureDescriptors::Scalar);
+        });
+  }
+  return num_bytes;
+}
+
 FeatureMatcherThread::FeatureMatcherThread(const SiftMatchingOptions& options,
                                            FeatureMatcherCache* cache)
     : options_(options), cache_(cache) {}
@@ -183,9 +216,10 @@ void SiftCPUFeatureMatcher::Run() {
       break;
     }
 
-    const auto input_job = input_queue_->Pop();
+    auto input_job = input_queue_->Pop();
     if (input_job.IsValid()) {
-      auto data = input_job.Data();
+      auto& data = input_job.Data();
+      TRACE_SCOPE("MatchImagePair");
 
       const FeatureDescriptors descriptors1 =
           cache_->GetDescriptors(data.image_id1);
@@ -197,7 +231,7 @@ void SiftCPUFeatureMatcher::Run() {
         data.matches = {};
       }
 
-      CHECK(output_queue_->Push(data));
+      CHECK(output_queue_->Push(std::move(data)));
     }
   }
 }
@@ -239,9 +273,10 @@ void SiftGPUFeatureMatcher::Run() {
       break;
     }
 
-    const auto input_job = input_queue_->Pop();
+    auto input_job = input_queue_->Pop();
     if (input_job.IsValid()) {
-      auto data = input_job.Data();
+      auto& data = input_job.Data();
+      TRACE_SCOPE("MatchImagePair");
 
       const FeatureDescriptors* descriptors1_ptr;
       GetDescriptorData(0, data.image_id1, &descriptors1_ptr);
@@ -254,7 +289,7 @@ void SiftGPUFeatureMatcher::Run() {
         data.matches = {};
       }
 
-      CHECK(output_queue_->Push(data));
+      CHECK(output_queue_->Push(std::move(data)));
     }
   }
 }
@@ -328,9 +363,13 @@ SiftFeatureMatcher::~SiftFeatureMatcher() {
 }
 
 bool SiftFeatureMatcher::Setup() {
+  // Without any descriptors yet, e.g. when matching while extracting, the
+  // maximum number of features is not known.
   const int max_num_features = CHECK_NOTNULL(database_)->MaxNumDescriptors();
-  options_.max_num_matches =
-      std::min(options_.max_num_matches, max_num_features);
+  if (max_num_features > 0) {
+    options_.max_num_matches =
+        std::min(options_.max_num_matches, max_num_features);
+  }
 
   for (auto& matcher : matchers_) {
     matcher->SetMaxNumMatches(options_.max_num_matches);
@@ -358,6 +397,8 @@ void SiftFeatureMatcher::Match(
     return;
   }
 
+  TRACE_SCOPE("MatchImagePairs");
+
   //////////////////////////////////////////////////////////////////////////////
   // Match the image pairs
   //////////////////////////////////////////////////////////////////////////////
@@ -365,7 +406,24 @@ void SiftFeatureMatcher::Match(
   std::unordered_set<image_pair_t> image_pair_ids;
   image_pair_ids.reserve(image_pairs.size());
 
-  size_t num_outputs = 0;
+  const auto WriteNextOutput = [this]() {
+    auto output_job = output_queue_.Pop();
+    CHECK(output_job.IsValid());
+    auto& output = output_job.Data();
+
+    if (output.matches.size() < static_cast<size_t>(options_.min_num_matches)) {
+      output.matches = {};
+    }
+
+    cache_->WriteMatches(output.image_id1, output.image_id2, output.matches);
+  };
+
+  // The queues are bounded, so the results are written while pushing new
+  // pairs to never have more pairs in flight than the queues can hold.
+  const size_t kMaxNumPendingOutputs =
+      JobQueue<internal::FeatureMatcherData>::kDefaultMaxNumJobs;
+
+  size_t num_pending_outputs = 0;
   for (const auto image_pair : image_pairs) {
     // Avoid self-matches.
     if (image_pair.first == image_pair.second) {
@@ -388,45 +446,48 @@ void SiftFeatureMatcher::Match(
       continue;
     }
 
-    num_outputs += 1;
-
     // If only one of the matches or inlier matches exist, we recompute them
     // from scratch and delete the existing results. This must be done before
     // pushing the jobs to the queue, otherwise database constraints might fail
     // when writing an existing result into the database.
 
+    if (num_pending_outputs == kMaxNumPendingOutputs) {
+      WriteNextOutput();
+      num_pending_outputs -= 1;
+    }
+
     internal::FeatureMatcherData data;
     data.image_id1 = image_pair.first;
     data.image_id2 = image_pair.second;
 
-    CHECK(matcher_queue_.Push(data));
+    CHECK(matcher_queue_.Push(std::move(data)));
+    num_pending_outputs += 1;
   }
 
   //////////////////////////////////////////////////////////////////////////////
   // Write results to database
   //////////////////////////////////////////////////////////////////////////////
 
-  for (size_t i = 0; i < num_outputs; ++i) {
-    const auto output_job = output_queue_.Pop();
-    CHECK(output_job.IsValid());
-    auto output = output_job.Data();
-
-    if (output.matches.size() < static_cast<size_t>(options_.min_num_matches)) {
-      output.matches = {};
-    }
-
-    cache_->WriteMatches(output.image_id1, output.image_id2, output.matches);
+  for (size_t i = 0; i < num_pending_outputs; ++i) {
+    WriteNextOutput();
   }
 
   CHECK_EQ(output_queue_.Size(), 0);
+
+  MemoryTracker& memory_tracker = MemoryTracker::Get();
+  if (memory_tracker.IsStarted()) {
+    memory_tracker.AddSample("MatchImagePairs",
+                             {{"FeatureMatcherCache", cache_->NumBytes()}});
+  }
 }
 
 ExhaustiveFeatureMatcher::ExhaustiveFeatureMatcher(
     const ExhaustiveMatchingOptions& options,
-    const SiftMatchingOptions& match_options, const std::string& database_path)
+    const SiftMatchingOptions& match_options, const std::string& database_path,
+    const DatabaseOptions& database_options)
     : options_(options),
       match_options_(match_options),
-      database_(database_path),
+      database_(database_path, false, database_options),
       cache_(5 * options_.block_size, &database_),
       matcher_(match_options, &database_, &cache_) {
   CHECK(options_.Check());
@@ -499,16 +560,35 @@ void ExhaustiveFeatureMatcher::Run() {
 
 SequentialFeatureMatcher::SequentialFeatureMatcher(
     const SequentialMatchingOptions& options,
-    const SiftMatchingOptions& match_options, const std::string& database_path)
+    const SiftMatchingOptions& match_options, const std::string& database_path,
+    const DatabaseOptions& database_options)
     : options_(options),
       match_options_(match_options),
-      database_(database_path),
+      database_(database_path, false, database_options),
       cache_(5 * options_.overlap, &database_),
-      matcher_(match_options, &database_, &cache_) {
+      matcher_(match_options, &database_, &cache_),
+      streaming_(false),
+      streaming_finished_(false) {
   CHECK(options_.Check());
   CHECK(match_options_.Check());
 }
 
+void SequentialFeatureMatcher::EnableStreaming() {
+  CHECK(!IsStarted());
+  streaming_ = true;
+}
+
+void SequentialFeatureMatcher::FinishStreaming() {
+  streaming_finished_ = true;
+}
+
+std::vector<std::string> SequentialFeatureMatcher::PopMatchedImageNames() {
+  std::unique_lock<std::mutex> lock(matched_image_names_mutex_);
+  std::vector<std::string> image_names;
+  image_names.swap(matched_image_names_);
+  return image_names;
+}
+
 void SequentialFeatureMatcher::Run() {
   PrintHeading1("Sequential feature matching");
 
@@ -518,6 +598,12 @@ void SequentialFeatureMatcher::Run() {
 
   cache_.Setup();
 
+  if (streaming_) {
+    RunStreamingMatching();
+    GetTimer().PrintMinutes();
+    return;
+  }
+
   const std::vector<image_t> ordered_image_ids = GetOrderedImageIds();
 
   RunSequentialMatching(ordered_image_ids);
@@ -591,12 +677,98 @@ void SequentialFeatureMatcher::RunSequentialMatching(
   }
 }
 
+void SequentialFeatureMatcher::RunStreamingMatching() {
+  const int kPollIntervalMs = 100;
+
+  std::vector<image_t> image_ids;
+  std::unordered_set<image_t> matched_image_ids;
+  std::vector<std::pair<image_t, image_t>> image_pairs;
+  image_pairs.reserve(2 * options_.overlap);
+
+  while (!IsStopped()) {
+    // Read the finished flag before polling, so that all images committed
+    // before finishing are matched.
+    const bool finished = streaming_finished_;
+
+    // Images are only matched once their descriptors are committed, which
+    // happens in the same transaction as writing new images.
+    std::vector<image_t> new_image_ids;
+    for (const image_t image_id : database_.ExistingDescriptorImageIds()) {
+      if (matched_image_ids.count(image_id) == 0) {
+        new_image_ids.push_back(image_id);
+      }
+    }
+
+    if (new_image_ids.empty()) {
+      if (finished) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(kPollIntervalMs));
+      continue;
+    }
+
+    std::sort(new_image_ids.begin(), new_image_ids.end());
+    cache_.Update();
+
+    for (const image_t image_id1 : new_image_ids) {
+      if (IsStopped()) {
+        return;
+      }
+
+      Timer timer;
+      timer.Start();
+
+      std::cout << StringPrintf("Matching image [%d]", image_ids.size() + 1)
+                << std::flush;
+
+      // Match against the same neighbors as in the sequential order, but only
+      // backward, since the following images are not yet known.
+      const size_t image_idx1 = image_ids.size();
+      image_pairs.clear();
+      for (int i = 0; i < options_.overlap; ++i) {
+        const size_t offset = static_cast<size_t>(i);
+        if (offset > 0 && offset <= image_idx1) {
+          image_pairs.emplace_back(image_ids.at(image_idx1 - offset),
+                                   image_id1);
+        }
+        if (options_.quadratic_overlap) {
+          const size_t quadratic_offset = static_cast<size_t>(1) << i;
+          if (quadratic_offset >= static_cast<size_t>(options_.overlap) &&
+              quadratic_offset <= image_idx1) {
+            image_pairs.emplace_back(
+                image_ids.at(image_idx1 - quadratic_offset), image_id1);
+          }
+        }
+      }
+
+      // The matches are written concurrently to the feature extractor, and
+      // the transaction reads before it writes.
+      {
+        DatabaseTransaction database_transaction(&database_,
+                                                 /*immediate=*/true);
+        matcher_.Match(image_pairs);
+      }
+
+      image_ids.push_back(image_id1);
+      matched_image_ids.insert(image_id1);
+
+      {
+        std::unique_lock<std::mutex> lock(matched_image_names_mutex_);
+        matched_image_names_.push_back(cache_.GetImage(image_id1).Name());
+      }
+
+      PrintElapsedTime(timer);
+    }
+  }
+}
+
 SpatialFeatureMatcher::SpatialFeatureMatcher(
     const SpatialMatchingOptions& options,
-    const SiftMatchingOptions& match_options, const std::string& database_path)
+    const SiftMatchingOptions& match_options, const std::string& database_path,
+    const DatabaseOptions& database_options)
     : options_(options),
       match_options_(match_options),
-      database_(database_path),
+      database_(database_path, false, database_options),
       cache_(5 * options_.max_num_neighbors, &database_),
       matcher_(match_options, &database_, &cache_) {
   CHECK(options_.Check());
@@ -688,8 +860,8 @@ void SpatialFeatureMatcher::Run() {
   flann::Matrix<float> locations(location_matrix.data(), num_locations,
                                  location_matrix.cols());
 
-  flann::LinearIndexParams index_params;
-  flann::LinearIndex<flann::L2<float>> search_index(index_params);
+  flann::KDTreeSingleIndexParams index_params;
+  flann::KDTreeSingleIndex<flann::L2<float>> search_index(index_params);
   search_index.buildIndex(locations);
 
   PrintElapsedTime(timer);
@@ -698,46 +870,52 @@ void SpatialFeatureMatcher::Run() {
   // Searching spatial index
   //////////////////////////////////////////////////////////////////////////////
 
-  timer.Restart();
-
-  std::cout << "Searching for nearest neighbors..." << std::flush;
+  // The radius search is performed in blocks of query images on a thread pool.
+  // The matching below consumes the blocks in order as soon as they finish, so
+  // the first image pairs are matched while the remaining blocks are searched.
+  const size_t kNumQueriesPerBlock = 1000;
 
-  const int knn = std::min<int>(options_.max_num_neighbors, num_locations);
+  // The query image is part of the result set, hence search for one more.
+  flann::SearchParams search_params(flann::FLANN_CHECKS_UNLIMITED);
+  search_params.max_neighbors = options_.max_num_neighbors + 1;
+  search_params.sorted = true;
+  search_params.cores = 1;
 
-  Eigen::Matrix<size_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
-      index_matrix(num_locations, knn);
-  flann::Matrix<size_t> indices(index_matrix.data(), num_locations, knn);
-
-  Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
-      distance_matrix(num_locations, knn);
-  flann::Matrix<float> distances(distance_matrix.data(), num_locations, knn);
+  // For the L2 metric, FLANN expects the squared radius.
+  const float max_distance =
+      static_cast<float>(options_.max_distance * options_.max_distance);
 
-  flann::SearchParams search_params(flann::FLANN_CHECKS_AUTOTUNED);
-  if (match_options_.num_threads == ThreadPool::kMaxNumThreads) {
-    search_params.cores = std::thread::hardware_concurrency();
-  } else {
-    search_params.cores = match_options_.num_threads;
-  }
-  if (search_params.cores <= 0) {
-    search_params.cores = 1;
+  const size_t num_blocks =
+      (num_locations + kNumQueriesPerBlock - 1) / kNumQueriesPerBlock;
+  std::vector<std::vector<std::vector<size_t>>> block_indices(num_blocks);
+
+  ThreadPool thread_pool(match_options_.num_threads);
+  std::vector<std::future<void>> block_futures;
+  block_futures.reserve(num_blocks);
+
+  for (size_t block_idx = 0; block_idx < num_blocks; ++block_idx) {
+    block_futures.push_back(thread_pool.AddTask([&, block_idx]() {
+      const size_t start_idx = block_idx * kNumQueriesPerBlock;
+      const size_t end_idx =
+          std::min(num_locations, start_idx + kNumQueriesPerBlock);
+      const flann::Matrix<float> queries(location_matrix.data() + 3 * start_idx,
+                                         end_idx - start_idx, 3);
+      std::vector<std::vector<float>> distances;
+      search_index.radiusSearch(queries, block_indices[block_idx], distances,
+                                max_distance, search_params);
+    }));
   }
 
-  search_index.knnSearch(locations, indices, distances, knn, search_params);
-
-  PrintElapsedTime(timer);
-
   //////////////////////////////////////////////////////////////////////////////
   // Matching
   //////////////////////////////////////////////////////////////////////////////
 
-  const float max_distance =
-      static_cast<float>(options_.max_distance * options_.max_distance);
-
   std::vector<std::pair<image_t, image_t>> image_pairs;
-  image_pairs.reserve(knn);
+  image_pairs.reserve(options_.max_num_neighbors);
 
   for (size_t i = 0; i < num_locations; ++i) {
     if (IsStopped()) {
+      thread_pool.Stop();
       GetTimer().PrintMinutes();
       return;
     }
@@ -747,22 +925,27 @@ void SpatialFeatureMatcher::Run() {
     std::cout << StringPrintf("Matching image [%d/%d]", i + 1, num_locations)
               << std::flush;
 
+    const size_t block_idx = i / kNumQueriesPerBlock;
+    block_futures[block_idx].wait();
+    const auto& neighbor_idxs =
+        block_indices[block_idx][i % kNumQueriesPerBlock];
+
     image_pairs.clear();
 
-    for (int j = 0; j < knn; ++j) {
+    const size_t idx = location_idxs[i];
+    const image_t image_id = image_ids.at(idx);
+    for (const size_t neighbor_idx : neighbor_idxs) {
       // Check if query equals result.
-      if (index_matrix(i, j) == i) {
+      if (neighbor_idx == i) {
         continue;
       }
 
-      // Since the nearest neighbors are sorted by distance, we can break.
-      if (distance_matrix(i, j) > max_distance) {
+      if (image_pairs.size() >=
+          static_cast<size_t>(options_.max_num_neighbors)) {
         break;
       }
 
-      const size_t idx = location_idxs[i];
-      const image_t image_id = image_ids.at(idx);
-      const size_t nn_idx = location_idxs.at(index_matrix(i, j));
+      const size_t nn_idx = location_idxs.at(neighbor_idx);
       const image_t nn_image_id = image_ids.at(nn_idx);
       image_pairs.emplace_back(image_id, nn_image_id);
     }
@@ -778,10 +961,11 @@ void SpatialFeatureMatcher::Run() {
 
 TransitiveFeatureMatcher::TransitiveFeatureMatcher(
     const TransitiveMatchingOptions& options,
-    const SiftMatchingOptions& match_options, const std::string& database_path)
+    const SiftMatchingOptions& match_options, const std::string& database_path,
+    const DatabaseOptions& database_options)
     : options_(options),
       match_options_(match_options),
-      database_(database_path),
+      database_(database_path, false, database_options),
       cache_(options_.batch_size, &database_),
       matcher_(match_options, &database_, &cache_) {
   CHECK(options_.Check());
@@ -875,10 +1059,11 @@ void TransitiveFeatureMatcher::Run() {
 
 ImagePairsFeatureMatcher::ImagePairsFeatureMatcher(
     const ImagePairsMatchingOptions& options,
-    const SiftMatchingOptions& match_options, const std::string& database_path)
+    const SiftMatchingOptions& match_options, const std::string& database_path,
+    const DatabaseOptions& database_options)
     : options_(options),
       match_options_(match_options),
-      database_(database_path),
+      database_(database_path, false, database_options),
       cache_(options.block_size, &database_),
       matcher_(match_options, &database_, &cache_) {
   CHECK(options_.Check());
@@ -983,10 +1168,11 @@ void ImagePairsFeatureMatcher::Run() {
 
 FeaturePairsFeatureMatcher::FeaturePairsFeatureMatcher(
     const FeaturePairsMatchingOptions& options,
-    const SiftMatchingOptions& match_options, const std::string& database_path)
+    const SiftMatchingOptions& match_options, const std::string& database_path,
+    const DatabaseOptions& database_options)
     : options_(options),
       match_options_(match_options),
-      database_(database_path),
+      database_(database_path, false, database_options),
       cache_(kCacheSize, &database_) {
   CHECK(options_.Check());
   CHECK(match_options_.Check());
@@ -33,6 +33,7 @@
 #define COLMAP_SRC_FEATURE_MATCHING_H_
 
 #include <array>
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -128,6 +129,10 @@ class FeatureMatcherCache {
 
   void Setup();
 
+  // Add the cameras and images that were added to the database since `Setup`.
+  // Must not be called concurrently with the other methods.
+  void Update();
+
   const Camera& GetCamera(const camera_t camera_id) const;
   const Image& GetImage(const image_t image_id) const;
   const FeatureDescriptors& GetDescriptors(const image_t image_id);
@@ -141,6 +146,10 @@ class FeatureMatcherCache {
 
   void DeleteMatches(const image_t image_id1, const image_t image_id2);
 
+  // Estimated size of the cached cameras, images, and descriptors in memory
+  // in bytes.
+  size_t NumBytes();
+
  private:
   const size_t cache_size_;
   const Database* database_;
@@ -262,9 +271,11 @@ class SiftFeatureMatcher {
 // are on the main diagonal and denote pairs of the same image.
 class ExhaustiveFeatureMatcher : public Thread {
  public:
-  ExhaustiveFeatureMatcher(const ExhaustiveMatchingOptions& options,
-                           const SiftMatchingOptions& match_options,
-                           const std::string& database_path);
+  ExhaustiveFeatureMatcher(
+      const ExhaustiveMatchingOptions& options,
+      const SiftMatchingOptions& match_options,
+      const std::string& database_path,
+      const DatabaseOptions& database_options = DatabaseOptions());
 
  private:
   void Run() override;
@@ -290,32 +301,60 @@ class ExhaustiveFeatureMatcher : public Thread {
 //                    image_[i - 2^o, i + 2^o]    (for quadratic overlap)
 //
 // Sequential order is determined based on the image names in ascending order.
+//
+// In streaming mode, the images are matched while they are added to the
+// database, e.g. by a concurrently running feature extractor. Each image is
+// matched against its preceding neighbors as soon as its descriptors are
+// committed, where the sequential order is the order of the image identifiers,
+// i.e. the order in which the images were added.
 class SequentialFeatureMatcher : public Thread {
  public:
-  SequentialFeatureMatcher(const SequentialMatchingOptions& options,
-                           const SiftMatchingOptions& match_options,
-                           const std::string& database_path);
+  SequentialFeatureMatcher(
+      const SequentialMatchingOptions& options,
+      const SiftMatchingOptions& match_options,
+      const std::string& database_path,
+      const DatabaseOptions& database_options = DatabaseOptions());
+
+  // Enable streaming mode, which must be done before starting the thread.
+  // The thread then runs until `FinishStreaming` is called and all images
+  // added to the database until then are matched.
+  void EnableStreaming();
+  void FinishStreaming();
+
+  // Retrieve the names of the images matched in streaming mode since the last
+  // call, in the order in which they were matched. All matches of an image to
+  // its preceding images are written to the database before its name is
+  // returned.
+  std::vector<std::string> PopMatchedImageNames();
 
  private:
   void Run() override;
 
   std::vector<image_t> GetOrderedImageIds() const;
   void RunSequentialMatching(const std::vector<image_t>& image_ids);
+  void RunStreamingMatching();
 
   const SequentialMatchingOptions options_;
   const SiftMatchingOptions match_options_;
   Database database_;
   FeatureMatcherCache cache_;
   SiftFeatureMatcher matcher_;
+
+  bool streaming_;
+  std::atomic<bool> streaming_finished_;
+  std::mutex matched_image_names_mutex_;
+  std::vector<std::string> matched_image_names_;
 };
 
 // Match images against spatial nearest neighbors using prior location
 // information, e.g. provided manually or extracted from EXIF.
 class SpatialFeatureMatcher : public Thread {
  public:
-  SpatialFeatureMatcher(const SpatialMatchingOptions& options,
-                        const SiftMatchingOptions& match_options,
-                        const std::string& database_path);
+  SpatialFeatureMatcher(
+      const SpatialMatchingOptions& options,
+      const SiftMatchingOptions& match_options,
+      const std::string& database_path,
+      const DatabaseOptions& database_options = DatabaseOptions());
 
  private:
   void Run() override;
@@ -333,9 +372,11 @@ class SpatialFeatureMatcher : public Thread {
 // A-C. This procedure is performed for multiple iterations.
 class TransitiveFeatureMatcher : public Thread {
  public:
-  TransitiveFeatureMatcher(const TransitiveMatchingOptions& options,
-                           const SiftMatchingOptions& match_options,
-                           const std::string& database_path);
+  TransitiveFeatureMatcher(
+      const TransitiveMatchingOptions& options,
+      const SiftMatchingOptions& match_options,
+      const std::string& database_path,
+      const DatabaseOptions& database_options = DatabaseOptions());
 
  private:
   void Run() override;
@@ -358,9 +399,11 @@ class TransitiveFeatureMatcher : public Thread {
 //
 class ImagePairsFeatureMatcher : public Thread {
  public:
-  ImagePairsFeatureMatcher(const ImagePairsMatchingOptions& options,
-                           const SiftMatchingOptions& match_options,
-                           const std::string& database_path);
+  ImagePairsFeatureMatcher(
+      const ImagePairsMatchingOptions& options,
+      const SiftMatchingOptions& match_options,
+      const std::string& database_path,
+      const DatabaseOptions& database_options = DatabaseOptions());
 
  private:
   void Run() override;
@@ -389,9 +432,11 @@ class ImagePairsFeatureMatcher : public Thread {
 //
 class FeaturePairsFeatureMatcher : public Thread {
  public:
-  FeaturePairsFeatureMatcher(const FeaturePairsMatchingOptions& options,
-                             const SiftMatchingOptions& match_options,
-                             const std::string& database_path);
+  FeaturePairsFeatureMatcher(
+      const FeaturePairsMatchingOptions& options,
+      const SiftMatchingOptions& match_options,
+      const std::string& database_path,
+      const DatabaseOptions& database_options = DatabaseOptions());
 
  private:
   const static size_t kCacheSize = 100;
@@ -383,6 +383,9 @@ bool SiftExtractionOptions::Check() const {
     CHECK_OPTION_GE(dsp_max_scale, dsp_min_scale);
     CHECK_OPTION_GT(dsp_num_scales, 0);
   }
+  CHECK_OPTION_GE(line_seed, 0);
+  CHECK_OPTION_GE(aligned_line_ratio, 0);
+  CHECK_OPTION_LE(aligned_line_ratio, 1);
   return true;
 }
 
@@ -111,6 +111,16 @@ struct SiftExtractionOptions {
   };
   Normalization normalization = Normalization::L1_ROOT;
 
+  // Seed for lifting the keypoints to lines. The lifted lines of an image only
+  // depend on this seed, the image name and its keypoints, such that repeated
+  // extractions produce identical lines.
+  int line_seed = 0;
+
+  // The fraction of the keypoints of an image with known gravity that are
+  // lifted to gravity-aligned lines. The other keypoints are lifted to lines
+  // with random directions.
+  double aligned_line_ratio = 0.5;
+
   bool Check() const;
 };
 
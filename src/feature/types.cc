@@ -32,6 +32,7 @@
 #include "feature/types.h"
 
 #include "util/logging.h"
+#include "util/memory.h"
 
 namespace colmap {
 
@@ -104,4 +105,60 @@ float FeatureKeypoint::ComputeShear() const {
   return std::atan2(-a12, a22) - ComputeOrientation();
 }
 
+FeatureLineArray::FeatureLineArray(const FeatureLines& lines) {
+  Reserve(lines.size());
+  for (const auto& line : lines) {
+    PushBack(line);
+  }
+}
+
+void FeatureLineArray::Reserve(const size_t num_lines) {
+  lines_.reserve(num_lines);
+  is_aligned_.reserve(num_lines);
+  point3D_ids_.reserve(num_lines);
+}
+
+void FeatureLineArray::Resize(const size_t num_lines) {
+  lines_.resize(num_lines, Eigen::Vector3d::Zero());
+  is_aligned_.resize(num_lines, 0);
+  point3D_ids_.resize(num_lines, kInvalidPoint3DId);
+}
+
+void FeatureLineArray::Clear() {
+  lines_.clear();
+  is_aligned_.clear();
+  point3D_ids_.clear();
+}
+
+void FeatureLineArray::PushBack(const FeatureLine& line) {
+  lines_.push_back(line.Line());
+  is_aligned_.push_back(line.IsAligned() ? 1 : 0);
+  point3D_ids_.push_back(line.Point3DId());
+}
+
+FeatureLine FeatureLineArray::At(const size_t idx) const {
+  return FeatureLine(lines_.at(idx), is_aligned_.at(idx) != 0,
+                     point3D_ids_.at(idx));
+}
+
+void FeatureLineArray::Set(const size_t idx, const FeatureLine& line) {
+  lines_.at(idx) = line.Line();
+  is_aligned_.at(idx) = line.IsAligned() ? 1 : 0;
+  point3D_ids_.at(idx) = line.Point3DId();
+}
+
+FeatureLines FeatureLineArray::ToFeatureLines() const {
+  FeatureLines lines;
+  lines.reserve(Size());
+  for (size_t i = 0; i < Size(); ++i) {
+    lines.push_back(At(i));
+  }
+  return lines;
+}
+
+size_t FeatureLineArray::NumBytes() const {
+  return sizeof(FeatureLineArray) + VectorNumBytes(lines_) +
+         VectorNumBytes(is_aligned_) + VectorNumBytes(point3D_ids_);
+}
+
 }  // namespace colmap
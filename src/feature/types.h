@@ -150,6 +150,123 @@ namespace colmap {
   typedef std::pair<Eigen::Vector2d, Eigen::Vector2d> LineCoord;
   typedef std::vector<LineCoord, Eigen::aligned_allocator<LineCoord>> LineCoords;
 
+// Structure-of-arrays container for the feature lines of an image. The line
+// parameters, the alignment flags and the 3D point identifiers are stored in
+// separate contiguous arrays, so that loops over the line parameters do not
+// pull the point identifiers into the cache. Individual lines are returned
+// by value as `FeatureLine`.
+class FeatureLineArray {
+ public:
+  class ConstIterator {
+   public:
+    ConstIterator(const FeatureLineArray* array, const size_t idx)
+        : array_(array), idx_(idx) {}
+
+    FeatureLine operator*() const { return array_->At(idx_); }
+    ConstIterator& operator++() {
+      idx_ += 1;
+      return *this;
+    }
+    bool operator==(const ConstIterator& other) const {
+      return idx_ == other.idx_;
+    }
+    bool operator!=(const ConstIterator& other) const {
+      return idx_ != other.idx_;
+    }
+
+   private:
+    const FeatureLineArray* array_;
+    size_t idx_;
+  };
+
+  FeatureLineArray() = default;
+  explicit FeatureLineArray(const FeatureLines& lines);
+
+  inline size_t Size() const;
+  inline bool Empty() const;
+
+  void Reserve(const size_t num_lines);
+  void Resize(const size_t num_lines);
+  void Clear();
+
+  void PushBack(const FeatureLine& line);
+
+  // Assemble the line at the given index. Note that this returns a copy.
+  FeatureLine At(const size_t idx) const;
+  void Set(const size_t idx, const FeatureLine& line);
+
+  // Access the individual fields of the line at the given index.
+  inline const Eigen::Vector3d& Line(const size_t idx) const;
+  inline void SetLine(const size_t idx, const Eigen::Vector3d& line);
+  inline bool IsAligned(const size_t idx) const;
+  inline void SetAligned(const size_t idx, const bool is_aligned);
+  inline point3D_t Point3DId(const size_t idx) const;
+  inline bool HasPoint3D(const size_t idx) const;
+  inline void SetPoint3DId(const size_t idx, const point3D_t point3D_id);
+
+  // Contiguous line parameters, e.g. for streaming over all lines.
+  inline const std::vector<Eigen::Vector3d>& LineParams() const;
+  inline const std::vector<point3D_t>& Point3DIds() const;
+
+  FeatureLines ToFeatureLines() const;
+
+  // Estimated size of the array in memory in bytes.
+  size_t NumBytes() const;
+
+  ConstIterator begin() const { return ConstIterator(this, 0); }
+  ConstIterator end() const { return ConstIterator(this, Size()); }
+
+ private:
+  std::vector<Eigen::Vector3d> lines_;
+  std::vector<uint8_t> is_aligned_;
+  std::vector<point3D_t> point3D_ids_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Implementation
+////////////////////////////////////////////////////////////////////////////////
+
+size_t FeatureLineArray::Size() const { return lines_.size(); }
+
+bool FeatureLineArray::Empty() const { return lines_.empty(); }
+
+const Eigen::Vector3d& FeatureLineArray::Line(const size_t idx) const {
+  return lines_.at(idx);
+}
+
+void FeatureLineArray::SetLine(const size_t idx, const Eigen::Vector3d& line) {
+  lines_.at(idx) = line;
+}
+
+bool FeatureLineArray::IsAligned(const size_t idx) const {
+  return is_aligned_.at(idx) != 0;
+}
+
+void FeatureLineArray::SetAligned(const size_t idx, const bool is_aligned) {
+  is_aligned_.at(idx) = is_aligned ? 1 : 0;
+}
+
+point3D_t FeatureLineArray::Point3DId(const size_t idx) const {
+  return point3D_ids_.at(idx);
+}
+
+bool FeatureLineArray::HasPoint3D(const size_t idx) const {
+  return point3D_ids_.at(idx) != kInvalidPoint3DId;
+}
+
+void FeatureLineArray::SetPoint3DId(const size_t idx,
+                                    const point3D_t point3D_id) {
+  point3D_ids_.at(idx) = point3D_id;
+}
+
+const std::vector<Eigen::Vector3d>& FeatureLineArray::LineParams() const {
+  return lines_;
+}
+
+const std::vector<point3D_t>& FeatureLineArray::Point3DIds() const {
+  return point3D_ids_;
+}
+
 }  // namespace colmap
 
 #endif  // COLMAP_SRC_FEATURE_TYPES_H_
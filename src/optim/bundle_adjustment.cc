@@ -363,19 +363,21 @@ void BundleAdjuster::AddImageToProblem(const image_t image_id,
 
   // Add residuals to bundle adjustment problem.
   size_t num_observations = 0;
-  const int num_lines = image.Lines().size();
+  const FeatureLineArray& lines = image.Lines();
+  const int num_lines = image.NumLines();
   for (int feature_idx = 0; feature_idx < num_lines; ++feature_idx) {
-    const FeatureLine& line = image.Line(feature_idx);
-    if (!line.HasPoint3D()) {
+    if (!lines.HasPoint3D(feature_idx)) {
       continue;
     }
 
-    CHECK_NEAR(line.Line().head<2>().norm(), 1.0, 1e-6);
+    const Eigen::Vector3d& line = lines.Line(feature_idx);
+    CHECK_NEAR(line.head<2>().norm(), 1.0, 1e-6);
 
+    const point3D_t point3D_id = lines.Point3DId(feature_idx);
     num_observations += 1;
-    point3D_num_observations_[line.Point3DId()] += 1;
+    point3D_num_observations_[point3D_id] += 1;
 
-    Point3D& point3D = reconstruction->Point3D(line.Point3DId());
+    Point3D& point3D = reconstruction->Point3D(point3D_id);
     assert(point3D.Track().Length() > 1);
 
     ceres::CostFunction* cost_function = nullptr;
@@ -387,7 +389,7 @@ void BundleAdjuster::AddImageToProblem(const image_t image_id,
           case CameraModel::kModelId:                                              \
             cost_function =                                                        \
                 BundleAdjustmentConstantPoseLineCostFunction<CameraModel>::Create( \
-                    image.Qvec(), image.Tvec(), line.Line());                      \
+                    image.Qvec(), image.Tvec(), line);                             \
             break;
 
           CAMERA_MODEL_SWITCH_CASES
@@ -402,7 +404,7 @@ void BundleAdjuster::AddImageToProblem(const image_t image_id,
         case CameraModel::kModelId:                                                \
           cost_function =                                                          \
             BundleAdjustmentLineCostFunction<CameraModel>::Create(                 \
-              line.Line());                                                        \
+              line);                                                               \
               break;
         CAMERA_MODEL_SWITCH_CASES
 
@@ -457,7 +459,7 @@ void BundleAdjuster::AddPointToProblem(const point3D_t point3D_id,
 
     Image& image = reconstruction->Image(track_el.image_id);
     Camera& camera = reconstruction->Camera(image.CameraId());
-    const FeatureLine& line = image.Line(track_el.line_idx);
+    const Eigen::Vector3d& line = image.Lines().Line(track_el.line_idx);
 
     // We do not want to refine the camera of images that are not
     // part of `constant_image_ids_`, `constant_image_ids_`,
@@ -474,7 +476,7 @@ void BundleAdjuster::AddPointToProblem(const point3D_t point3D_id,
       case CameraModel::kModelId:                                            \
         cost_function =                                                      \
           BundleAdjustmentConstantPoseLineCostFunction<CameraModel>::Create( \
-              image.Qvec(), image.Tvec(), line.Line());                      \
+              image.Qvec(), image.Tvec(), line);                             \
       break;
 
       CAMERA_MODEL_SWITCH_CASES
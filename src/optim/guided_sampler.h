@@ -0,0 +1,65 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef COLMAP_SRC_OPTIM_GUIDED_SAMPLER_H_
+#define COLMAP_SRC_OPTIM_GUIDED_SAMPLER_H_
+
+#include "optim/sampler.h"
+
+namespace colmap {
+
+// Sampler for RANSAC-based methods that first returns a list of seed samples,
+// e.g. the most informative subsets of the data according to some prior, and
+// then continues with random samples.
+//
+// Note that a separate sampler should be instantiated per thread.
+class GuidedSampler : public Sampler {
+ public:
+  explicit GuidedSampler(const size_t num_samples);
+
+  // Set the seed samples, which are returned in the given order before any
+  // random sample. Each seed sample must have `num_samples` unique indices.
+  void SetSeedSamples(const std::vector<std::vector<size_t>>& seed_samples);
+
+  void Initialize(const size_t total_num_samples) override;
+
+  size_t MaxNumSamples() override;
+
+  std::vector<size_t> Sample() override;
+
+ private:
+  const size_t num_samples_;
+  std::vector<std::vector<size_t>> seed_samples_;
+  size_t next_seed_sample_idx_;
+  std::vector<size_t> sample_idxs_;
+};
+
+}  // namespace colmap
+
+#endif  // COLMAP_SRC_OPTIM_GUIDED_SAMPLER_H_
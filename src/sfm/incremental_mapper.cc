@@ -43,6 +43,7 @@
 #include "estimators/pose.h"
 #include "init/initializer.h"
 #include "util/bitmap.h"
+#include "util/trace.h"
 
 namespace colmap {
 namespace {
@@ -190,6 +191,7 @@ std::vector<image_t> IncrementalMapper::FindNextImages(const Options& options) {
 }
 
 bool IncrementalMapper::RegisterInitialLineImages(const Options& options, const DatabaseCache& aligned_db_cache) {
+  TRACE_SCOPE("RegisterInitialLineImages");
 
   CHECK_NOTNULL(reconstruction_);
   CHECK_EQ(reconstruction_->NumRegImages(), 0);
@@ -315,18 +317,18 @@ bool IncrementalMapper::RegisterInitialLineImages(const Options& options, const
 
     // Search for correspondences for all features, aligned and unaligned.
     // Wen can split the tracks later
-    const int num_features = image.Lines().size();
+    const int num_features = image.NumLines();
     for (int line_idx = 0; line_idx < num_features; ++line_idx) {
 
-      const bool aligned_feature = image.Line(line_idx).IsAligned();
+      const bool aligned_feature = image.Lines().IsAligned(line_idx);
       const auto& corrs = corr_graph.FindCorrespondences(image_id, line_idx);
 
       // Only consider correspondences with the same alignment (either
       // gravity-aligned or random) as the reference.
       std::vector<CorrespondenceGraph::Correspondence> alignment_corrs;
       for (const auto& corr : corrs) {
-        if (aligned_db_cache.Image(corr.image_id).Line(corr.line_idx).IsAligned() ==
-            aligned_feature) {
+        const Image& corr_image = aligned_db_cache.Image(corr.image_id);
+        if (corr_image.Lines().IsAligned(corr.line_idx) == aligned_feature) {
           alignment_corrs.emplace_back(corr);
         }
       }
@@ -464,7 +466,7 @@ bool IncrementalMapper::RegisterInitialLineImages(const Options& options, const
         const int line_idx = track.at(i);
         lines.at(image_idx_map.at(image_id))
             .emplace_back(aligned_db_cache.Image(image_id).Line(line_idx));
-        CHECK(aligned_db_cache.Image(image_id).Line(line_idx).IsAligned());
+        CHECK(aligned_db_cache.Image(image_id).Lines().IsAligned(line_idx));
       }
     }
 
@@ -476,7 +478,7 @@ bool IncrementalMapper::RegisterInitialLineImages(const Options& options, const
         const int line_idx = track.at(i);
         lines.at(image_idx_map.at(image_id))
             .emplace_back(aligned_db_cache.Image(image_id).Line(line_idx));
-        CHECK(!aligned_db_cache.Image(image_id).Line(line_idx).IsAligned());
+        CHECK(!aligned_db_cache.Image(image_id).Lines().IsAligned(line_idx));
       }
     }
 
@@ -569,6 +571,7 @@ bool IncrementalMapper::RegisterInitialLineImages(const Options& options, const
 
 bool IncrementalMapper::RegisterNextImage(const Options& options,
                                           const image_t image_id) {
+  TRACE_SCOPE("RegisterNextImage");
   CHECK_NOTNULL(reconstruction_);
   CHECK_GE(reconstruction_->NumRegImages(), 2);
 
@@ -600,7 +603,6 @@ bool IncrementalMapper::RegisterNextImage(const Options& options,
 
   for (point2D_t line_idx = 0; line_idx < image.NumLines();
        ++line_idx) {
-    const FeatureLine& line = image.Line(line_idx);
     const CorrespondenceGraph& correspondence_graph =
         database_cache_->CorrespondenceGraph();
     const std::vector<CorrespondenceGraph::Correspondence> corrs =
@@ -615,13 +617,14 @@ bool IncrementalMapper::RegisterNextImage(const Options& options,
         continue;
       }
 
-      const FeatureLine& corr_line = corr_image.Line(corr.line_idx);
-      if (!corr_line.HasPoint3D()) {
+      const point3D_t corr_point3D_id =
+          corr_image.Lines().Point3DId(corr.line_idx);
+      if (corr_point3D_id == kInvalidPoint3DId) {
         continue;
       }
 
       // Avoid duplicate correspondences.
-      if (point3D_ids.count(corr_line.Point3DId()) > 0) {
+      if (point3D_ids.count(corr_point3D_id) > 0) {
         continue;
       }
 
@@ -635,13 +638,12 @@ bool IncrementalMapper::RegisterNextImage(const Options& options,
         continue;
       }
 
-      const Point3D& point3D =
-          reconstruction_->Point3D(corr_line.Point3DId());
+      const Point3D& point3D = reconstruction_->Point3D(corr_point3D_id);
 
-      tri_corrs.emplace_back(line_idx, corr_line.Point3DId());
-      point3D_ids.insert(corr_line.Point3DId());
-      tri_lines2D.push_back(line);
-      tri_lines2D_params.push_back(line.Line());
+      tri_corrs.emplace_back(line_idx, corr_point3D_id);
+      point3D_ids.insert(corr_point3D_id);
+      tri_lines2D.push_back(image.Line(line_idx));
+      tri_lines2D_params.push_back(image.Lines().Line(line_idx));
       tri_points3D.push_back(point3D.XYZ());
     }
   }
@@ -746,8 +748,7 @@ bool IncrementalMapper::RegisterNextImage(const Options& options,
   for (size_t i = 0; i < inlier_mask.size(); ++i) {
     if (inlier_mask[i]) {
       const point2D_t line_idx = tri_corrs[i].first;
-      const FeatureLine& line = image.Line(line_idx);
-      if (!line.HasPoint3D()) {
+      if (!image.Lines().HasPoint3D(line_idx)) {
         const point3D_t point3D_id = tri_corrs[i].second;
         const TrackElement track_el(image_id, line_idx);
         reconstruction_->AddObservation(point3D_id, track_el);
@@ -762,6 +763,7 @@ bool IncrementalMapper::RegisterNextImage(const Options& options,
 size_t IncrementalMapper::TriangulateImage(
     const IncrementalTriangulator::Options& tri_options,
     const image_t image_id) {
+  TRACE_SCOPE("TriangulateImage");
   CHECK_NOTNULL(reconstruction_);
   return triangulator_->TriangulateImage(tri_options, image_id);
 }
@@ -782,7 +784,9 @@ IncrementalMapper::LocalBundleAdjustmentReport
 IncrementalMapper::AdjustLocalBundle(
     const Options& options, const BundleAdjustmentOptions& ba_options,
     const IncrementalTriangulator::Options& tri_options, const image_t image_id,
-    const std::unordered_set<point3D_t>& point3D_ids) {
+    const std::unordered_set<point3D_t>& point3D_ids,
+    std::unordered_set<point3D_t>* changed_point3D_ids) {
+  TRACE_SCOPE("AdjustLocalBundle");
   CHECK_NOTNULL(reconstruction_);
   CHECK(options.Check());
 
@@ -791,6 +795,23 @@ IncrementalMapper::AdjustLocalBundle(
   // Find images that have most 3D points with given image in common.
   const std::vector<image_t> local_bundle = FindLocalBundle(options, image_id);
 
+  // The points are collected before the adjustment, since the points that are
+  // merged or filtered are deleted. The points of the local bundle are all
+  // adjusted, and the filtered points are either given or among them.
+  if (changed_point3D_ids != nullptr) {
+    changed_point3D_ids->insert(point3D_ids.begin(), point3D_ids.end());
+    std::vector<image_t> changed_image_ids = local_bundle;
+    changed_image_ids.push_back(image_id);
+    for (const image_t changed_image_id : changed_image_ids) {
+      const class Image& image = reconstruction_->Image(changed_image_id);
+      for (const FeatureLine& line : image.Lines()) {
+        if (line.HasPoint3D()) {
+          changed_point3D_ids->insert(line.Point3DId());
+        }
+      }
+    }
+  }
+
   // Do the bundle adjustment only if there is any connected images.
   if (local_bundle.size() > 0) {
     BundleAdjustmentConfig ba_config;
@@ -880,6 +901,7 @@ IncrementalMapper::AdjustLocalBundle(
   std::unordered_set<image_t> filter_image_ids;
   filter_image_ids.insert(image_id);
   filter_image_ids.insert(local_bundle.begin(), local_bundle.end());
+
   report.num_filtered_observations = reconstruction_->FilterPoints3DInImages(
       options.filter_max_reproj_error, options.filter_min_tri_angle,
       filter_image_ids);
@@ -892,6 +914,7 @@ IncrementalMapper::AdjustLocalBundle(
 
 bool IncrementalMapper::AdjustGlobalBundle(
     const Options& options, const BundleAdjustmentOptions& ba_options) {
+  TRACE_SCOPE("AdjustGlobalBundle");
   CHECK_NOTNULL(reconstruction_);
 
   const std::vector<image_t>& reg_image_ids = reconstruction_->RegImageIds();
@@ -164,11 +164,14 @@ class IncrementalMapper {
   // addition, refine the provided 3D points. Only images connected to the
   // reference image are optimized. If the provided 3D points are not locally
   // connected to the reference image, their observing images are set as
-  // constant in the adjustment.
+  // constant in the adjustment. If given, the 3D points that were adjusted,
+  // merged, or filtered, including the deleted ones, are added to
+  // `changed_point3D_ids`.
   LocalBundleAdjustmentReport AdjustLocalBundle(
       const Options& options, const BundleAdjustmentOptions& ba_options,
       const IncrementalTriangulator::Options& tri_options,
-      const image_t image_id, const std::unordered_set<point3D_t>& point3D_ids);
+      const image_t image_id, const std::unordered_set<point3D_t>& point3D_ids,
+      std::unordered_set<point3D_t>* changed_point3D_ids = nullptr);
 
   // Global bundle adjustment using Ceres Solver or PBA.
   bool AdjustGlobalBundle(const Options& options,
@@ -46,6 +46,10 @@ bool IncrementalTriangulator::Options::Check() const {
   CHECK_OPTION_GT(merge_max_reproj_error, 0);
   CHECK_OPTION_GT(complete_max_reproj_error, 0);
   CHECK_OPTION_GE(complete_max_transitivity, 0);
+  CHECK_OPTION_GE(guided_min_num_observations, 3);
+  CHECK_OPTION_GE(guided_num_seed_samples, 0);
+  CHECK_OPTION_GT(guided_max_num_trials, 0);
+  CHECK_OPTION_GE(refine_min_num_observations, 3);
   CHECK_OPTION_GT(re_max_angle_error, 0);
   CHECK_OPTION_GE(re_min_ratio, 0);
   CHECK_OPTION_LE(re_min_ratio, 1);
@@ -101,9 +105,7 @@ size_t IncrementalTriangulator::TriangulateImage(const Options& options,
 
 
 
-    const FeatureLine& line = image.Line(line_idx);
     ref_corr_data.line_idx = line_idx;
-    ref_corr_data.line = &line;
 
     if (num_triangulated == 0) {
       corrs_data.push_back(ref_corr_data);
@@ -147,6 +149,10 @@ size_t IncrementalTriangulator::CompleteImage(const Options& options,
   tri_options.ransac_options.confidence = 0.9999;
   tri_options.ransac_options.min_inlier_ratio = 0.02;
   tri_options.ransac_options.max_num_trials = 10000;
+  tri_options.guided_min_num_observations = options.guided_min_num_observations;
+  tri_options.guided_num_seed_samples = options.guided_num_seed_samples;
+  tri_options.guided_max_num_trials = options.guided_max_num_trials;
+  tri_options.refine_min_num_observations = options.refine_min_num_observations;
 
   // Correspondence data for reference observation in given image. We iterate
   // over all observations of the image and each observation once becomes
@@ -161,10 +167,9 @@ size_t IncrementalTriangulator::CompleteImage(const Options& options,
 
   for (point2D_t line_idx = 0; line_idx < image.NumLines();
        ++line_idx) {
-    const FeatureLine& line = image.Line(line_idx);
-    if (line.HasPoint3D()) {
+    if (image.Lines().HasPoint3D(line_idx)) {
       // Complete existing track.
-      num_tris += Complete(options, line.Point3DId());
+      num_tris += Complete(options, image.Lines().Point3DId(line_idx));
       continue;
     }
 
@@ -180,7 +185,6 @@ size_t IncrementalTriangulator::CompleteImage(const Options& options,
       continue;
     }
 
-    ref_corr_data.line = &line;
     ref_corr_data.line_idx = line_idx;
     corrs_data.push_back(ref_corr_data);
 
@@ -195,7 +199,7 @@ size_t IncrementalTriangulator::CompleteImage(const Options& options,
       //point_data[i].point_normalized =
       //    corr_data.camera->ImageToWorld(point_data[i].point);
       // TODO: I broke it here
-      point_data[i].line = corr_data.image->Line(corr_data.line_idx).Line();
+      point_data[i].line = corr_data.image->Lines().Line(corr_data.line_idx);
       pose_data[i].proj_matrix = corr_data.image->ProjectionMatrix();
       pose_data[i].proj_center = corr_data.image->ProjectionCenter();
       pose_data[i].camera = corr_data.camera;
@@ -453,11 +457,10 @@ size_t IncrementalTriangulator::Find(const Options& options,
     corr_data.line_idx = corr.line_idx;
     corr_data.image = &corr_image;
     corr_data.camera = &corr_camera;
-    corr_data.line = &corr_image.Line(corr.line_idx);
 
     corrs_data->push_back(corr_data);
 
-    if (corr_data.line->HasPoint3D()) {
+    if (corr_data.image->Lines().HasPoint3D(corr_data.line_idx)) {
       num_triangulated += 1;
     }
   }
@@ -471,7 +474,7 @@ size_t IncrementalTriangulator::Create(
   std::vector<CorrData> create_corrs_data;
   create_corrs_data.reserve(corrs_data.size());
   for (const CorrData& corr_data : corrs_data) {
-    if (!corr_data.line->HasPoint3D()) {
+    if (!corr_data.image->Lines().HasPoint3D(corr_data.line_idx)) {
       create_corrs_data.push_back(corr_data);
     }
   }
@@ -497,9 +500,9 @@ size_t IncrementalTriangulator::Create(
   for (size_t i = 0; i < create_corrs_data.size(); ++i) {
     const CorrData& corr_data = create_corrs_data[i];    
 
-    point_data[i].line = corr_data.image->Line(corr_data.line_idx).Line();
+    point_data[i].line = corr_data.image->Lines().Line(corr_data.line_idx);
 
-    if (!corr_data.image->Line(corr_data.line_idx).IsAligned()) {
+    if (!corr_data.image->Lines().IsAligned(corr_data.line_idx)) {
       num_random_lines += 1;
     }
         
@@ -523,6 +526,10 @@ size_t IncrementalTriangulator::Create(
   tri_options.ransac_options.confidence = 0.9999;
   tri_options.ransac_options.min_inlier_ratio = 0.02;
   tri_options.ransac_options.max_num_trials = 10000;
+  tri_options.guided_min_num_observations = options.guided_min_num_observations;
+  tri_options.guided_num_seed_samples = options.guided_num_seed_samples;
+  tri_options.guided_max_num_trials = options.guided_max_num_trials;
+  tri_options.refine_min_num_observations = options.refine_min_num_observations;
 
   // Enforce exhaustive sampling for small track lengths.
   const size_t kExhaustiveSamplingThreshold = 15;
@@ -564,7 +571,7 @@ size_t IncrementalTriangulator::Continue(
     const Options& options, const CorrData& ref_corr_data,
     const std::vector<CorrData>& corrs_data) {
   // No need to continue, if the reference observation is triangulated.
-  if (ref_corr_data.line->HasPoint3D()) {
+  if (ref_corr_data.image->Lines().HasPoint3D(ref_corr_data.line_idx)) {
     return 0;
   }
 
@@ -573,16 +580,17 @@ size_t IncrementalTriangulator::Continue(
 
   for (size_t idx = 0; idx < corrs_data.size(); ++idx) {
     const CorrData& corr_data = corrs_data[idx];
-    if (!corr_data.line->HasPoint3D()) {
+    if (!corr_data.image->Lines().HasPoint3D(corr_data.line_idx)) {
       continue;
     }
 
-    const Point3D& point3D =
-        reconstruction_->Point3D(corr_data.line->Point3DId());
+    const Point3D& point3D = reconstruction_->Point3D(
+        corr_data.image->Lines().Point3DId(corr_data.line_idx));
 
     const double angle_error = CalculateNormalizedLineAngularError(
-        ref_corr_data.image->Line(ref_corr_data.line_idx).Line(), point3D.XYZ(), ref_corr_data.image->Qvec(),
-        ref_corr_data.image->Tvec(), *ref_corr_data.camera);
+        ref_corr_data.image->Lines().Line(ref_corr_data.line_idx),
+        point3D.XYZ(), ref_corr_data.image->Qvec(), ref_corr_data.image->Tvec(),
+        *ref_corr_data.camera);
     if (angle_error < best_angle_error) {
       best_angle_error = angle_error;
       best_idx = idx;
@@ -595,8 +603,17 @@ size_t IncrementalTriangulator::Continue(
     const CorrData& corr_data = corrs_data[best_idx];
     const TrackElement track_el(ref_corr_data.image_id,
                                 ref_corr_data.line_idx);
-    reconstruction_->AddObservation(corr_data.line->Point3DId(), track_el);
-    modified_point3D_ids_.insert(corr_data.line->Point3DId());
+    const point3D_t point3D_id =
+        corr_data.image->Lines().Point3DId(corr_data.line_idx);
+    reconstruction_->AddObservation(point3D_id, track_el);
+    modified_point3D_ids_.insert(point3D_id);
+
+    if (options.refine_extended_tracks) {
+      MultiViewTriangulationEquations equations;
+      AddTrackEquations(point3D_id, &equations);
+      Refine(options, point3D_id, equations);
+    }
+
     return 1;
   }
 
@@ -625,20 +642,20 @@ size_t IncrementalTriangulator::Merge(const Options& options,
         continue;
       }
 
-      const FeatureLine& corr_line = image.Line(corr.line_idx);
-      if (!corr_line.HasPoint3D() ||
-          corr_line.Point3DId() == point3D_id ||
-          merge_trials_[point3D_id].count(corr_line.Point3DId()) > 0) {
+      const point3D_t corr_point3D_id = image.Lines().Point3DId(corr.line_idx);
+      if (corr_point3D_id == kInvalidPoint3DId ||
+          corr_point3D_id == point3D_id ||
+          merge_trials_[point3D_id].count(corr_point3D_id) > 0) {
         continue;
       }
 
       // Try to merge the two 3D points.
 
       const Point3D& corr_point3D =
-          reconstruction_->Point3D(corr_line.Point3DId());
+          reconstruction_->Point3D(corr_point3D_id);
 
-      merge_trials_[point3D_id].insert(corr_line.Point3DId());
-      merge_trials_[corr_line.Point3DId()].insert(point3D_id);
+      merge_trials_[point3D_id].insert(corr_point3D_id);
+      merge_trials_[corr_point3D_id].insert(point3D_id);
 
       // Weighted average of point locations, depending on track length.
       const Eigen::Vector3d merged_xyz =
@@ -654,10 +671,10 @@ size_t IncrementalTriangulator::Merge(const Options& options,
               reconstruction_->Image(test_track_el.image_id);
           const Camera& test_camera =
               reconstruction_->Camera(test_image.CameraId());
-          const FeatureLine test_line2D =
-                  test_image.Line(test_track_el.line_idx);
+          const Eigen::Vector3d& test_line2D =
+              test_image.Lines().Line(test_track_el.line_idx);
           if (CalculateSquaredLineReprojectionError(
-                  test_line2D.Line(), merged_xyz, test_image.Qvec(),
+                  test_line2D, merged_xyz, test_image.Qvec(),
                   test_image.Tvec(), test_camera) > max_squared_reproj_error) {
             merge_success = false;
             break;
@@ -674,10 +691,10 @@ size_t IncrementalTriangulator::Merge(const Options& options,
             point3D.Track().Length() + corr_point3D.Track().Length();
 
         const point3D_t merged_point3D_id = reconstruction_->MergePoints3D(
-            point3D_id, corr_line.Point3DId());
+            point3D_id, corr_point3D_id);
 
         modified_point3D_ids_.erase(point3D_id);
-        modified_point3D_ids_.erase(corr_line.Point3DId());
+        modified_point3D_ids_.erase(corr_point3D_id);
         modified_point3D_ids_.insert(merged_point3D_id);
 
         // Merge merged 3D point and return, as the original points are deleted.
@@ -709,6 +726,13 @@ size_t IncrementalTriangulator::Complete(const Options& options,
 
   std::vector<TrackElement> queue = point3D.Track().Elements();
 
+  // Normal equations of the track, which are updated with every completed
+  // observation, so that the point can be refined at the end.
+  MultiViewTriangulationEquations equations;
+  if (options.refine_extended_tracks) {
+    AddTrackEquations(point3D_id, &equations);
+  }
+
   const int max_transitivity = options.complete_max_transitivity;
   for (int transitivity = 0; transitivity < max_transitivity; ++transitivity) {
     if (queue.empty()) {
@@ -729,12 +753,11 @@ size_t IncrementalTriangulator::Complete(const Options& options,
           continue;
         }
 
-        const FeatureLine& line = image.Line(corr.line_idx);
-        const Eigen::Vector3d& line2D = image.Line(corr.line_idx).Line();
-        if (line.HasPoint3D()) {
+        if (image.Lines().HasPoint3D(corr.line_idx)) {
           continue;
         }
 
+        const Eigen::Vector3d& line2D = image.Lines().Line(corr.line_idx);
         const Camera& camera = reconstruction_->Camera(image.CameraId());
         if (HasCameraBogusParams(options, camera)) {
           continue;
@@ -751,6 +774,10 @@ size_t IncrementalTriangulator::Complete(const Options& options,
         reconstruction_->AddObservation(point3D_id, track_el);
         modified_point3D_ids_.insert(point3D_id);
 
+        if (options.refine_extended_tracks) {
+          equations.Add(image.ProjectionMatrix(), line2D);
+        }
+
         // Recursively complete track for this new correspondence.
         if (transitivity < max_transitivity - 1) {
           queue.emplace_back(corr.image_id, corr.line_idx);
@@ -761,9 +788,54 @@ size_t IncrementalTriangulator::Complete(const Options& options,
     }
   }
 
+  if (options.refine_extended_tracks && num_completed > 0) {
+    Refine(options, point3D_id, equations);
+  }
+
   return num_completed;
 }
 
+void IncrementalTriangulator::AddTrackEquations(
+    const point3D_t point3D_id,
+    MultiViewTriangulationEquations* equations) const {
+  const Point3D& point3D = reconstruction_->Point3D(point3D_id);
+  for (const auto& track_el : point3D.Track().Elements()) {
+    const Image& image = reconstruction_->Image(track_el.image_id);
+    equations->Add(image.ProjectionMatrix(),
+                   image.Lines().Line(track_el.line_idx));
+  }
+}
+
+bool IncrementalTriangulator::Refine(
+    const Options& options, const point3D_t point3D_id,
+    const MultiViewTriangulationEquations& equations) {
+  if (equations.NumObservations() < 3) {
+    return false;
+  }
+
+  const Eigen::Vector3d xyz = equations.Solve();
+
+  const double max_squared_reproj_error =
+      options.complete_max_reproj_error * options.complete_max_reproj_error;
+
+  Point3D& point3D = reconstruction_->Point3D(point3D_id);
+  for (const auto& track_el : point3D.Track().Elements()) {
+    const Image& image = reconstruction_->Image(track_el.image_id);
+    const Camera& camera = reconstruction_->Camera(image.CameraId());
+    const Eigen::Matrix3x4d proj_matrix = image.ProjectionMatrix();
+    if (!HasPointPositiveDepth(proj_matrix, xyz) ||
+        CalculateSquaredLineReprojectionError(
+            image.Lines().Line(track_el.line_idx), xyz, proj_matrix, camera) >
+            max_squared_reproj_error) {
+      return false;
+    }
+  }
+
+  point3D.SetXYZ(xyz);
+
+  return true;
+}
+
 bool IncrementalTriangulator::HasCameraBogusParams(const Options& options,
                                                    const Camera& camera) {
   const auto it = camera_has_bogus_params_.find(camera.CameraId());
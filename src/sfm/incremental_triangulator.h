@@ -36,6 +36,7 @@
 
 #include "base/database_cache.h"
 #include "base/reconstruction.h"
+#include "base/triangulation.h"
 #include "util/alignment.h"
 
 namespace colmap {
@@ -63,6 +64,25 @@ class IncrementalTriangulator {
     // Maximum transitivity for track completion.
     int complete_max_transitivity = 5;
 
+    // Whether to re-estimate the position of a 3D point from the accumulated
+    // normal equations of its track after continuing or completing it. The
+    // new position is only kept if all observations of the track have a
+    // reprojection error below `complete_max_reproj_error`.
+    bool refine_extended_tracks = false;
+
+    // Minimum track length for which the triangulation RANSAC is seeded with
+    // the view triplets with the widest triangulation angles.
+    int guided_min_num_observations = 15;
+
+    // Number of view triplets to seed the guided RANSAC with.
+    int guided_num_seed_samples = 10;
+
+    // Maximum number of RANSAC trials for guided sampling.
+    int guided_max_num_trials = 100;
+
+    // Minimum number of inliers to refine a new triangulation non-linearly.
+    int refine_min_num_observations = 15;
+
     // Maximum angular error to re-triangulate under-reconstructed image pairs.
     double re_max_angle_error = 5.0;
 
@@ -155,7 +175,6 @@ class IncrementalTriangulator {
     point2D_t line_idx;
     const Image* image;
     const Camera* camera;
-    const FeatureLine* line;
   };
 
  private:
@@ -181,6 +200,15 @@ class IncrementalTriangulator {
   // Try to transitively complete the track of a 3D point.
   size_t Complete(const Options& options, const point3D_t point3D_id);
 
+  // Accumulate the triangulation equations of all observations of the track.
+  void AddTrackEquations(const point3D_t point3D_id,
+                         MultiViewTriangulationEquations* equations) const;
+
+  // Re-estimate the 3D point from the triangulation equations of its track.
+  // Returns whether the refined position was accepted.
+  bool Refine(const Options& options, const point3D_t point3D_id,
+              const MultiViewTriangulationEquations& equations);
+
   // Check if camera has bogus parameters and cache the result.
   bool HasCameraBogusParams(const Options& options, const Camera& camera);
 
@@ -0,0 +1,312 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "sfm/localizer.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "FLANN/flann.hpp"
+#include "estimators/pose.h"
+#include "util/misc.h"
+#include "util/timer.h"
+
+namespace colmap {
+namespace {
+
+// Number of nearest neighbors to search for every query descriptor. More than
+// two neighbors are needed, since the index may contain several descriptors
+// of the same 3D point.
+const size_t kNumNearestNeighbors = 4;
+
+// SIFT descriptor vectors are normalized to length 512.
+const float kDistNorm = 1.0f / (512.0f * 512.0f);
+
+float ComputeDescriptorDistance(const FeatureDescriptors& descriptors1,
+                                const Eigen::Index idx1,
+                                const FeatureDescriptors& descriptors2,
+                                const Eigen::Index idx2) {
+  const int dot = descriptors1.row(idx1).cast<int>().dot(
+      descriptors2.row(idx2).cast<int>());
+  return std::acos(std::min(kDistNorm * dot, 1.0f));
+}
+
+}  // namespace
+
+bool Localizer::Options::Check() const {
+  CHECK_OPTION_GT(max_ratio, 0.0);
+  CHECK_OPTION_GT(max_distance, 0.0);
+  CHECK_OPTION_GT(num_index_trees, 0);
+  CHECK_OPTION_GT(num_index_checks, 0);
+  CHECK_OPTION_GT(abs_pose_max_error, 0.0);
+  CHECK_OPTION_GE(abs_pose_min_num_inliers, 0);
+  CHECK_OPTION_GE(abs_pose_min_inlier_ratio, 0.0);
+  CHECK_OPTION_LE(abs_pose_min_inlier_ratio, 1.0);
+  CHECK_OPTION_GT(abs_pose_max_num_trials, 0);
+  return true;
+}
+
+Localizer::Localizer(const Options& options,
+                     const Reconstruction* reconstruction,
+                     const Database& database)
+    : options_(options), reconstruction_(reconstruction) {
+  CHECK(options_.Check());
+  CHECK_NOTNULL(reconstruction_);
+
+  // Group the indexed observations by image, so that the descriptors of every
+  // image are only read once.
+  std::unordered_map<image_t, std::vector<std::pair<point2D_t, point3D_t>>>
+      image_observations;
+  size_t num_observations = 0;
+  for (const auto& point3D : reconstruction_->Points3D()) {
+    for (const auto& track_el : point3D.second.Track().Elements()) {
+      image_observations[track_el.image_id].emplace_back(track_el.line_idx,
+                                                         point3D.first);
+      num_observations += 1;
+      if (!options_.index_all_observations) {
+        break;
+      }
+    }
+  }
+
+  index_descriptors_.resize(num_observations, 128);
+  index_point3D_ids_.reserve(num_observations);
+  for (const auto& observations : image_observations) {
+    const FeatureDescriptors descriptors =
+        database.ReadDescriptors(observations.first);
+    for (const auto& observation : observations.second) {
+      CHECK_LT(observation.first, descriptors.rows());
+      index_descriptors_.row(index_point3D_ids_.size()) =
+          descriptors.row(observation.first);
+      index_point3D_ids_.push_back(observation.second);
+    }
+  }
+
+  if (index_descriptors_.rows() == 0) {
+    return;
+  }
+
+  const flann::Matrix<uint8_t> index_matrix(index_descriptors_.data(),
+                                            index_descriptors_.rows(), 128);
+  index_.reset(new flann::Index<flann::L2<uint8_t>>(
+      index_matrix, flann::KDTreeIndexParams(options_.num_index_trees)));
+  index_->buildIndex();
+}
+
+Localizer::~Localizer() {}
+
+size_t Localizer::NumIndexedDescriptors() const {
+  return index_point3D_ids_.size();
+}
+
+std::vector<Localizer::QueryResult> Localizer::LocalizeQueryDatabase(
+    const std::string& path, const DatabaseOptions& database_options) const {
+  // The line tables must be opened as well, since the lines are read.
+  Database database(path, true, database_options);
+
+  const std::vector<Image> images = database.ReadAllImages();
+
+  std::vector<QueryResult> query_results(images.size());
+  for (size_t i = 0; i < images.size(); ++i) {
+    Timer timer;
+    timer.Start();
+
+    const Image& image = images[i];
+    const Camera camera = database.ReadCamera(image.CameraId());
+    const FeatureLines lines = database.ReadFeatureLines(image.ImageId());
+    const FeatureDescriptors descriptors =
+        database.ReadDescriptors(image.ImageId());
+
+    QueryResult& query_result = query_results[i];
+    query_result.image_name = image.Name();
+    query_result.success =
+        lines.size() == static_cast<size_t>(descriptors.rows()) &&
+        Localize(camera, lines, descriptors, &query_result.result);
+    query_result.seconds = timer.ElapsedSeconds();
+  }
+
+  return query_results;
+}
+
+bool Localizer::Localize(const Camera& camera, const FeatureLines& lines,
+                         const FeatureDescriptors& descriptors,
+                         Result* result) const {
+  CHECK_NOTNULL(result);
+  CHECK_EQ(static_cast<Eigen::Index>(lines.size()), descriptors.rows());
+
+  *result = Result();
+
+  Timer timer;
+  timer.Start();
+
+  std::vector<std::pair<point2D_t, point3D_t>> matches;
+  MatchDescriptors(descriptors, &matches);
+
+  result->num_matches = matches.size();
+  result->matching_seconds = timer.ElapsedSeconds();
+
+  if (matches.size() <
+      static_cast<size_t>(std::max(options_.abs_pose_min_num_inliers, 3))) {
+    return false;
+  }
+
+  timer.Restart();
+
+  FeatureLines match_lines;
+  std::vector<Eigen::Vector3d> match_line_params;
+  std::vector<Eigen::Vector3d> match_points3D;
+  match_lines.reserve(matches.size());
+  match_line_params.reserve(matches.size());
+  match_points3D.reserve(matches.size());
+  for (const auto& match : matches) {
+    match_lines.push_back(lines[match.first]);
+    match_line_params.push_back(lines[match.first].Line());
+    match_points3D.push_back(reconstruction_->Point3D(match.second).XYZ());
+  }
+
+  RANSACOptions ransac_options;
+  ransac_options.max_error =
+      camera.ImageToWorldThreshold(options_.abs_pose_max_error);
+  ransac_options.min_inlier_ratio = options_.abs_pose_min_inlier_ratio;
+  ransac_options.max_num_trials = options_.abs_pose_max_num_trials;
+  ransac_options.confidence = 0.99999;
+
+  std::vector<char> inlier_mask;
+  if (!EstimateAbsolutePoseFromLines(ransac_options, match_lines,
+                                     match_points3D, &result->qvec,
+                                     &result->tvec, &result->num_inliers,
+                                     &inlier_mask)) {
+    result->estimation_seconds = timer.ElapsedSeconds();
+    return false;
+  }
+
+  if (result->num_inliers <
+      static_cast<size_t>(options_.abs_pose_min_num_inliers)) {
+    result->estimation_seconds = timer.ElapsedSeconds();
+    return false;
+  }
+
+  AbsolutePoseRefinementOptions refinement_options;
+  refinement_options.refine_focal_length = false;
+  refinement_options.refine_extra_params = false;
+  refinement_options.print_summary = false;
+
+  Camera refined_camera = camera;
+  const bool success = RefineAbsolutePoseFromLines(
+      refinement_options, inlier_mask, match_line_params, match_points3D,
+      &result->qvec, &result->tvec, &refined_camera);
+
+  result->estimation_seconds = timer.ElapsedSeconds();
+
+  return success;
+}
+
+void Localizer::MatchDescriptors(
+    const FeatureDescriptors& descriptors,
+    std::vector<std::pair<point2D_t, point3D_t>>* matches) const {
+  matches->clear();
+
+  if (!index_ || descriptors.rows() == 0) {
+    return;
+  }
+
+  CHECK_EQ(descriptors.cols(), 128);
+
+  const size_t num_neighbors =
+      std::min(kNumNearestNeighbors, index_point3D_ids_.size());
+
+  Eigen::Matrix<int, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> indices(
+      descriptors.rows(), num_neighbors);
+  std::vector<float> distances_vector(descriptors.rows() * num_neighbors);
+
+  const flann::Matrix<uint8_t> query_matrix(
+      const_cast<uint8_t*>(descriptors.data()), descriptors.rows(), 128);
+  flann::Matrix<int> indices_matrix(indices.data(), descriptors.rows(),
+                                    num_neighbors);
+  flann::Matrix<float> distances_matrix(distances_vector.data(),
+                                        descriptors.rows(), num_neighbors);
+  index_->knnSearch(query_matrix, indices_matrix, distances_matrix,
+                    num_neighbors,
+                    flann::SearchParams(options_.num_index_checks));
+
+  // Best match of every 3D point, so that every 3D point is only matched to
+  // one query line.
+  std::unordered_map<point3D_t, std::pair<point2D_t, float>> best_matches;
+
+  for (Eigen::Index line_idx = 0; line_idx < descriptors.rows(); ++line_idx) {
+    // The neighbors are sorted by increasing distance.
+    const int best_idx = indices(line_idx, 0);
+    if (best_idx < 0) {
+      continue;
+    }
+
+    const point3D_t point3D_id = index_point3D_ids_[best_idx];
+    const float best_dist = ComputeDescriptorDistance(
+        descriptors, line_idx, index_descriptors_, best_idx);
+    if (best_dist > options_.max_distance) {
+      continue;
+    }
+
+    // Ratio test against the best match to a different 3D point.
+    bool passes_ratio_test = true;
+    for (size_t k = 1; k < num_neighbors; ++k) {
+      const int idx = indices(line_idx, k);
+      if (idx < 0 || index_point3D_ids_[idx] == point3D_id) {
+        continue;
+      }
+      const float second_best_dist = ComputeDescriptorDistance(
+          descriptors, line_idx, index_descriptors_, idx);
+      passes_ratio_test = best_dist < options_.max_ratio * second_best_dist;
+      break;
+    }
+
+    if (!passes_ratio_test) {
+      continue;
+    }
+
+    const auto it = best_matches.find(point3D_id);
+    if (it == best_matches.end()) {
+      best_matches.emplace(
+          point3D_id,
+          std::make_pair(static_cast<point2D_t>(line_idx), best_dist));
+    } else if (best_dist < it->second.second) {
+      it->second = std::make_pair(static_cast<point2D_t>(line_idx), best_dist);
+    }
+  }
+
+  matches->reserve(best_matches.size());
+  for (const auto& best_match : best_matches) {
+    matches->emplace_back(best_match.second.first, best_match.first);
+  }
+
+  // Sort the matches for deterministic results.
+  std::sort(matches->begin(), matches->end());
+}
+
+}  // namespace colmap
@@ -0,0 +1,165 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef COLMAP_SRC_SFM_LOCALIZER_H_
+#define COLMAP_SRC_SFM_LOCALIZER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "base/camera.h"
+#include "base/database.h"
+#include "base/pose.h"
+#include "base/reconstruction.h"
+#include "feature/types.h"
+#include "util/alignment.h"
+#include "util/types.h"
+
+namespace flann {
+template <class T>
+struct L2;
+template <typename Distance>
+class Index;
+}  // namespace flann
+
+namespace colmap {
+
+// Registers query images against a fixed reconstruction without touching the
+// correspondence graph. The descriptors of the observations of the 3D points
+// are kept in a search index, such that the 2D-3D correspondences of a query
+// are found by direct descriptor matching.
+class Localizer {
+ public:
+  struct Options {
+    // Maximum distance ratio between the best match and the best match to a
+    // different 3D point.
+    double max_ratio = 0.8;
+
+    // Maximum distance to the best match.
+    double max_distance = 0.7;
+
+    // Whether to index the descriptors of all observations of a 3D point or
+    // only the descriptor of its first observation.
+    bool index_all_observations = true;
+
+    // Number of randomized kd-trees of the descriptor index.
+    int num_index_trees = 4;
+
+    // Number of leaves to visit during the descriptor search.
+    int num_index_checks = 128;
+
+    // Maximum reprojection error in pixels for absolute pose estimation.
+    double abs_pose_max_error = 12.0;
+
+    // Minimum number of inliers for absolute pose estimation.
+    int abs_pose_min_num_inliers = 30;
+
+    // Minimum inlier ratio for absolute pose estimation.
+    double abs_pose_min_inlier_ratio = 0.25;
+
+    // Maximum number of RANSAC trials for absolute pose estimation.
+    int abs_pose_max_num_trials = 10000;
+
+    bool Check() const;
+  };
+
+  struct Result {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    // Estimated pose of the query image.
+    Eigen::Vector4d qvec = ComposeIdentityQuaternion();
+    Eigen::Vector3d tvec = Eigen::Vector3d::Zero();
+
+    // Number of 2D-3D correspondences and of their inliers.
+    size_t num_matches = 0;
+    size_t num_inliers = 0;
+
+    // Time spent in descriptor matching and pose estimation.
+    double matching_seconds = 0.0;
+    double estimation_seconds = 0.0;
+  };
+
+  struct QueryResult {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    std::string image_name;
+
+    // Whether the query image was localized.
+    bool success = false;
+    Result result;
+
+    // Time spent reading and localizing the query image.
+    double seconds = 0.0;
+  };
+
+  // Build the descriptor index of all 3D points of the reconstruction, whose
+  // descriptors are read from the database. Note that the reconstruction must
+  // live as long as the localizer and must not be modified.
+  Localizer(const Options& options, const Reconstruction* reconstruction,
+            const Database& database);
+  ~Localizer();
+
+  size_t NumIndexedDescriptors() const;
+
+  // Estimate the pose of a query image from its lines in normalized
+  // coordinates and their descriptors. Returns false if no pose with
+  // sufficient support was found.
+  bool Localize(const Camera& camera, const FeatureLines& lines,
+                const FeatureDescriptors& descriptors, Result* result) const;
+
+  // Localize all images of the query database at the given path, which holds
+  // their cameras, lines, and descriptors. The results are in the order of
+  // the images in the database.
+  std::vector<QueryResult> LocalizeQueryDatabase(
+      const std::string& path, const DatabaseOptions& database_options) const;
+
+ private:
+  // Match the query descriptors against the index and return the unique
+  // correspondences between query lines and 3D points.
+  void MatchDescriptors(
+      const FeatureDescriptors& descriptors,
+      std::vector<std::pair<point2D_t, point3D_t>>* matches) const;
+
+  const Options options_;
+  const Reconstruction* reconstruction_;
+
+  // Indexed descriptors and the 3D points they belong to.
+  FeatureDescriptors index_descriptors_;
+  std::vector<point3D_t> index_point3D_ids_;
+  std::unique_ptr<flann::Index<flann::L2<uint8_t>>> index_;
+};
+
+}  // namespace colmap
+
+EIGEN_DEFINE_STL_VECTOR_SPECIALIZATION_CUSTOM(colmap::Localizer::QueryResult)
+
+#endif  // COLMAP_SRC_SFM_LOCALIZER_H_
@@ -0,0 +1,128 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#define TEST_NAME "sfm/localizer"
+#include "util/testing.h"
+
+#include <random>
+
+#include <boost/filesystem.hpp>
+
+#include "base/synthetic.h"
+#include "sfm/localizer.h"
+
+using namespace colmap;
+
+namespace {
+
+// Write a descriptor for every line of the synthetic dataset, where all
+// observations of a 3D point share the same random descriptor, normalized to
+// the length of SIFT descriptors.
+void WriteSyntheticDescriptors(const Reconstruction& reconstruction,
+                               Database* database) {
+  std::unordered_map<image_t, FeatureDescriptors> descriptors;
+  for (const auto& image : reconstruction.Images()) {
+    descriptors[image.first] =
+        FeatureDescriptors::Zero(image.second.NumLines(), 128);
+  }
+
+  for (const auto& point3D : reconstruction.Points3D()) {
+    std::mt19937 random_engine(point3D.first);
+    std::normal_distribution<float> distribution;
+    Eigen::VectorXf descriptor(128);
+    for (int i = 0; i < descriptor.size(); ++i) {
+      descriptor(i) = std::abs(distribution(random_engine));
+    }
+    descriptor *= 512.0f / descriptor.norm();
+    for (const auto& track_el : point3D.second.Track().Elements()) {
+      descriptors.at(track_el.image_id).row(track_el.line_idx) =
+          descriptor.array().round().cast<uint8_t>().transpose();
+    }
+  }
+
+  for (const auto& image_descriptors : descriptors) {
+    database->WriteDescriptors(image_descriptors.first,
+                               image_descriptors.second);
+  }
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(TestLocalizeQueryDatabase) {
+  SyntheticDatasetOptions synthetic_options;
+  synthetic_options.num_images = 10;
+  synthetic_options.num_points3D = 1000;
+  synthetic_options.point2D_stddev = 0;
+  synthetic_options.gravity_stddev = 0;
+  synthetic_options.outlier_match_ratio = 0;
+
+  Database database(":memory:", true);
+  Reconstruction reconstruction;
+  SynthesizeDataset(synthetic_options, &database, &reconstruction);
+  WriteSyntheticDescriptors(reconstruction, &database);
+
+  // The query database is synthesized with the same options, so that it
+  // contains the same images and their lines as seen by a client.
+  const std::string query_path =
+      (boost::filesystem::temp_directory_path() /
+       boost::filesystem::unique_path("%%%%-%%%%-%%%%.db"))
+          .string();
+  Reconstruction query_reconstruction;
+  {
+    Database query_database(query_path, true);
+    SynthesizeDataset(synthetic_options, &query_database,
+                      &query_reconstruction);
+    WriteSyntheticDescriptors(query_reconstruction, &query_database);
+  }
+
+  const Localizer localizer(Localizer::Options(), &reconstruction, database);
+  BOOST_CHECK_GT(localizer.NumIndexedDescriptors(), 0);
+
+  const std::vector<Localizer::QueryResult> query_results =
+      localizer.LocalizeQueryDatabase(query_path, DatabaseOptions());
+  boost::filesystem::remove(query_path);
+
+  std::unordered_map<std::string, const Image*> images;
+  for (const auto& image : reconstruction.Images()) {
+    images.emplace(image.second.Name(), &image.second);
+  }
+
+  BOOST_CHECK_EQUAL(query_results.size(), synthetic_options.num_images);
+  for (const auto& query_result : query_results) {
+    BOOST_REQUIRE_EQUAL(images.count(query_result.image_name), 1);
+    const Image* image = images.at(query_result.image_name);
+    BOOST_CHECK(query_result.success);
+    BOOST_CHECK_GE(query_result.result.num_inliers,
+                   query_result.result.num_matches / 2);
+    BOOST_CHECK_SMALL(
+        (query_result.result.tvec - image->Tvec()).norm(), 0.05);
+    BOOST_CHECK_SMALL(
+        std::abs(query_result.result.qvec.dot(image->Qvec())) - 1, 1e-3);
+  }
+}
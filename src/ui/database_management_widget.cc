@@ -719,7 +719,7 @@ DatabaseManagementWidget::DatabaseManagementWidget(QWidget* parent,
 void DatabaseManagementWidget::showEvent(QShowEvent*) {
   parent_->setDisabled(true);
 
-  database_.Open(*options_->database_path, true);
+  database_.Open(*options_->database_path, true, *options_->database);
 
   image_tab_->Reload();
   camera_tab_->Reload();
@@ -92,6 +92,8 @@ SIFTExtractionWidget::SIFTExtractionWidget(QWidget* parent,
   AddOptionDouble(&options->sift_extraction->dsp_max_scale, "dsp_max_scale",
                   0.0, 1e7, 0.00001, 5);
   AddOptionInt(&options->sift_extraction->dsp_num_scales, "dsp_num_scales", 1);
+  AddOptionDouble(&options->sift_extraction->aligned_line_ratio,
+                  "aligned_line_ratio", 0.0, 1.0);
 
   AddOptionInt(&options->sift_extraction->num_threads, "num_threads", -1);
   AddOptionBool(&options->sift_extraction->use_gpu, "use_gpu");
@@ -105,8 +107,8 @@ void SIFTExtractionWidget::Run() {
   reader_options.database_path = *options_->database_path;
   reader_options.image_path = *options_->image_path;
 
-  Thread* extractor =
-      new SiftFeatureExtractor(reader_options, *options_->sift_extraction);
+  Thread* extractor = new SiftFeatureExtractor(
+      reader_options, *options_->sift_extraction, *options_->database);
   thread_control_widget_->StartThread("Extracting...", true, extractor);
 }
 
@@ -141,9 +141,9 @@ ExhaustiveMatchingTab::ExhaustiveMatchingTab(QWidget* parent,
 void ExhaustiveMatchingTab::Run() {
   options_widget_->WriteOptions();
 
-  Thread* matcher = new ExhaustiveFeatureMatcher(*options_->exhaustive_matching,
-                                                 *options_->sift_matching,
-                                                 *options_->database_path);
+  Thread* matcher = new ExhaustiveFeatureMatcher(
+      *options_->exhaustive_matching, *options_->sift_matching,
+      *options_->database_path, *options_->database);
   thread_control_widget_->StartThread("Matching...", true, matcher);
 }
 
@@ -161,9 +161,9 @@ SequentialMatchingTab::SequentialMatchingTab(QWidget* parent,
 void SequentialMatchingTab::Run() {
   options_widget_->WriteOptions();
 
-  Thread* matcher = new SequentialFeatureMatcher(*options_->sequential_matching,
-                                                 *options_->sift_matching,
-                                                 *options_->database_path);
+  Thread* matcher = new SequentialFeatureMatcher(
+      *options_->sequential_matching, *options_->sift_matching,
+      *options_->database_path, *options_->database);
   thread_control_widget_->StartThread("Matching...", true, matcher);
 }
 
@@ -183,9 +183,9 @@ SpatialMatchingTab::SpatialMatchingTab(QWidget* parent, OptionManager* options)
 void SpatialMatchingTab::Run() {
   options_widget_->WriteOptions();
 
-  Thread* matcher = new SpatialFeatureMatcher(*options_->spatial_matching,
-                                              *options_->sift_matching,
-                                              *options_->database_path);
+  Thread* matcher = new SpatialFeatureMatcher(
+      *options_->spatial_matching, *options_->sift_matching,
+      *options_->database_path, *options_->database);
   thread_control_widget_->StartThread("Matching...", true, matcher);
 }
 
@@ -203,9 +203,9 @@ TransitiveMatchingTab::TransitiveMatchingTab(QWidget* parent,
 void TransitiveMatchingTab::Run() {
   options_widget_->WriteOptions();
 
-  Thread* matcher = new TransitiveFeatureMatcher(*options_->transitive_matching,
-                                                 *options_->sift_matching,
-                                                 *options_->database_path);
+  Thread* matcher = new TransitiveFeatureMatcher(
+      *options_->transitive_matching, *options_->sift_matching,
+      *options_->database_path, *options_->database);
   thread_control_widget_->StartThread("Matching...", true, matcher);
 }
 
@@ -235,7 +235,8 @@ void CustomMatchingTab::Run() {
     ImagePairsMatchingOptions matcher_options;
     matcher_options.match_list_path = match_list_path_;
     matcher = new ImagePairsFeatureMatcher(
-        matcher_options, *options_->sift_matching, *options_->database_path);
+        matcher_options, *options_->sift_matching, *options_->database_path,
+        *options_->database);
   } else {
     FeaturePairsMatchingOptions matcher_options;
     matcher_options.match_list_path = match_list_path_;
@@ -246,7 +247,8 @@ void CustomMatchingTab::Run() {
     }
 
     matcher = new FeaturePairsFeatureMatcher(
-        matcher_options, *options_->sift_matching, *options_->database_path);
+        matcher_options, *options_->sift_matching, *options_->database_path,
+        *options_->database);
   }
 
   thread_control_widget_->StartThread("Matching...", true, matcher);
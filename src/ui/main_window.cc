@@ -33,9 +33,20 @@
 
 #include "ui/main_window.h"
 
+#include <algorithm>
+
 #include "util/version.h"
 
 namespace colmap {
+namespace {
+
+// The interval of the render timer in milliseconds, where an interval of zero
+// would render continuously instead of at the maximum frame rate.
+int RenderTimerInterval(const RenderOptions& options) {
+  return std::max(1, static_cast<int>(1000 / options.max_frame_rate));
+}
+
+}  // namespace
 
 MainWindow::MainWindow(const OptionManager& options)
     : options_(options),
@@ -328,10 +339,6 @@ void MainWindow::CreateActions() {
   // Misc actions
   //////////////////////////////////////////////////////////////////////////////
 
-  action_render_ = new QAction(tr("Render"), this);
-  connect(action_render_, &QAction::triggered, this, &MainWindow::Render,
-          Qt::BlockingQueuedConnection);
-
   action_render_now_ = new QAction(tr("Render now"), this);
   render_options_widget_->action_render_now = action_render_now_;
   connect(action_render_now_, &QAction::triggered, this, &MainWindow::RenderNow,
@@ -463,6 +470,12 @@ void MainWindow::CreateStatusbar() {
   connect(statusbar_timer_, &QTimer::timeout, this, &MainWindow::UpdateTimer);
   statusbar_timer_->start(1000);
 
+  // The changes of the reconstruction are recorded by the mapper thread and
+  // rendered independently at the maximum frame rate.
+  render_timer_ = new QTimer(this);
+  connect(render_timer_, &QTimer::timeout, this, &MainWindow::Render);
+  render_timer_->start(RenderTimerInterval(*options_.render));
+
   model_viewer_widget_->statusbar_status_label =
       new QLabel("0 Images - 0 Points", this);
   model_viewer_widget_->statusbar_status_label->setFont(font);
@@ -478,7 +491,7 @@ void MainWindow::CreateControllers() {
 
   mapper_controller_.reset(new IncrementalMapperController(
       options_.mapper.get(), *options_.image_path, *options_.database_path,
-      &reconstruction_manager_));
+      &reconstruction_manager_, *options_.database));
   mapper_controller_->AddCallback(
       IncrementalMapperController::INITIAL_IMAGE_PAIR_REG_CALLBACK, [this]() {
         if (!mapper_controller_->IsStopped()) {
@@ -488,7 +501,8 @@ void MainWindow::CreateControllers() {
   mapper_controller_->AddCallback(
       IncrementalMapperController::NEXT_IMAGE_REG_CALLBACK, [this]() {
         if (!mapper_controller_->IsStopped()) {
-          action_render_->trigger();
+          model_viewer_widget_->RecordReconstructionChanges(
+              mapper_controller_->Changes());
         }
       });
   mapper_controller_->AddCallback(
@@ -870,29 +884,14 @@ void MainWindow::BundleAdjustment() {
 }
 
 void MainWindow::Render() {
-  if (reconstruction_manager_.Size() == 0) {
-    return;
-  }
+  // The frame rate may have changed in the render options.
+  render_timer_->setInterval(RenderTimerInterval(*options_.render));
 
-  const Reconstruction& reconstruction =
-      reconstruction_manager_.Get(SelectedReconstructionIdx());
-
-  int refresh_rate;
-  if (options_.render->adapt_refresh_rate) {
-    refresh_rate = static_cast<int>(reconstruction.NumRegImages() / 50 + 1);
-  } else {
-    refresh_rate = options_.render->refresh_rate;
-  }
-
-  if (!render_options_widget_->automatic_update ||
-      render_options_widget_->counter % refresh_rate != 0) {
-    render_options_widget_->counter += 1;
-    return;
+  // The reconstruction manager is not accessed here, since the mapper thread
+  // continues while the recorded changes are applied.
+  if (render_options_widget_->automatic_update) {
+    model_viewer_widget_->ApplyReconstructionChanges();
   }
-
-  render_options_widget_->counter += 1;
-
-  RenderNow();
 }
 
 void MainWindow::RenderNow() {
@@ -1061,13 +1060,11 @@ void MainWindow::Support() {
 void MainWindow::RenderToggle() {
   if (render_options_widget_->automatic_update) {
     render_options_widget_->automatic_update = false;
-    render_options_widget_->counter = 0;
     action_render_toggle_->setIcon(QIcon(":/media/render-disabled.png"));
     action_render_toggle_->setText(tr("Enable rendering"));
   } else {
     render_options_widget_->automatic_update = true;
-    render_options_widget_->counter = 0;
-    Render();
+    RenderNow();
     action_render_toggle_->setIcon(QIcon(":/media/render-enabled.png"));
     action_render_toggle_->setText(tr("Disable rendering"));
   }
@@ -169,6 +169,8 @@ class MainWindow : public QMainWindow {
   QTimer* statusbar_timer_;
   QLabel* statusbar_timer_label_;
 
+  QTimer* render_timer_;
+
   QAction* action_project_new_;
   QAction* action_project_open_;
   QAction* action_project_edit_;
@@ -195,7 +197,6 @@ class MainWindow : public QMainWindow {
 
   QAction* action_bundle_adjustment_;
 
-  QAction* action_render_;
   QAction* action_render_now_;
   QAction* action_render_toggle_;
   QAction* action_render_reset_view_;
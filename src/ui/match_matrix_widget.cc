@@ -41,7 +41,7 @@ MatchMatrixWidget::MatchMatrixWidget(QWidget* parent, OptionManager* options)
 }
 
 void MatchMatrixWidget::Show() {
-  Database database(*options_->database_path);
+  Database database(*options_->database_path, false, *options_->database);
 
   if (database.NumImages() == 0) {
     return;
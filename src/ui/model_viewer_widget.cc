@@ -36,7 +36,6 @@
 #include "ui/main_window.h"
 
 #define SELECTION_BUFFER_IMAGE_IDX 0
-#define SELECTION_BUFFER_POINT_IDX 1
 
 const Eigen::Vector4f kSelectedPointColor(0.0f, 1.0f, 0.0f, 1.0f);
 
@@ -60,6 +59,12 @@ inline size_t RGBToIndex(const uint8_t r, const uint8_t g, const uint8_t b) {
          static_cast<size_t>(b) * 65536;
 }
 
+// Convert color component in the range [0, 1] to a byte.
+inline uint8_t ColorToByte(const float color) {
+  return static_cast<uint8_t>(
+      std::round(255.0f * std::min(std::max(color, 0.0f), 1.0f)));
+}
+
 // Derive color from unique index, generated by `RGBToIndex`.
 inline Eigen::Vector4f IndexToRGB(const size_t index) {
   Eigen::Vector4f color;
@@ -261,8 +266,10 @@ void ModelViewerWidget::paintGL() {
     coordinate_grid_painter_.Render(pmvc_matrix, width(), height(), 1);
   }
 
-  // Points
-  point_painter_.Render(pmv_matrix, point_size_);
+  // Points, where the selected points are rendered first, so that they cover
+  // the same points in the octree.
+  selected_point_painter_.Render(pmv_matrix, point_size_);
+  point_painter_.Render(pmv_matrix, projection_matrix_, height(), point_size_);
   point_connection_painter_.Render(pmv_matrix, width(), height(), 1);
 
   // Images
@@ -287,6 +294,12 @@ void ModelViewerWidget::ReloadReconstruction() {
     return;
   }
 
+  // The reloaded data contains all previously recorded changes.
+  {
+    std::unique_lock<std::mutex> lock(recorded_changes_mutex_);
+    recorded_changes_ = RecordedChanges();
+  }
+
   cameras = reconstruction->Cameras();
   points3D = reconstruction->Points3D();
   reg_image_ids = reconstruction->RegImageIds();
@@ -296,14 +309,17 @@ void ModelViewerWidget::ReloadReconstruction() {
     images[image_id] = reconstruction->Image(image_id);
   }
 
-  statusbar_status_label->setText(QString().sprintf(
-      "%d Images - %d Points", static_cast<int>(reg_image_ids.size()),
-      static_cast<int>(points3D.size())));
+  UpdateStatusbar();
 
   Upload();
 }
 
 void ModelViewerWidget::ClearReconstruction() {
+  {
+    std::unique_lock<std::mutex> lock(recorded_changes_mutex_);
+    recorded_changes_ = RecordedChanges();
+  }
+
   cameras.clear();
   images.clear();
   points3D.clear();
@@ -312,6 +328,124 @@ void ModelViewerWidget::ClearReconstruction() {
   Upload();
 }
 
+void ModelViewerWidget::RecordReconstructionChanges(
+    const IncrementalMapperController::ReconstructionChanges& changes) {
+  const Reconstruction& changed_reconstruction =
+      *CHECK_NOTNULL(changes.reconstruction);
+
+  // Copy the changed data without holding the lock, so that the viewer is not
+  // blocked by copying the entire reconstruction.
+  RecordedChanges new_changes;
+  new_changes.reconstruction = changes.reconstruction;
+  new_changes.all_changed = changes.all_changed;
+  new_changes.reg_image_ids = changed_reconstruction.RegImageIds();
+
+  if (changes.all_changed) {
+    new_changes.cameras = changed_reconstruction.Cameras();
+    new_changes.points3D = changed_reconstruction.Points3D();
+    for (const image_t image_id : new_changes.reg_image_ids) {
+      new_changes.images[image_id] = changed_reconstruction.Image(image_id);
+    }
+  } else {
+    for (const image_t image_id : changes.image_ids) {
+      const Image& image = changed_reconstruction.Image(image_id);
+      if (image.IsRegistered()) {
+        new_changes.images[image_id] = image;
+        new_changes.cameras[image.CameraId()] =
+            changed_reconstruction.Camera(image.CameraId());
+      }
+    }
+    for (const point3D_t point3D_id : changes.point3D_ids) {
+      if (changed_reconstruction.ExistsPoint3D(point3D_id)) {
+        new_changes.points3D[point3D_id] =
+            changed_reconstruction.Point3D(point3D_id);
+      } else {
+        new_changes.deleted_point3D_ids.insert(point3D_id);
+      }
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(recorded_changes_mutex_);
+
+  if (new_changes.all_changed ||
+      recorded_changes_.reconstruction != new_changes.reconstruction) {
+    recorded_changes_ = std::move(new_changes);
+    return;
+  }
+
+  recorded_changes_.reg_image_ids = std::move(new_changes.reg_image_ids);
+  for (auto& camera : new_changes.cameras) {
+    recorded_changes_.cameras[camera.first] = std::move(camera.second);
+  }
+  for (auto& image : new_changes.images) {
+    recorded_changes_.images[image.first] = std::move(image.second);
+  }
+  for (auto& point3D : new_changes.points3D) {
+    recorded_changes_.deleted_point3D_ids.erase(point3D.first);
+    recorded_changes_.points3D[point3D.first] = std::move(point3D.second);
+  }
+  for (const point3D_t point3D_id : new_changes.deleted_point3D_ids) {
+    recorded_changes_.points3D.erase(point3D_id);
+    recorded_changes_.deleted_point3D_ids.insert(point3D_id);
+  }
+}
+
+bool ModelViewerWidget::ApplyReconstructionChanges() {
+  RecordedChanges changes;
+  {
+    std::unique_lock<std::mutex> lock(recorded_changes_mutex_);
+    std::swap(changes, recorded_changes_);
+  }
+
+  if (changes.reconstruction == nullptr ||
+      changes.reconstruction != reconstruction) {
+    return false;
+  }
+
+  reg_image_ids = std::move(changes.reg_image_ids);
+
+  if (changes.all_changed) {
+    cameras = std::move(changes.cameras);
+    images = std::move(changes.images);
+    points3D = std::move(changes.points3D);
+    UpdateStatusbar();
+    Upload();
+    return true;
+  }
+
+  for (auto& camera : changes.cameras) {
+    cameras[camera.first] = std::move(camera.second);
+  }
+  for (auto& image : changes.images) {
+    images[image.first] = std::move(image.second);
+  }
+
+  std::vector<point3D_t> changed_point3D_ids;
+  changed_point3D_ids.reserve(changes.points3D.size() +
+                              changes.deleted_point3D_ids.size());
+  for (auto& point3D : changes.points3D) {
+    changed_point3D_ids.push_back(point3D.first);
+    points3D[point3D.first] = std::move(point3D.second);
+  }
+  for (const point3D_t point3D_id : changes.deleted_point3D_ids) {
+    if (points3D.erase(point3D_id) > 0) {
+      changed_point3D_ids.push_back(point3D_id);
+    }
+  }
+
+  UpdateStatusbar();
+
+  // The colormaps are not prepared again, since the changes are small compared
+  // to the reconstruction.
+  UploadPointDataChanges(changed_point3D_ids);
+  UploadImageData();
+  UploadImageConnectionData();
+
+  update();
+
+  return true;
+}
+
 int ModelViewerWidget::GetProjectionType() const {
   return options_->render->projection_type;
 }
@@ -476,14 +610,15 @@ void ModelViewerWidget::SelectObject(const int x, const int y) {
   glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-  // Upload data in selection mode (one color per object).
+  // Upload data in selection mode (one color per object). The points are
+  // rendered with the index colors assigned when uploading them.
   UploadImageData(true);
-  UploadPointData(true);
 
   // Render in selection mode, with larger points to improve selection accuracy.
   const QMatrix4x4 pmv_matrix = projection_matrix_ * model_view_matrix_;
   image_triangle_painter_.Render(pmv_matrix);
-  point_painter_.Render(pmv_matrix, 2 * point_size_);
+  point_painter_.Render(pmv_matrix, projection_matrix_, height(),
+                        2 * point_size_, true);
 
   const int scaled_x = devicePixelRatio() * x;
   const int scaled_y = devicePixelRatio() * (height() - y - 1);
@@ -503,17 +638,21 @@ void ModelViewerWidget::SelectObject(const int x, const int y) {
   fbo.release();
 
   const size_t index = RGBToIndex(color[0], color[1], color[2]);
+  const size_t num_pickable_points = std::min(
+      point_painter_point3D_ids_.size(), OctreePointPainter::kMaxNumIndexColors);
 
-  if (index < selection_buffer_.size()) {
-    const char buffer_type = selection_buffer_[index].second;
+  if (index < num_pickable_points) {
+    selected_image_id_ = kInvalidImageId;
+    selected_point3D_id_ = point_painter_point3D_ids_[index];
+    ShowPointInfo(selected_point3D_id_);
+  } else if (index - num_pickable_points < selection_buffer_.size()) {
+    const size_t buffer_index = index - num_pickable_points;
+    const char buffer_type = selection_buffer_[buffer_index].second;
     if (buffer_type == SELECTION_BUFFER_IMAGE_IDX) {
-      selected_image_id_ = static_cast<image_t>(selection_buffer_[index].first);
+      selected_image_id_ =
+          static_cast<image_t>(selection_buffer_[buffer_index].first);
       selected_point3D_id_ = kInvalidPoint3DId;
       ShowImageInfo(selected_image_id_);
-    } else if (buffer_type == SELECTION_BUFFER_POINT_IDX) {
-      selected_image_id_ = kInvalidImageId;
-      selected_point3D_id_ = selection_buffer_[index].first;
-      ShowPointInfo(selection_buffer_[index].first);
     } else {
       selected_image_id_ = kInvalidImageId;
       selected_point3D_id_ = kInvalidPoint3DId;
@@ -530,7 +669,7 @@ void ModelViewerWidget::SelectObject(const int x, const int y) {
 
   selection_buffer_.clear();
 
-  UploadPointData();
+  UploadSelectedPointData();
   UploadImageData();
   UploadPointConnectionData();
   UploadImageConnectionData();
@@ -662,6 +801,7 @@ void ModelViewerWidget::SetupPainters() {
   coordinate_grid_painter_.Setup();
 
   point_painter_.Setup();
+  selected_point_painter_.Setup();
   point_connection_painter_.Setup();
 
   image_line_painter_.Setup();
@@ -689,6 +829,13 @@ void ModelViewerWidget::Upload() {
 
   ComposeProjectionMatrix();
 
+  // The points are filtered when rendering them and need not be uploaded
+  // again, when only the filter changes.
+  point_painter_.SetFilter(static_cast<float>(options_->render->max_error),
+                           static_cast<float>(options_->render->min_track_len));
+  point_painter_.SetMaxScreenSpaceError(
+      static_cast<float>(options_->render->max_screen_space_error));
+
   UploadPointData();
   UploadImageData();
   UploadMovieGrabberData();
@@ -753,85 +900,120 @@ void ModelViewerWidget::UploadCoordinateGridData() {
   coordinate_axes_painter_.Upload(axes_data);
 }
 
-void ModelViewerWidget::UploadPointData(const bool selection_mode) {
+void ModelViewerWidget::UploadPointData() {
   makeCurrent();
 
-  std::vector<PointPainter::Data> data;
-
-  // Assume we want to display the majority of points
+  std::vector<OctreePointPainter::Data> data;
   data.reserve(points3D.size());
 
-  const size_t min_track_len =
-      static_cast<size_t>(options_->render->min_track_len);
+  point_painter_point3D_ids_.clear();
+  point_painter_point3D_ids_.reserve(points3D.size());
+  point_painter_point3D_idxs_.clear();
+  point_painter_point3D_idxs_.reserve(points3D.size());
 
-  if (selected_image_id_ == kInvalidImageId &&
-      images.count(selected_image_id_) == 0) {
-    for (const auto& point3D : points3D) {
-      if (point3D.second.Error() <= options_->render->max_error &&
-          point3D.second.Track().Length() >= min_track_len) {
-        PointPainter::Data painter_point;
-
-        painter_point.x = static_cast<float>(point3D.second.XYZ(0));
-        painter_point.y = static_cast<float>(point3D.second.XYZ(1));
-        painter_point.z = static_cast<float>(point3D.second.XYZ(2));
-
-        Eigen::Vector4f color;
-        if (selection_mode) {
-          const size_t index = selection_buffer_.size();
-          selection_buffer_.push_back(
-              std::make_pair(point3D.first, SELECTION_BUFFER_POINT_IDX));
-          color = IndexToRGB(index);
-
-        } else if (point3D.first == selected_point3D_id_) {
-          color = kSelectedPointColor;
-        } else {
-          color = point_colormap_->ComputeColor(point3D.first, point3D.second);
-        }
+  // All points are uploaded, since they are filtered when rendering them.
+  for (const auto& point3D : points3D) {
+    point_painter_point3D_idxs_.emplace(point3D.first, data.size());
+    point_painter_point3D_ids_.push_back(point3D.first);
+    data.push_back(PointPainterData(point3D.first, point3D.second));
+  }
+
+  point_painter_.Upload(data);
+
+  UploadSelectedPointData();
+}
 
-        painter_point.r = color(0);
-        painter_point.g = color(1);
-        painter_point.b = color(2);
-        painter_point.a = color(3);
+void ModelViewerWidget::UploadPointDataChanges(
+    const std::vector<point3D_t>& point3D_ids) {
+  makeCurrent();
 
+  std::vector<size_t> point_idxs;
+  std::vector<OctreePointPainter::Data> data;
+  point_idxs.reserve(point3D_ids.size());
+  data.reserve(point3D_ids.size());
+
+  for (const point3D_t point3D_id : point3D_ids) {
+    const auto point3D = points3D.find(point3D_id);
+    const auto point_idx = point_painter_point3D_idxs_.find(point3D_id);
+    if (point3D == points3D.end()) {
+      // Hide the deleted points, which keep their picking index.
+      if (point_idx != point_painter_point3D_idxs_.end()) {
+        OctreePointPainter::Data painter_point;
+        painter_point.track_len = -1;
+        point_idxs.push_back(point_idx->second);
         data.push_back(painter_point);
       }
+    } else if (point_idx == point_painter_point3D_idxs_.end()) {
+      const size_t new_point_idx = point_painter_point3D_ids_.size();
+      point_painter_point3D_idxs_.emplace(point3D_id, new_point_idx);
+      point_painter_point3D_ids_.push_back(point3D_id);
+      point_idxs.push_back(new_point_idx);
+      data.push_back(PointPainterData(point3D_id, point3D->second));
+    } else {
+      point_idxs.push_back(point_idx->second);
+      data.push_back(PointPainterData(point3D_id, point3D->second));
     }
-  } else {  // Image selected
-    const auto& selected_image = images[selected_image_id_];
-    for (const auto& point3D : points3D) {
-      if (point3D.second.Error() <= options_->render->max_error &&
-          point3D.second.Track().Length() >= min_track_len) {
-        PointPainter::Data painter_point;
-
-        painter_point.x = static_cast<float>(point3D.second.XYZ(0));
-        painter_point.y = static_cast<float>(point3D.second.XYZ(1));
-        painter_point.z = static_cast<float>(point3D.second.XYZ(2));
-
-        Eigen::Vector4f color;
-        if (selection_mode) {
-          const size_t index = selection_buffer_.size();
-          selection_buffer_.push_back(
-              std::make_pair(point3D.first, SELECTION_BUFFER_POINT_IDX));
-          color = IndexToRGB(index);
-        } else if (selected_image.HasPoint3D(point3D.first)) {
-          color = kSelectedImagePlaneColor;
-        } else if (point3D.first == selected_point3D_id_) {
-          color = kSelectedPointColor;
-        } else {
-          color = point_colormap_->ComputeColor(point3D.first, point3D.second);
-        }
+  }
 
-        painter_point.r = color(0);
-        painter_point.g = color(1);
-        painter_point.b = color(2);
-        painter_point.a = color(3);
+  if (point_painter_.Update(point_idxs, data)) {
+    UploadSelectedPointData();
+  } else {
+    UploadPointData();
+  }
+}
 
-        data.push_back(painter_point);
+void ModelViewerWidget::UploadSelectedPointData() {
+  makeCurrent();
+
+  std::vector<PointPainter::Data> data;
+
+  const size_t min_track_len =
+      static_cast<size_t>(options_->render->min_track_len);
+
+  const auto AddPoint = [&](const Point3D& point3D,
+                            const Eigen::Vector4f& color) {
+    if (point3D.Error() <= options_->render->max_error &&
+        point3D.Track().Length() >= min_track_len) {
+      data.emplace_back(static_cast<float>(point3D.XYZ(0)),
+                        static_cast<float>(point3D.XYZ(1)),
+                        static_cast<float>(point3D.XYZ(2)), color(0),
+                        color(1), color(2), color(3));
+    }
+  };
+
+  if (images.count(selected_image_id_) > 0) {
+    const auto& selected_image = images[selected_image_id_];
+    for (const point3D_t point3D_id : selected_image.Lines().Point3DIds()) {
+      if (point3D_id != kInvalidPoint3DId && points3D.count(point3D_id) > 0) {
+        AddPoint(points3D[point3D_id], kSelectedImagePlaneColor);
       }
     }
+  } else if (points3D.count(selected_point3D_id_) > 0) {
+    AddPoint(points3D[selected_point3D_id_], kSelectedPointColor);
   }
 
-  point_painter_.Upload(data);
+  selected_point_painter_.Upload(data);
+}
+
+OctreePointPainter::Data ModelViewerWidget::PointPainterData(
+    const point3D_t point3D_id, const Point3D& point3D) const {
+  OctreePointPainter::Data painter_point;
+
+  painter_point.x = static_cast<float>(point3D.XYZ(0));
+  painter_point.y = static_cast<float>(point3D.XYZ(1));
+  painter_point.z = static_cast<float>(point3D.XYZ(2));
+
+  const Eigen::Vector4f color =
+      point_colormap_->ComputeColor(point3D_id, point3D);
+  painter_point.r = ColorToByte(color(0));
+  painter_point.g = ColorToByte(color(1));
+  painter_point.b = ColorToByte(color(2));
+  painter_point.a = ColorToByte(color(3));
+
+  painter_point.error = static_cast<float>(point3D.Error());
+  painter_point.track_len = static_cast<float>(point3D.Track().Length());
+
+  return painter_point;
 }
 
 void ModelViewerWidget::UploadPointConnectionData() {
@@ -878,6 +1060,10 @@ void ModelViewerWidget::UploadImageData(const bool selection_mode) {
   std::vector<TrianglePainter::Data> triangle_data;
   triangle_data.reserve(2 * reg_image_ids.size());
 
+  // The picking indices of the images follow those of the points.
+  const size_t num_pickable_points = std::min(
+      point_painter_point3D_ids_.size(), OctreePointPainter::kMaxNumIndexColors);
+
   for (const image_t image_id : reg_image_ids) {
     const Image& image = images[image_id];
     const Camera& camera = cameras[image.CameraId()];
@@ -888,7 +1074,7 @@ void ModelViewerWidget::UploadImageData(const bool selection_mode) {
       const size_t index = selection_buffer_.size();
       selection_buffer_.push_back(
           std::make_pair(image_id, SELECTION_BUFFER_IMAGE_IDX));
-      plane_color = frame_color = IndexToRGB(index);
+      plane_color = frame_color = IndexToRGB(num_pickable_points + index);
     } else {
       if (image_id == selected_image_id_) {
         plane_color = kSelectedImagePlaneColor;
@@ -951,8 +1137,10 @@ void ModelViewerWidget::UploadImageConnectionData() {
     std::unordered_set<image_t> conn_image_ids;
 
     for (const FeatureLine& line : image.Lines()) {
-      if (line.HasPoint3D()) {
-        const Point3D& point3D = points3D[line.Point3DId()];
+      // The observations of incrementally updated images may refer to points,
+      // which were deleted in the meantime.
+      if (line.HasPoint3D() && points3D.count(line.Point3DId()) > 0) {
+        const Point3D& point3D = points3D.at(line.Point3DId());
         for (const auto& track_elem : point3D.Track().Elements()) {
           conn_image_ids.insert(track_elem.image_id);
         }
@@ -968,7 +1156,10 @@ void ModelViewerWidget::UploadImageConnectionData() {
 
     // All connected images to the selected image.
     for (const image_t conn_image_id : conn_image_ids) {
-      const Image& conn_image = images[conn_image_id];
+      if (images.count(conn_image_id) == 0) {
+        continue;
+      }
+      const Image& conn_image = images.at(conn_image_id);
       const Eigen::Vector3f conn_proj_center =
           conn_image.ProjectionCenter().cast<float>();
       line.point2 = PointPainter::Data(
@@ -1076,6 +1267,12 @@ void ModelViewerWidget::ComposeProjectionMatrix() {
   }
 }
 
+void ModelViewerWidget::UpdateStatusbar() {
+  statusbar_status_label->setText(QString().sprintf(
+      "%d Images - %d Points", static_cast<int>(reg_image_ids.size()),
+      static_cast<int>(points3D.size())));
+}
+
 float ModelViewerWidget::ZoomScale() const {
   // "Constant" scale factor w.r.t. zoom-level.
   return 2.0f * std::tan(static_cast<float>(DegToRad(kFieldOfView)) / 2.0f) *
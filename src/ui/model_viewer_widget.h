@@ -32,6 +32,8 @@
 #ifndef COLMAP_SRC_UI_MODEL_VIEWER_WIDGET_H_
 #define COLMAP_SRC_UI_MODEL_VIEWER_WIDGET_H_
 
+#include <mutex>
+
 #include <QtCore>
 #include <QtOpenGL>
 
@@ -39,10 +41,12 @@
 
 #include "base/database.h"
 #include "base/reconstruction.h"
+#include "controllers/incremental_mapper.h"
 #include "ui/colormaps.h"
 #include "ui/image_viewer_widget.h"
 #include "ui/line_painter.h"
 #include "ui/movie_grabber_widget.h"
+#include "ui/octree_point_painter.h"
 #include "ui/point_painter.h"
 #include "ui/point_viewer_widget.h"
 #include "ui/render_options.h"
@@ -79,6 +83,15 @@ class ModelViewerWidget : public QOpenGLWidget,
   void ReloadReconstruction();
   void ClearReconstruction();
 
+  // Record the changes of a reconstruction during incremental mapping, which
+  // is called from the mapper thread in its callbacks and only copies the
+  // changed data. The recorded changes are applied to the displayed data and
+  // the uploaded buffers with `ApplyReconstructionChanges`, which returns
+  // false if there are no changes of the displayed reconstruction.
+  void RecordReconstructionChanges(
+      const IncrementalMapperController::ReconstructionChanges& changes);
+  bool ApplyReconstructionChanges();
+
   int GetProjectionType() const;
 
   // Takes ownwership of the colormap objects.
@@ -146,13 +159,19 @@ class ModelViewerWidget : public QOpenGLWidget,
 
   void Upload();
   void UploadCoordinateGridData();
-  void UploadPointData(const bool selection_mode = false);
+  void UploadPointData();
+  void UploadPointDataChanges(const std::vector<point3D_t>& point3D_ids);
+  void UploadSelectedPointData();
   void UploadPointConnectionData();
   void UploadImageData(const bool selection_mode = false);
   void UploadImageConnectionData();
   void UploadMovieGrabberData();
 
   void ComposeProjectionMatrix();
+  void UpdateStatusbar();
+
+  OctreePointPainter::Data PointPainterData(const point3D_t point3D_id,
+                                            const Point3D& point3D) const;
 
   float ZoomScale() const;
   float AspectRatio() const;
@@ -168,9 +187,30 @@ class ModelViewerWidget : public QOpenGLWidget,
   LinePainter coordinate_axes_painter_;
   LinePainter coordinate_grid_painter_;
 
-  PointPainter point_painter_;
+  OctreePointPainter point_painter_;
+  PointPainter selected_point_painter_;
   LinePainter point_connection_painter_;
 
+  // The identifiers of the uploaded points, indexed by their picking index,
+  // and the inverse mapping.
+  std::vector<point3D_t> point_painter_point3D_ids_;
+  std::unordered_map<point3D_t, size_t> point_painter_point3D_idxs_;
+
+  // The copied data of the changes, which were recorded since they were last
+  // applied, where the deleted points are not contained in the points.
+  struct RecordedChanges {
+    const Reconstruction* reconstruction = nullptr;
+    bool all_changed = false;
+    EIGEN_STL_UMAP(camera_t, Camera) cameras;
+    EIGEN_STL_UMAP(image_t, Image) images;
+    EIGEN_STL_UMAP(point3D_t, Point3D) points3D;
+    std::unordered_set<point3D_t> deleted_point3D_ids;
+    std::vector<image_t> reg_image_ids;
+  };
+
+  std::mutex recorded_changes_mutex_;
+  RecordedChanges recorded_changes_;
+
   LinePainter image_line_painter_;
   TrianglePainter image_triangle_painter_;
   LinePainter image_connection_painter_;
@@ -192,6 +232,8 @@ class ModelViewerWidget : public QOpenGLWidget,
 
   float focus_distance_;
 
+  // The images uploaded in selection mode, indexed by their picking index
+  // relative to the number of pickable points.
   std::vector<std::pair<size_t, char>> selection_buffer_;
   image_t selected_image_id_;
   point3D_t selected_point3D_id_;
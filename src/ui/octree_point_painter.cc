@@ -0,0 +1,561 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ui/octree_point_painter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <random>
+
+#include "util/logging.h"
+#include "util/opengl_utils.h"
+
+namespace colmap {
+namespace {
+
+// The maximum number of points stored in an inner node.
+const size_t kMaxNumNodePoints = 16384;
+
+// The maximum depth of the octree, after which the remaining points are stored
+// in a leaf, e.g. for many points at the same position.
+const int kMaxDepth = 20;
+
+// Half of the diagonal of the unit cube.
+const float kHalfCubeDiagonal = 0.8660254f;
+
+// The node indices of points that are not in the octree, because their
+// position is not finite, and of appended points.
+const int kInvalidNodeIdx = -1;
+const int kAppendedNodeIdx = -2;
+
+// The maximum number of appended points relative to the number of points in
+// the octree, so that the cost of building the octree again is amortized.
+const double kMaxAppendedPointsRatio = 0.25;
+
+bool IsFinitePoint(const OctreePointPainter::Data& point) {
+  return std::isfinite(point.x) && std::isfinite(point.y) &&
+         std::isfinite(point.z);
+}
+
+}  // namespace
+
+const size_t OctreePointPainter::kMaxNumIndexColors = 256 * 256 * 256 - 1;
+
+OctreePointPainter::OctreePointPainter()
+    : max_error_(std::numeric_limits<float>::max()),
+      min_track_len_(0),
+      max_screen_space_error_(0),
+      num_octree_points_(0) {}
+
+OctreePointPainter::~OctreePointPainter() { ClearNodes(); }
+
+void OctreePointPainter::Setup() {
+  ClearNodes();
+  if (shader_program_.isLinked()) {
+    shader_program_.release();
+    shader_program_.removeAllShaders();
+  }
+
+  shader_program_.addShaderFromSourceFile(QOpenGLShader::Vertex,
+                                          ":/shaders/octree_points.v.glsl");
+  shader_program_.addShaderFromSourceFile(QOpenGLShader::Fragment,
+                                          ":/shaders/points.f.glsl");
+  shader_program_.bindAttributeLocation("a_position", 0);
+  shader_program_.bindAttributeLocation("a_color", 1);
+  shader_program_.bindAttributeLocation("a_index_color", 2);
+  shader_program_.bindAttributeLocation("a_error", 3);
+  shader_program_.bindAttributeLocation("a_track_len", 4);
+  shader_program_.link();
+  shader_program_.bind();
+
+#if DEBUG
+  glDebugLog();
+#endif
+}
+
+void OctreePointPainter::Upload(
+    const std::vector<OctreePointPainter::Data>& data) {
+  ClearNodes();
+
+  point_locations_.resize(data.size(), {kInvalidNodeIdx, 0});
+  num_octree_points_ = data.size();
+
+  // Shuffle the points, so that the first points of each node are a random
+  // sample of the points in its cell.
+  std::vector<uint32_t> point_idxs;
+  point_idxs.reserve(data.size());
+  std::array<float, 3> min_xyz;
+  std::array<float, 3> max_xyz;
+  min_xyz.fill(std::numeric_limits<float>::max());
+  max_xyz.fill(std::numeric_limits<float>::lowest());
+  for (size_t i = 0; i < data.size(); ++i) {
+    if (!IsFinitePoint(data[i])) {
+      continue;
+    }
+    const std::array<float, 3> xyz = {{data[i].x, data[i].y, data[i].z}};
+    for (int d = 0; d < 3; ++d) {
+      min_xyz[d] = std::min(min_xyz[d], xyz[d]);
+      max_xyz[d] = std::max(max_xyz[d], xyz[d]);
+    }
+    point_idxs.push_back(static_cast<uint32_t>(i));
+  }
+
+  if (point_idxs.empty()) {
+    return;
+  }
+
+  std::mt19937 prng(0);
+  std::shuffle(point_idxs.begin(), point_idxs.end(), prng);
+
+  float size = 0;
+  for (int d = 0; d < 3; ++d) {
+    size = std::max(size, max_xyz[d] - min_xyz[d]);
+  }
+  if (size <= 0) {
+    size = 1;
+  }
+
+  BuildNode(data, point_idxs, min_xyz, size, 0);
+
+#if DEBUG
+  glDebugLog();
+#endif
+}
+
+bool OctreePointPainter::Update(
+    const std::vector<size_t>& point_idxs,
+    const std::vector<OctreePointPainter::Data>& data) {
+  CHECK_EQ(point_idxs.size(), data.size());
+
+  if (nodes_.empty()) {
+    return false;
+  }
+
+  bool appended_changed = false;
+  for (size_t i = 0; i < point_idxs.size(); ++i) {
+    const size_t point_idx = point_idxs[i];
+    const Data& point = data[i];
+    const bool is_hidden = point.track_len < 0;
+    const Vertex vertex = MakeVertex(point_idx, point);
+
+    if (point_idx == point_locations_.size()) {
+      if (IsFinitePoint(point)) {
+        point_locations_.push_back(
+            {kAppendedNodeIdx, static_cast<uint32_t>(appended_vertices_.size())});
+        appended_vertices_.push_back(vertex);
+        appended_changed = true;
+      } else {
+        point_locations_.push_back({kInvalidNodeIdx, 0});
+      }
+      continue;
+    }
+
+    CHECK_LT(point_idx, point_locations_.size());
+    const PointLocation location = point_locations_[point_idx];
+
+    if (location.node_idx == kAppendedNodeIdx) {
+      appended_vertices_[location.offset] = vertex;
+      appended_changed = true;
+      continue;
+    }
+
+    if (location.node_idx == kInvalidNodeIdx) {
+      if (is_hidden || !IsFinitePoint(point)) {
+        continue;
+      }
+      return false;
+    }
+
+    // Hidden points are never rendered and may remain at any position.
+    Node& node = nodes_[location.node_idx];
+    if (!is_hidden) {
+      if (!IsFinitePoint(point)) {
+        return false;
+      }
+      const std::array<float, 3> xyz = {{point.x, point.y, point.z}};
+      for (int d = 0; d < 3; ++d) {
+        if (xyz[d] < node.min[d] || xyz[d] > node.min[d] + node.size) {
+          return false;
+        }
+      }
+    }
+
+    node.vbo->bind();
+    node.vbo->write(static_cast<int>(location.offset * sizeof(Vertex)),
+                    &vertex, static_cast<int>(sizeof(Vertex)));
+    node.vbo->release();
+
+    UpdateNodeBounds(location.node_idx, point.error, point.track_len);
+  }
+
+  const size_t max_num_appended_points = std::max(
+      kMaxNumNodePoints,
+      static_cast<size_t>(kMaxAppendedPointsRatio * num_octree_points_));
+  if (appended_vertices_.size() > max_num_appended_points) {
+    return false;
+  }
+
+  if (appended_changed) {
+    UploadVertices(appended_vertices_, &appended_node_);
+  }
+
+#if DEBUG
+  glDebugLog();
+#endif
+
+  return true;
+}
+
+void OctreePointPainter::SetFilter(const float max_error,
+                                   const float min_track_len) {
+  max_error_ = max_error;
+  min_track_len_ = min_track_len;
+}
+
+void OctreePointPainter::SetMaxScreenSpaceError(
+    const float max_screen_space_error) {
+  max_screen_space_error_ = max_screen_space_error;
+}
+
+void OctreePointPainter::Render(const QMatrix4x4& pmv_matrix,
+                                const QMatrix4x4& projection_matrix,
+                                const int viewport_height,
+                                const float point_size,
+                                const bool selection_mode) {
+  if (nodes_.empty()) {
+    return;
+  }
+
+  shader_program_.bind();
+  shader_program_.setUniformValue("u_pmv_matrix", pmv_matrix);
+  shader_program_.setUniformValue("u_point_size", point_size);
+  shader_program_.setUniformValue("u_max_error", max_error_);
+  shader_program_.setUniformValue("u_min_track_len", min_track_len_);
+  shader_program_.setUniformValue("u_selection_mode",
+                                  static_cast<GLint>(selection_mode));
+
+  // The size in pixels of a unit length at unit distance to the camera for
+  // perspective projection or at any distance for orthographic projection.
+  const bool is_perspective = projection_matrix(3, 3) == 0;
+  const float pixel_scale = 0.5f * projection_matrix(1, 1) * viewport_height;
+
+  QOpenGLFunctions* gl_funcs = QOpenGLContext::currentContext()->functions();
+
+  std::vector<size_t> node_idxs = {0};
+  while (!node_idxs.empty()) {
+    const Node& node = nodes_[node_idxs.back()];
+    node_idxs.pop_back();
+
+    if (node.min_error > max_error_ || node.max_track_len < min_track_len_ ||
+        !IsNodeVisible(pmv_matrix, node)) {
+      continue;
+    }
+
+    node.vao->bind();
+    gl_funcs->glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(node.num_points));
+    node.vao->release();
+
+    // Refine the node, if the spacing of its points projected at the closest
+    // possible distance of its cell exceeds the maximum error.
+    float distance = 1;
+    if (is_perspective) {
+      const float half_size = 0.5f * node.size;
+      const QVector4D center =
+          pmv_matrix * QVector4D(node.min[0] + half_size,
+                                 node.min[1] + half_size,
+                                 node.min[2] + half_size, 1);
+      distance = center.w() - kHalfCubeDiagonal * node.size;
+    }
+
+    if (distance <= 0 ||
+        node.spacing * pixel_scale > max_screen_space_error_ * distance) {
+      for (const int child_idx : node.child_idxs) {
+        if (child_idx >= 0) {
+          node_idxs.push_back(static_cast<size_t>(child_idx));
+        }
+      }
+    }
+  }
+
+  if (appended_node_.num_points > 0) {
+    appended_node_.vao->bind();
+    gl_funcs->glDrawArrays(GL_POINTS, 0,
+                           static_cast<GLsizei>(appended_node_.num_points));
+    appended_node_.vao->release();
+  }
+
+#if DEBUG
+  glDebugLog();
+#endif
+}
+
+size_t OctreePointPainter::BuildNode(
+    const std::vector<OctreePointPainter::Data>& data,
+    const std::vector<uint32_t>& point_idxs, const std::array<float, 3>& min,
+    const float size, const int depth) {
+  const size_t node_idx = nodes_.size();
+  nodes_.emplace_back();
+  nodes_[node_idx].min = min;
+  nodes_[node_idx].size = size;
+  nodes_[node_idx].child_idxs.fill(-1);
+
+  const size_t num_node_points =
+      depth < kMaxDepth ? std::min(point_idxs.size(), kMaxNumNodePoints)
+                        : point_idxs.size();
+
+  float min_error = std::numeric_limits<float>::max();
+  float max_track_len = 0;
+
+  // Distribute the points that are not stored in the node to its children.
+  if (point_idxs.size() > num_node_points) {
+    const float child_size = 0.5f * size;
+    std::array<std::vector<uint32_t>, 8> child_point_idxs;
+    for (size_t i = num_node_points; i < point_idxs.size(); ++i) {
+      const Data& point = data[point_idxs[i]];
+      int octant = 0;
+      if (point.x >= min[0] + child_size) {
+        octant |= 1;
+      }
+      if (point.y >= min[1] + child_size) {
+        octant |= 2;
+      }
+      if (point.z >= min[2] + child_size) {
+        octant |= 4;
+      }
+      child_point_idxs[octant].push_back(point_idxs[i]);
+    }
+
+    for (int octant = 0; octant < 8; ++octant) {
+      if (child_point_idxs[octant].empty()) {
+        continue;
+      }
+
+      std::array<float, 3> child_min = min;
+      for (int d = 0; d < 3; ++d) {
+        if (octant & (1 << d)) {
+          child_min[d] += child_size;
+        }
+      }
+
+      const size_t child_idx = BuildNode(data, child_point_idxs[octant],
+                                         child_min, child_size, depth + 1);
+      std::vector<uint32_t>().swap(child_point_idxs[octant]);
+
+      nodes_[node_idx].child_idxs[octant] = static_cast<int>(child_idx);
+      nodes_[child_idx].parent_idx = static_cast<int>(node_idx);
+      min_error = std::min(min_error, nodes_[child_idx].min_error);
+      max_track_len = std::max(max_track_len, nodes_[child_idx].max_track_len);
+    }
+  }
+
+  Node& node = nodes_[node_idx];
+  node.num_points = num_node_points;
+  for (size_t i = 0; i < num_node_points; ++i) {
+    min_error = std::min(min_error, data[point_idxs[i]].error);
+    max_track_len = std::max(max_track_len, data[point_idxs[i]].track_len);
+    point_locations_[point_idxs[i]] = {static_cast<int>(node_idx),
+                                       static_cast<uint32_t>(i)};
+  }
+  node.min_error = min_error;
+  node.max_track_len = max_track_len;
+
+  // Assume that the points sample surfaces, which are the common case in
+  // reconstructions, rather than volumes.
+  node.spacing = size / std::sqrt(static_cast<float>(num_node_points));
+
+  UploadNode(data, point_idxs, &node);
+
+  return node_idx;
+}
+
+void OctreePointPainter::UploadNode(
+    const std::vector<OctreePointPainter::Data>& data,
+    const std::vector<uint32_t>& point_idxs, Node* node) {
+  std::vector<Vertex> vertices(node->num_points);
+  for (size_t i = 0; i < node->num_points; ++i) {
+    vertices[i] = MakeVertex(point_idxs[i], data[point_idxs[i]]);
+  }
+  UploadVertices(vertices, node);
+}
+
+void OctreePointPainter::UploadVertices(const std::vector<Vertex>& vertices,
+                                        Node* node) {
+  node->num_points = vertices.size();
+
+  // The attributes refer to the buffer object, so that a buffer of an existing
+  // node can be allocated again.
+  if (node->vao) {
+    node->vbo->bind();
+    node->vbo->allocate(vertices.data(),
+                        static_cast<int>(vertices.size() * sizeof(Vertex)));
+    node->vbo->release();
+    return;
+  }
+
+  node->vao.reset(new QOpenGLVertexArrayObject());
+  node->vbo.reset(new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer));
+  node->vao->create();
+  node->vbo->create();
+
+  node->vao->bind();
+  node->vbo->bind();
+
+  node->vbo->setUsagePattern(QOpenGLBuffer::StaticDraw);
+  node->vbo->allocate(vertices.data(),
+                      static_cast<int>(vertices.size() * sizeof(Vertex)));
+
+  // a_position
+  shader_program_.enableAttributeArray(0);
+  shader_program_.setAttributeBuffer(0, GL_FLOAT, offsetof(Vertex, x), 3,
+                                     sizeof(Vertex));
+
+  // a_color
+  shader_program_.enableAttributeArray(1);
+  shader_program_.setAttributeBuffer(1, GL_UNSIGNED_BYTE, offsetof(Vertex, r),
+                                     4, sizeof(Vertex));
+
+  // a_index_color
+  shader_program_.enableAttributeArray(2);
+  shader_program_.setAttributeBuffer(2, GL_UNSIGNED_BYTE,
+                                     offsetof(Vertex, index_r), 4,
+                                     sizeof(Vertex));
+
+  // a_error
+  shader_program_.enableAttributeArray(3);
+  shader_program_.setAttributeBuffer(3, GL_FLOAT, offsetof(Vertex, error), 1,
+                                     sizeof(Vertex));
+
+  // a_track_len
+  shader_program_.enableAttributeArray(4);
+  shader_program_.setAttributeBuffer(4, GL_FLOAT, offsetof(Vertex, track_len),
+                                     1, sizeof(Vertex));
+
+  // Make sure they are not changed from the outside
+  node->vbo->release();
+  node->vao->release();
+}
+
+void OctreePointPainter::UpdateNodeBounds(const int node_idx,
+                                          const float error,
+                                          const float track_len) {
+  // The bounds of the ancestors contain the bounds of their descendants, so
+  // the update stops at the first node whose bounds contain the point.
+  int idx = node_idx;
+  while (idx >= 0) {
+    Node& node = nodes_[idx];
+    if (error >= node.min_error && track_len <= node.max_track_len) {
+      break;
+    }
+    node.min_error = std::min(node.min_error, error);
+    node.max_track_len = std::max(node.max_track_len, track_len);
+    idx = node.parent_idx;
+  }
+}
+
+void OctreePointPainter::ClearNodes() {
+  for (auto& node : nodes_) {
+    node.vao->destroy();
+    node.vbo->destroy();
+  }
+  nodes_.clear();
+
+  if (appended_node_.vao) {
+    appended_node_.vao->destroy();
+    appended_node_.vbo->destroy();
+    appended_node_.vao.reset();
+    appended_node_.vbo.reset();
+  }
+  appended_node_.num_points = 0;
+  appended_vertices_.clear();
+
+  point_locations_.clear();
+  num_octree_points_ = 0;
+}
+
+bool OctreePointPainter::IsNodeVisible(const QMatrix4x4& pmv_matrix,
+                                       const Node& node) const {
+  // The cell is outside of the view frustum, if all its corners are outside
+  // of the same clipping plane.
+  int common_outcode = 0x3F;
+  for (int corner = 0; corner < 8; ++corner) {
+    const QVector4D xyz = pmv_matrix * QVector4D(
+        node.min[0] + ((corner & 1) ? node.size : 0),
+        node.min[1] + ((corner & 2) ? node.size : 0),
+        node.min[2] + ((corner & 4) ? node.size : 0), 1);
+    int outcode = 0;
+    if (xyz.x() < -xyz.w()) {
+      outcode |= 0x01;
+    }
+    if (xyz.x() > xyz.w()) {
+      outcode |= 0x02;
+    }
+    if (xyz.y() < -xyz.w()) {
+      outcode |= 0x04;
+    }
+    if (xyz.y() > xyz.w()) {
+      outcode |= 0x08;
+    }
+    if (xyz.z() < -xyz.w()) {
+      outcode |= 0x10;
+    }
+    if (xyz.z() > xyz.w()) {
+      outcode |= 0x20;
+    }
+    common_outcode &= outcode;
+    if (common_outcode == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+OctreePointPainter::Vertex OctreePointPainter::MakeVertex(
+    const size_t point_idx, const OctreePointPainter::Data& point) {
+  Vertex vertex;
+  vertex.x = point.x;
+  vertex.y = point.y;
+  vertex.z = point.z;
+  vertex.r = point.r;
+  vertex.g = point.g;
+  vertex.b = point.b;
+  vertex.a = point.a;
+  const size_t index = std::min(point_idx, kMaxNumIndexColors);
+  vertex.index_r = static_cast<uint8_t>(index & 0xFF);
+  vertex.index_g = static_cast<uint8_t>((index >> 8) & 0xFF);
+  vertex.index_b = static_cast<uint8_t>((index >> 16) & 0xFF);
+  vertex.index_a = 255;
+  vertex.error = point.error;
+  vertex.track_len = point.track_len;
+  return vertex;
+}
+
+}  // namespace colmap
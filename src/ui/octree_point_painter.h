@@ -0,0 +1,169 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef COLMAP_SRC_UI_OCTREE_POINT_PAINTER_H_
+#define COLMAP_SRC_UI_OCTREE_POINT_PAINTER_H_
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include <QtCore>
+#include <QtOpenGL>
+
+namespace colmap {
+
+// Painter for large point clouds, which are organized in an octree with one
+// vertex buffer per node. Each inner node stores a random sample of the points
+// in its cell and the leaves store the remaining points, so that a coarse level
+// of detail is rendered by only drawing the upper levels of the tree. A node is
+// only refined while the projected spacing of its points exceeds the maximum
+// screen-space error, and nodes outside of the view frustum are skipped.
+//
+// The points are filtered by their error and track length in the shader and
+// each point carries a unique index color for picking, so that neither
+// changing the filter nor selecting points requires to upload them again.
+class OctreePointPainter {
+ public:
+  // Points with an index of at least this number are not pickable, since the
+  // index colors are limited to 24 bits and white is the background.
+  static const size_t kMaxNumIndexColors;
+
+  OctreePointPainter();
+  ~OctreePointPainter();
+
+  struct Data {
+    Data() : x(0), y(0), z(0), r(0), g(0), b(0), a(0), error(0), track_len(0) {}
+
+    float x, y, z;
+    uint8_t r, g, b, a;
+    float error;
+    float track_len;
+  };
+
+  void Setup();
+
+  // Build the octree and upload its nodes. The index of a point in `data` is
+  // encoded in its color in selection mode.
+  void Upload(const std::vector<OctreePointPainter::Data>& data);
+
+  // Patch the uploaded points with the given indices in place, where the next
+  // unused indices append new points. Points are hidden by a negative track
+  // length. The appended points are rendered without level of detail, so
+  // the function returns false if the octree must be built again with
+  // `Upload`, because too many points were appended or points moved out of
+  // the cells of their nodes.
+  bool Update(const std::vector<size_t>& point_idxs,
+              const std::vector<OctreePointPainter::Data>& data);
+
+  // Only render points with at most the given error and at least the given
+  // track length.
+  void SetFilter(const float max_error, const float min_track_len);
+
+  // The maximum projected point spacing in pixels of the rendered nodes.
+  void SetMaxScreenSpaceError(const float max_screen_space_error);
+
+  // Render the nodes selected for the current view, where the viewport height
+  // in pixels and the projection matrix determine the projected point spacing.
+  // In selection mode, the points are rendered with their index colors.
+  void Render(const QMatrix4x4& pmv_matrix,
+              const QMatrix4x4& projection_matrix, const int viewport_height,
+              const float point_size, const bool selection_mode = false);
+
+ private:
+  struct Vertex {
+    float x, y, z;
+    uint8_t r, g, b, a;
+    uint8_t index_r, index_g, index_b, index_a;
+    float error;
+    float track_len;
+  };
+
+  struct Node {
+    // The cubic cell of the node.
+    std::array<float, 3> min;
+    float size = 0;
+
+    // The average distance between the points of the node.
+    float spacing = 0;
+
+    // The bounds of the points of the node and its descendants, which are used
+    // to skip subtrees that are filtered entirely.
+    float min_error = 0;
+    float max_track_len = 0;
+
+    int parent_idx = -1;
+    std::array<int, 8> child_idxs;
+    size_t num_points = 0;
+
+    std::unique_ptr<QOpenGLVertexArrayObject> vao;
+    std::unique_ptr<QOpenGLBuffer> vbo;
+  };
+
+  // The node of a point and the offset of the point in the buffer of the node.
+  struct PointLocation {
+    int node_idx;
+    uint32_t offset;
+  };
+
+  size_t BuildNode(const std::vector<OctreePointPainter::Data>& data,
+                   const std::vector<uint32_t>& point_idxs,
+                   const std::array<float, 3>& min, const float size,
+                   const int depth);
+  void UploadNode(const std::vector<OctreePointPainter::Data>& data,
+                  const std::vector<uint32_t>& point_idxs, Node* node);
+  void UploadVertices(const std::vector<Vertex>& vertices, Node* node);
+  void UpdateNodeBounds(const int node_idx, const float error,
+                        const float track_len);
+  void ClearNodes();
+  bool IsNodeVisible(const QMatrix4x4& pmv_matrix, const Node& node) const;
+
+  static Vertex MakeVertex(const size_t point_idx,
+                           const OctreePointPainter::Data& point);
+
+  QOpenGLShaderProgram shader_program_;
+  std::vector<Node> nodes_;
+
+  float max_error_;
+  float min_track_len_;
+  float max_screen_space_error_;
+
+  // The locations of the points indexed by their index, which are used to
+  // patch the points in place.
+  std::vector<PointLocation> point_locations_;
+  size_t num_octree_points_;
+
+  // The points appended after building the octree.
+  Node appended_node_;
+  std::vector<Vertex> appended_vertices_;
+};
+
+}  // namespace colmap
+
+#endif  // COLMAP_SRC_UI_OCTREE_POINT_PAINTER_H_
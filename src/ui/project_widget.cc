@@ -111,7 +111,7 @@ void ProjectWidget::Save() {
     *options_->image_path = GetImagePath();
 
     // Save empty database file.
-    Database database(*options_->database_path, true);
+    Database database(*options_->database_path, true, *options_->database);
 
     hide();
   } else {
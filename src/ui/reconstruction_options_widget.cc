@@ -70,6 +70,16 @@ MapperTriangulationOptionsWidget::MapperTriangulationOptionsWidget(
                   "complete_max_reproj_error [px]");
   AddOptionInt(&options->mapper->triangulation.complete_max_transitivity,
                "complete_max_transitivity");
+  AddOptionBool(&options->mapper->triangulation.refine_extended_tracks,
+                "refine_extended_tracks");
+  AddOptionInt(&options->mapper->triangulation.guided_min_num_observations,
+               "guided_min_num_observations", 3);
+  AddOptionInt(&options->mapper->triangulation.guided_num_seed_samples,
+               "guided_num_seed_samples");
+  AddOptionInt(&options->mapper->triangulation.guided_max_num_trials,
+               "guided_max_num_trials", 1);
+  AddOptionInt(&options->mapper->triangulation.refine_min_num_observations,
+               "refine_min_num_observations", 3);
   AddOptionDouble(&options->mapper->triangulation.min_angle, "min_angle [deg]",
                   0, 180);
   AddOptionBool(&options->mapper->triangulation.ignore_two_view_tracks,
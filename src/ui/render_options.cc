@@ -38,7 +38,9 @@ namespace colmap {
 bool RenderOptions::Check() const {
   CHECK_OPTION_GE(min_track_len, 0);
   CHECK_OPTION_GE(max_error, 0);
-  CHECK_OPTION_GT(refresh_rate, 0);
+  CHECK_OPTION_GE(max_screen_space_error, 0);
+  CHECK_OPTION_GT(max_frame_rate, 0);
+  CHECK_OPTION_LE(max_frame_rate, 1000);
   CHECK_OPTION(projection_type == ProjectionType::PERSPECTIVE ||
                projection_type == ProjectionType::ORTHOGRAPHIC);
   return true;
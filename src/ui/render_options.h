@@ -48,11 +48,18 @@ struct RenderOptions {
   // Maximum error for a point to be rendered.
   double max_error = 2;
 
-  // The rate of registered images at which to refresh.
-  int refresh_rate = 1;
+  // Maximum projected spacing in pixels between the rendered points, before
+  // the next finer level of detail of the point cloud is rendered.
+  double max_screen_space_error = 2;
+
+  // The maximum number of times per second to render the changes of the
+  // reconstruction during incremental mapping, at most 1000.
+  double max_frame_rate = 10;
 
-  // Whether to automatically adjust the refresh rate. The bigger the
-  // reconstruction gets, the less frequently the scene is rendered.
+  // Deprecated and ignored, since the changes are rendered at
+  // `max_frame_rate` instead of after a number of registered images. Only
+  // kept so that existing project files can still be read.
+  int refresh_rate = 1;
   bool adapt_refresh_rate = true;
 
   // Whether to visualize image connections.
@@ -39,7 +39,6 @@ RenderOptionsWidget::RenderOptionsWidget(QWidget* parent,
                                          OptionManager* options,
                                          ModelViewerWidget* model_viewer_widget)
     : OptionsWidget(parent),
-      counter(0),
       automatic_update(true),
       options_(options),
       model_viewer_widget_(model_viewer_widget),
@@ -96,6 +95,8 @@ RenderOptionsWidget::RenderOptionsWidget(QWidget* parent,
 
   AddOptionDouble(&options->render->max_error, "Point max. error [px]");
   AddOptionInt(&options->render->min_track_len, "Point min. track length", 0);
+  AddOptionDouble(&options->render->max_screen_space_error,
+                  "Point level of detail [px]");
 
   AddSpacer();
 
@@ -155,8 +156,8 @@ RenderOptionsWidget::RenderOptionsWidget(QWidget* parent,
 
   AddSpacer();
 
-  AddOptionBool(&options->render->adapt_refresh_rate, "Adaptive refresh rate");
-  AddOptionInt(&options->render->refresh_rate, "Refresh rate [frames]", 1);
+  AddOptionDouble(&options->render->max_frame_rate, "Max. frame rate [Hz]",
+                  0.1, 1000);
 
   AddSpacer();
 
@@ -176,8 +177,6 @@ void RenderOptionsWidget::closeEvent(QCloseEvent* event) {
 void RenderOptionsWidget::Apply() {
   WriteOptions();
 
-  counter = 0;
-
   ApplyProjection();
   ApplyPointColormap();
   ApplyImageColormap();
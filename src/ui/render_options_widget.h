@@ -46,7 +46,6 @@ class RenderOptionsWidget : public OptionsWidget {
   RenderOptionsWidget(QWidget* parent, OptionManager* options,
                       ModelViewerWidget* model_viewer_widget);
 
-  size_t counter;
   bool automatic_update;
 
   QAction* action_render_now;
@@ -0,0 +1,25 @@
+#version 150
+
+uniform float u_point_size;
+uniform mat4 u_pmv_matrix;
+uniform float u_max_error;
+uniform float u_min_track_len;
+uniform bool u_selection_mode;
+
+in vec3 a_position;
+in vec4 a_color;
+in vec4 a_index_color;
+in float a_error;
+in float a_track_len;
+out vec4 v_color;
+
+void main(void) {
+  if (a_error > u_max_error || a_track_len < u_min_track_len) {
+    // Move filtered points outside of the clip volume.
+    gl_Position = vec4(2, 2, 2, 1);
+  } else {
+    gl_Position = u_pmv_matrix * vec4(a_position, 1);
+  }
+  gl_PointSize = u_point_size;
+  v_color = u_selection_mode ? a_index_color : a_color;
+}
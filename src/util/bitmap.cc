@@ -425,29 +425,74 @@ bool Bitmap::Read(const std::string& path, const bool as_rgb) {
     return false;
   }
 
-  FIBITMAP* fi_bitmap = FreeImage_Load(format, path.c_str());
-  if (fi_bitmap == nullptr) {
+  return Load(path, format, 0, as_rgb);
+}
+
+bool Bitmap::ReadScaled(const std::string& path, const bool as_rgb,
+                        const int min_size, int* full_width,
+                        int* full_height) {
+  CHECK_NOTNULL(full_width);
+  CHECK_NOTNULL(full_height);
+
+  if (!ExistsFile(path)) {
     return false;
   }
 
-  data_ = FIBitmapPtr(fi_bitmap, &FreeImage_Unload);
+  const FREE_IMAGE_FORMAT format = FreeImage_GetFileType(path.c_str(), 0);
 
-  if (!IsPtrRGB(data_.get()) && as_rgb) {
-    FIBITMAP* converted_bitmap = FreeImage_ConvertTo24Bits(fi_bitmap);
-    data_ = FIBitmapPtr(converted_bitmap, &FreeImage_Unload);
-  } else if (!IsPtrGrey(data_.get()) && !as_rgb) {
-    FIBITMAP* converted_bitmap = FreeImage_ConvertToGreyscale(fi_bitmap);
-    data_ = FIBitmapPtr(converted_bitmap, &FreeImage_Unload);
+  if (format == FIF_UNKNOWN) {
+    return false;
   }
 
-  if (!IsPtrSupported(data_.get())) {
-    data_.reset();
+  *full_width = 0;
+  *full_height = 0;
+
+  int flags = 0;
+
+#ifdef FIF_LOAD_NOPIXELS
+  if (format == FIF_JPEG && min_size > 0) {
+    // Only read the header to determine the image dimensions.
+    FIBITMAP* fi_header =
+        FreeImage_Load(format, path.c_str(), FIF_LOAD_NOPIXELS);
+    if (fi_header != nullptr) {
+      *full_width = FreeImage_GetWidth(fi_header);
+      *full_height = FreeImage_GetHeight(fi_header);
+      FreeImage_Unload(fi_header);
+
+      const int max_dim = std::max(*full_width, *full_height);
+
+      int scale_denom = 8;
+      while (scale_denom > 1 && max_dim / scale_denom < min_size) {
+        scale_denom /= 2;
+      }
+
+      // The JPEG plugin chooses the largest scale denominator of 2, 4, or 8,
+      // which is at most the ratio of the larger dimension to the requested
+      // size encoded in the upper 16 bits of the flags. Requesting the larger
+      // dimension at the chosen scale therefore selects exactly that scale.
+      if (scale_denom > 1) {
+        flags = (max_dim / scale_denom) << 16;
+      }
+    }
+  }
+#endif
+
+  if (!Load(path, format, flags, as_rgb)) {
     return false;
   }
 
-  width_ = FreeImage_GetWidth(data_.get());
-  height_ = FreeImage_GetHeight(data_.get());
-  channels_ = as_rgb ? 3 : 1;
+  if (flags != 0 && std::max(width_, height_) < min_size) {
+    // Fall back to the full resolution, if the decoder scaled more than
+    // expected.
+    if (!Load(path, format, 0, as_rgb)) {
+      return false;
+    }
+  }
+
+  if (*full_width == 0 || *full_height == 0) {
+    *full_width = width_;
+    *full_height = height_;
+  }
 
   return true;
 }
@@ -570,6 +615,35 @@ void Bitmap::SetPtr(FIBITMAP* data) {
   channels_ = IsPtrRGB(data) ? 3 : 1;
 }
 
+bool Bitmap::Load(const std::string& path, const FREE_IMAGE_FORMAT format,
+                  const int flags, const bool as_rgb) {
+  FIBITMAP* fi_bitmap = FreeImage_Load(format, path.c_str(), flags);
+  if (fi_bitmap == nullptr) {
+    return false;
+  }
+
+  data_ = FIBitmapPtr(fi_bitmap, &FreeImage_Unload);
+
+  if (!IsPtrRGB(data_.get()) && as_rgb) {
+    FIBITMAP* converted_bitmap = FreeImage_ConvertTo24Bits(fi_bitmap);
+    data_ = FIBitmapPtr(converted_bitmap, &FreeImage_Unload);
+  } else if (!IsPtrGrey(data_.get()) && !as_rgb) {
+    FIBITMAP* converted_bitmap = FreeImage_ConvertToGreyscale(fi_bitmap);
+    data_ = FIBitmapPtr(converted_bitmap, &FreeImage_Unload);
+  }
+
+  if (!IsPtrSupported(data_.get())) {
+    data_.reset();
+    return false;
+  }
+
+  width_ = FreeImage_GetWidth(data_.get());
+  height_ = FreeImage_GetHeight(data_.get());
+  channels_ = as_rgb ? 3 : 1;
+
+  return true;
+}
+
 bool Bitmap::IsPtrGrey(FIBITMAP* data) {
   return FreeImage_GetColorType(data) == FIC_MINISBLACK &&
          FreeImage_GetBPP(data) == 8;
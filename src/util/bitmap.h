@@ -158,6 +158,14 @@ class Bitmap {
   // Read bitmap at given path and convert to grey- or colorscale.
   bool Read(const std::string& path, const bool as_rgb = true);
 
+  // Read bitmap as above, but let the JPEG decoder downscale the image by a
+  // factor of 2, 4 or 8 during decoding, as long as its larger dimension stays
+  // at least `min_size`. This is much faster than reading the full image and
+  // rescaling it afterwards. Other formats are read at full resolution. The
+  // dimensions of the full resolution image are returned in any case.
+  bool ReadScaled(const std::string& path, const bool as_rgb,
+                  const int min_size, int* full_width, int* full_height);
+
   // Write image to file. Flags can be used to set e.g. the JPEG quality.
   // Consult the FreeImage documentation for all available flags.
   bool Write(const std::string& path,
@@ -188,6 +196,11 @@ class Bitmap {
 
   void SetPtr(FIBITMAP* data);
 
+  // Load the bitmap with the given FreeImage flags and convert it to grey- or
+  // colorscale.
+  bool Load(const std::string& path, const FREE_IMAGE_FORMAT format,
+            const int flags, const bool as_rgb);
+
   static bool IsPtrGrey(FIBITMAP* data);
   static bool IsPtrRGB(FIBITMAP* data);
   static bool IsPtrSupported(FIBITMAP* data);
@@ -56,6 +56,11 @@ class LRUCache {
   // Check whether the element with the given key exists.
   bool Exists(const key_t& key) const;
 
+  // Call `func(key, value)` for all elements in the cache, starting with the
+  // most recently used element. This does not change the usage order.
+  template <typename Func>
+  void ForEach(const Func& func) const;
+
   // Get the value of an element either from the cache or compute the new value.
   const value_t& Get(const key_t& key);
   value_t& GetMutable(const key_t& key);
@@ -142,6 +147,14 @@ size_t LRUCache<key_t, value_t>::MaxNumElems() const {
   return max_num_elems_;
 }
 
+template <typename key_t, typename value_t>
+template <typename Func>
+void LRUCache<key_t, value_t>::ForEach(const Func& func) const {
+  for (const auto& elem : elems_list_) {
+    func(elem.first, elem.second);
+  }
+}
+
 template <typename key_t, typename value_t>
 bool LRUCache<key_t, value_t>::Exists(const key_t& key) const {
   return elems_map_.find(key) != elems_map_.end();
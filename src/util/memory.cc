@@ -0,0 +1,246 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "util/memory.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+#include "util/misc.h"
+#include "util/string.h"
+
+namespace colmap {
+namespace {
+
+double BytesToMB(const size_t num_bytes) {
+  return num_bytes / (1024.0 * 1024.0);
+}
+
+}  // namespace
+
+size_t GetCurrentRSS() {
+#if defined(__linux__)
+  std::ifstream file("/proc/self/statm");
+  size_t num_total_pages = 0;
+  size_t num_resident_pages = 0;
+  if (!(file >> num_total_pages >> num_resident_pages)) {
+    return 0;
+  }
+  return num_resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#elif defined(__APPLE__)
+  mach_task_basic_info info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+    return 0;
+  }
+  return static_cast<size_t>(info.resident_size);
+#else
+  return 0;
+#endif
+}
+
+size_t GetPeakRSS() {
+#if defined(__linux__) || defined(__APPLE__)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#ifdef __APPLE__
+  // Reported in bytes on macOS.
+  return static_cast<size_t>(usage.ru_maxrss);
+#else
+  // Reported in kilobytes on Linux.
+  return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+  return 0;
+#endif
+}
+
+MemoryTracker& MemoryTracker::Get() {
+  static MemoryTracker tracker;
+  return tracker;
+}
+
+MemoryTracker::MemoryTracker()
+    : started_(false), start_time_(std::chrono::steady_clock::now()) {}
+
+MemoryTracker::~MemoryTracker() { Stop(); }
+
+void MemoryTracker::Start(const std::string& path) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  path_ = path;
+  start_time_ = std::chrono::steady_clock::now();
+  samples_.clear();
+  started_ = true;
+}
+
+void MemoryTracker::Stop() {
+  if (!started_.exchange(false)) {
+    return;
+  }
+
+  std::string path;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    path = path_;
+  }
+
+  PrintSummary();
+
+  if (!path.empty() && !Write(path)) {
+    std::cerr << "ERROR: Failed to write memory report to " << path
+              << std::endl;
+  }
+}
+
+void MemoryTracker::AddSample(const std::string& stage,
+                              const ContainerSizes& container_sizes) {
+  if (!IsStarted()) {
+    return;
+  }
+
+  Sample sample;
+  sample.stage = stage;
+  sample.current_rss = GetCurrentRSS();
+  sample.peak_rss = GetPeakRSS();
+  sample.container_sizes = container_sizes;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  sample.time = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start_time_)
+                    .count();
+  samples_.push_back(std::move(sample));
+}
+
+std::vector<MemoryTracker::Sample> MemoryTracker::Samples() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return samples_;
+}
+
+void MemoryTracker::PrintSummary() const {
+  struct StageSummary {
+    size_t num_samples = 0;
+    size_t max_current_rss = 0;
+    size_t max_peak_rss = 0;
+    std::map<std::string, size_t> max_container_sizes;
+  };
+
+  // Aggregate the samples per stage in the order of their first occurrence.
+  std::vector<std::string> stages;
+  std::map<std::string, StageSummary> summaries;
+  for (const auto& sample : Samples()) {
+    if (summaries.count(sample.stage) == 0) {
+      stages.push_back(sample.stage);
+    }
+    StageSummary& summary = summaries[sample.stage];
+    summary.num_samples += 1;
+    summary.max_current_rss =
+        std::max(summary.max_current_rss, sample.current_rss);
+    summary.max_peak_rss = std::max(summary.max_peak_rss, sample.peak_rss);
+    for (const auto& container_size : sample.container_sizes) {
+      size_t& max_size = summary.max_container_sizes[container_size.first];
+      max_size = std::max(max_size, container_size.second);
+    }
+  }
+
+  PrintHeading1("Memory usage");
+
+  size_t max_stage_length = 5;
+  for (const auto& stage : stages) {
+    max_stage_length = std::max(max_stage_length, stage.size());
+  }
+
+  std::cout << std::left << std::setw(max_stage_length) << "Stage" << std::right
+            << std::setw(10) << "Samples" << std::setw(12) << "RSS [MB]"
+            << std::setw(12) << "Peak [MB]"
+            << "  Containers [MB]" << std::endl;
+
+  for (const auto& stage : stages) {
+    const StageSummary& summary = summaries.at(stage);
+    std::cout << std::left << std::setw(max_stage_length) << stage
+              << std::right << std::setw(10) << summary.num_samples
+              << std::setw(12)
+              << StringPrintf("%.1f", BytesToMB(summary.max_current_rss))
+              << std::setw(12)
+              << StringPrintf("%.1f", BytesToMB(summary.max_peak_rss));
+    for (const auto& container_size : summary.max_container_sizes) {
+      std::cout << StringPrintf("  %s=%.1f", container_size.first.c_str(),
+                                BytesToMB(container_size.second));
+    }
+    std::cout << std::endl;
+  }
+
+  std::cout << std::endl
+            << StringPrintf("Peak RSS: %.1f MB", BytesToMB(GetPeakRSS()))
+            << std::endl;
+}
+
+bool MemoryTracker::Write(const std::string& path) const {
+  std::ofstream file(path, std::ios::trunc);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  file << "{\"peak_rss\":" << GetPeakRSS() << ",\"samples\":[";
+
+  const std::vector<Sample> samples = Samples();
+  for (size_t i = 0; i < samples.size(); ++i) {
+    const Sample& sample = samples[i];
+    file << (i == 0 ? "" : ",") << "\n{\"stage\":\""
+         << EscapeJSON(sample.stage) << "\",\"time\":" << sample.time
+         << ",\"current_rss\":" << sample.current_rss
+         << ",\"peak_rss\":" << sample.peak_rss << ",\"containers\":{";
+    for (size_t j = 0; j < sample.container_sizes.size(); ++j) {
+      file << (j == 0 ? "" : ",") << "\""
+           << EscapeJSON(sample.container_sizes[j].first)
+           << "\":" << sample.container_sizes[j].second;
+    }
+    file << "}}";
+  }
+
+  file << "\n]}\n";
+
+  return file.good();
+}
+
+}  // namespace colmap
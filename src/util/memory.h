@@ -0,0 +1,160 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef COLMAP_SRC_UTIL_MEMORY_H_
+#define COLMAP_SRC_UTIL_MEMORY_H_
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace colmap {
+
+// Resident set size of the process in bytes or 0, if it cannot be determined
+// on the current platform.
+size_t GetCurrentRSS();
+
+// Maximum resident set size of the process since its start in bytes or 0, if
+// it cannot be determined on the current platform.
+size_t GetPeakRSS();
+
+// Estimated size of a vector in memory, including its reserved capacity.
+template <typename T, typename Alloc>
+size_t VectorNumBytes(const std::vector<T, Alloc>& vec);
+
+// Estimated size of a node-based hash map in memory, i.e. its bucket array and
+// one node per element with the key, the mapped value, the next pointer, and
+// the cached hash value. Memory owned by the mapped values is not included.
+template <typename Map>
+size_t HashMapNumBytes(const Map& map);
+
+// Same as `HashMapNumBytes` but also includes the memory owned by the mapped
+// values, which must implement a `size_t NumBytes()` method that returns
+// their total size in memory.
+template <typename Map>
+size_t NestedHashMapNumBytes(const Map& map);
+
+// Records the memory usage of the process at the boundaries of the pipeline
+// stages. Every sample contains the current and the peak resident set size
+// and optionally the estimated sizes of the major containers alive at that
+// point, e.g.:
+//
+//    MemoryTracker::Get().AddSample(
+//        "LoadDatabase", {{"DatabaseCache", database_cache.NumBytes()}});
+//
+// The samples are only recorded after the tracker was started, e.g. through
+// the `memory_report_path` option, and a summary is printed and written as
+// JSON when the tracker is stopped. Since estimating the container sizes may
+// require a pass over the containers, callers should check `IsStarted` first.
+class MemoryTracker {
+ public:
+  typedef std::vector<std::pair<std::string, size_t>> ContainerSizes;
+
+  struct Sample {
+    std::string stage;
+    // Time in seconds since the tracker was started.
+    double time;
+    size_t current_rss;
+    size_t peak_rss;
+    ContainerSizes container_sizes;
+  };
+
+  // The global tracker, which writes the report when the program exits.
+  static MemoryTracker& Get();
+
+  ~MemoryTracker();
+
+  // Start recording samples, which are written to the given path when the
+  // tracker is stopped.
+  void Start(const std::string& path);
+
+  // Stop recording samples, print the summary, and write the report.
+  void Stop();
+
+  inline bool IsStarted() const;
+
+  // Record the memory usage at the end of the given stage. Thread-safe.
+  void AddSample(const std::string& stage,
+                 const ContainerSizes& container_sizes = ContainerSizes());
+
+  std::vector<Sample> Samples() const;
+
+  // Print a table with one row per stage containing the maximum of the
+  // resident set size and of the container sizes over all its samples.
+  void PrintSummary() const;
+
+  // Write all samples to a JSON file.
+  bool Write(const std::string& path) const;
+
+ private:
+  MemoryTracker();
+
+  std::atomic<bool> started_;
+  std::string path_;
+  std::chrono::steady_clock::time_point start_time_;
+
+  mutable std::mutex mutex_;
+  std::vector<Sample> samples_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Implementation
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename T, typename Alloc>
+size_t VectorNumBytes(const std::vector<T, Alloc>& vec) {
+  return vec.capacity() * sizeof(T);
+}
+
+template <typename Map>
+size_t HashMapNumBytes(const Map& map) {
+  return map.bucket_count() * sizeof(void*) +
+         map.size() * (sizeof(typename Map::value_type) + sizeof(void*) +
+                       sizeof(size_t));
+}
+
+template <typename Map>
+size_t NestedHashMapNumBytes(const Map& map) {
+  size_t num_bytes = HashMapNumBytes(map);
+  for (const auto& elem : map) {
+    num_bytes += elem.second.NumBytes() - sizeof(elem.second);
+  }
+  return num_bytes;
+}
+
+bool MemoryTracker::IsStarted() const {
+  return started_.load(std::memory_order_relaxed);
+}
+
+}  // namespace colmap
+
+#endif  // COLMAP_SRC_UTIL_MEMORY_H_
@@ -290,6 +290,37 @@ std::vector<double> CSVToVector(const std::string& csv) {
   return values;
 }
 
+std::string EscapeJSON(const std::string& str) {
+  std::string escaped;
+  escaped.reserve(str.size());
+  for (const char c : str) {
+    switch (c) {
+      case '"':
+        escaped += "\\\"";
+        break;
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      case '\r':
+        escaped += "\\r";
+        break;
+      case '\t':
+        escaped += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          escaped += StringPrintf("\\u%04x", static_cast<int>(c));
+        } else {
+          escaped += c;
+        }
+    }
+  }
+  return escaped;
+}
+
 std::vector<std::string> ReadTextFileLines(const std::string& path) {
   std::ifstream file(path);
   CHECK(file.is_open()) << path;
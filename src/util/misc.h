@@ -123,6 +123,9 @@ std::vector<T> CSVToVector(const std::string& csv);
 template <typename T>
 std::string VectorToCSV(const std::vector<T>& values);
 
+// Escape quotes, backslashes, and control characters for a JSON string.
+std::string EscapeJSON(const std::string& str);
+
 // Read contiguous binary blob from file.
 template <typename T>
 void ReadBinaryBlob(const std::string& path, std::vector<T>* data);
@@ -35,14 +35,17 @@
 
 #include <boost/property_tree/ini_parser.hpp>
 
+#include "base/database.h"
 #include "base/image_reader.h"
 #include "controllers/incremental_mapper.h"
 #include "feature/matching.h"
 #include "feature/sift.h"
 #include "optim/bundle_adjustment.h"
 #include "ui/render_options.h"
+#include "util/memory.h"
 #include "util/misc.h"
 #include "util/random.h"
+#include "util/trace.h"
 #include "util/version.h"
 
 namespace config = boost::program_options;
@@ -53,7 +56,10 @@ OptionManager::OptionManager(bool add_project_options) {
   project_path.reset(new std::string());
   database_path.reset(new std::string());
   image_path.reset(new std::string());
+  trace_path.reset(new std::string());
+  memory_report_path.reset(new std::string());
 
+  database.reset(new DatabaseOptions());
   image_reader.reset(new ImageReaderOptions());
   sift_extraction.reset(new SiftExtractionOptions());
   sift_matching.reset(new SiftMatchingOptions());
@@ -70,6 +76,8 @@ OptionManager::OptionManager(bool add_project_options) {
   desc_->add_options()("help,h", "");
 
   AddAndRegisterDefaultOption("random_seed", &kDefaultPRNGSeed);
+  AddAndRegisterDefaultOption("trace_path", trace_path.get());
+  AddAndRegisterDefaultOption("memory_report_path", memory_report_path.get());
 
   if (add_project_options) {
     desc_->add_options()("project_path", config::value<std::string>());
@@ -160,6 +168,11 @@ void OptionManager::AddDatabaseOptions() {
   added_database_options_ = true;
 
   AddAndRegisterRequiredOption("database_path", database_path.get());
+  AddAndRegisterDefaultOption("Database.use_wal", &database->use_wal);
+  AddAndRegisterDefaultOption("Database.mmap_size", &database->mmap_size);
+  AddAndRegisterDefaultOption("Database.cache_size", &database->cache_size);
+  AddAndRegisterDefaultOption("Database.busy_timeout",
+                              &database->busy_timeout);
 }
 
 void OptionManager::AddImageOptions() {
@@ -189,6 +202,10 @@ void OptionManager::AddExtractionOptions() {
                               &image_reader->default_focal_length_factor);
   AddAndRegisterDefaultOption("ImageReader.camera_mask_path",
                               &image_reader->camera_mask_path);
+  AddAndRegisterDefaultOption("ImageReader.manifest_path",
+                              &image_reader->manifest_path);
+  AddAndRegisterDefaultOption("ImageReader.num_threads",
+                              &image_reader->num_threads);
 
   AddAndRegisterDefaultOption("SiftExtraction.num_threads",
                               &sift_extraction->num_threads);
@@ -224,6 +241,10 @@ void OptionManager::AddExtractionOptions() {
                               &sift_extraction->dsp_max_scale);
   AddAndRegisterDefaultOption("SiftExtraction.dsp_num_scales",
                               &sift_extraction->dsp_num_scales);
+  AddAndRegisterDefaultOption("SiftExtraction.line_seed",
+                              &sift_extraction->line_seed);
+  AddAndRegisterDefaultOption("SiftExtraction.aligned_line_ratio",
+                              &sift_extraction->aligned_line_ratio);
 }
 
 void OptionManager::AddMatchingOptions() {
@@ -436,6 +457,18 @@ void OptionManager::AddMapperOptions() {
                               &mapper->triangulation.complete_max_reproj_error);
   AddAndRegisterDefaultOption("Mapper.tri_complete_max_transitivity",
                               &mapper->triangulation.complete_max_transitivity);
+  AddAndRegisterDefaultOption("Mapper.tri_refine_extended_tracks",
+                              &mapper->triangulation.refine_extended_tracks);
+  AddAndRegisterDefaultOption(
+      "Mapper.tri_guided_min_num_observations",
+      &mapper->triangulation.guided_min_num_observations);
+  AddAndRegisterDefaultOption("Mapper.tri_guided_num_seed_samples",
+                              &mapper->triangulation.guided_num_seed_samples);
+  AddAndRegisterDefaultOption("Mapper.tri_guided_max_num_trials",
+                              &mapper->triangulation.guided_max_num_trials);
+  AddAndRegisterDefaultOption(
+      "Mapper.tri_refine_min_num_observations",
+      &mapper->triangulation.refine_min_num_observations);
   AddAndRegisterDefaultOption("Mapper.tri_re_max_angle_error",
                               &mapper->triangulation.re_max_angle_error);
   AddAndRegisterDefaultOption("Mapper.tri_re_min_ratio",
@@ -456,6 +489,11 @@ void OptionManager::AddRenderOptions() {
 
   AddAndRegisterDefaultOption("Render.min_track_len", &render->min_track_len);
   AddAndRegisterDefaultOption("Render.max_error", &render->max_error);
+  AddAndRegisterDefaultOption("Render.max_screen_space_error",
+                              &render->max_screen_space_error);
+  AddAndRegisterDefaultOption("Render.max_frame_rate",
+                              &render->max_frame_rate);
+  // Deprecated and ignored.
   AddAndRegisterDefaultOption("Render.refresh_rate", &render->refresh_rate);
   AddAndRegisterDefaultOption("Render.adapt_refresh_rate",
                               &render->adapt_refresh_rate);
@@ -498,7 +536,10 @@ void OptionManager::ResetOptions(const bool reset_paths) {
     *project_path = "";
     *database_path = "";
     *image_path = "";
+    *trace_path = "";
+    *memory_report_path = "";
   }
+  *database = DatabaseOptions();
   *image_reader = ImageReaderOptions();
   *sift_extraction = SiftExtractionOptions();
   *sift_matching = SiftMatchingOptions();
@@ -524,6 +565,8 @@ bool OptionManager::Check() {
   if (added_image_options_)
     success = success && CHECK_OPTION_IMPL(ExistsDir(*image_path));
 
+  if (database) success = success && database->Check();
+
   if (image_reader) success = success && image_reader->Check();
   if (sift_extraction) success = success && sift_extraction->Check();
 
@@ -583,6 +626,14 @@ void OptionManager::Parse(const int argc, char** argv) {
     std::cerr << "ERROR: Invalid options provided." << std::endl;
     exit(EXIT_FAILURE);
   }
+
+  if (!trace_path->empty()) {
+    Tracer::Get().Start(*trace_path);
+  }
+
+  if (!memory_report_path->empty()) {
+    MemoryTracker::Get().Start(*memory_report_path);
+  }
 }
 
 bool OptionManager::Read(const std::string& path) {
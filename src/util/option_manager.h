@@ -40,6 +40,7 @@
 
 namespace colmap {
 
+struct DatabaseOptions;
 struct ImageReaderOptions;
 struct SiftExtractionOptions;
 struct SiftMatchingOptions;
@@ -105,6 +106,15 @@ class OptionManager {
   std::shared_ptr<std::string> database_path;
   std::shared_ptr<std::string> image_path;
 
+  // Path of the Chrome trace file, which is written at exit, if not empty.
+  std::shared_ptr<std::string> trace_path;
+
+  // Path of the JSON memory usage report, which is written at exit, if not
+  // empty.
+  std::shared_ptr<std::string> memory_report_path;
+
+  std::shared_ptr<DatabaseOptions> database;
+
   std::shared_ptr<ImageReaderOptions> image_reader;
   std::shared_ptr<SiftExtractionOptions> sift_extraction;
 
@@ -35,6 +35,7 @@
 
 #include <Eigen/Core>
 
+#include "util/endian.h"
 #include "util/logging.h"
 #include "util/misc.h"
 
@@ -330,55 +331,100 @@ void WriteTextPlyPoints(const std::string& path,
 void WriteBinaryPlyPoints(const std::string& path,
                           const std::vector<PlyPoint>& points,
                           const bool write_normal, const bool write_rgb) {
-  std::fstream text_file(path, std::ios::out);
-  CHECK(text_file.is_open()) << path;
+  BinaryPlyPointsWriter writer(path, points.size(), write_normal, write_rgb);
+  for (const auto& point : points) {
+    writer.Write(point);
+  }
+  writer.Close();
+}
 
-  text_file << "ply" << std::endl;
-  text_file << "format binary_little_endian 1.0" << std::endl;
-  text_file << "element vertex " << points.size() << std::endl;
-
-  text_file << "property float x" << std::endl;
-  text_file << "property float y" << std::endl;
-  text_file << "property float z" << std::endl;
+BinaryPlyPointsWriter::BinaryPlyPointsWriter(const std::string& path,
+                                             const size_t num_points,
+                                             const bool write_normal,
+                                             const bool write_rgb)
+    : path_(path),
+      num_points_(num_points),
+      write_normal_(write_normal),
+      write_rgb_(write_rgb),
+      num_written_points_(0),
+      file_(path, std::ios::out | std::ios::binary) {
+  CHECK(file_.is_open()) << path;
+
+  file_ << "ply" << std::endl;
+  file_ << "format binary_little_endian 1.0" << std::endl;
+  file_ << "element vertex " << num_points << std::endl;
+
+  file_ << "property float x" << std::endl;
+  file_ << "property float y" << std::endl;
+  file_ << "property float z" << std::endl;
 
   if (write_normal) {
-    text_file << "property float nx" << std::endl;
-    text_file << "property float ny" << std::endl;
-    text_file << "property float nz" << std::endl;
+    file_ << "property float nx" << std::endl;
+    file_ << "property float ny" << std::endl;
+    file_ << "property float nz" << std::endl;
   }
 
   if (write_rgb) {
-    text_file << "property uchar red" << std::endl;
-    text_file << "property uchar green" << std::endl;
-    text_file << "property uchar blue" << std::endl;
+    file_ << "property uchar red" << std::endl;
+    file_ << "property uchar green" << std::endl;
+    file_ << "property uchar blue" << std::endl;
   }
 
-  text_file << "end_header" << std::endl;
-  text_file.close();
+  file_ << "end_header" << std::endl;
 
-  std::fstream binary_file(path,
-                           std::ios::out | std::ios::binary | std::ios::app);
-  CHECK(binary_file.is_open()) << path;
+  const size_t kBufferSize = 1 << 20;
+  buffer_.reserve(kBufferSize);
+}
 
-  for (const auto& point : points) {
-    WriteBinaryLittleEndian<float>(&binary_file, point.x);
-    WriteBinaryLittleEndian<float>(&binary_file, point.y);
-    WriteBinaryLittleEndian<float>(&binary_file, point.z);
+BinaryPlyPointsWriter::~BinaryPlyPointsWriter() {
+  if (file_.is_open()) {
+    Flush();
+    file_.close();
+  }
+}
 
-    if (write_normal) {
-      WriteBinaryLittleEndian<float>(&binary_file, point.nx);
-      WriteBinaryLittleEndian<float>(&binary_file, point.ny);
-      WriteBinaryLittleEndian<float>(&binary_file, point.nz);
-    }
+void BinaryPlyPointsWriter::Write(const PlyPoint& point) {
+  CHECK_LT(num_written_points_, num_points_) << path_;
+  num_written_points_ += 1;
 
-    if (write_rgb) {
-      WriteBinaryLittleEndian<uint8_t>(&binary_file, point.r);
-      WriteBinaryLittleEndian<uint8_t>(&binary_file, point.g);
-      WriteBinaryLittleEndian<uint8_t>(&binary_file, point.b);
-    }
+  Append<float>(point.x);
+  Append<float>(point.y);
+  Append<float>(point.z);
+
+  if (write_normal_) {
+    Append<float>(point.nx);
+    Append<float>(point.ny);
+    Append<float>(point.nz);
   }
 
-  binary_file.close();
+  if (write_rgb_) {
+    Append<uint8_t>(point.r);
+    Append<uint8_t>(point.g);
+    Append<uint8_t>(point.b);
+  }
+
+  if (buffer_.size() + sizeof(PlyPoint) > buffer_.capacity()) {
+    Flush();
+  }
+}
+
+void BinaryPlyPointsWriter::Close() {
+  CHECK_EQ(num_written_points_, num_points_) << path_;
+  Flush();
+  file_.close();
+}
+
+template <typename T>
+void BinaryPlyPointsWriter::Append(const T value) {
+  const T little_endian_value = NativeToLittleEndian<T>(value);
+  const char* bytes = reinterpret_cast<const char*>(&little_endian_value);
+  buffer_.insert(buffer_.end(), bytes, bytes + sizeof(T));
+}
+
+void BinaryPlyPointsWriter::Flush() {
+  file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  CHECK(file_.good()) << path_;
+  buffer_.clear();
 }
 
 void WriteTextPlyMesh(const std::string& path, const PlyMesh& mesh) {
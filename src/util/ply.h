@@ -32,6 +32,7 @@
 #ifndef COLMAP_SRC_UTIL_PLY_H_
 #define COLMAP_SRC_UTIL_PLY_H_
 
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -92,6 +93,35 @@ void WriteBinaryPlyPoints(const std::string& path,
                           const bool write_normal = true,
                           const bool write_rgb = true);
 
+// Writer of a binary PLY point cloud, which writes the points one at a time
+// through a buffer, so that the points need not be stored in memory at once.
+// The number of points must be known in advance for the header.
+class BinaryPlyPointsWriter {
+ public:
+  BinaryPlyPointsWriter(const std::string& path, const size_t num_points,
+                        const bool write_normal = true,
+                        const bool write_rgb = true);
+  ~BinaryPlyPointsWriter();
+
+  void Write(const PlyPoint& point);
+
+  // Flush the buffer and close the file, after all points were written.
+  void Close();
+
+ private:
+  template <typename T>
+  void Append(const T value);
+  void Flush();
+
+  const std::string path_;
+  const size_t num_points_;
+  const bool write_normal_;
+  const bool write_rgb_;
+  size_t num_written_points_;
+  std::ofstream file_;
+  std::vector<char> buffer_;
+};
+
 // Write PLY mesh to text or binary file.
 void WriteTextPlyMesh(const std::string& path, const PlyMesh& mesh);
 void WriteBinaryPlyMesh(const std::string& path, const PlyMesh& mesh);
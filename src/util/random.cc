@@ -49,4 +49,87 @@ void SetPRNGSeed(unsigned seed) {
   srand(seed);
 }
 
+PhiloxRandomGenerator::PhiloxRandomGenerator(const uint64_t key,
+                                             const uint64_t stream)
+    : key_{{static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32)}},
+      counter_{{0, 0, static_cast<uint32_t>(stream),
+                static_cast<uint32_t>(stream >> 32)}},
+      block_idx_(block_.size()) {}
+
+uint32_t PhiloxRandomGenerator::UniformInteger(const uint32_t max) {
+  if (max == UINT32_MAX) {
+    return (*this)();
+  }
+
+  // Rejection sampling to avoid the modulo bias.
+  const uint32_t range = max + 1;
+  const uint32_t threshold = (UINT32_MAX - range + 1) % range;
+  while (true) {
+    const uint32_t value = (*this)();
+    if (value >= threshold) {
+      return value % range;
+    }
+  }
+}
+
+double PhiloxRandomGenerator::UniformReal(const double min, const double max) {
+  // Combine two draws into a 53-bit mantissa.
+  const uint64_t high = (*this)() >> 5;
+  const uint64_t low = (*this)() >> 6;
+  const double unit = ((high << 26) + low) * (1.0 / 9007199254740992.0);
+  return min + unit * (max - min);
+}
+
+uint64_t PhiloxRandomGenerator::MakeKey(const unsigned seed,
+                                        const std::string& str) {
+  // FNV-1a hash of the string, finalized together with the seed by the
+  // SplitMix64 mixing function.
+  uint64_t hash = 14695981039346656037ULL;
+  for (const char c : str) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ULL;
+  }
+
+  uint64_t key = hash ^ (static_cast<uint64_t>(seed) * 0x9E3779B97F4A7C15ULL);
+  key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+  return key ^ (key >> 31);
+}
+
+std::array<uint32_t, 4> PhiloxRandomGenerator::EncryptBlock(
+    const std::array<uint32_t, 4>& counter,
+    const std::array<uint32_t, 2>& key) {
+  const uint32_t kMultiplier0 = 0xD2511F53;
+  const uint32_t kMultiplier1 = 0xCD9E8D57;
+  const uint32_t kWeyl0 = 0x9E3779B9;
+  const uint32_t kWeyl1 = 0xBB67AE85;
+  const int kNumRounds = 10;
+
+  std::array<uint32_t, 4> block = counter;
+  std::array<uint32_t, 2> round_key = key;
+  for (int round = 0; round < kNumRounds; ++round) {
+    const uint64_t product0 = static_cast<uint64_t>(kMultiplier0) * block[0];
+    const uint64_t product1 = static_cast<uint64_t>(kMultiplier1) * block[2];
+    block = {{static_cast<uint32_t>(product1 >> 32) ^ block[1] ^ round_key[0],
+              static_cast<uint32_t>(product1),
+              static_cast<uint32_t>(product0 >> 32) ^ block[3] ^ round_key[1],
+              static_cast<uint32_t>(product0)}};
+    round_key[0] += kWeyl0;
+    round_key[1] += kWeyl1;
+  }
+
+  return block;
+}
+
+void PhiloxRandomGenerator::GenerateBlock() {
+  block_ = EncryptBlock(counter_, key_);
+  block_idx_ = 0;
+
+  // The first half of the counter enumerates the blocks of the stream.
+  counter_[0] += 1;
+  if (counter_[0] == 0) {
+    counter_[1] += 1;
+  }
+}
+
 }  // namespace colmap
@@ -32,8 +32,11 @@
 #ifndef COLMAP_SRC_UTIL_RANDOM_H_
 #define COLMAP_SRC_UTIL_RANDOM_H_
 
+#include <array>
 #include <chrono>
+#include <cstdint>
 #include <random>
+#include <string>
 #include <thread>
 
 #include "util/logging.h"
@@ -81,6 +84,51 @@ T RandomGaussian(const T mean, const T stddev);
 template <typename T>
 void Shuffle(const uint32_t num_to_shuffle, std::vector<T>* elems);
 
+// Counter-based random number generator (Philox4x32-10) as proposed in
+// "Parallel Random Numbers: As Easy as 1, 2, 3", J. K. Salmon et al., SC 2011.
+//
+// The generated sequence only depends on the key and the stream, so that many
+// independent generators can be created without any shared state, e.g., one
+// per image keyed on its name. In contrast to the standard distributions, the
+// `UniformInteger` and `UniformReal` methods produce the same values on all
+// platforms. The generator also satisfies UniformRandomBitGenerator.
+class PhiloxRandomGenerator {
+ public:
+  typedef uint32_t result_type;
+
+  explicit PhiloxRandomGenerator(const uint64_t key, const uint64_t stream = 0);
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return UINT32_MAX; }
+
+  // Generate the next 32-bit random number.
+  inline result_type operator()();
+
+  // Generate uniformly distributed random integer number in [0, max].
+  uint32_t UniformInteger(const uint32_t max);
+
+  // Generate uniformly distributed random real number in [min, max).
+  double UniformReal(const double min, const double max);
+
+  // Derive a generator key from a user seed and a string, e.g. an image name.
+  static uint64_t MakeKey(const unsigned seed, const std::string& str);
+
+  // Encrypt a single counter block with the given key, where the generator
+  // uses the counter (block index, stream) and the key in little-endian words.
+  static std::array<uint32_t, 4> EncryptBlock(
+      const std::array<uint32_t, 4>& counter,
+      const std::array<uint32_t, 2>& key);
+
+ private:
+  // Encrypt the current counter into the output block and increment it.
+  void GenerateBlock();
+
+  std::array<uint32_t, 2> key_;
+  std::array<uint32_t, 4> counter_;
+  std::array<uint32_t, 4> block_;
+  size_t block_idx_;
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 // Implementation
 ////////////////////////////////////////////////////////////////////////////////
@@ -127,6 +175,13 @@ void Shuffle(const uint32_t num_to_shuffle, std::vector<T>* elems) {
   }
 }
 
+PhiloxRandomGenerator::result_type PhiloxRandomGenerator::operator()() {
+  if (block_idx_ == block_.size()) {
+    GenerateBlock();
+  }
+  return block_[block_idx_++];
+}
+
 }  // namespace colmap
 
 #endif  // COLMAP_SRC_UTIL_RANDOM_H_
@@ -0,0 +1,94 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#define TEST_NAME "util/random"
+#include "util/testing.h"
+
+#include "util/random.h"
+
+using namespace colmap;
+
+// Known-answer vectors of philox4x32-10 from the Random123 distribution.
+BOOST_AUTO_TEST_CASE(TestPhiloxKnownAnswers) {
+  const std::array<uint32_t, 4> block1 =
+      PhiloxRandomGenerator::EncryptBlock({{0, 0, 0, 0}}, {{0, 0}});
+  BOOST_CHECK_EQUAL(block1[0], 0x6627e8d5);
+  BOOST_CHECK_EQUAL(block1[1], 0xe169c58d);
+  BOOST_CHECK_EQUAL(block1[2], 0xbc57ac4c);
+  BOOST_CHECK_EQUAL(block1[3], 0x9b00dbd8);
+
+  const std::array<uint32_t, 4> block2 = PhiloxRandomGenerator::EncryptBlock(
+      {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}},
+      {{0xffffffff, 0xffffffff}});
+  BOOST_CHECK_EQUAL(block2[0], 0x408f276d);
+  BOOST_CHECK_EQUAL(block2[1], 0x41c83b0e);
+  BOOST_CHECK_EQUAL(block2[2], 0xa20bc7c6);
+  BOOST_CHECK_EQUAL(block2[3], 0x6d5451fd);
+
+  const std::array<uint32_t, 4> block3 = PhiloxRandomGenerator::EncryptBlock(
+      {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}},
+      {{0xa4093822, 0x299f31d0}});
+  BOOST_CHECK_EQUAL(block3[0], 0xd16cfe09);
+  BOOST_CHECK_EQUAL(block3[1], 0x94fdcceb);
+  BOOST_CHECK_EQUAL(block3[2], 0x5001e420);
+  BOOST_CHECK_EQUAL(block3[3], 0x24126ea1);
+}
+
+BOOST_AUTO_TEST_CASE(TestPhiloxGenerator) {
+  PhiloxRandomGenerator zero_generator(0);
+  BOOST_CHECK_EQUAL(zero_generator(), 0x6627e8d5);
+  BOOST_CHECK_EQUAL(zero_generator(), 0xe169c58d);
+  BOOST_CHECK_EQUAL(zero_generator(), 0xbc57ac4c);
+  BOOST_CHECK_EQUAL(zero_generator(), 0x9b00dbd8);
+
+  const uint64_t key = 0x299f31d0a4093822;
+  const uint64_t stream = 0x0370734413198a2e;
+  PhiloxRandomGenerator generator(key, stream);
+  for (uint32_t block_idx = 0; block_idx < 3; ++block_idx) {
+    const std::array<uint32_t, 4> block = PhiloxRandomGenerator::EncryptBlock(
+        {{block_idx, 0, 0x13198a2e, 0x03707344}}, {{0xa4093822, 0x299f31d0}});
+    for (const uint32_t value : block) {
+      BOOST_CHECK_EQUAL(generator(), value);
+    }
+  }
+
+  PhiloxRandomGenerator other_stream_generator(key, stream + 1);
+  PhiloxRandomGenerator same_stream_generator(key, stream);
+  BOOST_CHECK_NE(other_stream_generator(), same_stream_generator());
+}
+
+BOOST_AUTO_TEST_CASE(TestPhiloxUniform) {
+  PhiloxRandomGenerator generator(PhiloxRandomGenerator::MakeKey(0, "image"));
+  for (int i = 0; i < 1000; ++i) {
+    BOOST_CHECK_LE(generator.UniformInteger(10), 10);
+    const double value = generator.UniformReal(-1, 2);
+    BOOST_CHECK_GE(value, -1);
+    BOOST_CHECK_LT(value, 2);
+  }
+}
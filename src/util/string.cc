@@ -32,10 +32,16 @@
 #include "util/string.h"
 
 #include <algorithm>
+#include <clocale>
 #include <cstdarg>
+#include <cstdlib>
 #include <fstream>
 #include <sstream>
 
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+
 #include <boost/algorithm/string.hpp>
 
 namespace colmap {
@@ -126,6 +132,19 @@ bool IsNotWhiteSpace(const int character) {
          character != '\t';
 }
 
+// The locale is created once and shared by all threads.
+#ifdef _MSC_VER
+_locale_t GetNumericCLocale() {
+  static const _locale_t locale = _create_locale(LC_NUMERIC, "C");
+  return locale;
+}
+#else
+locale_t GetNumericCLocale() {
+  static const locale_t locale = newlocale(LC_NUMERIC_MASK, "C", nullptr);
+  return locale;
+}
+#endif
+
 }  // namespace
 
 std::string StringPrintf(const char* format, ...) {
@@ -201,4 +220,20 @@ bool StringContains(const std::string& str, const std::string& sub_str) {
   return str.find(sub_str) != std::string::npos;
 }
 
+double StringToDouble(const char* str, char** str_end) {
+#ifdef _MSC_VER
+  return _strtod_l(str, str_end, GetNumericCLocale());
+#else
+  return strtod_l(str, str_end, GetNumericCLocale());
+#endif
+}
+
+float StringToFloat(const char* str, char** str_end) {
+#ifdef _MSC_VER
+  return _strtof_l(str, str_end, GetNumericCLocale());
+#else
+  return strtof_l(str, str_end, GetNumericCLocale());
+#endif
+}
+
 }  // namespace colmap
@@ -68,6 +68,12 @@ void StringToUpper(std::string* str);
 // Check whether the sub-string is contained in the given string.
 bool StringContains(const std::string& str, const std::string& sub_str);
 
+// Parse a floating point number like `std::strtod` and `std::strtof`, but
+// always in the "C" locale, i.e. independent of the global locale, which the
+// GUI sets from the environment and which may then expect a decimal comma.
+double StringToDouble(const char* str, char** str_end);
+float StringToFloat(const char* str, char** str_end);
+
 }  // namespace colmap
 
 #endif  // COLMAP_SRC_UTIL_STRING_H_
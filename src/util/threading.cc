@@ -266,6 +266,181 @@ int ThreadPool::GetThreadIndex() {
   return thread_id_to_index_.at(GetThreadId());
 }
 
+namespace {
+
+// The work-stealing pool and worker index of the current thread, if it is a
+// worker of a work-stealing pool.
+thread_local const WorkStealingThreadPool* current_work_stealing_pool = nullptr;
+thread_local int current_work_stealing_index = -1;
+
+}  // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(const int num_threads)
+    : num_queued_tasks_(0), num_sleeping_workers_(0), stopped_(false) {
+  const int num_effective_threads = GetEffectiveNumThreads(num_threads);
+  for (int index = 0; index <= num_effective_threads; ++index) {
+    deques_.emplace_back(new TaskDeque());
+  }
+  for (int index = 0; index < num_effective_threads; ++index) {
+    workers_.emplace_back(&WorkStealingThreadPool::WorkerFunc, this, index);
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() { Stop(); }
+
+void WorkStealingThreadPool::Stop() {
+  if (stopped_.exchange(true)) {
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    sleep_condition_.notify_all();
+  }
+
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void WorkStealingThreadPool::Push(const Task& task) {
+  // Count the task before it becomes visible, so that the counter never
+  // drops below zero when the task is popped right away.
+  num_queued_tasks_.fetch_add(1);
+
+  const size_t deque_idx =
+      current_work_stealing_pool == this
+          ? static_cast<size_t>(current_work_stealing_index)
+          : workers_.size();
+  {
+    TaskDeque& deque = *deques_[deque_idx];
+    std::unique_lock<std::mutex> lock(deque.mutex);
+    deque.tasks.push_back(task);
+  }
+
+  if (num_sleeping_workers_.load() > 0) {
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    sleep_condition_.notify_one();
+  }
+}
+
+bool WorkStealingThreadPool::TryPop(Task* task) {
+  if (num_queued_tasks_.load() <= 0) {
+    return false;
+  }
+
+  size_t own_deque_idx = workers_.size();
+  if (current_work_stealing_pool == this) {
+    own_deque_idx = static_cast<size_t>(current_work_stealing_index);
+    // Pop the most recently pushed task of the own deque, which likely
+    // belongs to the innermost task group of this worker.
+    TaskDeque& deque = *deques_[own_deque_idx];
+    std::unique_lock<std::mutex> lock(deque.mutex);
+    if (!deque.tasks.empty()) {
+      *task = deque.tasks.back();
+      deque.tasks.pop_back();
+      num_queued_tasks_.fetch_sub(1);
+      return true;
+    }
+  }
+
+  // Steal the oldest task of another deque, which likely covers the largest
+  // range of work.
+  for (size_t i = 1; i <= deques_.size(); ++i) {
+    const size_t deque_idx = (own_deque_idx + i) % deques_.size();
+    TaskDeque& deque = *deques_[deque_idx];
+    std::unique_lock<std::mutex> lock(deque.mutex);
+    if (!deque.tasks.empty()) {
+      *task = deque.tasks.front();
+      deque.tasks.pop_front();
+      num_queued_tasks_.fetch_sub(1);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void WorkStealingThreadPool::Execute(const Task& task) {
+  // Tasks of a stopped pool are only popped to release their task groups.
+  if (!stopped_.load() && !task.task_group->IsCancelled()) {
+    task.func(task.context, task.begin, task.end);
+  }
+  task.task_group->num_pending_tasks_.fetch_sub(1, std::memory_order_release);
+}
+
+void WorkStealingThreadPool::WorkerFunc(const int index) {
+  current_work_stealing_pool = this;
+  current_work_stealing_index = index;
+
+  while (true) {
+    Task task;
+    if (TryPop(&task)) {
+      Execute(task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    num_sleeping_workers_.fetch_add(1);
+    sleep_condition_.wait(lock, [this]() {
+      return stopped_.load() || num_queued_tasks_.load() > 0;
+    });
+    num_sleeping_workers_.fetch_sub(1);
+
+    if (stopped_) {
+      return;
+    }
+  }
+}
+
+TaskGroup::TaskGroup(WorkStealingThreadPool* thread_pool)
+    : thread_pool_(thread_pool), num_pending_tasks_(0), cancelled_(false) {}
+
+TaskGroup::~TaskGroup() { Wait(); }
+
+void TaskGroup::Run(const std::function<void()>& func) {
+  std::function<void()>* function = nullptr;
+  {
+    std::unique_lock<std::mutex> lock(functions_mutex_);
+    functions_.push_back(func);
+    function = &functions_.back();
+  }
+  RunRange(&TaskGroup::RunFunction, function, 0, 0);
+}
+
+void TaskGroup::RunRange(void (*func)(void* context, size_t begin, size_t end),
+                         void* context, const size_t begin, const size_t end) {
+  num_pending_tasks_.fetch_add(1, std::memory_order_relaxed);
+
+  WorkStealingThreadPool::Task task;
+  task.func = func;
+  task.context = context;
+  task.begin = begin;
+  task.end = end;
+  task.task_group = this;
+  thread_pool_->Push(task);
+}
+
+void TaskGroup::Wait() {
+  while (num_pending_tasks_.load(std::memory_order_acquire) > 0) {
+    WorkStealingThreadPool::Task task;
+    if (thread_pool_->TryPop(&task)) {
+      thread_pool_->Execute(task);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(functions_mutex_);
+  functions_.clear();
+}
+
+void TaskGroup::Cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+
+void TaskGroup::RunFunction(void* context, size_t, size_t) {
+  (*static_cast<std::function<void()>*>(context))();
+}
+
 int GetEffectiveNumThreads(const int num_threads) {
   int num_effective_threads = num_threads;
   if (num_threads <= 0) {
@@ -34,10 +34,13 @@
 
 #include <atomic>
 #include <climits>
+#include <deque>
 #include <functional>
 #include <future>
 #include <list>
+#include <memory>
 #include <queue>
+#include <stdexcept>
 #include <unordered_map>
 
 #include "util/timer.h"
@@ -249,6 +252,133 @@ class ThreadPool {
   std::unordered_map<std::thread::id, int> thread_id_to_index_;
 };
 
+class TaskGroup;
+
+// A thread pool, in which every worker has its own deque of tasks and idle
+// workers steal tasks from the other workers. In contrast to `ThreadPool`,
+// submitting a task neither allocates a future nor takes a global lock, which
+// makes it suitable for fine-grained parallelism. Tasks are submitted through
+// a `TaskGroup` or `ParallelFor`:
+//
+//    WorkStealingThreadPool thread_pool;
+//    TaskGroup task_group(&thread_pool);
+//    for (int i = 0; i < 10; ++i) {
+//      task_group.Run([i]() { /* Do some work */ });
+//    }
+//    task_group.Wait();
+//
+//    ParallelFor(&thread_pool, 0, 1000, 16, [](const size_t i) { /* ... */ });
+//
+// A thread waiting for a task group executes pending tasks of the pool in the
+// meantime, so that task groups and parallel loops can be nested inside of
+// tasks without deadlocking the pool.
+class WorkStealingThreadPool {
+ public:
+  static const int kMaxNumThreads = -1;
+
+  explicit WorkStealingThreadPool(const int num_threads = kMaxNumThreads);
+  ~WorkStealingThreadPool();
+
+  inline size_t NumThreads() const;
+
+  // Stop the execution of all workers. Tasks that have not started yet are
+  // discarded when their task group is waited for.
+  void Stop();
+
+ private:
+  friend class TaskGroup;
+
+  // A task executes the function on a range of indices. Tasks are plain data,
+  // such that pushing and popping them does not allocate.
+  struct Task {
+    void (*func)(void* context, size_t begin, size_t end) = nullptr;
+    void* context = nullptr;
+    size_t begin = 0;
+    size_t end = 0;
+    TaskGroup* task_group = nullptr;
+  };
+
+  struct TaskDeque {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  // Push the task to the deque of the current worker or, if called from a
+  // thread outside of the pool, to the shared deque.
+  void Push(const Task& task);
+
+  // Pop a task from the back of the current worker's deque or steal one from
+  // the front of the other deques.
+  bool TryPop(Task* task);
+
+  void Execute(const Task& task);
+
+  void WorkerFunc(const int index);
+
+  std::vector<std::thread> workers_;
+
+  // One deque per worker followed by the shared deque for external threads.
+  std::vector<std::unique_ptr<TaskDeque>> deques_;
+
+  std::atomic<int64_t> num_queued_tasks_;
+  std::atomic<int> num_sleeping_workers_;
+  std::atomic<bool> stopped_;
+
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_condition_;
+};
+
+// A group of tasks executed by a work-stealing thread pool, which can be
+// waited for and cancelled as a whole.
+class TaskGroup {
+ public:
+  explicit TaskGroup(WorkStealingThreadPool* thread_pool);
+
+  // Waits for the remaining tasks.
+  ~TaskGroup();
+
+  // Add a new task to the group.
+  void Run(const std::function<void()>& func);
+
+  // Add a task, which executes `func(context, begin, end)`, to the group.
+  // In contrast to `Run`, this does not allocate any memory.
+  void RunRange(void (*func)(void* context, size_t begin, size_t end),
+                void* context, const size_t begin, const size_t end);
+
+  // Wait until all tasks of the group are finished. The calling thread
+  // executes pending tasks of the pool while waiting.
+  void Wait();
+
+  // Skip all tasks of the group that have not started yet. Running tasks may
+  // query `IsCancelled` to finish early.
+  void Cancel();
+  inline bool IsCancelled() const;
+
+ private:
+  friend class WorkStealingThreadPool;
+
+  static void RunFunction(void* context, size_t begin, size_t end);
+
+  WorkStealingThreadPool* thread_pool_;
+
+  std::atomic<size_t> num_pending_tasks_;
+  std::atomic<bool> cancelled_;
+
+  // Storage of the functions added through `Run`, whose elements do not move
+  // when new functions are added.
+  std::mutex functions_mutex_;
+  std::list<std::function<void()>> functions_;
+};
+
+// Execute `func(i)` for all indices in [begin, end) using the given thread
+// pool. The range is recursively split into chunks of at least `grain_size`
+// indices, which idle workers steal. The calling thread participates in the
+// work and no memory is allocated per index or chunk.
+template <typename func_t>
+void ParallelFor(WorkStealingThreadPool* thread_pool, const size_t begin,
+                 const size_t end, const size_t grain_size,
+                 const func_t& func);
+
 // A job queue class for the producer-consumer paradigm.
 //
 //    JobQueue<int> job_queue;
@@ -276,7 +406,7 @@ class JobQueue {
   class Job {
    public:
     Job() : valid_(false) {}
-    explicit Job(const T& data) : data_(data), valid_(true) {}
+    explicit Job(T data) : data_(std::move(data)), valid_(true) {}
 
     // Check whether the data is valid.
     bool IsValid() const { return valid_; }
@@ -290,6 +420,9 @@ class JobQueue {
     bool valid_;
   };
 
+  // The default capacity of the queue.
+  static const size_t kDefaultMaxNumJobs = 1024;
+
   JobQueue();
   explicit JobQueue(const size_t max_num_jobs);
   ~JobQueue();
@@ -299,6 +432,7 @@ class JobQueue {
 
   // Push a new job to the queue. Waits if the number of jobs is exceeded.
   bool Push(const T& data);
+  bool Push(T&& data);
 
   // Pop a job from the queue. Waits if there is no job in the queue.
   Job Pop();
@@ -313,13 +447,42 @@ class JobQueue {
   void Clear();
 
  private:
-  size_t max_num_jobs_;
-  std::atomic<bool> stop_;
-  std::queue<T> jobs_;
+  // The jobs are stored in a bounded ring buffer, which multiple producers
+  // and consumers access without locks, see "Bounded MPMC queue", D. Vyukov.
+  // The sequence number of a slot tells whether the slot is ready to be
+  // written (2 * position) or read (2 * position + 1) at a given position.
+  // The factor two makes the states unique even for a capacity of one.
+  // Threads only block on the condition variables if the queue is full or
+  // empty.
+  struct Slot {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  bool TryPush(T* data);
+  bool TryPop(T* data);
+
+  // Wake up the waiting threads, if there are any.
+  void Notify(const std::atomic<int>& num_waiters,
+              std::condition_variable* condition, const bool notify_all);
+
+  const size_t max_num_jobs_;
+  std::unique_ptr<Slot[]> slots_;
+
+  // Place the positions on separate cache lines to avoid false sharing
+  // between producers and consumers.
+  alignas(64) std::atomic<size_t> push_pos_;
+  alignas(64) std::atomic<size_t> pop_pos_;
+
+  alignas(64) std::atomic<bool> stop_;
+
   std::mutex mutex_;
   std::condition_variable push_condition_;
   std::condition_variable pop_condition_;
   std::condition_variable empty_condition_;
+  std::atomic<int> num_push_waiters_;
+  std::atomic<int> num_pop_waiters_;
+  std::atomic<int> num_empty_waiters_;
 };
 
 // Return the number of logical CPU cores if num_threads <= 0,
@@ -355,12 +518,81 @@ auto ThreadPool::AddTask(func_t&& f, args_t&&... args)
   return result;
 }
 
+size_t WorkStealingThreadPool::NumThreads() const { return workers_.size(); }
+
+bool TaskGroup::IsCancelled() const {
+  return cancelled_.load(std::memory_order_relaxed);
+}
+
+namespace internal {
+
+template <typename func_t>
+struct ParallelForContext {
+  const func_t* func;
+  TaskGroup* task_group;
+  size_t grain_size;
+
+  static void Run(void* context, size_t begin, size_t end) {
+    const auto* for_context = static_cast<ParallelForContext*>(context);
+    // Split off the upper halves of the range as new tasks, which can be
+    // stolen by idle workers, until the remaining chunk is small enough.
+    while (end - begin > for_context->grain_size) {
+      const size_t mid = begin + (end - begin) / 2;
+      for_context->task_group->RunRange(&Run, context, mid, end);
+      end = mid;
+    }
+    for (size_t i = begin; i < end; ++i) {
+      (*for_context->func)(i);
+    }
+  }
+};
+
+}  // namespace internal
+
+template <typename func_t>
+void ParallelFor(WorkStealingThreadPool* thread_pool, const size_t begin,
+                 const size_t end, const size_t grain_size,
+                 const func_t& func) {
+  if (begin >= end) {
+    return;
+  }
+
+  const size_t effective_grain_size = std::max<size_t>(grain_size, 1);
+
+  if (thread_pool == nullptr || end - begin <= effective_grain_size) {
+    for (size_t i = begin; i < end; ++i) {
+      func(i);
+    }
+    return;
+  }
+
+  TaskGroup task_group(thread_pool);
+  internal::ParallelForContext<func_t> context{&func, &task_group,
+                                               effective_grain_size};
+  internal::ParallelForContext<func_t>::Run(&context, begin, end);
+  task_group.Wait();
+}
+
 template <typename T>
-JobQueue<T>::JobQueue() : JobQueue(std::numeric_limits<size_t>::max()) {}
+JobQueue<T>::JobQueue() : JobQueue(kDefaultMaxNumJobs) {}
 
 template <typename T>
 JobQueue<T>::JobQueue(const size_t max_num_jobs)
-    : max_num_jobs_(max_num_jobs), stop_(false) {}
+    : max_num_jobs_(max_num_jobs),
+      slots_(new Slot[max_num_jobs]),
+      push_pos_(0),
+      pop_pos_(0),
+      stop_(false),
+      num_push_waiters_(0),
+      num_pop_waiters_(0),
+      num_empty_waiters_(0) {
+  if (max_num_jobs_ == 0) {
+    throw std::invalid_argument("Job queue must have a positive capacity.");
+  }
+  for (size_t i = 0; i < max_num_jobs_; ++i) {
+    slots_[i].sequence.store(2 * i, std::memory_order_relaxed);
+  }
+}
 
 template <typename T>
 JobQueue<T>::~JobQueue() {
@@ -369,64 +601,148 @@ JobQueue<T>::~JobQueue() {
 
 template <typename T>
 size_t JobQueue<T>::Size() {
-  std::unique_lock<std::mutex> lock(mutex_);
-  return jobs_.size();
+  // Load the pop position first, since the push position is never behind it.
+  const size_t pop_pos = pop_pos_.load();
+  const size_t push_pos = push_pos_.load();
+  return push_pos - pop_pos;
 }
 
 template <typename T>
 bool JobQueue<T>::Push(const T& data) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  while (jobs_.size() >= max_num_jobs_ && !stop_) {
-    pop_condition_.wait(lock);
-  }
-  if (stop_) {
-    return false;
-  } else {
-    jobs_.push(data);
-    push_condition_.notify_one();
-    return true;
+  T data_copy(data);
+  return Push(std::move(data_copy));
+}
+
+template <typename T>
+bool JobQueue<T>::Push(T&& data) {
+  while (true) {
+    if (stop_) {
+      return false;
+    }
+
+    if (TryPush(&data)) {
+      Notify(num_pop_waiters_, &pop_condition_, false);
+      return true;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    num_push_waiters_ += 1;
+    push_condition_.wait(
+        lock, [this]() { return stop_ || Size() < max_num_jobs_; });
+    num_push_waiters_ -= 1;
   }
 }
 
 template <typename T>
 typename JobQueue<T>::Job JobQueue<T>::Pop() {
-  std::unique_lock<std::mutex> lock(mutex_);
-  while (jobs_.empty() && !stop_) {
-    push_condition_.wait(lock);
-  }
-  if (stop_) {
-    return Job();
-  } else {
-    const T data = jobs_.front();
-    jobs_.pop();
-    pop_condition_.notify_one();
-    if (jobs_.empty()) {
-      empty_condition_.notify_all();
+  while (true) {
+    if (stop_) {
+      return Job();
     }
-    return Job(data);
+
+    T data;
+    if (TryPop(&data)) {
+      Notify(num_push_waiters_, &push_condition_, false);
+      if (Size() == 0) {
+        Notify(num_empty_waiters_, &empty_condition_, true);
+      }
+      return Job(std::move(data));
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    num_pop_waiters_ += 1;
+    pop_condition_.wait(lock, [this]() { return stop_ || Size() > 0; });
+    num_pop_waiters_ -= 1;
   }
 }
 
 template <typename T>
 void JobQueue<T>::Wait() {
   std::unique_lock<std::mutex> lock(mutex_);
-  while (!jobs_.empty()) {
-    empty_condition_.wait(lock);
-  }
+  num_empty_waiters_ += 1;
+  empty_condition_.wait(lock, [this]() { return Size() == 0; });
+  num_empty_waiters_ -= 1;
 }
 
 template <typename T>
 void JobQueue<T>::Stop() {
   stop_ = true;
+  std::unique_lock<std::mutex> lock(mutex_);
   push_condition_.notify_all();
   pop_condition_.notify_all();
 }
 
 template <typename T>
 void JobQueue<T>::Clear() {
-  std::unique_lock<std::mutex> lock(mutex_);
-  std::queue<T> empty_jobs;
-  std::swap(jobs_, empty_jobs);
+  T data;
+  while (TryPop(&data)) {
+  }
+  Notify(num_push_waiters_, &push_condition_, true);
+  Notify(num_empty_waiters_, &empty_condition_, true);
+}
+
+template <typename T>
+bool JobQueue<T>::TryPush(T* data) {
+  size_t pos = push_pos_.load(std::memory_order_relaxed);
+  while (true) {
+    Slot& slot = slots_[pos % max_num_jobs_];
+    const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    const int64_t diff =
+        static_cast<int64_t>(sequence) - static_cast<int64_t>(2 * pos);
+    if (diff == 0) {
+      if (push_pos_.compare_exchange_weak(pos, pos + 1)) {
+        slot.data = std::move(*data);
+        slot.sequence.store(2 * pos + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      // The slot has not been popped yet, i.e. the queue is full.
+      return false;
+    } else {
+      pos = push_pos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename T>
+bool JobQueue<T>::TryPop(T* data) {
+  size_t pos = pop_pos_.load(std::memory_order_relaxed);
+  while (true) {
+    Slot& slot = slots_[pos % max_num_jobs_];
+    const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    const int64_t diff =
+        static_cast<int64_t>(sequence) - static_cast<int64_t>(2 * pos + 1);
+    if (diff == 0) {
+      if (pop_pos_.compare_exchange_weak(pos, pos + 1)) {
+        *data = std::move(slot.data);
+        slot.sequence.store(2 * (pos + max_num_jobs_),
+                            std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      // The slot has not been pushed yet, i.e. the queue is empty.
+      return false;
+    } else {
+      pos = pop_pos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename T>
+void JobQueue<T>::Notify(const std::atomic<int>& num_waiters,
+                         std::condition_variable* condition,
+                         const bool notify_all) {
+  // The waiters register themselves before checking their condition, so
+  // either they observe the new state or they are notified here. Locking the
+  // mutex ensures that they are not between the check and the wait.
+  if (num_waiters.load() > 0) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (notify_all) {
+      condition->notify_all();
+    } else {
+      condition->notify_one();
+    }
+  }
 }
 
 }  // namespace colmap
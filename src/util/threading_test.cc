@@ -0,0 +1,163 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#define TEST_NAME "util/threading"
+#include "util/testing.h"
+
+#include <atomic>
+
+#include "util/threading.h"
+
+using namespace colmap;
+
+BOOST_AUTO_TEST_CASE(TestParallelFor) {
+  WorkStealingThreadPool thread_pool(4);
+  std::vector<int> values(10000, 0);
+  ParallelFor(&thread_pool, 0, values.size(), 16,
+              [&values](const size_t i) { values[i] += static_cast<int>(i); });
+  for (size_t i = 0; i < values.size(); ++i) {
+    BOOST_CHECK_EQUAL(values[i], static_cast<int>(i));
+  }
+
+  // Without a thread pool, the loop runs in the calling thread.
+  ParallelFor(nullptr, 0, values.size(), 16,
+              [&values](const size_t i) { values[i] -= static_cast<int>(i); });
+  for (const int value : values) {
+    BOOST_CHECK_EQUAL(value, 0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestParallelForNested) {
+  WorkStealingThreadPool thread_pool(2);
+  std::atomic<size_t> num_iterations(0);
+  ParallelFor(&thread_pool, 0, 100, 1, [&](const size_t) {
+    ParallelFor(&thread_pool, 0, 100, 1,
+                [&](const size_t) { num_iterations += 1; });
+  });
+  BOOST_CHECK_EQUAL(num_iterations, 10000);
+}
+
+BOOST_AUTO_TEST_CASE(TestTaskGroup) {
+  WorkStealingThreadPool thread_pool(4);
+  std::atomic<int> num_tasks(0);
+  TaskGroup task_group(&thread_pool);
+  for (int i = 0; i < 100; ++i) {
+    task_group.Run([&num_tasks]() { num_tasks += 1; });
+  }
+  task_group.Wait();
+  BOOST_CHECK_EQUAL(num_tasks, 100);
+  BOOST_CHECK(!task_group.IsCancelled());
+}
+
+BOOST_AUTO_TEST_CASE(TestTaskGroupCancel) {
+  WorkStealingThreadPool thread_pool(1);
+  std::atomic<int> num_tasks(0);
+  TaskGroup task_group(&thread_pool);
+  task_group.Cancel();
+  for (int i = 0; i < 100; ++i) {
+    task_group.Run([&num_tasks]() { num_tasks += 1; });
+  }
+  task_group.Wait();
+  BOOST_CHECK_EQUAL(num_tasks, 0);
+  BOOST_CHECK(task_group.IsCancelled());
+}
+
+BOOST_AUTO_TEST_CASE(TestTaskGroupWaitAfterStop) {
+  WorkStealingThreadPool thread_pool(1);
+  thread_pool.Stop();
+  std::atomic<int> num_tasks(0);
+  TaskGroup task_group(&thread_pool);
+  for (int i = 0; i < 100; ++i) {
+    task_group.Run([&num_tasks]() { num_tasks += 1; });
+  }
+  task_group.Wait();
+  BOOST_CHECK_EQUAL(num_tasks, 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestJobQueueMultipleProducersConsumers) {
+  const int kNumProducers = 4;
+  const int kNumConsumers = 4;
+  const int kNumJobsPerProducer = 20000;
+
+  for (const size_t max_num_jobs : {1, 3, 64}) {
+    JobQueue<std::unique_ptr<int>> job_queue(max_num_jobs);
+
+    std::atomic<int> num_pushed(0);
+    std::vector<std::thread> producers;
+    for (int i = 0; i < kNumProducers; ++i) {
+      producers.emplace_back([&job_queue, &num_pushed, i]() {
+        for (int j = 0; j < kNumJobsPerProducer; ++j) {
+          if (job_queue.Push(std::unique_ptr<int>(
+                  new int(i * kNumJobsPerProducer + j)))) {
+            num_pushed += 1;
+          }
+        }
+      });
+    }
+
+    std::vector<std::vector<int>> consumed_values(kNumConsumers);
+    std::vector<std::thread> consumers;
+    for (int i = 0; i < kNumConsumers; ++i) {
+      consumers.emplace_back([&job_queue, &consumed_values, i]() {
+        while (true) {
+          auto job = job_queue.Pop();
+          if (!job.IsValid()) {
+            break;
+          }
+          consumed_values[i].push_back(*job.Data());
+        }
+      });
+    }
+
+    for (auto& producer : producers) {
+      producer.join();
+    }
+
+    BOOST_CHECK_EQUAL(num_pushed, kNumProducers * kNumJobsPerProducer);
+
+    job_queue.Wait();
+    BOOST_CHECK_EQUAL(job_queue.Size(), 0);
+    job_queue.Stop();
+
+    for (auto& consumer : consumers) {
+      consumer.join();
+    }
+
+    // Every job is popped exactly once.
+    std::vector<int> num_consumed(kNumProducers * kNumJobsPerProducer, 0);
+    for (const auto& values : consumed_values) {
+      for (const int value : values) {
+        num_consumed[value] += 1;
+      }
+    }
+    for (const int count : num_consumed) {
+      BOOST_CHECK_EQUAL(count, 1);
+    }
+  }
+}
@@ -0,0 +1,159 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "util/trace.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "util/misc.h"
+
+namespace colmap {
+namespace {
+
+// The buffer of the current thread, which is owned by the global tracer.
+thread_local void* thread_trace_buffer = nullptr;
+
+}  // namespace
+
+Tracer& Tracer::Get() {
+  static Tracer tracer;
+  return tracer;
+}
+
+Tracer::Tracer()
+    : started_(false), start_time_(std::chrono::steady_clock::now()) {}
+
+void Tracer::Start(const std::string& path) {
+#ifndef TRACING_ENABLED
+  std::cerr << "WARNING: Tracing requested, but ppsfm was compiled without "
+               "TRACING_ENABLED, so no events will be recorded."
+            << std::endl;
+#endif
+  std::unique_lock<std::mutex> lock(buffers_mutex_);
+  path_ = path;
+  started_ = true;
+}
+
+void Tracer::Stop() {
+  if (!started_.exchange(false)) {
+    return;
+  }
+
+  std::string path;
+  {
+    std::unique_lock<std::mutex> lock(buffers_mutex_);
+    path = path_;
+  }
+
+  if (!path.empty() && !Write(path)) {
+    std::cerr << "ERROR: Failed to write trace to " << path << std::endl;
+  }
+}
+
+int64_t Tracer::Now() const {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start_time_)
+      .count();
+}
+
+void Tracer::AddEvent(const Event& event) {
+  ThreadBuffer* buffer = GetThreadBuffer();
+  std::unique_lock<std::mutex> lock(buffer->mutex);
+  buffer->events.push_back(event);
+}
+
+bool Tracer::Write(const std::string& path) const {
+  std::ofstream file(path, std::ios::trunc);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+  bool first_event = true;
+
+  std::unique_lock<std::mutex> buffers_lock(buffers_mutex_);
+  for (const auto& buffer : buffers_) {
+    std::unique_lock<std::mutex> buffer_lock(buffer->mutex);
+
+    // Name the threads in the order in which they recorded their first event.
+    file << (first_event ? "" : ",") << "\n"
+         << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+         << buffer->thread_index << ",\"args\":{\"name\":\"Thread "
+         << buffer->thread_index << "\"}}";
+    first_event = false;
+
+    for (const auto& event : buffer->events) {
+      file << ",\n{\"name\":\"" << EscapeJSON(event.name)
+           << "\",\"cat\":\"ppsfm\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+           << buffer->thread_index << ",\"ts\":" << event.start_time
+           << ",\"dur\":" << event.duration << "}";
+    }
+  }
+
+  file << "\n]}\n";
+
+  return file.good();
+}
+
+Tracer::ThreadBuffer* Tracer::GetThreadBuffer() {
+  if (thread_trace_buffer == nullptr) {
+    std::unique_lock<std::mutex> lock(buffers_mutex_);
+    buffers_.emplace_back(new ThreadBuffer());
+    buffers_.back()->thread_index = static_cast<int>(buffers_.size()) - 1;
+    thread_trace_buffer = buffers_.back().get();
+  }
+  return static_cast<ThreadBuffer*>(thread_trace_buffer);
+}
+
+ScopedTrace::ScopedTrace(const char* name) : name_(name), start_time_(-1) {
+  const Tracer& tracer = Tracer::Get();
+  if (tracer.IsStarted()) {
+    start_time_ = tracer.Now();
+  }
+}
+
+ScopedTrace::~ScopedTrace() {
+  if (start_time_ < 0) {
+    return;
+  }
+
+  Tracer& tracer = Tracer::Get();
+  if (tracer.IsStarted()) {
+    Tracer::Event event;
+    event.name = name_;
+    event.start_time = start_time_;
+    event.duration = tracer.Now() - start_time_;
+    tracer.AddEvent(event);
+  }
+}
+
+}  // namespace colmap
@@ -0,0 +1,137 @@
+// Copyright (c) 2018, ETH Zurich and UNC Chapel Hill.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+//     * Neither the name of ETH Zurich and UNC Chapel Hill nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef COLMAP_SRC_UTIL_TRACE_H_
+#define COLMAP_SRC_UTIL_TRACE_H_
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace colmap {
+
+// Records the wall-clock time spent in scopes of the pipeline and writes them
+// in the Chrome trace event format, which can be inspected in chrome://tracing
+// or https://ui.perfetto.dev. Scopes are instrumented with:
+//
+//    void IncrementalMapper::RegisterNextImage(...) {
+//      TRACE_SCOPE("RegisterNextImage");
+//      ...
+//    }
+//
+// The instrumentation only exists if compiled with TRACING_ENABLED and the
+// events are only recorded after the tracer was started, e.g. through the
+// `trace_path` option, and before it is stopped. Every thread records into its own buffer, so tracing
+// does not introduce contention between threads.
+class Tracer {
+ public:
+  struct Event {
+    // Must point to a string with static storage duration.
+    const char* name;
+    int64_t start_time;
+    int64_t duration;
+  };
+
+  // The global tracer. The trace is only written when it is stopped, which
+  // the program must do explicitly before it exits, since the buffers of
+  // threads may already be destroyed during static destruction.
+  static Tracer& Get();
+
+  // Start recording events, which are written to the given path when the
+  // tracer is stopped.
+  void Start(const std::string& path);
+
+  // Stop recording events and write the trace file.
+  void Stop();
+
+  inline bool IsStarted() const;
+
+  // Time in microseconds since the construction of the tracer.
+  int64_t Now() const;
+
+  // Add an event to the buffer of the calling thread.
+  void AddEvent(const Event& event);
+
+  // Write all recorded events to a Chrome trace JSON file.
+  bool Write(const std::string& path) const;
+
+ private:
+  struct ThreadBuffer {
+    int thread_index;
+    std::mutex mutex;
+    std::vector<Event> events;
+  };
+
+  Tracer();
+
+  ThreadBuffer* GetThreadBuffer();
+
+  std::atomic<bool> started_;
+  std::string path_;
+  const std::chrono::steady_clock::time_point start_time_;
+
+  mutable std::mutex buffers_mutex_;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+// Records the lifetime of the object as a trace event.
+class ScopedTrace {
+ public:
+  explicit ScopedTrace(const char* name);
+  ~ScopedTrace();
+
+ private:
+  const char* name_;
+  int64_t start_time_;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#ifdef TRACING_ENABLED
+#define TRACE_SCOPE(name) \
+  ::colmap::ScopedTrace TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name)
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Implementation
+////////////////////////////////////////////////////////////////////////////////
+
+bool Tracer::IsStarted() const {
+  return started_.load(std::memory_order_relaxed);
+}
+
+}  // namespace colmap
+
+#endif  // COLMAP_SRC_UTIL_TRACE_H_